@@ -43,6 +43,7 @@ LOCAL_SRC_FILES:=          \
 LOCAL_MODULE_TAGS := optional
 
 LOCAL_STATIC_LIBRARIES := \
+    libvideoeditor_videofilters \
     libvideoeditor_osal \
     libstagefright_color_conversion
 
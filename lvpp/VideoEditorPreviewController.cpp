@@ -16,6 +16,7 @@
 
 #define LOG_NDEBUG 1
 #define LOG_TAG "VideoEditorPreviewController"
+#include <sys/stat.h>
 #include "VideoEditorPreviewController.h"
 
 namespace android {
@@ -51,7 +52,9 @@ VideoEditorPreviewController::VideoEditorPreviewController()
       mOutputVideoWidth(0),
       mOutputVideoHeight(0),
       bStopThreadInProgress(false),
-      mSemThreadWait(NULL) {
+      mSemThreadWait(NULL),
+      mProxyPath(NULL),
+      mProxyPathFct(NULL) {
     LOGV("VideoEditorPreviewController");
     mRenderingMode = M4xVSS_kBlackBorders;
     mIsFiftiesEffectStarted = false;
@@ -117,6 +120,7 @@ VideoEditorPreviewController::~VideoEditorPreviewController() {
 
                 mEffectsSettings[i].xVSS.pFramingBuffer = NULL;
             }
+            freeEffectContext(&(mEffectsSettings[i]));
         }
         free(mEffectsSettings);
         mEffectsSettings = NULL;
@@ -137,6 +141,11 @@ VideoEditorPreviewController::~VideoEditorPreviewController() {
         mTarget = NULL;
     }
 
+    if(mProxyPath != NULL) {
+        free(mProxyPath);
+        mProxyPath = NULL;
+    }
+
     mOverlayState = OVERLAY_CLEAR;
 
     LOGV("~VideoEditorPreviewController returns");
@@ -195,6 +204,7 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
 
                 mEffectsSettings[i].xVSS.pFramingBuffer = NULL;
             }
+            freeEffectContext(&(mEffectsSettings[i]));
         }
         free(mEffectsSettings);
         mEffectsSettings = NULL;
@@ -287,6 +297,16 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
                  (void *)&(pSettings->Effects[i]),
                  sizeof(M4VSS3GPP_EffectSettings));
 
+                // Build the per effect data once, not at each rendered frame
+                err = prepareEffectContext(&(mEffectsSettings[i]));
+                if(err != M4NO_ERROR) {
+                    LOGE("loadEffectsSettings: prepareEffectContext error 0x%x",
+                     (unsigned int)err);
+                    // The framing buffer is still the one of the caller
+                    mEffectsSettings[i].xVSS.pFramingBuffer = NULL;
+                    break;
+                }
+
                 if(pSettings->Effects[i].VideoEffectType ==
                  (M4VSS3GPP_VideoEffectType)M4xVSS_kVideoEffectType_Framing) {
                     // Allocate the pFraming RGB buffer
@@ -296,10 +316,10 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
 
                     if(mEffectsSettings[i].xVSS.pFramingBuffer == NULL) {
                         LOGE("loadEffectsSettings:Alloc error for pFramingBuf");
-                        free(mEffectsSettings);
-                        mEffectsSettings = NULL;
-                        return M4ERR_ALLOC;
+                        err = M4ERR_ALLOC;
+                        break;
                     }
+                    mEffectsSettings[i].xVSS.pFramingBuffer->pac_data = NULL;
 
                     // Allocate the pac_data (RGB)
                     if(pSettings->Effects[i].xVSS.rgbType == M4VSS3GPP_kRGB565){
@@ -315,9 +335,8 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
                     }
                     else {
                         LOGE("loadEffectsSettings: wrong RGB type");
-                        free(mEffectsSettings);
-                        mEffectsSettings = NULL;
-                        return M4ERR_PARAMETER;
+                        err = M4ERR_PARAMETER;
+                        break;
                     }
 
                     tmp = (M4VIFI_UInt8 *)M4OSA_32bitAlignedMalloc(rgbSize, M4VS,
@@ -325,12 +344,8 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
 
                     if(tmp == NULL) {
                         LOGE("loadEffectsSettings:Alloc error pFramingBuf pac");
-                        free(mEffectsSettings);
-                        mEffectsSettings = NULL;
-                        free(mEffectsSettings[i].xVSS.pFramingBuffer);
-
-                        mEffectsSettings[i].xVSS.pFramingBuffer = NULL;
-                        return M4ERR_ALLOC;
+                        err = M4ERR_ALLOC;
+                        break;
                     }
                     /* Initialize the pFramingBuffer*/
                     mEffectsSettings[i].xVSS.pFramingBuffer->pac_data = tmp;
@@ -370,6 +385,23 @@ M4OSA_ERR VideoEditorPreviewController::loadEditSettings(
                      pSettings->Effects[i].xVSS.rgbType;
                 }
             }
+
+            if(err != M4NO_ERROR) {
+                // Free what was built for the effects up to the failing one
+                do {
+                    if((mEffectsSettings[i].VideoEffectType ==
+                     (M4VSS3GPP_VideoEffectType)M4xVSS_kVideoEffectType_Framing) &&
+                     (mEffectsSettings[i].xVSS.pFramingBuffer != NULL)) {
+                        free(mEffectsSettings[i].xVSS.pFramingBuffer->pac_data);
+                        free(mEffectsSettings[i].xVSS.pFramingBuffer);
+                        mEffectsSettings[i].xVSS.pFramingBuffer = NULL;
+                    }
+                    freeEffectContext(&(mEffectsSettings[i]));
+                } while(i-- > 0);
+                free(mEffectsSettings);
+                mEffectsSettings = NULL;
+                return err;
+            }
         }
     }
 
@@ -950,6 +982,32 @@ M4OSA_Void VideoEditorPreviewController::setJniCallback(void* cookie,
     mJniCallback = callbackFct;
 }
 
+bool VideoEditorPreviewController::getProxyFile(
+    int index, char *pProxyFile, M4OSA_UInt32 size) {
+
+    struct stat clipStat, proxyStat;
+    const char *pClipFile = (const char *)mClipList[index]->pFile;
+
+    if (mProxyPath == NULL || mProxyPathFct == NULL ||
+        mClipList[index]->FileType == M4VIDEOEDITING_kFileType_ARGB8888) {
+        return false;
+    }
+
+    if (mProxyPathFct(mProxyPath, (M4OSA_Void *)pClipFile,
+            (M4OSA_Char *)pProxyFile, size) != M4NO_ERROR) {
+        return false;
+    }
+
+    // A proxy older than its clip is out of date
+    if (stat(pProxyFile, &proxyStat) != 0 || stat(pClipFile, &clipStat) != 0 ||
+        proxyStat.st_mtime < clipStat.st_mtime) {
+        return false;
+    }
+
+    LOGV("getProxyFile: clip %d plays %s", index, pProxyFile);
+    return true;
+}
+
 M4OSA_ERR VideoEditorPreviewController::preparePlayer(
     void* param, int playerInstance, int index) {
 
@@ -957,12 +1015,18 @@ M4OSA_ERR VideoEditorPreviewController::preparePlayer(
     VideoEditorPreviewController *pController =
      (VideoEditorPreviewController *)param;
 
+    char proxyFile[M4XVSS_MAX_PATH_LEN];
+    const char *pDataSource = (const char *)pController->mClipList[index]->pFile;
+
     LOGV("preparePlayer: instance %d file %d", playerInstance, index);
 
-    pController->mVePlayer[playerInstance]->setDataSource(
-    (const char *)pController->mClipList[index]->pFile, NULL);
-    LOGV("preparePlayer: setDataSource instance %s",
-     (const char *)pController->mClipList[index]->pFile);
+    // The proxy has the timeline of the clip, the cuts still apply
+    if (pController->getProxyFile(index, proxyFile, M4XVSS_MAX_PATH_LEN)) {
+        pDataSource = proxyFile;
+    }
+
+    pController->mVePlayer[playerInstance]->setDataSource(pDataSource, NULL);
+    LOGV("preparePlayer: setDataSource instance %s", pDataSource);
 
     pController->mVePlayer[playerInstance]->setVideoSurface(
      pController->mSurface);
@@ -1415,6 +1479,31 @@ status_t VideoEditorPreviewController::setPreviewFrameRenderingMode(
     return err;
 }
 
+M4OSA_ERR VideoEditorPreviewController::setProxyPath(
+    const char *pTempPath, proxy_path_fct proxyPathFct) {
+
+    LOGV("setProxyPath: %s", pTempPath);
+
+    if (mProxyPath != NULL) {
+        free(mProxyPath);
+        mProxyPath = NULL;
+    }
+    mProxyPathFct = proxyPathFct;
+
+    if (pTempPath == NULL) {
+        return M4NO_ERROR;
+    }
+
+    mProxyPath = (M4OSA_Char *)M4OSA_32bitAlignedMalloc(strlen(pTempPath) + 1,
+        M4VS, (M4OSA_Char *)"Proxy path");
+    if (mProxyPath == NULL) {
+        return M4ERR_ALLOC;
+    }
+    strcpy((char *)mProxyPath, pTempPath);
+
+    return M4NO_ERROR;
+}
+
 M4OSA_ERR VideoEditorPreviewController::doImageRenderingMode(
     M4OSA_Void * dataPtr, M4OSA_UInt32 colorFormat, M4OSA_UInt32 videoWidth,
     M4OSA_UInt32 videoHeight, M4OSA_Void* outPtr) {
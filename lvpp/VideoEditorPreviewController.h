@@ -59,6 +59,10 @@ typedef enum {
 // Callback mechanism from PreviewController to Jni  */
 typedef void (*jni_progress_callback_fct)(void* cookie, M4OSA_UInt32 msgType, void *argc);
 
+// Gives the preview proxy of a clip, see M4xVSS_proxyGetPath
+typedef M4OSA_ERR (*proxy_path_fct)(M4OSA_Char* pTempPath, M4OSA_Void* pClipFile,
+    M4OSA_Char* pProxyFile, M4OSA_UInt32 uiSize);
+
 
 class VideoEditorPreviewController {
 
@@ -89,6 +93,9 @@ public:
     status_t setPreviewFrameRenderingMode(M4xVSS_MediaRendering mode,
         M4VIDEOEDITING_VideoFrameSize outputVideoSize);
 
+    // Plays the proxies made by M4xVSS_proxyStart in pTempPath, when they exist
+    M4OSA_ERR setProxyPath(const char *pTempPath, proxy_path_fct proxyPathFct);
+
 private:
     sp<VideoEditorPlayer> mVePlayer[NBPLAYER_INSTANCES];
     int mCurrentPlayer; //Instance of the player currently being used
@@ -134,10 +141,14 @@ private:
     VideoEditorAudioPlayer *mVEAudioPlayer;
     NativeWindowRenderer* mNativeWindowRenderer;
 
+    M4OSA_Char* mProxyPath;
+    proxy_path_fct mProxyPathFct;
+
     M4VIFI_UInt8*  mFrameRGBBuffer;
     M4VIFI_UInt8*  mFrameYUVBuffer;
     mutable Mutex mLockSem;
     static M4OSA_ERR preparePlayer(void* param, int playerInstance, int index);
+    bool getProxyFile(int index, char *pProxyFile, M4OSA_UInt32 size);
     static M4OSA_ERR threadProc(M4OSA_Void* param);
     static void notify(void* cookie, int msg, int ext1, int ext2);
 
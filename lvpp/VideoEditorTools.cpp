@@ -329,167 +329,6 @@ M4VIFI_UInt8 M4VIFI_SemiplanarYUV420toYUV420(void *user_data,
 }
 
 
-/**
- ******************************************************************************
- * prototype    M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
- *                                                  M4VIFI_ImagePlane *PlaneIn,
- *                                                  M4VIFI_ImagePlane *PlaneOut,
- *                                                  M4VSS3GPP_ExternalProgress *pProgress,
- *                                                  M4OSA_UInt32 uiEffectKind)
- *
- * @brief   This function apply a color effect on an input YUV420 planar frame
- * @note
- * @param   pFunctionContext(IN) Contains which color to apply (not very clean ...)
- * @param   PlaneIn         (IN) Input YUV420 planar
- * @param   PlaneOut        (IN/OUT) Output YUV420 planar
- * @param   pProgress       (IN/OUT) Progress indication (0-100)
- * @param   uiEffectKind    (IN) Unused
- *
- * @return  M4VIFI_OK:  No error
- ******************************************************************************
-*/
-M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
-            M4VIFI_ImagePlane *PlaneIn, M4VIFI_ImagePlane *PlaneOut,
-            M4VSS3GPP_ExternalProgress *pProgress, M4OSA_UInt32 uiEffectKind) {
-
-    M4VIFI_Int32 plane_number;
-    M4VIFI_UInt32 i,j;
-    M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
-    M4xVSS_ColorStruct* ColorContext = (M4xVSS_ColorStruct*)pFunctionContext;
-
-    for (plane_number = 0; plane_number < 3; plane_number++)
-    {
-        p_buf_src =
-         &(PlaneIn[plane_number].pac_data[PlaneIn[plane_number].u_topleft]);
-
-        p_buf_dest =
-         &(PlaneOut[plane_number].pac_data[PlaneOut[plane_number].u_topleft]);
-        for (i = 0; i < PlaneOut[plane_number].u_height; i++)
-        {
-            /**
-             * Chrominance */
-            if(plane_number==1 || plane_number==2)
-            {
-                //switch ((M4OSA_UInt32)pFunctionContext) // commented because a structure for the effects context exist
-                switch (ColorContext->colorEffectType)
-                {
-                case M4xVSS_kVideoEffectType_BlackAndWhite:
-                    memset((void *)p_buf_dest,128,
-                     PlaneIn[plane_number].u_width);
-                    break;
-                case M4xVSS_kVideoEffectType_Pink:
-                    memset((void *)p_buf_dest,255,
-                     PlaneIn[plane_number].u_width);
-                    break;
-                case M4xVSS_kVideoEffectType_Green:
-                    memset((void *)p_buf_dest,0,
-                     PlaneIn[plane_number].u_width);
-                    break;
-                case M4xVSS_kVideoEffectType_Sepia:
-                    if(plane_number==1)
-                    {
-                        memset((void *)p_buf_dest,117,
-                         PlaneIn[plane_number].u_width);
-                    }
-                    else
-                    {
-                        memset((void *)p_buf_dest,139,
-                         PlaneIn[plane_number].u_width);
-                    }
-                    break;
-                case M4xVSS_kVideoEffectType_Negative:
-                    memcpy((void *)p_buf_dest,
-                     (void *)p_buf_src ,PlaneOut[plane_number].u_width);
-                    break;
-
-                case M4xVSS_kVideoEffectType_ColorRGB16:
-                    {
-                        M4OSA_UInt16 r = 0,g = 0,b = 0,y = 0,u = 0,v = 0;
-
-                        /*first get the r, g, b*/
-                        b = (ColorContext->rgb16ColorData &  0x001f);
-                        g = (ColorContext->rgb16ColorData &  0x07e0)>>5;
-                        r = (ColorContext->rgb16ColorData &  0xf800)>>11;
-
-                        /*keep y, but replace u and v*/
-                        if(plane_number==1)
-                        {
-                            /*then convert to u*/
-                            u = U16(r, g, b);
-                            memset((void *)p_buf_dest,(M4OSA_UInt8)u,
-                             PlaneIn[plane_number].u_width);
-                        }
-                        if(plane_number==2)
-                        {
-                            /*then convert to v*/
-                            v = V16(r, g, b);
-                            memset((void *)p_buf_dest,(M4OSA_UInt8)v,
-                             PlaneIn[plane_number].u_width);
-                        }
-                    }
-                    break;
-                case M4xVSS_kVideoEffectType_Gradient:
-                    {
-                        M4OSA_UInt16 r = 0,g = 0,b = 0,y = 0,u = 0,v = 0;
-
-                        /*first get the r, g, b*/
-                        b = (ColorContext->rgb16ColorData &  0x001f);
-                        g = (ColorContext->rgb16ColorData &  0x07e0)>>5;
-                        r = (ColorContext->rgb16ColorData &  0xf800)>>11;
-
-                        /*for color gradation*/
-                        b = (M4OSA_UInt16)( b - ((b*i)/PlaneIn[plane_number].u_height));
-                        g = (M4OSA_UInt16)(g - ((g*i)/PlaneIn[plane_number].u_height));
-                        r = (M4OSA_UInt16)(r - ((r*i)/PlaneIn[plane_number].u_height));
-
-                        /*keep y, but replace u and v*/
-                        if(plane_number==1)
-                        {
-                            /*then convert to u*/
-                            u = U16(r, g, b);
-                            memset((void *)p_buf_dest,(M4OSA_UInt8)u,
-                             PlaneIn[plane_number].u_width);
-                        }
-                        if(plane_number==2)
-                        {
-                            /*then convert to v*/
-                            v = V16(r, g, b);
-                            memset((void *)p_buf_dest,(M4OSA_UInt8)v,
-                             PlaneIn[plane_number].u_width);
-                        }
-                    }
-                    break;
-                default:
-                    return M4VIFI_INVALID_PARAM;
-                }
-            }
-            /**
-             * Luminance */
-            else
-            {
-                //switch ((M4OSA_UInt32)pFunctionContext)// commented because a structure for the effects context exist
-                switch (ColorContext->colorEffectType)
-                {
-                case M4xVSS_kVideoEffectType_Negative:
-                    for(j=0;j<PlaneOut[plane_number].u_width;j++)
-                    {
-                            p_buf_dest[j] = 255 - p_buf_src[j];
-                    }
-                    break;
-                default:
-                    memcpy((void *)p_buf_dest,
-                     (void *)p_buf_src ,PlaneOut[plane_number].u_width);
-                    break;
-                }
-            }
-            p_buf_src += PlaneIn[plane_number].u_stride;
-            p_buf_dest += PlaneOut[plane_number].u_stride;
-        }
-    }
-
-    return M4VIFI_OK;
-}
-
 /**
  ******************************************************************************
  * prototype    M4VSS3GPP_externalVideoEffectFraming(M4OSA_Void *pFunctionContext,
@@ -739,11 +578,12 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties(
     M4VIFI_ImagePlane *pPlaneOut, M4VSS3GPP_ExternalProgress *pProgress,
     M4OSA_UInt32 uiEffectKind )
 {
-    M4VIFI_UInt32 x, y, xShift;
+    M4VIFI_UInt32 x, xShift;
     M4VIFI_UInt8 *pInY = pPlaneIn[0].pac_data;
     M4VIFI_UInt8 *pOutY, *pInYbegin;
     M4VIFI_UInt8 *pInCr,* pOutCr;
     M4VIFI_Int32 plane_number;
+    M4OSA_Bool bNewRandom = M4OSA_FALSE;
 
     /* Internal context*/
     M4xVSS_FiftiesStruct* p_FiftiesData = (M4xVSS_FiftiesStruct *)pUserData;
@@ -753,20 +593,27 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties(
     pOutY = pPlaneOut[0].pac_data;
     pInYbegin  = pInY;
 
-    /* Initialize the random */
+    /* Draw new random values at the beginning of the effect, then each time we have
+    reached the duration of a partial effect. The values only depend on the seed and
+    on their rank, so that the effect gives the same output on each run */
     if(p_FiftiesData->previousClipTime < 0)
     {
-        M4OSA_randInit();
-        M4OSA_rand((M4OSA_Int32*)&(p_FiftiesData->shiftRandomValue), (pPlaneIn[0].u_height) >> 4);
-        M4OSA_rand((M4OSA_Int32*)&(p_FiftiesData->stripeRandomValue), (pPlaneIn[0].u_width)<< 2);
-        p_FiftiesData->previousClipTime = pProgress->uiOutputTime;
+        p_FiftiesData->randomCounter = 0;
+        bNewRandom = M4OSA_TRUE;
     }
-
-    /* Choose random values if we have reached the duration of a partial effect */
     else if( (pProgress->uiOutputTime - p_FiftiesData->previousClipTime) > p_FiftiesData->fiftiesEffectDuration)
     {
-        M4OSA_rand((M4OSA_Int32*)&(p_FiftiesData->shiftRandomValue), (pPlaneIn[0].u_height) >> 4);
-        M4OSA_rand((M4OSA_Int32*)&(p_FiftiesData->stripeRandomValue), (pPlaneIn[0].u_width)<< 2);
+        bNewRandom = M4OSA_TRUE;
+    }
+
+    if (M4OSA_TRUE == bNewRandom)
+    {
+        M4OSA_randCounter((M4OSA_Int32 *)&(p_FiftiesData->shiftRandomValue),
+            (pPlaneIn[0].u_height) >> 4, p_FiftiesData->randomSeed,
+            p_FiftiesData->randomCounter++);
+        M4OSA_randCounter((M4OSA_Int32 *)&(p_FiftiesData->stripeRandomValue),
+            (pPlaneIn[0].u_width)<< 2, p_FiftiesData->randomSeed,
+            p_FiftiesData->randomCounter++);
         p_FiftiesData->previousClipTime = pProgress->uiOutputTime;
     }
 
@@ -791,7 +638,7 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties(
     /* Compute the new pixels values */
     for( x = 0 ; x < pPlaneIn[0].u_height ; x++)
     {
-        M4VIFI_UInt8 *p_outYtmp, *p_inYtmp;
+        M4VIFI_UInt8 *p_inYtmp;
 
         /* Compute the xShift (random value) */
         if (0 == (p_FiftiesData->shiftRandomValue % 5 ))
@@ -799,28 +646,22 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties(
         else
             xShift = (x + (pPlaneIn[0].u_height - p_FiftiesData->shiftRandomValue) ) % (pPlaneIn[0].u_height - 1);
 
-        /* Initialize the pointers */
-        p_outYtmp = pOutY + 1;                                    /* yShift of 1 pixel */
         p_inYtmp  = pInYbegin + (xShift * pPlaneIn[0].u_stride);  /* Apply the xShift */
 
-        for( y = 0 ; y < pPlaneIn[0].u_width ; y++)
+        if (xShift > (pPlaneIn[0].u_height - 4))
         {
-            /* Set Y value */
-            if (xShift > (pPlaneIn[0].u_height - 4))
-                *p_outYtmp = 40;        /* Add some horizontal black lines between the two parts of the image */
-            else if ( y == p_FiftiesData->stripeRandomValue)
-                *p_outYtmp = 90;        /* Add a random vertical line for the bulk */
-            else
-                *p_outYtmp = *p_inYtmp;
-
-
-            /* Go to the next pixel */
-            p_outYtmp++;
-            p_inYtmp++;
+            /* Add some horizontal black lines between the two parts of the image */
+            memset((void *)pOutY, 40, pPlaneIn[0].u_width);
+        }
+        else
+        {
+            /* yShift of 1 pixel, the last pixel of the line goes to the beginning */
+            memcpy((void *)(pOutY + 1), (void *)p_inYtmp, pPlaneIn[0].u_width - 1);
+            pOutY[0] = p_inYtmp[pPlaneIn[0].u_width - 1];
 
-            /* Restart at the beginning of the line for the last pixel*/
-            if (y == (pPlaneIn[0].u_width - 2))
-                p_outYtmp = pOutY;
+            /* Add a random vertical line for the bulk */
+            if (p_FiftiesData->stripeRandomValue < pPlaneIn[0].u_width)
+                pOutY[(p_FiftiesData->stripeRandomValue + 1) % pPlaneIn[0].u_width] = 90;
         }
 
         /* Go to the next line */
@@ -830,103 +671,6 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties(
     return M4VIFI_OK;
 }
 
-unsigned char M4VFL_modifyLumaWithScale(M4ViComImagePlane *plane_in,
-                                        M4ViComImagePlane *plane_out,
-                                        unsigned long lum_factor,
-                                        void *user_data)
-{
-    unsigned short *p_src, *p_dest, *p_src_line, *p_dest_line;
-    unsigned char *p_csrc, *p_cdest, *p_csrc_line, *p_cdest_line;
-    unsigned long pix_src;
-    unsigned long u_outpx, u_outpx2;
-    unsigned long u_width, u_stride, u_stride_out,u_height, pix;
-    long i, j;
-
-    /* copy or filter chroma */
-    u_width = plane_in[1].u_width;
-    u_height = plane_in[1].u_height;
-    u_stride = plane_in[1].u_stride;
-    u_stride_out = plane_out[1].u_stride;
-    p_cdest_line = (unsigned char *) &plane_out[1].pac_data[plane_out[1].u_topleft];
-    p_csrc_line = (unsigned char *) &plane_in[1].pac_data[plane_in[1].u_topleft];
-
-    if (lum_factor > 256)
-    {
-        p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        /* copy chroma */
-        for (j = u_height; j != 0; j--)
-        {
-            for (i = u_width; i != 0; i--)
-            {
-                memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
-                memcpy((void *)p_cdest, (void *)p_csrc, u_width);
-            }
-            p_cdest_line += u_stride_out;
-            p_cdest += u_stride_out;
-            p_csrc_line += u_stride;
-            p_csrc += u_stride;
-        }
-    }
-    else
-    {
-        /* filter chroma */
-        pix = (1024 - lum_factor) << 7;
-        for (j = u_height; j != 0; j--)
-        {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc++ & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
-        }
-        p_cdest_line = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc_line = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        for (j = u_height; j != 0; j--)
-        {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
-        }
-    }
-    /* apply luma factor */
-    u_width = plane_in[0].u_width;
-    u_height = plane_in[0].u_height;
-    u_stride = (plane_in[0].u_stride >> 1);
-    u_stride_out = (plane_out[0].u_stride >> 1);
-    p_dest = (unsigned short *) &plane_out[0].pac_data[plane_out[0].u_topleft];
-    p_src = (unsigned short *) &plane_in[0].pac_data[plane_in[0].u_topleft];
-    p_dest_line = p_dest;
-    p_src_line = p_src;
-
-    for (j = u_height; j != 0; j--)
-    {
-        p_dest = p_dest_line;
-        p_src = p_src_line;
-        for (i = (u_width >> 1); i != 0; i--)
-        {
-            pix_src = (unsigned long) *p_src++;
-            pix = pix_src & 0xFF;
-            u_outpx = ((pix * lum_factor) >> LUM_FACTOR_MAX);
-            pix = ((pix_src & 0xFF00) >> 8);
-            u_outpx2 = (((pix * lum_factor) >> LUM_FACTOR_MAX)<< 8) ;
-            *p_dest++ = (unsigned short) (u_outpx2 | u_outpx);
-        }
-        p_dest_line += u_stride_out;
-        p_src_line += u_stride;
-    }
-
-    return 0;
-}
-
 /******************************************************************************
  * prototype    M4OSA_ERR M4xVSS_internalConvertRGBtoYUV(M4xVSS_FramingStruct* framingCtx)
  * @brief   This function converts an RGB565 plane to YUV420 planar
@@ -3203,22 +2947,140 @@ M4OSA_ERR prepareFramingStructure(
     return err;
 }
 
+static M4OSA_ERR getColorLutEffect(M4xVSS_VideoEffectType colorEffect,
+    M4VFL_ColorEffect *pLutEffect) {
+
+    // Same lookup table engine as the saving path (M4VFL_ColorLut)
+    switch(colorEffect) {
+        case M4xVSS_kVideoEffectType_BlackAndWhite:
+            *pLutEffect = M4VFL_kColorEffect_BlackAndWhite;
+            break;
+        case M4xVSS_kVideoEffectType_Pink:
+            *pLutEffect = M4VFL_kColorEffect_Pink;
+            break;
+        case M4xVSS_kVideoEffectType_Green:
+            *pLutEffect = M4VFL_kColorEffect_Green;
+            break;
+        case M4xVSS_kVideoEffectType_Sepia:
+            *pLutEffect = M4VFL_kColorEffect_Sepia;
+            break;
+        case M4xVSS_kVideoEffectType_Negative:
+            *pLutEffect = M4VFL_kColorEffect_Negative;
+            break;
+        case M4xVSS_kVideoEffectType_ColorRGB16:
+            *pLutEffect = M4VFL_kColorEffect_ColorRGB16;
+            break;
+        case M4xVSS_kVideoEffectType_Gradient:
+            *pLutEffect = M4VFL_kColorEffect_Gradient;
+            break;
+        default:
+            return M4ERR_PARAMETER;
+    }
+    return M4NO_ERROR;
+}
+
+static M4OSA_Void initFiftiesContext(M4xVSS_FiftiesStruct *pFiftiesCtx,
+    M4VSS3GPP_EffectSettings* pEffect) {
+
+    // Same initial state as in M4xVSS_SendCommand
+    pFiftiesCtx->previousClipTime = -1;
+    pFiftiesCtx->fiftiesEffectDuration = 1000/pEffect->xVSS.uiFiftiesOutFrameRate;
+    pFiftiesCtx->shiftRandomValue = 0;
+    pFiftiesCtx->stripeRandomValue = 0;
+    pFiftiesCtx->randomSeed = pEffect->uiStartTime;
+    pFiftiesCtx->randomCounter = 0;
+}
+
+M4OSA_ERR prepareEffectContext(M4VSS3GPP_EffectSettings* pEffect) {
+
+    M4VFL_ColorEffect lutEffect;
+    M4VFL_ColorLut *pColorLut;
+    M4xVSS_FiftiesStruct *pFiftiesCtx;
+    M4OSA_ERR err = M4NO_ERROR;
+
+    // The context of the effect settings given by the application is not ours
+    pEffect->pExtVideoEffectFctCtxt = NULL;
+
+    // The fifties effect keeps its random values from frame to frame
+    if(pEffect->VideoEffectType ==
+     (M4VSS3GPP_VideoEffectType)M4xVSS_kVideoEffectType_Fifties) {
+        if(pEffect->xVSS.uiFiftiesOutFrameRate == 0) {
+            LOGE("prepareEffectContext: fifties frame rate is 0");
+            return M4ERR_PARAMETER;
+        }
+        pFiftiesCtx = (M4xVSS_FiftiesStruct*)M4OSA_32bitAlignedMalloc(
+         sizeof(M4xVSS_FiftiesStruct), M4VS, (M4OSA_Char*)"lvpp fifties context");
+        if(pFiftiesCtx == NULL) {
+            LOGE("prepareEffectContext: allocation error");
+            return M4ERR_ALLOC;
+        }
+        initFiftiesContext(pFiftiesCtx, pEffect);
+        pEffect->pExtVideoEffectFctCtxt = pFiftiesCtx;
+        return err;
+    }
+
+    // Color effects are compiled once into tables, as in M4xVSS_SendCommand
+    if(getColorLutEffect((M4xVSS_VideoEffectType)pEffect->VideoEffectType,
+     &lutEffect) == M4NO_ERROR) {
+        pColorLut = (M4VFL_ColorLut*)M4OSA_32bitAlignedMalloc(
+         sizeof(M4VFL_ColorLut), M4VS, (M4OSA_Char*)"lvpp color lut");
+        if(pColorLut == NULL) {
+            LOGE("prepareEffectContext: allocation error");
+            return M4ERR_ALLOC;
+        }
+        err = M4VFL_colorLutBuild(pColorLut, lutEffect,
+         (M4OSA_UInt16)pEffect->xVSS.uiRgb16InputColor);
+        if(err != M4NO_ERROR) {
+            LOGE("prepareEffectContext: M4VFL_colorLutBuild error 0x%x",
+             (unsigned int)err);
+            free(pColorLut);
+            return err;
+        }
+        pEffect->pExtVideoEffectFctCtxt = pColorLut;
+    }
+    return err;
+}
+
+M4OSA_Void freeEffectContext(M4VSS3GPP_EffectSettings* pEffect) {
+
+    if(pEffect->pExtVideoEffectFctCtxt != NULL) {
+        free(pEffect->pExtVideoEffectFctCtxt);
+        pEffect->pExtVideoEffectFctCtxt = NULL;
+    }
+}
+
 M4OSA_ERR applyColorEffect(M4xVSS_VideoEffectType colorEffect,
+    M4VSS3GPP_EffectSettings* pEffect,
     M4VIFI_ImagePlane *planeIn, M4VIFI_ImagePlane *planeOut,
-    M4VIFI_UInt8 *buffer1, M4VIFI_UInt8 *buffer2, M4OSA_UInt16 rgbColorData) {
+    M4VIFI_UInt8 *buffer1, M4VIFI_UInt8 *buffer2) {
 
-    M4xVSS_ColorStruct colorContext;
+    M4VFL_ColorLut colorLut;
+    M4VFL_ColorLut *pColorLut = NULL;
+    M4VFL_ColorEffect lutEffect;
     M4OSA_ERR err = M4NO_ERROR;
 
-    colorContext.colorEffectType = colorEffect;
-    colorContext.rgb16ColorData = rgbColorData;
+    if(pEffect != NULL) {
+        pColorLut = (M4VFL_ColorLut*)pEffect->pExtVideoEffectFctCtxt;
+    }
 
-    err = M4VSS3GPP_externalVideoEffectColor(
-     (M4OSA_Void *)&colorContext, planeIn, planeOut, NULL,
-     colorEffect);
+    // The tables are normally built with the effect settings,
+    // see prepareEffectContext
+    if(pColorLut == NULL) {
+        err = getColorLutEffect(colorEffect, &lutEffect);
+        if(err != M4NO_ERROR) {
+            LOGE("applyColorEffect: unsupported color effect %d", colorEffect);
+            return err;
+        }
+        err = M4VFL_colorLutBuild(&colorLut, lutEffect, (pEffect != NULL) ?
+         (M4OSA_UInt16)pEffect->xVSS.uiRgb16InputColor : 0);
+        pColorLut = &colorLut;
+    }
+    if(err == M4NO_ERROR) {
+        err = M4VFL_colorLutApply(pColorLut, planeIn, planeOut);
+    }
 
     if(err != M4NO_ERROR) {
-        LOGV("M4VSS3GPP_externalVideoEffectColor(%d) error %d",
+        LOGV("M4VFL_colorLutApply(%d) error %d",
             colorEffect, err);
 
         if(NULL != buffer1) {
@@ -3269,6 +3131,20 @@ M4OSA_ERR applyLumaEffect(M4VSS3GPP_VideoEffectType videoEffect,
     return err;
 }
 
+static M4VSS3GPP_EffectSettings* findEffectSettings(vePostProcessParams *params,
+    M4xVSS_VideoEffectType videoEffect) {
+
+    M4OSA_UInt32 i;
+
+    // Find the effect in effectSettings array
+    for(i=0;i<params->numberEffects;i++) {
+        if(params->effectsSettings[i].VideoEffectType ==
+         (M4VSS3GPP_VideoEffectType)videoEffect)
+            return &(params->effectsSettings[i]);
+    }
+    return NULL;
+}
+
 M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
     M4OSA_UInt32 reportedWidth, M4OSA_UInt32 reportedHeight) {
 
@@ -3279,6 +3155,7 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
     M4OSA_Int32 lum_factor;
     M4VSS3GPP_ExternalProgress extProgress;
     M4xVSS_FiftiesStruct fiftiesCtx;
+    M4xVSS_FiftiesStruct *pFiftiesCtx = NULL;
     M4OSA_UInt32 frameSize = 0, i=0;
 
     frameSize = (params->videoWidth*params->videoHeight*3) >> 1;
@@ -3319,8 +3196,9 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
 
     if(params->currentVideoEffect & VIDEO_EFFECT_BLACKANDWHITE) {
         err = applyColorEffect(M4xVSS_kVideoEffectType_BlackAndWhite,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_BlackAndWhite),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer, 0);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
@@ -3328,8 +3206,9 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
 
     if(params->currentVideoEffect & VIDEO_EFFECT_PINK) {
         err = applyColorEffect(M4xVSS_kVideoEffectType_Pink,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_Pink),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer, 0);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
@@ -3337,8 +3216,9 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
 
     if(params->currentVideoEffect & VIDEO_EFFECT_GREEN) {
         err = applyColorEffect(M4xVSS_kVideoEffectType_Green,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_Green),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer, 0);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
@@ -3346,8 +3226,9 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
 
     if(params->currentVideoEffect & VIDEO_EFFECT_SEPIA) {
         err = applyColorEffect(M4xVSS_kVideoEffectType_Sepia,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_Sepia),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer, 0);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
@@ -3355,40 +3236,29 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
 
     if(params->currentVideoEffect & VIDEO_EFFECT_NEGATIVE) {
         err = applyColorEffect(M4xVSS_kVideoEffectType_Negative,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_Negative),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer, 0);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
     }
 
     if(params->currentVideoEffect & VIDEO_EFFECT_GRADIENT) {
-        // find the effect in effectSettings array
-        for(i=0;i<params->numberEffects;i++) {
-            if(params->effectsSettings[i].VideoEffectType ==
-             (M4VSS3GPP_VideoEffectType)M4xVSS_kVideoEffectType_Gradient)
-                break;
-        }
         err = applyColorEffect(M4xVSS_kVideoEffectType_Gradient,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_Gradient),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer,
-              params->effectsSettings[i].xVSS.uiRgb16InputColor);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
     }
 
     if(params->currentVideoEffect & VIDEO_EFFECT_COLOR_RGB16) {
-        // Find the effect in effectSettings array
-        for(i=0;i<params->numberEffects;i++) {
-            if(params->effectsSettings[i].VideoEffectType ==
-             (M4VSS3GPP_VideoEffectType)M4xVSS_kVideoEffectType_ColorRGB16)
-                break;
-        }
         err = applyColorEffect(M4xVSS_kVideoEffectType_ColorRGB16,
+              findEffectSettings(params, M4xVSS_kVideoEffectType_ColorRGB16),
               planeIn, planeOut, (M4VIFI_UInt8 *)finalOutputBuffer,
-              (M4VIFI_UInt8 *)tempOutputBuffer,
-              params->effectsSettings[i].xVSS.uiRgb16InputColor);
+              (M4VIFI_UInt8 *)tempOutputBuffer);
         if(err != M4NO_ERROR) {
             return err;
         }
@@ -3406,17 +3276,19 @@ M4OSA_ERR applyEffectsAndRenderingMode(vePostProcessParams *params,
              params->effectsSettings[i].uiStartTime,
              params->effectsSettings[i].uiDuration, &extProgress);
 
+            // The random values go on from frame to frame, as when saving
+            pFiftiesCtx = (M4xVSS_FiftiesStruct*)
+             params->effectsSettings[i].pExtVideoEffectFctCtxt;
+            if(pFiftiesCtx == NULL) {
+                pFiftiesCtx = &fiftiesCtx;
+                initFiftiesContext(pFiftiesCtx, &(params->effectsSettings[i]));
+            }
             if(params->isFiftiesEffectStarted) {
-                fiftiesCtx.previousClipTime = -1;
+                pFiftiesCtx->previousClipTime = -1;
             }
-            fiftiesCtx.fiftiesEffectDuration =
-             1000/params->effectsSettings[i].xVSS.uiFiftiesOutFrameRate;
-
-            fiftiesCtx.shiftRandomValue = 0;
-            fiftiesCtx.stripeRandomValue = 0;
 
             err = M4VSS3GPP_externalVideoEffectFifties(
-             (M4OSA_Void *)&fiftiesCtx, planeIn, planeOut, &extProgress,
+             (M4OSA_Void *)pFiftiesCtx, planeIn, planeOut, &extProgress,
              M4xVSS_kVideoEffectType_Fifties);
 
             if(err != M4NO_ERROR) {
@@ -26,6 +26,7 @@
 /* Clip table declaration */
 #include "M4VIFI_Clip.h"
 #include "M4VFL_transition.h"
+#include "M4VFL_ColorLut.h"
 #include "M4VSS3GPP_API.h"
 #include "M4xVSS_API.h"
 #include "M4xVSS_Internal.h"
@@ -73,14 +74,10 @@ typedef struct {
 M4VIFI_UInt8 M4VIFI_YUV420PlanarToYUV420Semiplanar(void *user_data, M4VIFI_ImagePlane *PlaneIn, M4VIFI_ImagePlane *PlaneOut );
 M4VIFI_UInt8 M4VIFI_SemiplanarYUV420toYUV420(void *user_data, M4VIFI_ImagePlane *PlaneIn, M4VIFI_ImagePlane *PlaneOut );
 
-M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext, M4VIFI_ImagePlane *PlaneIn,
-                                                    M4VIFI_ImagePlane *PlaneOut,M4VSS3GPP_ExternalProgress *pProgress, M4OSA_UInt32 uiEffectKind);
-
 M4OSA_ERR M4VSS3GPP_externalVideoEffectFraming( M4OSA_Void *userData, M4VIFI_ImagePlane PlaneIn[3], M4VIFI_ImagePlane *PlaneOut, M4VSS3GPP_ExternalProgress *pProgress, M4OSA_UInt32 uiEffectKind );
 
 M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties( M4OSA_Void *pUserData, M4VIFI_ImagePlane *pPlaneIn, M4VIFI_ImagePlane *pPlaneOut, M4VSS3GPP_ExternalProgress *pProgress, M4OSA_UInt32 uiEffectKind );
 
-unsigned char M4VFL_modifyLumaWithScale(M4ViComImagePlane *plane_in, M4ViComImagePlane *plane_out, unsigned long lum_factor, void *user_data);
 
 M4OSA_ERR M4xVSS_internalConvertRGBtoYUV(M4xVSS_FramingStruct* framingCtx);
 M4VIFI_UInt8    M4VIFI_xVSS_RGB565toYUV420(void *pUserData, M4VIFI_ImagePlane *pPlaneIn,
@@ -125,9 +122,14 @@ M4OSA_ERR prepareFramingStructure(
     M4VSS3GPP_EffectSettings* effectsSettings, M4OSA_UInt32 index,
     M4VIFI_UInt8* overlayRGB, M4VIFI_UInt8* overlayYUV);
 
+M4OSA_ERR prepareEffectContext(M4VSS3GPP_EffectSettings* pEffect);
+
+M4OSA_Void freeEffectContext(M4VSS3GPP_EffectSettings* pEffect);
+
 M4OSA_ERR applyColorEffect(M4xVSS_VideoEffectType colorEffect,
+    M4VSS3GPP_EffectSettings* pEffect,
     M4VIFI_ImagePlane *planeIn, M4VIFI_ImagePlane *planeOut,
-    M4VIFI_UInt8 *buffer1, M4VIFI_UInt8 *buffer2, M4OSA_UInt16 rgbColorData);
+    M4VIFI_UInt8 *buffer1, M4VIFI_UInt8 *buffer2);
 
 M4OSA_ERR applyLumaEffect(M4VSS3GPP_VideoEffectType videoEffect,
     M4VIFI_ImagePlane *planeIn, M4VIFI_ImagePlane *planeOut,
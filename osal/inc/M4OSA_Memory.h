@@ -48,6 +48,11 @@ M4OSAL_MEMORY_EXPORT_TYPE extern M4OSA_ERR M4OSA_randInit(void);
 M4OSAL_MEMORY_EXPORT_TYPE extern M4OSA_ERR M4OSA_rand(M4OSA_Int32* out_value,
                                                       M4OSA_UInt32 max_value);
 
+M4OSAL_MEMORY_EXPORT_TYPE extern M4OSA_ERR M4OSA_randCounter(M4OSA_Int32* out_value,
+                                                             M4OSA_UInt32 max_value,
+                                                             M4OSA_UInt32 seed,
+                                                             M4OSA_UInt32 counter);
+
 
 #ifdef __cplusplus
 }
@@ -87,4 +87,43 @@ M4OSA_ERR M4OSA_rand(M4OSA_Int32* out_value, M4OSA_UInt32 max_value)
     return M4NO_ERROR;
 }
 
+/**
+ ************************************************************************
+ * @fn         M4OSA_ERR M4OSA_randCounter(M4OSA_Int32* out_value, M4OSA_UInt32 max_value,
+ *                                          M4OSA_UInt32 seed, M4OSA_UInt32 counter)
+ * @brief      This function gives a pseudo random number between 1 and max_value
+ *               (inclusive), computed from a seed and a counter only
+ * @note       Unlike M4OSA_rand(), there is no hidden state and M4OSA_randInit()
+ *               is not needed: the same (seed, counter) pair always gives the
+ *               same value, so the output of an effect can be reproduced.
+ * @param      out_value (OUT): on return, points to random result
+ * @param      max_value (IN): max expected value
+ * @param      seed (IN): seed of the sequence
+ * @param      counter (IN): index of the value in the sequence
+ * @return     M4NO_ERROR
+ * @return     M4ERR_PARAMETER: out_value is M4OSA_NULL or max_value is 0
+ ************************************************************************
+*/
+
+M4OSA_ERR M4OSA_randCounter(M4OSA_Int32* out_value, M4OSA_UInt32 max_value,
+                            M4OSA_UInt32 seed, M4OSA_UInt32 counter)
+{
+    M4OSA_UInt32 x;
 
+    if( (out_value == M4OSA_NULL) || (max_value < 1) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    /* Integer hash of the (seed, counter) pair, computed on 32 bits */
+    x = (seed ^ (counter * 0x9E3779B9UL)) & 0xFFFFFFFFUL;
+    x ^= x >> 16;
+    x = (x * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+    x ^= x >> 15;
+    x = (x * 0x846CA68BUL) & 0xFFFFFFFFUL;
+    x ^= x >> 16;
+
+    (*out_value) = (M4OSA_Int32)((x % max_value) + 1);
+
+    return M4NO_ERROR;
+}
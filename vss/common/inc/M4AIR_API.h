@@ -180,5 +180,53 @@ M4OSA_ERR M4AIR_configure(M4OSA_Context pContext, M4AIR_Params* pParams);
 M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_ImagePlane* pOut);
 
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4AIR_configurePanZoom(M4OSA_Context pContext, M4AIR_Params* pStartParams,
+ *                                  M4AIR_Params* pEndParams)
+ * @brief    This function will configure the AIR for an animated pan and zoom.
+ * @note    The source position of each output column and row is precomputed (16.16 fixed
+ *            point) for the start and the end windows. Since the mapping is linear in the
+ *            window coordinates, any intermediate window is obtained by interpolating these
+ *            tables, see M4AIR_getPanZoom. Only the YUV420 planar format, top-left output
+ *            orientation and normal (non stripe) mode are supported. Both windows must have
+ *            the same output size.
+ * @param    pContext:        (IN) Context identifying the instance
+ * @param    pStartParams:    (IN) AIR parameters of the first picture
+ * @param    pEndParams:        (IN) AIR parameters of the last picture
+ * @return    M4NO_ERROR: there is no error
+ * @return    M4ERR_ALLOC: No more memory is available
+ * @return    M4ERR_PARAMETER: pContext is M4OSA_NULL (debug only), or unsupported parameters
+ * @return    M4ERR_STATE: Internal state is incompatible with this function call.
+ * @return    M4ERR_AIR_FORMAT_NOT_SUPPORTED: the input format is not supported.
+ * @return    M4ERR_AIR_ILLEGAL_FRAME_SIZE: the input or output size is incorrect
+ ******************************************************************************
+*/
+M4OSA_ERR M4AIR_configurePanZoom(M4OSA_Context pContext, M4AIR_Params* pStartParams,
+                                 M4AIR_Params* pEndParams);
+
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4AIR_getPanZoom(M4OSA_Context pContext, M4OSA_UInt32 uiStep,
+ *                            M4OSA_UInt32 uiNbSteps, M4VIFI_ImagePlane* pIn,
+ *                            M4VIFI_ImagePlane* pOut)
+ * @brief    This function will provide the picture of the pan and zoom at a given step.
+ * @note    The window used is the linear interpolation between the start (uiStep = 0) and
+ *            end (uiStep = uiNbSteps) windows given in M4AIR_configurePanZoom.
+ * @param    pContext:    (IN) Context identifying the instance
+ * @param    uiStep:        (IN) Current step, between 0 and uiNbSteps
+ * @param    uiNbSteps:    (IN) Number of steps between the start and end windows
+ * @param    pIn:        (IN) Plane structure containing input Plane(s).
+ * @param    pOut:        (IN/OUT)  Plane structure containing output Plane(s).
+ * @return    M4NO_ERROR: there is no error
+ * @return    M4ERR_PARAMETER: pContext is M4OSA_NULL (debug only).
+ * @return    M4ERR_STATE: M4AIR_configurePanZoom has not been called.
+ ******************************************************************************
+*/
+M4OSA_ERR M4AIR_getPanZoom(M4OSA_Context pContext, M4OSA_UInt32 uiStep, M4OSA_UInt32 uiNbSteps,
+                           M4VIFI_ImagePlane* pIn, M4VIFI_ImagePlane* pOut);
+
+
 
 #endif /* M4AIR_API_H */
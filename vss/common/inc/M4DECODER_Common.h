@@ -135,6 +135,20 @@ typedef enum
     M4DECODER_kOptionID_VideoDecodersAndCapabilities =
         M4OSA_OPTION_ID_CREATE(M4_READ, M4DECODER_COMMON, 0x10),
 
+    /**
+     * Get how far in ms (M4OSA_Int32) before the target of the last jump the decoding
+     * restarted: from the previous sync sample, or from the last decoded frame when the
+     * jump decoded forward */
+    M4DECODER_kOptionID_PrevRapDistance =
+        M4OSA_OPTION_ID_CREATE(M4_READ, M4DECODER_COMMON, 0x11),
+
+    /**
+     * Stops the decoder reading the stream ahead (no value), to be set before the caller
+     * reads or jumps in the video stream itself. The decoder reads again from the next
+     * decode call. The AUs it has read ahead are lost, so the caller has to jump. */
+    M4DECODER_kOptionID_PauseReadAhead =
+        M4OSA_OPTION_ID_CREATE(M4_WRITE, M4DECODER_COMMON, 0x12),
+
     /* common to MPEG4 decoders */
     /**
      * Get the DecoderConfigInfo */
@@ -379,8 +379,13 @@ typedef enum
     M4ENCODER_kOptionID_SetH264ProcessNALUfctsPtr= M4OSA_OPTION_ID_CREATE (M4_READ ,\
                                                              M4ENCODER_COMMON, 0x05),
     M4ENCODER_kOptionID_H264ProcessNALUContext        = M4OSA_OPTION_ID_CREATE (M4_READ ,\
-                                                             M4ENCODER_COMMON, 0x06)
+                                                             M4ENCODER_COMMON, 0x06),
 /*-CR LV6775 -H.264 Trimming  */
+
+    /**< the VPP function honors the stride of the output planes, so the encoder may give
+         planes of its own input layout (with padding), option value is M4OSA_Bool type */
+    M4ENCODER_kOptionID_StridedPreProcessing   = M4OSA_OPTION_ID_CREATE (M4_WRITE,\
+                                                             M4ENCODER_COMMON, 0x07)
 } M4ENCODER_OptionID;
 
 /*+ CR LV6775 -H.264 Trimming  */
@@ -40,6 +40,60 @@ M4OSA_ERR M4VD_Tools_WriteBitsToMemory(M4OSA_UInt32 bitsToWrite,
                                          M4OSA_MemAddr32 dest_bits,
                                          M4OSA_UInt8 offset, M4OSA_UInt8 nb_bits);
 
+/* ----- H264 byte stream (Annex B) ----- */
+
+/**
+ ************************************************************************
+ * M4OSA_UInt8* M4VD_Tools_FindStartCode(M4OSA_UInt8* pData, M4OSA_UInt32 size,
+ *                                       M4OSA_UInt32* pStartCodeSize)
+ * @brief   Finds the first H264 start code (0x000001 or 0x00000001) of a buffer
+ * @note    Only start codes followed by at least one byte (the NAL header)
+ *          are reported.
+ * @param   pData:          (IN) Buffer to scan
+ * @param   size:           (IN) Size of the buffer
+ * @param   pStartCodeSize: (OUT) 3 or 4, size of the start code found
+ * @return  The address of the start code, M4OSA_NULL if there is none
+ ************************************************************************
+ */
+M4OSA_UInt8* M4VD_Tools_FindStartCode(M4OSA_UInt8* pData, M4OSA_UInt32 size,
+                                      M4OSA_UInt32* pStartCodeSize);
+
+/**
+ ************************************************************************
+ * M4OSA_Bool M4VD_Tools_IsNALStream(M4OSA_UInt8* pData, M4OSA_UInt32 size)
+ * @brief   Tells if a H264 access unit is made of 4 bytes NAL sizes and NAL units
+ * @note    The NAL sizes must chain up to the exact end of the access unit
+ * @param   pData:      (IN) Access unit
+ * @param   size:       (IN) Size of the access unit
+ * @return  M4OSA_TRUE if the access unit is a NAL stream
+ ************************************************************************
+ */
+M4OSA_Bool M4VD_Tools_IsNALStream(M4OSA_UInt8* pData, M4OSA_UInt32 size);
+
+/**
+ ************************************************************************
+ * M4OSA_ERR M4VD_Tools_ConvertByteStreamToNALStream(M4OSA_UInt8* pIn,
+ *                  M4OSA_UInt32 inSize, M4OSA_UInt8* pOut, M4OSA_UInt32* pOutSize)
+ * @brief   Replaces the start codes of a H264 access unit by 4 bytes NAL sizes
+ * @note    Access units already made of 4 bytes NAL sizes and NAL units, as given by
+ *          the 3GPP readers, are detected (see M4VD_Tools_IsNALStream) and kept as is.
+ *          The conversion can be done in place (pOut == pIn) when all the start
+ *          codes are 4 bytes long. 3 bytes start codes need a separate output
+ *          buffer, one byte larger per NAL unit.
+ * @param   pIn:        (IN) Access unit, begins with a start code or a NAL size
+ * @param   inSize:     (IN) Size of the access unit
+ * @param   pOut:       (OUT) Converted access unit, may be pIn
+ * @param   pOutSize:   (IN/OUT) Size of pOut buffer / size of the converted data. May be
+ *                      M4OSA_NULL in place, the size is then unchanged
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: the access unit begins neither with a start code nor with
+ *          NAL sizes, the output buffer is too small, or a 3 bytes start code is
+ *          found in place
+ ************************************************************************
+ */
+M4OSA_ERR M4VD_Tools_ConvertByteStreamToNALStream(M4OSA_UInt8* pIn, M4OSA_UInt32 inSize,
+                                                  M4OSA_UInt8* pOut, M4OSA_UInt32* pOutSize);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4VFL_ColorLut.h
+ * @brief       Lookup table based color effects on YUV420 planar frames
+ * @note        A color effect is compiled once into per plane 256 entries
+ *              tables (or a small YUV 3D table when the chroma depends on the
+ *              luma), then applied on each frame with table lookups only.
+ ******************************************************************************
+*/
+
+#ifndef __M4VFL_COLORLUT_H__
+#define __M4VFL_COLORLUT_H__
+
+#include "M4OSA_Types.h"
+#include "M4OSA_Error.h"
+#include "M4OSA_CoreID.h"
+#include "M4OSA_FileReader.h"
+#include "M4VIFI_FiltersAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The .cube file is not valid (bad syntax, bad size or missing entries) */
+#define M4ERR_VFL_LUT_FILE_INVALID      M4OSA_ERR_CREATE(M4_ERR,M4VEE,0x000001)
+
+/**
+ * Number of nodes per dimension of the 3D table (node k is at value 16*k) */
+#define M4VFL_LUT3D_SIZE                17
+
+/**
+ * Maximum number of nodes per dimension accepted in a .cube file */
+#define M4VFL_LUT_CUBE_MAX_SIZE         64
+
+/**
+ ******************************************************************************
+ * enum     M4VFL_ColorEffect
+ * @brief   Built-in color effects that can be compiled into a table
+ ******************************************************************************
+*/
+typedef enum
+{
+    M4VFL_kColorEffect_BlackAndWhite,
+    M4VFL_kColorEffect_Pink,
+    M4VFL_kColorEffect_Green,
+    M4VFL_kColorEffect_Sepia,
+    M4VFL_kColorEffect_Negative,
+    M4VFL_kColorEffect_ColorRGB16,
+    M4VFL_kColorEffect_Gradient
+} M4VFL_ColorEffect;
+
+/**
+ ******************************************************************************
+ * enum     M4VFL_ColorLutType
+ * @brief   Kind of table held by a M4VFL_ColorLut
+ ******************************************************************************
+*/
+typedef enum
+{
+    M4VFL_kColorLut_Planes,     /**< One independent 256 entries table per plane */
+    M4VFL_kColorLut_Gradient,   /**< Luma table, chroma filled per row (vertical gradient) */
+    M4VFL_kColorLut_3D          /**< YUV to YUV 3D table, trilinear interpolation */
+} M4VFL_ColorLutType;
+
+/**
+ ******************************************************************************
+ * struct   M4VFL_ColorLut
+ * @brief   Compiled color effect
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4VFL_ColorLutType  type;
+    M4OSA_UInt8         lut[3][256];    /**< Per plane tables (Planes and Gradient types) */
+    M4OSA_Bool          bCopy[3];       /**< The plane table is the identity */
+    M4OSA_Bool          bFill[3];       /**< The plane table is a constant, lut[x][0] */
+    M4OSA_UInt16        gradientR;      /**< Gradient color (RGB565 components) */
+    M4OSA_UInt16        gradientG;
+    M4OSA_UInt16        gradientB;
+    M4OSA_UInt8         *pLut3D;        /**< M4VFL_LUT3D_SIZE^3 YUV triplets, Y fastest */
+} M4VFL_ColorLut;
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VFL_colorLutBuild(M4VFL_ColorLut *pLut, M4VFL_ColorEffect effect,
+ *                               M4OSA_UInt16 rgb16Color)
+ * @brief   Compiles a built-in color effect into a table
+ * @param   pLut:       (OUT) Table to build
+ * @param   effect:     (IN) Color effect
+ * @param   rgb16Color: (IN) RGB565 color, used by ColorRGB16 and Gradient only
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: pLut is M4OSA_NULL or effect is unknown
+ ******************************************************************************
+*/
+M4OSA_ERR M4VFL_colorLutBuild(M4VFL_ColorLut *pLut, M4VFL_ColorEffect effect,
+                              M4OSA_UInt16 rgb16Color);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutInit(M4VFL_ColorLut *pLut)
+ * @brief   Sets a table to the identity (per plane type)
+ * @param   pLut:   (OUT) Table to initialize
+ ******************************************************************************
+*/
+M4OSA_Void M4VFL_colorLutInit(M4VFL_ColorLut *pLut);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutBuildLumaScale(M4VFL_ColorLut *pLut, M4OSA_UInt32 lumFactor)
+ * @brief   Builds the table equivalent to M4VFL_modifyLumaWithScale
+ * @note    Luma is scaled by lumFactor/1024, chroma is moved towards 128 by the same
+ *          factor when lumFactor <= 256 and copied otherwise.
+ * @param   pLut:       (OUT) Table to build
+ * @param   lumFactor:  (IN) Luma factor, 0 (black) to 1024 (unchanged)
+ ******************************************************************************
+*/
+M4OSA_Void M4VFL_colorLutBuildLumaScale(M4VFL_ColorLut *pLut, M4OSA_UInt32 lumFactor);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VFL_colorLutCompose(M4VFL_ColorLut *pLut, const M4VFL_ColorLut *pNext)
+ * @brief   Fuses two per plane tables: pLut becomes "pLut then pNext"
+ * @note    Applying the result once gives exactly the same frame as applying both
+ *          tables one after the other.
+ * @param   pLut:   (IN/OUT) First table, receives the fused table
+ * @param   pNext:  (IN) Table applied after pLut
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: one of the tables is not a per plane table
+ ******************************************************************************
+*/
+M4OSA_ERR M4VFL_colorLutCompose(M4VFL_ColorLut *pLut, const M4VFL_ColorLut *pNext);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VFL_colorLutLoadCube(M4VFL_ColorLut *pLut, M4OSA_Void *pFile,
+ *                                  M4OSA_FileReadPointer *pFileReadPtr)
+ * @brief   Compiles a .cube 3D LUT file into a table
+ * @note    The RGB cube (LUT_3D_SIZE, DOMAIN_MIN, DOMAIN_MAX keywords, red
+ *          varying fastest) is resampled once into a M4VFL_LUT3D_SIZE^3 YUV
+ *          to YUV table, so that no color conversion is needed per frame.
+ *          M4VFL_colorLutRelease must be called to free the table.
+ * @param   pLut:           (OUT) Table to build
+ * @param   pFile:          (IN) .cube file descriptor
+ * @param   pFileReadPtr:   (IN) File read function pointers
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: at least one parameter is M4OSA_NULL
+ * @return  M4ERR_ALLOC: there is no more memory available
+ * @return  M4ERR_VFL_LUT_FILE_INVALID: the file is not a valid .cube file
+ * @return  Any error returned by the file reader
+ ******************************************************************************
+*/
+M4OSA_ERR M4VFL_colorLutLoadCube(M4VFL_ColorLut *pLut, M4OSA_Void *pFile,
+                                 M4OSA_FileReadPointer *pFileReadPtr);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutRelease(M4VFL_ColorLut *pLut)
+ * @brief   Frees the memory held by a table
+ * @param   pLut:   (IN/OUT) Table to release
+ ******************************************************************************
+*/
+M4OSA_Void M4VFL_colorLutRelease(M4VFL_ColorLut *pLut);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VFL_colorLutApply(M4VFL_ColorLut *pLut, M4VIFI_ImagePlane *pPlaneIn,
+ *                               M4VIFI_ImagePlane *pPlaneOut)
+ * @brief   Applies a compiled color effect on a YUV420 planar frame
+ * @param   pLut:       (IN) Table built by M4VFL_colorLutBuild or M4VFL_colorLutLoadCube
+ * @param   pPlaneIn:   (IN) Input YUV420 planar
+ * @param   pPlaneOut:  (IN/OUT) Output YUV420 planar, same size as the input
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: at least one parameter is M4OSA_NULL
+ ******************************************************************************
+*/
+M4OSA_ERR M4VFL_colorLutApply(M4VFL_ColorLut *pLut, M4VIFI_ImagePlane *pPlaneIn,
+                              M4VIFI_ImagePlane *pPlaneOut);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __M4VFL_COLORLUT_H__ */
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+*************************************************************************
+ * @file    M4_StepStats.h
+ * @brief   Cumulative timers and counters of the MCS and VSS step loops
+ * @note    Each stage gets the time spent in it, without the time of the
+ *          stages nested in it (for instance the encoder calls the VPP
+ *          function, which decodes and resizes, and the writer).
+*************************************************************************
+*/
+#ifndef __M4_STEPSTATS_H__
+#define __M4_STEPSTATS_H__
+
+#include "M4OSA_Types.h"
+#include "M4OSA_Error.h"
+#include "M4OSA_Time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Size of the buffer needed by M4_StepStatsToJson */
+#define M4_STEPSTATS_JSON_SIZE      512
+
+/**
+ ******************************************************************************
+ * enum     M4_StepStage
+ * @brief   Measured stages of a step
+ ******************************************************************************
+*/
+typedef enum
+{
+    M4_kStepStage_Read = 0,     /**< Reader AU reads done by the step itself */
+    M4_kStepStage_Decode,       /**< Video decoding */
+    M4_kStepStage_Effect,       /**< Video effects, transitions and frame render */
+    M4_kStepStage_Resize,       /**< Video resize and rendering mode */
+    M4_kStepStage_Encode,       /**< Video encoding */
+    M4_kStepStage_Write,        /**< Writer AU writes */
+    M4_kStepStage_Audio,        /**< Audio decoding, conversion, mixing and encoding */
+    M4_kStepStage_NB            /**< Number of stages */
+} M4_StepStage;
+
+/**
+ ******************************************************************************
+ * struct   M4_StepStats
+ * @brief   Cumulative statistics of a context
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_UInt32    uiCount[M4_kStepStage_NB];  /**< Number of calls per stage */
+    M4OSA_Time      time[M4_kStepStage_NB];     /**< Time per stage, in microseconds */
+    M4OSA_UInt32    uiNbSteps;                  /**< Number of steps */
+    M4OSA_Time      stepTime;                   /**< Time in the steps, in microseconds */
+    M4OSA_Time      measuredTime;               /**< Sum of time[], used for nesting */
+} M4_StepStats;
+
+/**
+ ******************************************************************************
+ * struct   M4_StepTimer
+ * @brief   A running measure, see M4_StepStatsStart
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_Time      startTime;
+    M4OSA_Time      measuredTime;   /**< measuredTime of the stats at the start */
+} M4_StepTimer;
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsReset(M4_StepStats *pStats)
+ * @brief   Sets all the counters to 0
+ * @param   pStats:     (OUT) Statistics
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsReset(M4_StepStats *pStats);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsStart(M4_StepStats *pStats, M4_StepTimer *pTimer)
+ * @brief   Starts the measure of a stage or of a step
+ * @param   pStats:     (IN) Statistics the measure is added to
+ * @param   pTimer:     (OUT) Measure to give to M4_StepStatsStop or M4_StepStatsStopStep
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsStart(M4_StepStats *pStats, M4_StepTimer *pTimer);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsStop(M4_StepStats *pStats, M4_StepStage stage,
+ *                             M4_StepTimer *pTimer)
+ * @brief   Adds a measure to a stage
+ * @note    The time of the stages measured between the start and the stop is
+ *          not counted twice.
+ * @param   pStats:     (IN/OUT) Statistics
+ * @param   stage:      (IN) Measured stage
+ * @param   pTimer:     (IN) Measure started by M4_StepStatsStart
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsStop(M4_StepStats *pStats, M4_StepStage stage,
+                            M4_StepTimer *pTimer);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsStopStep(M4_StepStats *pStats, M4_StepTimer *pTimer)
+ * @brief   Adds a measure to the steps
+ * @param   pStats:     (IN/OUT) Statistics
+ * @param   pTimer:     (IN) Measure started by M4_StepStatsStart
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsStopStep(M4_StepStats *pStats, M4_StepTimer *pTimer);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsMerge(M4_StepStats *pStats, const M4_StepStats *pOther)
+ * @brief   Adds the counters of pOther to pStats
+ * @param   pStats:     (IN/OUT) Statistics
+ * @param   pOther:     (IN) Statistics to add
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsMerge(M4_StepStats *pStats, const M4_StepStats *pOther);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4_StepStatsToJson(const M4_StepStats *pStats, M4OSA_Char *pBuffer,
+ *                              M4OSA_UInt32 uiSize)
+ * @brief   Writes the statistics as a JSON object
+ * @note    Times are written in milliseconds, for instance
+ *          {"steps":{"count":120,"ms":2400},"read":{"count":0,"ms":0},...}
+ * @param   pStats:     (IN) Statistics
+ * @param   pBuffer:    (OUT) Zero terminated JSON string
+ * @param   uiSize:     (IN) Size of pBuffer, M4_STEPSTATS_JSON_SIZE is enough
+ * @return  M4NO_ERROR: there is no error
+ * @return  M4ERR_PARAMETER: at least one parameter is M4OSA_NULL
+ * @return  M4ERR_CHR_STR_OVERFLOW: pBuffer is too small
+ ******************************************************************************
+*/
+M4OSA_ERR M4_StepStatsToJson(const M4_StepStats *pStats, M4OSA_Char *pBuffer,
+                             M4OSA_UInt32 uiSize);
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4_StepStatsTrace(const M4_StepStats *pStats, const M4OSA_Char *pName)
+ * @brief   Traces the statistics as a JSON summary (trace level 1)
+ * @note    Nothing is traced when no step has been done.
+ * @param   pStats:     (IN) Statistics
+ * @param   pName:      (IN) Name of the traced context
+ ******************************************************************************
+*/
+M4OSA_Void M4_StepStatsTrace(const M4_StepStats *pStats, const M4OSA_Char *pName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __M4_STEPSTATS_H__ */
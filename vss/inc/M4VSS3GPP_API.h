@@ -44,12 +44,17 @@
  * Image planes definition */
 #include "M4VIFI_FiltersAPI.h"
 
+/**
+ * Lookup table color effects */
+#include "M4VFL_ColorLut.h"
+
 /**
  * Common definitions of video editing components */
 #include "M4_VideoEditingCommon.h"
 #include "M4ENCODER_AudioCommon.h"
 #include "M4AD_Common.h"
 #include "M4DA_Types.h"
+#include "M4_StepStats.h"
 
 /**
  * Extended API (xVSS) */
@@ -437,6 +442,161 @@ M4OSA_ERR M4VSS3GPP_editAnalyseClip(M4OSA_Void *pClip, M4VIDEOEDITING_FileType F
                                     M4VIDEOEDITING_ClipProperties  *pClipProperties,
                                     M4OSA_FileReadPointer *pFileReadPtrFct);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editAnalyseClipList()
+ * @brief   Analyses all the clips of a list which are not analysed yet
+ * @note    The clips are analysed concurrently by up to M4VSS3GPP_ANALYSIS_MAX_THREADS
+ *          threads, the calling thread included. If a cache is given, the analysis of an
+ *          unchanged file is taken from it and new analyses are stored in it.
+ *          On success, ClipProperties is filled for each clip, as M4VSS3GPP_editAnalyseClip
+ *          would do. On error, the error of the first failing clip of the list is returned.
+ * @param   pClipList           (IN/OUT) Array of pointers on the clip settings
+ * @param   uiClipNumber        (IN) Number of clips in pClipList
+ * @param   pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param   pCacheContext       (IN) Analysis cache, can be M4OSA_NULL
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only)
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ * @return  Any error returned by M4VSS3GPP_editAnalyseClip
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editAnalyseClipList(M4VSS3GPP_ClipSettings **pClipList,
+                                        M4OSA_UInt32 uiClipNumber,
+                                        M4OSA_FileReadPointer *pFileReadPtrFct,
+                                        M4OSA_Context pCacheContext);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheOpen()
+ * @brief   Creates a clip properties cache
+ * @note    Entries are keyed by file path, file type, file size and modification date,
+ *          so that a file modified since it was stored is analysed again.
+ *          The cache can be shared by several threads.
+ * @param   pCacheContext       (OUT) Pointer on the cache context to create
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    pCacheContext is M4OSA_NULL (debug only)
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheOpen(M4OSA_Context *pCacheContext);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheGet()
+ * @brief   Looks a file up in a clip properties cache
+ * @param   pCacheContext       (IN) Cache context
+ * @param   pClip               (IN) File descriptor of the clip
+ * @param   FileType            (IN) Type of the clip file
+ * @param   pClipProperties     (OUT) Cached properties, filled on M4NO_ERROR only
+ * @param   pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return  M4NO_ERROR:         The properties were found
+ * @return  M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED: The file is not in the cache or was modified
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheGet(M4OSA_Context pCacheContext, M4OSA_Void *pClip,
+                                     M4VIDEOEDITING_FileType FileType,
+                                     M4VIDEOEDITING_ClipProperties *pClipProperties,
+                                     M4OSA_FileReadPointer *pFileReadPtrFct);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheSet()
+ * @brief   Stores the properties of a file in a clip properties cache
+ * @note    When the cache is full, the oldest entry is replaced.
+ * @param   pCacheContext       (IN) Cache context
+ * @param   pClip               (IN) File descriptor of the clip
+ * @param   FileType            (IN) Type of the clip file
+ * @param   pClipProperties     (IN) Properties to store
+ * @param   pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ * @return  Any error returned by the file reader
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheSet(M4OSA_Context pCacheContext, M4OSA_Void *pClip,
+                                     M4VIDEOEDITING_FileType FileType,
+                                     M4VIDEOEDITING_ClipProperties *pClipProperties,
+                                     M4OSA_FileReadPointer *pFileReadPtrFct);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheLoad()
+ * @brief   Fills a clip properties cache from an index file
+ * @note    The index keeps the cache content from one session to the next one.
+ *          Entries are still checked against the file size and modification date
+ *          when they are looked up. An index written by another library build is ignored.
+ * @param   pCacheContext       (IN) Cache context
+ * @param   pIndexFile          (IN) File descriptor of the index file
+ * @param   pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ * @return  M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED: The index file is not valid
+ * @return  Any error returned by the file reader (the index file may not exist yet)
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheLoad(M4OSA_Context pCacheContext, M4OSA_Void *pIndexFile,
+                                      M4OSA_FileReadPointer *pFileReadPtrFct);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheSave()
+ * @brief   Writes the content of a clip properties cache to an index file
+ * @param   pCacheContext       (IN) Cache context
+ * @param   pIndexFile          (IN) File descriptor of the index file
+ * @param   pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ * @return  Any error returned by the file writer
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheSave(M4OSA_Context pCacheContext, M4OSA_Void *pIndexFile,
+                                      M4OSA_FileWriterPointer *pFileWritePtrFct);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editExtractThumbnails()
+ * @brief   Extracts the thumbnails of a clip at several times
+ * @note    The clip is opened once and decoded by one decoder, in increasing time order
+ *          whatever the order of pTimes. In approximate mode, each thumbnail is the sync
+ *          sample preceding its time, and the times sharing a sync sample share one
+ *          decoding. In exact mode, each thumbnail is the first frame at or after its time.
+ *          The frames are resized into the thumbnails by the bilinear M4VIFI filter,
+ *          without rotation. The times are clamped to the clip duration.
+ * @param   pClip               (IN) File descriptor of the clip
+ * @param   FileType            (IN) Type of the clip file (not ARGB8888)
+ * @param   pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param   pTimes              (IN) Thumbnail times in the clip, in ms, in any order
+ * @param   uiNbTimes           (IN) Number of times
+ * @param   bExact              (IN) M4OSA_TRUE for the frames at the times, M4OSA_FALSE
+ *                                   for the sync samples
+ * @param   pThumbnails         (OUT) 3 * uiNbTimes YUV420 planes allocated by the caller,
+ *                                   the thumbnail of pTimes[i] is pThumbnails[3 * i] at
+ *                                   the size of these planes
+ * @param   pThumbnailTimes     (OUT) Time of the frame of each thumbnail, can be M4OSA_NULL
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL or invalid
+ * @return  M4ERR_ALLOC:        There is no more available memory
+ * @return  M4VSS3GPP_ERR_EDITING_NO_SUPPORTED_VIDEO_STREAM_IN_FILE
+ * @return  Any error returned by the reader or the decoder
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editExtractThumbnails(M4OSA_Void *pClip, M4VIDEOEDITING_FileType FileType,
+                                          M4OSA_FileReadPointer *pFileReadPtrFct,
+                                          const M4OSA_Int32 *pTimes, M4OSA_UInt32 uiNbTimes,
+                                          M4OSA_Bool bExact, M4VIFI_ImagePlane *pThumbnails,
+                                          M4OSA_Int32 *pThumbnailTimes);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheClose()
+ * @brief   Frees a clip properties cache
+ * @param   pCacheContext       (IN) Cache context
+ * @return  M4NO_ERROR:         No error
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheClose(M4OSA_Context pCacheContext);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_editCheckClipCompatibility()
@@ -540,6 +700,27 @@ M4OSA_ERR M4VSS3GPP_editFreeClipSettings(M4VSS3GPP_ClipSettings *pClipSettings);
  */
 M4OSA_ERR M4VSS3GPP_editOpen(M4VSS3GPP_EditContext pContext, M4VSS3GPP_EditSettings *pSettings);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editSetEffectLut()
+ * @brief   Declare that an external video effect is a per plane lookup table.
+ * @note    Must be called after M4VSS3GPP_editOpen(). The table of the effect can then be
+ *          fused with the neighbouring table effects (fades and other color effects).
+ *          The table is not copied, it must stay valid until M4VSS3GPP_editCleanUp().
+ *          Effects for which this function is not called are applied by their
+ *          external function only.
+ * @param   pContext            (IN) VSS 3GPP edit context
+ * @param   uiEffect            (IN) Index of the effect in the edit settings
+ * @param   pLut                (IN) Per plane table equivalent to the external effect
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only), the index
+ *                              is out of range or the table is not a per plane table
+ * @return  M4ERR_STATE:        M4VSS3GPP_editOpen() has not been called
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editSetEffectLut(M4VSS3GPP_EditContext pContext, M4OSA_UInt8 uiEffect,
+                                     M4VFL_ColorLut *pLut);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_editStep()
@@ -582,6 +763,22 @@ M4OSA_ERR M4VSS3GPP_editClose(M4VSS3GPP_EditContext pContext);
  */
 M4OSA_ERR M4VSS3GPP_editCleanUp(M4VSS3GPP_EditContext pContext);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editGetStatistics()
+ * @brief   Get the time spent in each stage of the edit steps.
+ * @note    Reads, decodes, VPP and writes done from the encoder callbacks are
+ *          counted in their own stage, not in the encode stage.
+ *          The statistics are traced when M4VSS3GPP_editClose() is called.
+ * @param   pContext            (IN) VSS 3GPP edit context
+ * @param   pStats              (OUT) Statistics since M4VSS3GPP_editInit()
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only)
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editGetStatistics(M4VSS3GPP_EditContext pContext,
+                                      M4_StepStats *pStats);
+
 /**
  ******************************************************************************
  ******************************************************************************
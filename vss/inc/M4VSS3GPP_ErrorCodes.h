@@ -52,6 +52,10 @@
 /* RC: to know when a file has been processed */
 #define M4VSS3GPP_WAR_SWITCH_CLIP              M4OSA_ERR_CREATE( M4_WAR, M4VSS3GPP, 0x0030)
 
+/**
+ *    The clip properties are not in the analysis cache */
+#define M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED      M4OSA_ERR_CREATE( M4_WAR, M4VSS3GPP, 0x0040)
+
 /************************************************************************/
 /* Error codes                                                          */
 /************************************************************************/
@@ -150,6 +150,9 @@ typedef struct
                                             Used only if video effect is framming */
     M4OSA_UInt32                height; /*height of the ARGB8888 clip .
                                             Used only if video effect is framming */
+    /**< .cube 3D LUT file path, used only if VideoEffectType == color LUT. The file is
+     read during M4xVSS_SendCommand and the path is not kept */
+    M4OSA_Void                 *pColorLutFilePath;
 } M4xVSS_EffectSettings;
 
 /**
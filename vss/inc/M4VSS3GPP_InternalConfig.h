@@ -34,6 +34,21 @@
                                                                    an STSS table (no rap frames),
                                                                    jump backward 40 s maximum */
 
+/**< Clips analysed concurrently by M4VSS3GPP_editAnalyseClipList (calling thread included) */
+#define M4VSS3GPP_ANALYSIS_MAX_THREADS                  4
+/**< Number of clips kept in an analysis cache */
+#define M4VSS3GPP_ANALYSIS_CACHE_SIZE                   64
+/**< Analysis cache index file: "M4CI" magic and format version */
+#define M4VSS3GPP_ANALYSIS_INDEX_MAGIC                  0x4943344D
+#define M4VSS3GPP_ANALYSIS_INDEX_VERSION                1
+/**< Index entry size without the path: path length, file type, file size, modification
+     date and clip properties */
+#define M4VSS3GPP_ANALYSIS_INDEX_ENTRY_SIZE             (3 * sizeof(M4OSA_UInt32) \
+                                                        + sizeof(M4OSA_Time) \
+                                                        + sizeof(M4VIDEOEDITING_ClipProperties))
+/**< AUs copied per step by a stream copy clip (no effect, cut nor transition) */
+#define M4VSS3GPP_STREAM_COPY_BURST                     32
+
 /*****************/
 /* Writer config */
 /*****************/
@@ -82,6 +82,20 @@ M4OSA_ERR M4VSS3GPP_intEditStepMP3(M4VSS3GPP_InternalEditContext *pC);
 M4OSA_ERR M4VSS3GPP_intOpenClip(M4VSS3GPP_InternalEditContext *pC, M4VSS3GPP_ClipContext **hClip,
                                  M4VSS3GPP_ClipSettings *pClipSettings);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intOpenNextClip()
+ * @brief    Gets a clip of the clip list opened
+ * @note     If the clip is being opened by the prefetch thread, waits for it
+ *           and takes it, else opens it.
+ * @param   pC            (IN/OUT) Internal edit context
+ * @param   hClip         (OUT) Opened clip
+ * @param   uiClipIndex   (IN) Index of the clip in the clip list
+ ******************************************************************************
+*/
+M4OSA_ERR M4VSS3GPP_intOpenNextClip(M4VSS3GPP_InternalEditContext *pC,
+                                    M4VSS3GPP_ClipContext **hClip, M4OSA_UInt8 uiClipIndex);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intDestroyVideoEncoder()
@@ -100,6 +114,16 @@ M4OSA_ERR M4VSS3GPP_intDestroyVideoEncoder(M4VSS3GPP_InternalEditContext *pC);
 */
 M4OSA_ERR  M4VSS3GPP_intCreateVideoEncoder(M4VSS3GPP_InternalEditContext *pC);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intStopVideoEncoder()
+ * @brief    Stops the video encoder, but keeps it for the next encoded segment
+ * @note     M4VSS3GPP_intCreateVideoEncoder starts it again. The encoder is
+ *           destroyed if it cannot be stopped and started again.
+  ******************************************************************************
+*/
+M4OSA_ERR  M4VSS3GPP_intStopVideoEncoder(M4VSS3GPP_InternalEditContext *pC);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intReachedEndOfVideo()
@@ -381,6 +381,54 @@ typedef struct
     M4OSA_Bool                  bGetYuvDataFromDecoder;  /* Boolean used to get YUV data from dummy video decoder only for first time */
 } M4VSS3GPP_ClipContext;
 
+/**
+ ******************************************************************************
+ * struct    M4VSS3GPP_AnalysisCacheEntry
+ * @brief    Clip properties of one file, with the file identification
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_Char                      *pFile;         /**< Copy of the file path,
+                                                         M4OSA_NULL if the entry is free */
+    M4VIDEOEDITING_FileType         FileType;
+    M4OSA_FilePosition              fileSize;
+    M4OSA_Time                      modifiedTime;
+    M4VIDEOEDITING_ClipProperties   ClipProperties;
+} M4VSS3GPP_AnalysisCacheEntry;
+
+/**
+ ******************************************************************************
+ * struct    M4VSS3GPP_AnalysisCache
+ * @brief    Clip properties cache (see M4VSS3GPP_analysisCacheOpen)
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4OSA_Context                   mutex;          /**< Protects the entries */
+    M4VSS3GPP_AnalysisCacheEntry    *pEntries;      /**< M4VSS3GPP_ANALYSIS_CACHE_SIZE entries */
+    M4OSA_UInt32                    uiNextEntry;    /**< Entry replaced when the cache is full */
+} M4VSS3GPP_AnalysisCache;
+
+/**
+ ******************************************************************************
+ * struct    M4VSS3GPP_AnalysisJob
+ * @brief    Clip list shared by the M4VSS3GPP_editAnalyseClipList threads
+ ******************************************************************************
+*/
+typedef struct
+{
+    M4VSS3GPP_ClipSettings          **pClipList;
+    M4OSA_UInt32                    uiClipNumber;
+    M4OSA_FileReadPointer           *pFileReadPtr;
+    M4OSA_Context                   pCache;         /**< Analysis cache, can be M4OSA_NULL */
+    M4OSA_Context                   mutex;          /**< Protects the fields below */
+    M4OSA_UInt32                    uiNextClip;     /**< Next clip to analyse */
+    M4OSA_ERR                       err;            /**< Error of the first failing clip */
+    M4OSA_UInt32                    uiErrClip;      /**< Index of the first failing clip */
+    M4OSA_Context                   semDone;        /**< Posted by each thread when it ends */
+} M4VSS3GPP_AnalysisJob;
+
 
 /**
  ******************************************************************************
@@ -536,6 +584,9 @@ typedef struct
                                                     Array of uiClipNumber-1 transition settings */
     M4VSS3GPP_EffectSettings       *pEffectsList;        /**< List of the effects settings.
                                                              Array of nbEffects RC */
+    M4VFL_ColorLut                **pEffectsLut;         /**< Per plane table of each effect,
+                                                             or M4OSA_NULL if the effect cannot
+                                                             be fused. Array of nbEffects */
     M4OSA_UInt8                       *pActiveEffectsList;    /**< List of the active effects
                                                                 settings. Array of nbEffects RC */
     M4OSA_UInt8                        nbEffects;            /**< Numbers of effects RC */
@@ -610,6 +661,21 @@ typedef struct
 
     M4OSA_Bool bClip1ActiveFramingEffect; /**< Overlay flag for clip1 */
     M4OSA_Bool bClip2ActiveFramingEffect; /**< Overlay flag for clip2, used in transition */
+
+    M4_StepStats            Stats;      /**< Time spent in each stage of the steps */
+
+    /**
+     * Next clip prefetch: the clip after the current one is opened on a thread */
+    M4OSA_Context           pPrefetchThread;    /**< Thread opening the next clip */
+    M4OSA_Context           semPrefetchDone;    /**< Posted when the clip is opened */
+    M4VSS3GPP_ClipContext*  pPrefetchClip;      /**< Clip opened by the thread */
+    M4OSA_UInt8             uiPrefetchClip;     /**< Index of the prefetched clip */
+    M4OSA_ERR               PrefetchErr;        /**< Error returned by the clip opening */
+
+    /**
+     * Stream copy: clip1 has no effect, begin cut nor transition and needs no
+     * transcoding, its AUs are copied in bursts */
+    M4OSA_Bool              bClip1StreamCopy;
 } M4VSS3GPP_InternalEditContext;
 
 
@@ -70,6 +70,19 @@ extern "C" {
  * SWIKAR :Error whan NO_MORE_SPACE*/
 #define M4xVSSERR_NO_MORE_SPACE                       M4OSA_ERR_CREATE( M4_ERR, M4VS, 0x0007)
 
+/**
+ * Maximum number of threads editing the segments of a saving, see M4xVSS_setSaveThreads */
+#define M4xVSS_SAVE_MAX_THREADS                       8
+
+/**
+ * Maximum number of video decoders and encoders used at the same time by the segment
+ * editions of a saving, see M4xVSS_setSaveThreads */
+#define M4xVSS_SAVE_MAX_VIDEO_CODECS                  6
+
+/**
+ * Proxies are only made for the clips higher than this number of lines, see M4xVSS_proxyStart */
+#define M4xVSS_PROXY_MIN_HEIGHT                       480
+
 /**
  ******************************************************************************
  * enum     M4xVSS_VideoEffectType
@@ -89,7 +102,8 @@ typedef enum
     M4xVSS_kVideoEffectType_ZoomOut,                                               /* 265 */
     M4xVSS_kVideoEffectType_Fifties,                                                /*266 */
     M4xVSS_kVideoEffectType_ColorRGB16,                                                /*267 */
-    M4xVSS_kVideoEffectType_Gradient                                                /*268*/
+    M4xVSS_kVideoEffectType_Gradient,                                               /*268*/
+    M4xVSS_kVideoEffectType_ColorLut                                                /*269*/
 } M4xVSS_VideoEffectType;
 
 /**
@@ -581,6 +595,90 @@ M4OSA_ERR M4xVSS_getMCSContext(M4OSA_Context pContext, M4OSA_Context* mcsContext
 */
 M4OSA_ERR M4xVSS_getVSS3GPPContext(M4OSA_Context pContext, M4OSA_Context* vss3gppContext);
 
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_getStatistics(M4OSA_Context pContext,
+ *                                              M4_StepStats* pStats)
+ * @brief        This function returns the time spent in each stage of the steps
+ * @note        The statistics of the transcodings and of the editions are added when
+ *                they are closed, the audio mixing steps are counted in the audio stage.
+ *                The statistics of the session are traced by M4xVSS_CleanUp.
+ *
+ * @param    pContext            (IN) Pointer on the xVSS edit context
+ * @param    pStats            (OUT) Statistics since M4xVSS_Init
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ ******************************************************************************
+*/
+M4OSA_ERR M4xVSS_getStatistics(M4OSA_Context pContext, M4_StepStats* pStats);
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_setSaveThreads(M4OSA_Context pContext,
+ *                                              M4OSA_UInt32 uiNbThreads)
+ * @brief        This function sets the number of threads used to save
+ * @note        With more than one thread, M4xVSS_SaveStart splits the storyboard at the
+ *                clip boundaries without transition nor effect. The segments are edited
+ *                concurrently into temporary files, which are then joined without
+ *                re-encoding. Storyboards that can not be split, MMS and size limited
+ *                savings are still edited by one thread. Fewer threads are used when
+ *                their video codecs would exceed M4xVSS_SAVE_MAX_VIDEO_CODECS, and the
+ *                storyboard is saved again by one thread if a segment fails.
+ *                The default is 1. It is taken into account by the next M4xVSS_SaveStart.
+ *
+ * @param    pContext            (IN) Pointer on the xVSS edit context
+ * @param    uiNbThreads        (IN) Number of threads, 1 to M4xVSS_SAVE_MAX_THREADS
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    pContext is M4OSA_NULL or uiNbThreads is out of range
+ ******************************************************************************
+*/
+M4OSA_ERR M4xVSS_setSaveThreads(M4OSA_Context pContext, M4OSA_UInt32 uiNbThreads);
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_proxyStart(M4OSA_Context pContext,
+ *                                          M4VSS3GPP_ClipSettings* pClip)
+ * @brief        This function starts the background transcoding of the preview proxy of a clip
+ * @note        The proxy is a 360 or 480 lines MPEG-4 copy of the clip, with the same
+ *                duration and audio, written in the temporary path next to the clip
+ *                analysis cache. Its name is given by M4xVSS_proxyGetPath, the file
+ *                only exists once it is complete.
+ *                Nothing is done for the clips which are not higher than
+ *                M4xVSS_PROXY_MIN_HEIGHT, not 16:9 nor 4:3, rotated, or whose proxy is
+ *                up to date or being transcoded. The transcodings run one at a time and
+ *                are cancelled by M4xVSS_CleanUp.
+ *
+ * @param    pContext            (IN) Pointer on the xVSS edit context
+ * @param    pClip                (IN) Clip settings, with the properties filled by
+ *                                M4xVSS_sendCommand
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ * @return    M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+*/
+M4OSA_ERR M4xVSS_proxyStart(M4OSA_Context pContext, M4VSS3GPP_ClipSettings* pClip);
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_proxyGetPath(M4OSA_Char* pTempPath, M4OSA_Void* pClipFile,
+ *                                            M4OSA_Char* pProxyFile, M4OSA_UInt32 uiSize)
+ * @brief        This function gives the file name of the preview proxy of a clip
+ * @note        It does not need an xVSS context, so that the preview can look for the
+ *                proxies. The proxy can be used when the file exists and is not older
+ *                than the clip.
+ *
+ * @param    pTempPath            (IN) xVSS temporary path, as given to M4xVSS_Init
+ * @param    pClipFile            (IN) Clip file, as given in the clip settings
+ * @param    pProxyFile            (OUT) Proxy file name
+ * @param    uiSize                (IN) Size of pProxyFile
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ * @return    M4ERR_CHR_STR_OVERFLOW: pProxyFile is too small
+ ******************************************************************************
+*/
+M4OSA_ERR M4xVSS_proxyGetPath(M4OSA_Char* pTempPath, M4OSA_Void* pClipFile,
+                              M4OSA_Char* pProxyFile, M4OSA_UInt32 uiSize);
+
 // Get supported video decoders and capabilities.
 M4OSA_ERR M4xVSS_getVideoDecoderCapabilities(M4DECODER_VideoDecoders **decoders);
 #ifdef __cplusplus
@@ -35,6 +35,8 @@
 
 #include "M4AIR_API.h"
 
+#include "M4VFL_ColorLut.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -227,6 +229,10 @@ typedef struct
                                                 for SAVING */
     M4OSA_UInt32 shiftRandomValue;                /**< Vertical shift of the image */
       M4OSA_UInt32 stripeRandomValue;                /**< Horizontal position of the stripe */
+    M4OSA_UInt32 randomSeed;        /**< Seed of the random values, same seed gives
+                                         the same output */
+    M4OSA_UInt32 randomCounter;     /**< Number of random values drawn since the
+                                         beginning of the effect */
 
 } M4xVSS_FiftiesStruct;
 
@@ -240,6 +246,7 @@ typedef struct
 {
     M4xVSS_VideoEffectType colorEffectType;    /*Color type of effect*/
     M4OSA_UInt16    rgb16ColorData;            /*RGB16 color only for the RGB16 color effect*/
+    M4VFL_ColorLut  lut;                       /*Color effect compiled once in SendCommand*/
 } M4xVSS_ColorStruct;
 
 
@@ -260,6 +267,8 @@ typedef struct
     M4xVSS_Pto3GPP_params*    m_pPto3GPPparams;
     M4OSA_Context            m_air_context;
     M4xVSS_MediaRendering    m_mediaRendering;
+    M4OSA_Bool                m_bPanZoomConfigured; /* AIR configured with the start and
+                                                       end pan&zoom windows */
 
 } M4xVSS_PictureCallbackCtxt;
 
@@ -290,7 +299,8 @@ typedef enum
 typedef enum
 {
     M4xVSS_kMicroStateEditing = 0,
-    M4xVSS_kMicroStateAudioMixing
+    M4xVSS_kMicroStateAudioMixing,
+    M4xVSS_kMicroStateEditingSegments   /**< Segments edited concurrently, before the join */
 
 } M4xVSS_editMicroState;
 
@@ -410,6 +420,79 @@ typedef struct
 
 
 
+/**
+ ******************************************************************************
+ * struct    M4xVSS_Segment
+ * @brief    Part of the storyboard edited by its own VSS session (parallel saving)
+ ******************************************************************************
+*/
+typedef struct {
+    /**< Edit settings of the segment, the clip and transition lists point into the
+         current edit settings */
+    M4VSS3GPP_EditSettings          Settings;
+    /**< The edited segment file, as a clip of the join */
+    M4VSS3GPP_ClipSettings          Clip;
+    /**< Output duration of the segment, in ms */
+    M4OSA_UInt32                    uiDuration;
+    /**< Progress of the segment edition */
+    M4OSA_UInt8                     uiProgress;
+    /**< The segment edition is over */
+    M4OSA_Bool                      bDone;
+    /**< Result of the segment edition */
+    M4OSA_ERR                       err;
+} M4xVSS_Segment;
+
+/**
+ ******************************************************************************
+ * struct    M4xVSS_SegmentsContext
+ * @brief    Parallel saving: segments, edition threads and join settings
+ ******************************************************************************
+*/
+typedef struct {
+    /**< xVSS context */
+    M4OSA_Context                   pXvssContext;
+    /**< Segments, in storyboard order */
+    M4xVSS_Segment*                 pSegments;
+    M4OSA_UInt32                    uiNbSegments;
+    /**< Next segment to edit, number of segments edited */
+    M4OSA_UInt32                    uiNextSegment;
+    M4OSA_UInt32                    uiNbDone;
+    /**< The threads must stop as soon as possible */
+    M4OSA_Bool                      bAbort;
+    /**< Error of the first failing segment, M4NO_ERROR if none */
+    M4OSA_ERR                       errFailed;
+    /**< Protects the above fields, the segments progress and the statistics */
+    M4OSA_Context                   mutex;
+    /**< Posted each time a segment edition is over */
+    M4OSA_Context                   semDone;
+    M4OSA_Context                   pThreads[M4xVSS_SAVE_MAX_THREADS];
+    M4OSA_UInt32                    uiNbThreads;
+    /**< Edit settings joining the segment files into the output file */
+    M4VSS3GPP_EditSettings          JoinSettings;
+    M4VSS3GPP_TransitionSettings*   pJoinTransitions;
+    /**< Statistics of the segment editions */
+    M4_StepStats                    Stats;
+} M4xVSS_SegmentsContext;
+
+/**
+ ******************************************************************************
+ * struct    M4xVSS_ProxyJob
+ * @brief    Preview proxy being transcoded, see M4xVSS_proxyStart
+ ******************************************************************************
+*/
+typedef struct {
+    /**< Batch job identifier */
+    M4OSA_UInt32                    uiJobId;
+    /**< Clip, temporary output and proxy files, in the customer format */
+    M4OSA_Void*                     pClipFile;
+    M4OSA_Void*                     pTempFile;
+    M4OSA_Void*                     pProxyFile;
+    /**< The job is done, failed or cancelled */
+    M4OSA_Bool                      bFinished;
+    /**< Address of next M4xVSS_ProxyJob* element */
+    M4OSA_Void*                     pNext;
+} M4xVSS_ProxyJob;
+
 /**
  ******************************************************************************
  * struct    M4xVSS_Context
@@ -480,6 +563,26 @@ typedef struct {
     /*UTF Conversion support*/
     M4xVSS_UTFConversionContext    UTFConversionContext;    /*UTF conversion context structure*/
 
+    /**< Clip analyses of the previous editions, M4OSA_NULL if not available */
+    M4OSA_Context                   pAnalysisCache;
+    /**< Input file properties (MCS) of the previous sendCommand, M4OSA_NULL if not available */
+    M4OSA_Context                   pPropertiesCache;
+
+    /**< Time spent in each stage of the MCS, VSS and audio mixing steps of the session */
+    M4_StepStats                    Stats;
+
+    /**< Number of threads used to save, see M4xVSS_setSaveThreads */
+    M4OSA_UInt32                    uiSaveThreads;
+    /**< Parallel saving context (M4xVSS_SegmentsContext), M4OSA_NULL if not used */
+    M4OSA_Context                   pSegments;
+
+    /**< Preview proxy transcodings (M4MCS_batchOpen), M4OSA_NULL until the first one */
+    M4MCS_BatchContext              pProxyBatch;
+    /**< Chained list of the proxies started by M4xVSS_proxyStart */
+    M4xVSS_ProxyJob*                pProxyJobs;
+    /**< Protects pProxyJobs against the batch progress callback */
+    M4OSA_Context                   pProxyMutex;
+
 } M4xVSS_Context;
 
 /**
@@ -529,8 +632,22 @@ M4OSA_ERR M4xVSS_internalConvertARGB888toYUV420_FrammingEffect(M4OSA_Context pCo
                                                                M4VIDEOEDITING_VideoFrameSize \
                                                                     OutputVideoResolution);
 
+M4OSA_ERR M4xVSS_internalBuildColorLut(M4OSA_Context pContext, M4xVSS_ColorStruct* pColorCtx,
+                                       M4VSS3GPP_EffectSettings* pEffect);
+
+M4OSA_ERR M4xVSS_internalOpenEdition(M4OSA_Context pContext, M4VSS3GPP_EditSettings* pSettings,
+                                     M4VSS3GPP_EditContext* pVssCtxt);
+
 M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext);
 
+M4OSA_ERR M4xVSS_internalStartSegments(M4OSA_Context pContext, M4OSA_Bool* pbStarted);
+
+M4OSA_ERR M4xVSS_internalStepSegments(M4OSA_Context pContext, M4OSA_UInt8* pProgress);
+
+M4OSA_ERR M4xVSS_internalStopSegments(M4OSA_Context pContext);
+
+M4OSA_ERR M4xVSS_internalStopProxies(M4OSA_Context pContext);
+
 M4OSA_ERR M4xVSS_internalCloseEditedFile(M4OSA_Context pContext);
 
 M4OSA_ERR M4xVSS_internalGenerateAudioMixFile(M4OSA_Context pContext);
@@ -578,6 +695,8 @@ M4OSA_ERR M4xVSS_internalConvertToUTF8(M4OSA_Context pContext, M4OSA_Void* pBuff
 
 M4OSA_ERR M4xVSS_internalConvertFromUTF8(M4OSA_Context pContext, M4OSA_Void* pBufferIn,
                                          M4OSA_Void* pBufferOut, M4OSA_UInt32* convertedSize);
+
+M4OSA_ERR M4xVSS_internalAnalysisCacheIndex(M4OSA_Context pContext, M4OSA_Bool bSave);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -45,6 +45,10 @@
  * Common definitions of video editing components */
 #include "M4_VideoEditingCommon.h"
 
+/**
+ * Step loop statistics */
+#include "M4_StepStats.h"
+
 /**
  * To enable external audio codecs registering*/
 #include "M4AD_Common.h"
@@ -309,6 +313,61 @@ typedef struct
     /*--- STILL PICTURE ---*/
 } M4MCS_EncodingParams;
 
+/**
+ ******************************************************************************
+ * enum      M4MCS_BatchJobState
+ * @brief    State of a job of a batch transcoding queue
+ ******************************************************************************
+ */
+typedef enum
+{
+    M4MCS_kBatchJobPending = 0,     /**< Waiting for a free lane */
+    M4MCS_kBatchJobRunning,         /**< Being transcoded */
+    M4MCS_kBatchJobDone,            /**< Transcoded, the output file is complete */
+    M4MCS_kBatchJobFailed,          /**< Stopped on an error */
+    M4MCS_kBatchJobCancelled        /**< Cancelled by M4MCS_batchCancelJob or M4MCS_batchClose */
+} M4MCS_BatchJobState;
+
+/**
+ ******************************************************************************
+ * struct    M4MCS_BatchJob
+ * @brief    One transcoding of a batch queue, i.e. the parameters of the M4MCS_open,
+ *           M4MCS_setOutputParams and M4MCS_setEncodingParams calls
+ * @note     The file descriptors must stay valid until the job is finished
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_Void*                 pInputFile;     /**< Input file to transcode */
+    M4VIDEOEDITING_FileType     InputFileType;  /**< Container type of the input file */
+    M4OSA_Void*                 pOutputFile;    /**< Output file to create */
+    M4OSA_Void*                 pTempFile;      /**< Temporary file for the moov, or M4OSA_NULL */
+    M4MCS_OutputParams          OutputParams;
+    M4MCS_EncodingParams        EncodingParams;
+    M4OSA_Bool                  bTwoPassRateControl; /**< Passed to M4MCS_setTwoPassRateControl */
+} M4MCS_BatchJob;
+
+/**
+ ******************************************************************************
+ * prototype M4MCS_BatchProgressFct
+ * @brief    Called by the lane running a job each time its progress or state changes
+ * @note     Called without any batch lock held, from a lane thread (or from the
+ *           M4MCS_batchCancelJob/M4MCS_batchClose caller for pending jobs)
+ * @param    pUserData   (IN) User data given to M4MCS_batchOpen
+ * @param    uiJobId     (IN) Identifier returned by M4MCS_batchAddJob
+ * @param    state       (IN) Job state
+ * @param    uiProgress  (IN) Job progress, 0..100
+ * @param    err         (IN) Job result (M4NO_ERROR while running)
+ ******************************************************************************
+ */
+typedef M4OSA_Void (*M4MCS_BatchProgressFct)(M4OSA_Void* pUserData, M4OSA_UInt32 uiJobId,
+                                             M4MCS_BatchJobState state, M4OSA_UInt8 uiProgress,
+                                             M4OSA_ERR err);
+
+/**
+ * Batch transcoding queue context */
+typedef M4OSA_Void* M4MCS_BatchContext;
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_getVersion(M4_VersionInfo* pVersionInfo);
@@ -460,6 +519,39 @@ M4OSA_ERR M4MCS_cleanUp(M4MCS_Context pContext);
  */
 M4OSA_ERR M4MCS_abort(M4MCS_Context pContext);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_reset(M4MCS_Context pContext);
+ * @brief    Finish the MCS transcoding whatever the state is, and make the context
+ *          ready for a new M4MCS_open.
+ * @note    Same as M4MCS_abort followed by M4MCS_init, but the media and codecs
+ *          shells registered by M4MCS_init are kept. After M4MCS_close, the video
+ *          encoder is kept stopped and started again by the next transcoding if it
+ *          has the same output format, size, frame rate, bitrate, profile and level.
+ * @param    pContext            (IN) MCS context
+ * @return    M4NO_ERROR:            No error
+ * @return    M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return    M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_reset(M4MCS_Context pContext);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_getStatistics(M4MCS_Context pContext, M4_StepStats* pStats);
+ * @brief    Get the cumulative time spent in each stage of the transcoding.
+ * @note    The video reads are done by the decoder, they are counted in the decode
+ *          stage. The encoded video AUs are written by the encoder, in the encode
+ *          stage. The statistics are traced as a JSON summary by M4MCS_close and reset
+ *          by M4MCS_reset.
+ * @param    pContext            (IN) MCS context
+ * @param    pStats                (OUT) Statistics
+ * @return    M4NO_ERROR:            No error
+ * @return    M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only)
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_getStatistics(M4MCS_Context pContext, M4_StepStats* pStats);
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_getInputFileProperties(M4MCS_Context pContext,
@@ -567,6 +659,132 @@ M4OSA_ERR M4MCS_getExtendedEncodingParams(M4MCS_Context pContext, M4MCS_Encoding
  */
 M4OSA_ERR M4MCS_checkParamsAndStart(M4MCS_Context pContext);
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_setConcurrentAudio(M4MCS_Context pContext, M4OSA_Bool bConcurrent)
+ * @brief   Runs the audio transcoding on its own thread.
+ * @note    Only used when both the audio and the video streams are processed and the
+ *          audio is re-encoded. The audio steps are written by M4MCS_step as without
+ *          the thread, so the output file is the same.
+ *          Must be called before the first M4MCS_step.
+ * @param   pContext            (IN) MCS context
+ * @param   bConcurrent         (IN) M4OSA_TRUE to use the audio thread
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return  M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_setConcurrentAudio(M4MCS_Context pContext, M4OSA_Bool bConcurrent);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_setTwoPassRateControl(M4MCS_Context pContext, M4OSA_Bool bTwoPass)
+ * @brief   Fits the video bitrate to the maximum output file size with a first pass.
+ * @note    Only used when an output file size is set and the video is re-encoded.
+ *          M4MCS_checkParamsAndStart then reads the input AUs in the cut range once,
+ *          without decoding them, to measure the audio size and the complexity
+ *          variation between GOPs, and encodes the video at the bitrate filling the
+ *          file size minus a margin growing with that variation, instead of the
+ *          rounded down bitrate of M4MCS_setEncodingParams. This bitrate never
+ *          exceeds the requested video bitrate nor the input one.
+ *          Must be called before M4MCS_checkParamsAndStart.
+ * @param   pContext            (IN) MCS context
+ * @param   bTwoPass            (IN) M4OSA_TRUE to run the first pass
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return  M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_setTwoPassRateControl(M4MCS_Context pContext, M4OSA_Bool bTwoPass);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchOpen(M4MCS_BatchContext* pContext, M4OSA_UInt32 uiNbLanes,
+ *                           M4OSA_FileReadPointer* pFileReadPtrFct,
+ *                           M4OSA_FileWriterPointer* pFileWritePtrFct,
+ *                           M4MCS_BatchProgressFct pProgressFct, M4OSA_Void* pUserData)
+ * @brief    Creates a batch transcoding queue with uiNbLanes parallel lanes.
+ * @note     Each lane owns one MCS context, initialized once and reset between its
+ *           jobs (M4MCS_reset) so that the media and codecs shells are kept. A lane
+ *           video encoder is kept warm across its jobs with the same encoder settings.
+ * @param    pContext            (OUT) Batch context
+ * @param    uiNbLanes           (IN) Number of jobs transcoded at the same time
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param    pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
+ * @param    pProgressFct        (IN) Progress callback, can be M4OSA_NULL
+ * @param    pUserData           (IN) Given back to pProgressFct
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL or uiNbLanes is 0
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchOpen(M4MCS_BatchContext* pContext, M4OSA_UInt32 uiNbLanes,
+                          M4OSA_FileReadPointer* pFileReadPtrFct,
+                          M4OSA_FileWriterPointer* pFileWritePtrFct,
+                          M4MCS_BatchProgressFct pProgressFct, M4OSA_Void* pUserData);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchAddJob(M4MCS_BatchContext pContext, M4MCS_BatchJob* pJob,
+ *                             M4OSA_UInt32* pJobId)
+ * @brief    Queues a transcoding. Jobs are started in the order they are added.
+ * @param    pContext            (IN) Batch context
+ * @param    pJob                (IN) Job parameters, copied
+ * @param    pJobId              (OUT) Job identifier
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ * @return   M4ERR_STATE:        The batch is being closed
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchAddJob(M4MCS_BatchContext pContext, M4MCS_BatchJob* pJob,
+                            M4OSA_UInt32* pJobId);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchCancelJob(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId)
+ * @brief    Cancels a pending or running job.
+ * @note     A running job is stopped at its next step, its output file is incomplete.
+ * @param    pContext            (IN) Batch context
+ * @param    uiJobId             (IN) Job identifier
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    Unknown job identifier
+ * @return   M4ERR_STATE:        The job is already finished
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchCancelJob(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchGetJobStatus(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId,
+ *                                   M4MCS_BatchJobState* pState, M4OSA_UInt8* pProgress,
+ *                                   M4OSA_ERR* pJobErr)
+ * @brief    Gets the state, the progress and the result of a job.
+ * @param    pContext            (IN) Batch context
+ * @param    uiJobId             (IN) Job identifier
+ * @param    pState              (OUT) Job state
+ * @param    pProgress           (OUT) Job progress, 0..100
+ * @param    pJobErr             (OUT) Job result, M4NO_ERROR if not finished or done
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    Unknown job identifier or a parameter is M4OSA_NULL
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchGetJobStatus(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId,
+                                  M4MCS_BatchJobState* pState, M4OSA_UInt8* pProgress,
+                                  M4OSA_ERR* pJobErr);
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchClose(M4MCS_BatchContext pContext)
+ * @brief    Cancels the pending and running jobs, stops the lanes and frees the batch.
+ * @note     To wait for all the jobs, call it once they are all finished.
+ * @param    pContext            (IN) Batch context
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    pContext is M4OSA_NULL
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchClose(M4MCS_BatchContext pContext);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -46,6 +46,8 @@
 /* Indicate that picture will be automatically resized to fit into the required
    parameters (file size) */
 #define M4MCS_WAR_PICTURE_AUTO_RESIZE        M4OSA_ERR_CREATE( M4_WAR, M4MCS, 0x3)
+/* The batch job has been cancelled before its end */
+#define M4MCS_WAR_BATCH_JOB_CANCELLED        M4OSA_ERR_CREATE( M4_WAR, M4MCS, 0x4)
 
 /************************************************************************/
 /* Error codes                                                          */
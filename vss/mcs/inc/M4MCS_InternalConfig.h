@@ -71,5 +71,23 @@
    jump backward to a specified limit */
 #define M4MCS_NO_STSS_JUMP_POINT          40000 /**< 40 s */
 
+/**
+ * H.264 trimming: how far after the begin cut a sync sample is looked for before
+   re-encoding the whole cut */
+#define M4MCS_H264_RAP_SEARCH_MAX_TIME    10000 /**< 10 s */
+
+/**
+ * Number of audio steps the concurrent audio thread can do ahead of the writer */
+#define M4MCS_AUDIO_STEP_QUEUE_SIZE       8
+
+/**
+ * Two-pass rate control: moov size estimation and margin bounds */
+#define M4MCS_TWO_PASS_MOOV_FIXED_BYTES   4096  /**< Headers and boxes independent of the AUs */
+#define M4MCS_TWO_PASS_MOOV_BYTES_PER_AU  16    /**< Sample tables, per AU */
+#define M4MCS_TWO_PASS_AUDIO_AU_DURATION  20    /**< Estimated encoded audio AU duration, ms */
+#define M4MCS_TWO_PASS_MIN_MARGIN         1     /**< Margin for even content, in % of size */
+#define M4MCS_TWO_PASS_MAX_MARGIN         6     /**< Margin for very uneven content, in % */
+#define M4MCS_TWO_PASS_INITIAL_GOPS       64    /**< GOP entries allocated first, then doubled */
+
 #endif /* __M4MCS_INTERNALCONFIG_H__ */
 
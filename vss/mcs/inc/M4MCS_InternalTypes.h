@@ -141,6 +141,37 @@ enum
     M4MCS_kEncoderRunning
 };
 
+/**
+ ******************************************************************************
+ * structure    M4MCS_AudioStep
+ * @brief       Result of one audio transcoding step done by the audio thread
+ * @note        The audio thread never calls the writer: the encoded AU is kept
+ *              here until M4MCS_step writes it, in the same order and at the
+ *              same place in the file as without the thread.
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_ERR               err;            /**< Result of the step */
+    M4_MediaTime            dReaderCts;     /**< Reader audio CTS after the step */
+    M4OSA_UInt32            uiAUDuration;   /**< Audio AU duration after the step */
+    M4OSA_Bool              bAU;            /**< An AU has been encoded by the step */
+    M4SYS_AccessUnit        AU;             /**< Encoded AU (size and CTS) */
+    M4OSA_MemAddr8          pData;          /**< Encoded AU data, uiAudioMaxAuSize bytes */
+} M4MCS_AudioStep;
+
+/**
+ ******************************************************************************
+ * structure    M4MCS_TwoPassGop
+ * @brief       One GOP of the input video, as measured by the two-pass first pass
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_Double            dBytes;         /**< Size of the GOP AUs in the input */
+    M4OSA_Double            dDuration;      /**< Duration of the GOP, in ms */
+} M4MCS_TwoPassGop;
+
 /**
  ******************************************************************************
  * structure    M4MCS_InternalContext
@@ -162,11 +193,9 @@ typedef struct
     M4OSA_UInt32    currBuff;
                 /* Current buffer holds, 4bytes of bitstream*/
 
-    M4OSA_UInt8   prevByte;
-                /* Previous byte written in the buffer */
-
-    M4OSA_UInt8   prevPrevByte;
-                /* Previous to previous byte written in the buffer */
+    M4OSA_UInt32    zeroCnt;
+                /* Number of zero bytes ending the bitstream buffer, for the
+                   emulation prevention */
 
 }NSWAVC_bitStream_t_MCS;
 
@@ -460,6 +489,15 @@ typedef struct
     M4OSA_UInt32          uiEncVideoBitrate;  /**< Actual video bitrate for the video encoder */
     M4OSA_UInt32          outputVideoTimescale;
     M4OSA_UInt32          encoderState;
+    M4ENCODER_AdvancedParams VideoEncParams;  /**< Settings the video encoder was opened with*/
+
+    /**
+     * Video encoder kept stopped by M4MCS_reset, started again by the next transcoding
+       with the same settings (M4OSA_NULL if none) */
+    M4OSA_Context               pKeptViEncCtxt;
+    M4ENCODER_GlobalInterface*  pKeptVideoEncoderGlobalFcts;
+    M4WRITER_DataInterface*     pKeptWriterDataFcts;
+    M4ENCODER_AdvancedParams    KeptVideoEncParams;
 
     /**
      * Audio decoder stuff */
@@ -594,13 +632,84 @@ typedef struct
     M4OSA_UInt32            H264MCSTempBufferSize;
     M4OSA_UInt32            H264MCSTempBufferDataSize;
     M4OSA_Bool              bH264Trim;
+    /* CTS of the first sync sample after the begin cut, -1 if none: the video is
+       re-encoded up to it, then copied */
+    M4OSA_Int32             iH264NextRapCts;
     /* Flag when to get  lastdecodedframeCTS */
     M4OSA_Bool              bLastDecodedFrameCTS;
     M4OSA_Int32             encodingVideoProfile;
     M4OSA_Int32             encodingVideoLevel;
 
+    /**
+     * Concurrent audio transcoding */
+    M4OSA_Bool              bConcurrentAudio;   /**< Set by M4MCS_setConcurrentAudio */
+    M4OSA_Bool              bTwoPassRateControl;/**< Set by M4MCS_setTwoPassRateControl */
+    M4OSA_Context           pAudioThread;       /**< Audio thread, M4OSA_NULL if not started */
+    M4OSA_Bool              bAudioThreadStop;   /**< Asks the audio thread to exit */
+    M4OSA_Context           semAudioStepFree;   /**< Free steps in the queue */
+    M4OSA_Context           semAudioStepReady;  /**< Steps done by the thread, not written */
+    M4MCS_AudioStep         *pAudioSteps;       /**< M4MCS_AUDIO_STEP_QUEUE_SIZE steps */
+    M4OSA_UInt32            uiAudioStepWrite;   /**< Next step done by the thread */
+    M4OSA_UInt32            uiAudioStepRead;    /**< Next step written by M4MCS_step */
+    M4_MediaTime            dAudioStepCts;      /**< Reader audio CTS of the last written step*/
+    M4OSA_UInt32            uiAudioStepDuration;/**< Audio AU duration of the last written step*/
+
+    M4_StepStats            Stats;              /**< Returned by M4MCS_getStatistics */
+
 } M4MCS_InternalContext;
 
+/**
+ ******************************************************************************
+ * structure    M4MCS_BatchJobEntry
+ * @brief       A job of a batch queue and its status
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4MCS_BatchJob          job;
+    M4MCS_BatchJobState     state;
+    M4OSA_UInt8             uiProgress;
+    M4OSA_ERR               err;
+    M4OSA_Bool              bCancel;    /**< Stop the running job at its next step */
+} M4MCS_BatchJobEntry;
+
+/**
+ ******************************************************************************
+ * structure    M4MCS_BatchLane
+ * @brief       A batch lane: one thread and one MCS context reused by its jobs
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_Void              *pBatch;    /**< M4MCS_BatchInternalContext */
+    M4OSA_Context           pThread;
+    M4MCS_Context           pMcs;
+} M4MCS_BatchLane;
+
+/**
+ ******************************************************************************
+ * structure    M4MCS_BatchInternalContext
+ * @brief       Batch transcoding queue context (private)
+ * @note        pJobs, uiNbJobs, uiNextJob, bClosing and the job status are
+ *              protected by mutex
+ ******************************************************************************
+ */
+typedef struct
+{
+    M4OSA_Context           mutex;
+    M4OSA_Context           semJobs;    /**< Posted once per added job, and per lane
+                                             on close */
+    M4MCS_BatchJobEntry     *pJobs;
+    M4OSA_UInt32            uiNbJobs;
+    M4OSA_UInt32            uiMaxJobs;  /**< Allocated entries in pJobs */
+    M4OSA_UInt32            uiNextJob;  /**< First job that may be pending */
+    M4OSA_Bool              bClosing;
+    M4MCS_BatchLane         *pLanes;
+    M4OSA_UInt32            uiNbLanes;
+    M4MCS_BatchProgressFct  pProgressFct;
+    M4OSA_Void              *pUserData;
+} M4MCS_BatchInternalContext;
+
 
 #endif /* __M4MCS_INTERNALTYPES_H__ */
 
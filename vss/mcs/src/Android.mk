@@ -27,6 +27,7 @@ LOCAL_MODULE:= libvideoeditor_mcs
 LOCAL_SRC_FILES:=          \
       M4MCS_API.c \
       M4MCS_AudioEffects.c \
+      M4MCS_Batch.c \
       M4MCS_Codecs.c \
       M4MCS_MediaAndCodecSubscription.c \
       M4MCS_VideoPreProcessing.c
@@ -31,6 +31,8 @@
  * OSAL headers */
 #include "M4OSA_Memory.h" /**< OSAL memory management */
 #include "M4OSA_Debug.h"  /**< OSAL debug management */
+#include "M4OSA_Thread.h" /**< OSAL thread management */
+#include "M4OSA_Semaphore.h"
 
 /* PCM samples */
 #include "VideoEditorResampler.h"
@@ -41,6 +43,8 @@
 /* Encoder interface*/
 #include "M4ENCODER_common.h"
 
+#include <math.h>
+
 /* Enable for DEBUG logging */
 //#define MCS_DUMP_PCM_TO_FILE
 #ifdef MCS_DUMP_PCM_TO_FILE
@@ -71,6 +75,7 @@ FILE *file_pcm_encoder = NULL;
 #endif /* M4VSS_ENABLE_EXTERNAL_DECODERS */
 
 #include "M4AIR_API.h"
+#include "M4VD_Tools.h"
 #include "OMX_Video.h"
 
 /* Version */
@@ -89,6 +94,11 @@ static M4OSA_ERR M4MCS_intPrepareVideoDecoder(
                                     M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intPrepareVideoEncoder(
                                     M4MCS_InternalContext *pC );
+static M4OSA_ERR M4MCS_intCreateVideoEncoder(
+                                    M4MCS_InternalContext *pC,
+                                    M4ENCODER_AdvancedParams *pEncParams );
+static M4OSA_Void M4MCS_intDestroyKeptVideoEncoder(
+                                    M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intPrepareAudioProcessing(
                                     M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intPrepareWriter( M4MCS_InternalContext *pC );
@@ -101,8 +111,12 @@ static M4OSA_ERR M4MCS_intStepBeginVideoJump(
                                     M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intStepBeginVideoDecode(
                                     M4MCS_InternalContext *pC );
+static M4OSA_ERR M4MCS_intFindNextVideoRap( M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intAudioNullEncoding( M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intAudioTranscoding( M4MCS_InternalContext *pC );
+static M4OSA_ERR M4MCS_intStartAudioThread( M4MCS_InternalContext *pC );
+static M4OSA_Void M4MCS_intStopAudioThread( M4MCS_InternalContext *pC );
+static M4OSA_ERR M4MCS_intWriteAudioStep( M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intVideoTranscoding( M4MCS_InternalContext *pC );
 static M4OSA_ERR M4MCS_intGetInputClipProperties(
@@ -112,6 +126,7 @@ static M4OSA_UInt32 M4MCS_intGetFrameSize_AMRNB(
 static M4OSA_UInt32 M4MCS_intGetFrameSize_EVRC(
                                     M4OSA_MemAddr8 pAudioFrame );
 static M4OSA_ERR M4MCS_intCheckMaxFileSize( M4MCS_Context pContext );
+static M4OSA_ERR M4MCS_intTwoPassAnalysis( M4MCS_InternalContext *pC );
 static M4VIDEOEDITING_Bitrate M4MCS_intGetNearestBitrate(
                                     M4OSA_Int32 freebitrate,
                                     M4OSA_Int8 mode );
@@ -409,17 +424,66 @@ M4OSA_ERR NSWAVCMCS_initBitstream( NSWAVC_bitStream_t_MCS *bS )
     bS->bitPos = 0;
     bS->byteCnt = 0;
     bS->currBuff = 0;
-    bS->prevByte = 0xff;
-    bS->prevPrevByte = 0xff;
+    bS->zeroCnt = 0;
 
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_Void NSWAVCMCS_writeByte(NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt8 byte)
+ * @brief    Writes a byte in the bitstream buffer, with the emulation prevention
+ * @note    0x03 is inserted before a byte lower than 4 that follows two zero bytes.
+ *            The buffer must be large enough for the inserted bytes.
+ ******************************************************************************
+ */
+static M4OSA_Void NSWAVCMCS_writeByte( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt8 byte )
+{
+    if( ( bS->zeroCnt >= 2) && (!(byte & 0xFC)) )
+    {
+        bS->streamBuffer[bS->byteCnt++] = 0x03;
+        bS->zeroCnt = 0;
+    }
+    bS->streamBuffer[bS->byteCnt++] = byte;
+    bS->zeroCnt = (0 == byte) ? bS->zeroCnt + 1 : 0;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void NSWAVCMCS_writeWord(NSWAVC_bitStream_t_MCS *bS)
+ * @brief    Writes the 4 bytes of the current buffer in the bitstream buffer
+ * @note    The bytes are escaped as they are written, see NSWAVCMCS_writeByte. A word
+ *            without zero byte that does not follow a zero byte cannot need any
+ *            emulation prevention byte, it is stored at once.
+ ******************************************************************************
+ */
+static M4OSA_Void NSWAVCMCS_writeWord( NSWAVC_bitStream_t_MCS *bS )
+{
+    M4OSA_UInt32 word = bS->currBuff;
+    M4OSA_UInt8 *pDst;
+
+    if( ( 0 == bS->zeroCnt)
+        && (0 == ((word - 0x01010101) & ~word & 0x80808080)) )
+    {
+        pDst = bS->streamBuffer + bS->byteCnt;
+        pDst[0] = (M4OSA_UInt8)(word >> 24);
+        pDst[1] = (M4OSA_UInt8)(( word >> 16) & 0xff);
+        pDst[2] = (M4OSA_UInt8)(( word >> 8) & 0xff);
+        pDst[3] = (M4OSA_UInt8)(word & 0xff);
+        bS->byteCnt += 4;
+        return;
+    }
+
+    NSWAVCMCS_writeByte(bS, (M4OSA_UInt8)(word >> 24));
+    NSWAVCMCS_writeByte(bS, (M4OSA_UInt8)(( word >> 16) & 0xff));
+    NSWAVCMCS_writeByte(bS, (M4OSA_UInt8)(( word >> 8) & 0xff));
+    NSWAVCMCS_writeByte(bS, (M4OSA_UInt8)(word & 0xff));
+}
+
 M4OSA_ERR NSWAVCMCS_putBits( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value,
                             M4OSA_UInt8 length )
 {
     M4OSA_UInt32 maskedValue = 0, temp = 0;
-    M4OSA_UInt8 byteOne;
 
     M4OSA_UInt32 len1 = (length == 32) ? 31 : length;
 
@@ -442,70 +506,14 @@ M4OSA_ERR NSWAVCMCS_putBits( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value,
 
         bS->currBuff |= (maskedValue >> (temp));
 
-        byteOne =
-            bS->streamBuffer[bS->byteCnt++] = (M4OSA_UInt8)(bS->currBuff >> 24);
-
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)(( bS->currBuff >> 16) & 0xff);
-
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)(( bS->currBuff >> 8) & 0xff);
+        NSWAVCMCS_writeWord(bS);
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)((bS->currBuff) &0xff);
+        bS->currBuff = 0;
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
+        if( temp )
         {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
+            bS->currBuff |= ( maskedValue &(( 1 << temp) - 1)) << (32 - temp);
         }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-
-        bS->currBuff = 0;
-
-        bS->currBuff |= ( maskedValue &(( 1 << temp) - 1)) << (32 - temp);
 
         bS->bitPos = temp;
     }
@@ -515,8 +523,7 @@ M4OSA_ERR NSWAVCMCS_putBits( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value,
 
 M4OSA_ERR NSWAVCMCS_putBit( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value )
 {
-    M4OSA_UInt32 maskedValue = 0, temp = 0;
-    M4OSA_UInt8 byteOne;
+    M4OSA_UInt32 maskedValue = 0;
 
     maskedValue = (value ? 1 : 0);
 
@@ -527,74 +534,33 @@ M4OSA_ERR NSWAVCMCS_putBit( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value )
     }
     else
     {
-        temp = 0;
-
         bS->currBuff |= (maskedValue);
 
         /* writing it to memory*/
-        byteOne =
-            bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)(bS->currBuff >> 24);
+        NSWAVCMCS_writeWord(bS);
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)(( bS->currBuff >> 16) & 0xff);
+        bS->currBuff = 0;
+        bS->bitPos = 0;
+    }
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)(( bS->currBuff >> 8) & 0xff);
+    return M4NO_ERROR;
+}
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        byteOne = bS->streamBuffer[bS->byteCnt++] =
-            (M4OSA_UInt8)((bS->currBuff) &0xff);
+/**
+ ******************************************************************************
+ * M4OSA_ERR NSWAVCMCS_flushBits(NSWAVC_bitStream_t_MCS *bS)
+ * @brief    Ends the NAL unit written in the bitstream buffer
+ * @note    Writes the complete bytes still in the current buffer, escaped as the
+ *            previous ones. Must be called once, on a byte aligned bitstream.
+ ******************************************************************************
+ */
+M4OSA_ERR NSWAVCMCS_flushBits( NSWAVC_bitStream_t_MCS *bS )
+{
+    M4OSA_UInt32 i;
 
-        if( (( bS->prevPrevByte
-            == 0) & (bS->prevByte == 0) & (!(byteOne & 0xFC))) )
-        {
-            bS->byteCnt -= 1;
-            bS->prevPrevByte = bS->streamBuffer[bS->byteCnt++] = 0x03;
-            bS->prevByte = bS->streamBuffer[bS->byteCnt++] = byteOne;
-        }
-        else
-        {
-            bS->prevPrevByte = bS->prevByte;
-            bS->prevByte = byteOne;
-        }
-        bS->currBuff = 0;
-        bS->bitPos = 0;
+    for ( i = 0; i < (bS->bitPos >> 3); i++ )
+    {
+        NSWAVCMCS_writeByte(bS, (M4OSA_UInt8)(( bS->currBuff >> (24 - (i << 3))) & 0xff));
     }
 
     return M4NO_ERROR;
@@ -603,7 +569,6 @@ M4OSA_ERR NSWAVCMCS_putBit( NSWAVC_bitStream_t_MCS *bS, M4OSA_UInt32 value )
 M4OSA_Int32 NSWAVCMCS_putRbspTbits( NSWAVC_bitStream_t_MCS *bS )
 {
     M4OSA_UInt8 trailBits = 0;
-    M4OSA_UInt8 byteCnt = 0;
 
     trailBits = (M4OSA_UInt8)(bS->bitPos % 8);
 
@@ -626,37 +591,7 @@ M4OSA_Int32 NSWAVCMCS_putRbspTbits( NSWAVC_bitStream_t_MCS *bS )
         }
     }
 
-    /* For writting the currBuff in streamBuff 4byte alignment is required*/
-    byteCnt = (M4OSA_UInt8)(( bS->bitPos + 4) / 8);
-
-    switch( byteCnt )
-    {
-        case 1:
-            bS->streamBuffer[bS->byteCnt++] = (M4OSA_UInt8)(bS->currBuff >> 24);
-            break;
-
-        case 2:
-            bS->streamBuffer[bS->byteCnt++] = (M4OSA_UInt8)(bS->currBuff >> 24);
-            bS->streamBuffer[bS->byteCnt++] =
-                (M4OSA_UInt8)(( bS->currBuff >> 16) & 0xff);
-            break;
-
-        case 3:
-            bS->streamBuffer[bS->byteCnt++] = (M4OSA_UInt8)(bS->currBuff >> 24);
-            bS->streamBuffer[bS->byteCnt++] =
-                (M4OSA_UInt8)(( bS->currBuff >> 16) & 0xff);
-            bS->streamBuffer[bS->byteCnt++] =
-                (M4OSA_UInt8)(( bS->currBuff >> 8) & 0xff);
-
-            break;
-
-        default:
-            /* It will not come here */
-            break;
-    }
-
-    //    bS->bitPos =0;
-    //    bS->currBuff = 0;
+    NSWAVCMCS_flushBits(bS);
 
     return M4NO_ERROR;
 }
@@ -991,6 +926,7 @@ M4OSA_ERR H264MCS_ProcessEncodedNALU(   M4OSA_Void *ainstance,
                     NSWAVCMCS_putBits(&instance->encbs, 0,
                         (8 - instance->encbs.bitPos % 8));
                 }
+                NSWAVCMCS_flushBits(&instance->encbs);
             }
 
             temp = instance->encbs.byteCnt;
@@ -1958,6 +1894,7 @@ M4OSA_ERR H264MCS_ProcessNALU( NSWAVC_MCS_t *ainstance, M4OSA_UInt8 *inbuff,
                     NSWAVCMCS_putBits(&instance->encbs, 0,
                         (8 - instance->encbs.bitPos % 8));
                 }
+                NSWAVCMCS_flushBits(&instance->encbs);
             }
 
             temp = instance->encbs.byteCnt;
@@ -2001,50 +1938,6 @@ M4OSA_ERR H264MCS_ProcessNALU( NSWAVC_MCS_t *ainstance, M4OSA_UInt8 *inbuff,
     return M4NO_ERROR;
 }
 
-M4OSA_ERR   M4MCS_convetFromByteStreamtoNALStream(  M4OSA_UInt8 *inbuff,
-                                                    M4OSA_UInt32 inbuf_size )
-{
-    M4OSA_ERR err = M4NO_ERROR;
-    M4OSA_UInt32 framesize = 0;
-    M4OSA_UInt32 nal_size =0;
-    M4OSA_UInt8 *buff;
-
-
-    while(framesize < inbuf_size)
-    {
-            nal_size = inbuf_size - framesize - 4;
-            buff =  inbuff + framesize + 4;
-
-            while(nal_size > 4){
-                if((buff[0] == 0x00) &&
-                (buff[1] == 0x00) &&
-                (buff[2] == 0x00) &&
-                (buff[3] == 0x01)){
-                    break;
-                }
-                buff = buff + 1;
-                nal_size = nal_size -1;
-            }
-
-            if(nal_size <= 4){
-                nal_size = 0;
-            }
-            nal_size = (inbuf_size - framesize - 4) - nal_size;
-
-        inbuff[framesize + 0]  = (M4OSA_UInt8)((nal_size >> 24)& 0xFF);
-        inbuff[framesize + 1]  = (M4OSA_UInt8)((nal_size >> 16)& 0xFF);
-        inbuff[framesize + 2]  = (M4OSA_UInt8)((nal_size >> 8)& 0xFF);
-        inbuff[framesize + 3]  = (M4OSA_UInt8)((nal_size )& 0xFF);
-        framesize += nal_size + 4;
-
-        M4OSA_TRACE1_2("M4MCS_convetFromByteStreamtoNALStream framesize = %x nalsize = %x",
-            framesize, nal_size)
-    }
-
-    return  err;
-}
-
-
 M4OSA_ERR H264MCS_Freeinstance( NSWAVC_MCS_t *instance )
 {
     M4OSA_ERR err = M4NO_ERROR;
@@ -2114,56 +2007,16 @@ M4OSA_ERR M4MCS_getVersion( M4_VersionInfo *pVersionInfo )
 
 /**
  ******************************************************************************
- * @brief    Initializes the MCS (allocates an execution context).
- * @note
- * @param    pContext            (OUT) Pointer on the MCS context to allocate
- * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
- * @param    pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
- * @return   M4NO_ERROR:         No error
- * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (If Debug Level >= 2)
- * @return   M4ERR_ALLOC:        There is no more available memory
+ * M4OSA_Void M4MCS_intResetContext(M4MCS_InternalContext* pC)
+ * @brief    Sets all the per transcoding fields of the context to their initial value.
+ * @note     Used by M4MCS_init and M4MCS_reset. The shells interfaces, the file
+ *           function pointers, the H264 instance and what M4MCS_reset keeps (video
+ *           encoder, H264 temporary buffer) are not touched.
+ * @param    pC                  (IN/OUT) MCS context
  ******************************************************************************
  */
-
-M4OSA_ERR M4MCS_init( M4MCS_Context *pContext,
-                     M4OSA_FileReadPointer *pFileReadPtrFct,
-                     M4OSA_FileWriterPointer *pFileWritePtrFct )
+static M4OSA_Void M4MCS_intResetContext( M4MCS_InternalContext *pC )
 {
-    M4MCS_InternalContext *pC = M4OSA_NULL;
-    M4OSA_ERR err;
-
-    M4OSA_TRACE3_3(
-        "M4MCS_init called with pContext=0x%x, pFileReadPtrFct=0x%x, pFileWritePtrFct=0x%x",
-        pContext, pFileReadPtrFct, pFileWritePtrFct);
-
-    /**
-    * Check input parameters */
-    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
-        "M4MCS_init: pContext is M4OSA_NULL");
-    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileReadPtrFct), M4ERR_PARAMETER,
-        "M4MCS_init: pFileReadPtrFct is M4OSA_NULL");
-    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileWritePtrFct), M4ERR_PARAMETER,
-        "M4MCS_init: pFileWritePtrFct is M4OSA_NULL");
-
-    /**
-    * Allocate the MCS context and return it to the user */
-    pC = (M4MCS_InternalContext *)M4OSA_32bitAlignedMalloc(sizeof(M4MCS_InternalContext),
-        M4MCS, (M4OSA_Char *)"M4MCS_InternalContext");
-    *pContext = pC;
-
-    if( M4OSA_NULL == pC )
-    {
-        M4OSA_TRACE1_0(
-            "M4MCS_init(): unable to allocate M4MCS_InternalContext, returning M4ERR_ALLOC");
-        return M4ERR_ALLOC;
-    }
-
-    /**
-    * Init the context. All pointers must be initialized to M4OSA_NULL
-    * because CleanUp() can be called just after Init(). */
-    pC->State = M4MCS_kState_CREATED;
-    pC->pOsaFileReadPtr = pFileReadPtrFct;
-    pC->pOsaFileWritPtr = pFileWritePtrFct;
     pC->VideoState = M4MCS_kStreamState_NOSTREAM;
     pC->AudioState = M4MCS_kStreamState_NOSTREAM;
     pC->noaudio = M4OSA_FALSE;
@@ -2285,6 +2138,90 @@ M4OSA_ERR M4MCS_init( M4MCS_Context *pContext,
     pC->pActiveEffectNumber = -1;
     /**/
 
+    pC->bConcurrentAudio = M4OSA_FALSE;
+    pC->bTwoPassRateControl = M4OSA_FALSE;
+    M4_StepStatsReset(&pC->Stats);
+    pC->pAudioThread = M4OSA_NULL;
+    pC->bAudioThreadStop = M4OSA_FALSE;
+    pC->semAudioStepFree = M4OSA_NULL;
+    pC->semAudioStepReady = M4OSA_NULL;
+    pC->pAudioSteps = M4OSA_NULL;
+    pC->uiAudioStepWrite = 0;
+    pC->uiAudioStepRead = 0;
+    pC->dAudioStepCts = 0;
+    pC->uiAudioStepDuration = 0;
+
+    pC->H264MCSTempBufferDataSize = 0;
+    pC->bH264Trim = M4OSA_FALSE;
+    pC->iH264NextRapCts = -1;
+
+    /* Flag to get the last decoded frame cts */
+    pC->bLastDecodedFrameCTS = M4OSA_FALSE;
+    pC->bExtOMXAudDecoder = M4OSA_FALSE;
+}
+
+/**
+ ******************************************************************************
+ * @brief    Initializes the MCS (allocates an execution context).
+ * @note
+ * @param    pContext            (OUT) Pointer on the MCS context to allocate
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param    pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (If Debug Level >= 2)
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+
+M4OSA_ERR M4MCS_init( M4MCS_Context *pContext,
+                     M4OSA_FileReadPointer *pFileReadPtrFct,
+                     M4OSA_FileWriterPointer *pFileWritePtrFct )
+{
+    M4MCS_InternalContext *pC = M4OSA_NULL;
+    M4OSA_ERR err;
+
+    M4OSA_TRACE3_3(
+        "M4MCS_init called with pContext=0x%x, pFileReadPtrFct=0x%x, pFileWritePtrFct=0x%x",
+        pContext, pFileReadPtrFct, pFileWritePtrFct);
+
+    /**
+    * Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4MCS_init: pContext is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileReadPtrFct), M4ERR_PARAMETER,
+        "M4MCS_init: pFileReadPtrFct is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileWritePtrFct), M4ERR_PARAMETER,
+        "M4MCS_init: pFileWritePtrFct is M4OSA_NULL");
+
+    /**
+    * Allocate the MCS context and return it to the user */
+    pC = (M4MCS_InternalContext *)M4OSA_32bitAlignedMalloc(sizeof(M4MCS_InternalContext),
+        M4MCS, (M4OSA_Char *)"M4MCS_InternalContext");
+    *pContext = pC;
+
+    if( M4OSA_NULL == pC )
+    {
+        M4OSA_TRACE1_0(
+            "M4MCS_init(): unable to allocate M4MCS_InternalContext, returning M4ERR_ALLOC");
+        return M4ERR_ALLOC;
+    }
+
+    /**
+    * Init the context. All pointers must be initialized to M4OSA_NULL
+    * because CleanUp() can be called just after Init(). */
+    pC->State = M4MCS_kState_CREATED;
+    pC->pOsaFileReadPtr = pFileReadPtrFct;
+    pC->pOsaFileWritPtr = pFileWritePtrFct;
+    M4MCS_intResetContext(pC);
+
+    /**
+    * Kept across the transcodings by M4MCS_reset */
+    pC->pKeptViEncCtxt = M4OSA_NULL;
+    pC->pKeptVideoEncoderGlobalFcts = M4OSA_NULL;
+    pC->pKeptWriterDataFcts = M4OSA_NULL;
+    pC->H264MCSTempBuffer = M4OSA_NULL;
+    pC->H264MCSTempBufferSize = 0;
+
     /*
     * Reset pointers for media and codecs interfaces */
     err = M4MCS_clearInterfaceTables(pC);
@@ -2307,19 +2244,11 @@ M4OSA_ERR M4MCS_init( M4MCS_Context *pContext,
 #endif /*M4MCS_SUPPORT_STILL_PICTURE*/
 
     pC->m_pInstance = M4OSA_NULL;
-    pC->H264MCSTempBuffer = M4OSA_NULL;
-    pC->H264MCSTempBufferSize = 0;
-    pC->H264MCSTempBufferDataSize = 0;
-    pC->bH264Trim = M4OSA_FALSE;
-
-    /* Flag to get the last decoded frame cts */
-    pC->bLastDecodedFrameCTS = M4OSA_FALSE;
 
     if( pC->m_pInstance == M4OSA_NULL )
     {
         err = H264MCS_Getinstance(&pC->m_pInstance);
     }
-    pC->bExtOMXAudDecoder = M4OSA_FALSE;
 
     /**
     * Return with no error */
@@ -2831,7 +2760,11 @@ M4OSA_ERR M4MCS_step( M4MCS_Context pContext, M4OSA_UInt8 *pProgress )
         case M4MCS_kState_PROCESSING:
             {
                 M4OSA_ERR err = M4NO_ERROR;
+                M4_StepTimer timer;
+
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = M4MCS_intStepEncoding(pC, pProgress);
+                M4_StepStatsStopStep(&pC->Stats, &timer);
                 /* Save progress info in case of pause */
                 pC->uiProgress = *pProgress;
                 return err;
@@ -3071,6 +3004,12 @@ M4OSA_ERR M4MCS_close( M4MCS_Context pContext )
         return M4ERR_STATE;
     }
 
+    M4_StepStatsTrace(&pC->Stats, (const M4OSA_Char *)"MCS");
+
+    /**
+    * The audio thread uses the audio decoder and encoder, stop it first */
+    M4MCS_intStopAudioThread(pC);
+
     /* Close the encoder before the writer to be certain all the AUs have been written and we can
     get the DSI. */
 
@@ -3093,8 +3032,13 @@ M4OSA_ERR M4MCS_close( M4MCS_Context pContext )
         pC->encoderState = M4MCS_kEncoderStopped;
     }
 
-    /* Has the encoder actually been opened? Don't close it if that's not the case. */
-    if( M4MCS_kEncoderStopped == pC->encoderState )
+    /* Has the encoder actually been opened? Don't close it if that's not the case.
+    An encoder that can be started again stays opened, M4MCS_reset keeps it for the
+    next transcoding and the context clean up closes it otherwise. */
+    if( ( M4MCS_kEncoderStopped == pC->encoderState)
+        && (( M4NO_ERROR != err)
+        || (M4OSA_NULL == pC->pVideoEncoderGlobalFcts->pFctStop)
+        || (M4OSA_NULL == pC->pVideoEncoderGlobalFcts->pFctStart)) )
     {
         err = pC->pVideoEncoderGlobalFcts->pFctClose(pC->pViEncCtxt);
 
@@ -3236,74 +3180,21 @@ M4OSA_ERR M4MCS_close( M4MCS_Context pContext )
     * State transition */
     pC->State = M4MCS_kState_CLOSED;
 
-    if( M4OSA_NULL != pC->H264MCSTempBuffer )
-    {
-        free(pC->H264MCSTempBuffer);
-    }
-
     M4OSA_TRACE3_0("M4MCS_close(): returning M4NO_ERROR");
     return err;
 }
 
 /**
  ******************************************************************************
- * M4OSA_ERR M4MCS_cleanUp(M4MCS_Context pContext);
- * @brief    Free all resources used by the MCS.
- * @note The context is no more valid after this call
- * @param    pContext            (IN) MCS context
- * @return   M4NO_ERROR:         No error
- * @return   M4ERR_PARAMETER:    pContext is M4OSA_NULL (If Debug Level >= 2)
- * @return   M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
+ * M4OSA_Void M4MCS_intFreeContextResources(M4MCS_InternalContext* pC)
+ * @brief    Frees all the resources of a closed context but the shells interfaces.
+ * @note     Used by M4MCS_cleanUp and M4MCS_reset.
+ * @param    pC                  (IN/OUT) MCS context
  ******************************************************************************
  */
-M4OSA_ERR M4MCS_cleanUp( M4MCS_Context pContext )
+static M4OSA_Void M4MCS_intFreeContextResources( M4MCS_InternalContext *pC )
 {
-    M4OSA_ERR err = M4NO_ERROR;
-    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
-
-    M4OSA_TRACE3_1("M4MCS_cleanUp called with pContext=0x%x", pContext);
-
-#ifdef MCS_DUMP_PCM_TO_FILE
-
-    if( file_au_reader )
-    {
-        fclose(file_au_reader);
-        file_au_reader = NULL;
-    }
-
-    if( file_pcm_decoder )
-    {
-        fclose(file_pcm_decoder);
-        file_pcm_decoder = NULL;
-    }
-
-    if( file_pcm_encoder )
-    {
-        fclose(file_pcm_encoder);
-        file_pcm_encoder = NULL;
-    }
-
-#endif
-
-    /**
-    * Check input parameter */
-
-    if( M4OSA_NULL == pContext )
-    {
-        M4OSA_TRACE1_0(
-            "M4MCS_cleanUp: pContext is M4OSA_NULL, returning M4ERR_PARAMETER");
-        return M4ERR_PARAMETER;
-    }
-
-    /**
-    * Check state automaton */
-    if( M4MCS_kState_CLOSED != pC->State )
-    {
-        M4OSA_TRACE1_1(
-            "M4MCS_cleanUp(): Wrong State (%d), returning M4ERR_STATE",
-            pC->State);
-        return M4ERR_STATE;
-    }
+    M4OSA_ERR err;
 
     if( M4OSA_NULL != pC->m_pInstance )
     {
@@ -3316,6 +3207,21 @@ M4OSA_ERR M4MCS_cleanUp( M4MCS_Context pContext )
     if( ( M4OSA_NULL != pC->pViEncCtxt)
         && (M4OSA_NULL != pC->pVideoEncoderGlobalFcts) )
     {
+        /**
+        * Encoder left opened by M4MCS_close and not kept by M4MCS_reset */
+        if( M4MCS_kEncoderStopped == pC->encoderState )
+        {
+            err = pC->pVideoEncoderGlobalFcts->pFctClose(pC->pViEncCtxt);
+
+            if( M4NO_ERROR != err )
+            {
+                M4OSA_TRACE1_1(
+                    "M4MCS_cleanUp: pVideoEncoderGlobalFcts->pFctClose returns 0x%x",
+                    err);
+                /**< don't return, we still have stuff to free */
+            }
+        }
+
         err = pC->pVideoEncoderGlobalFcts->pFctCleanup(pC->pViEncCtxt);
         pC->pViEncCtxt = M4OSA_NULL;
 
@@ -3434,6 +3340,78 @@ M4OSA_ERR M4MCS_cleanUp( M4MCS_Context pContext )
     M4MCS_stillPicCleanUp(pC);
 
 #endif /*M4MCS_SUPPORT_STILL_PICTURE*/
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_cleanUp(M4MCS_Context pContext);
+ * @brief    Free all resources used by the MCS.
+ * @note The context is no more valid after this call
+ * @param    pContext            (IN) MCS context
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    pContext is M4OSA_NULL (If Debug Level >= 2)
+ * @return   M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_cleanUp( M4MCS_Context pContext )
+{
+    M4OSA_ERR err = M4NO_ERROR;
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
+
+    M4OSA_TRACE3_1("M4MCS_cleanUp called with pContext=0x%x", pContext);
+
+#ifdef MCS_DUMP_PCM_TO_FILE
+
+    if( file_au_reader )
+    {
+        fclose(file_au_reader);
+        file_au_reader = NULL;
+    }
+
+    if( file_pcm_decoder )
+    {
+        fclose(file_pcm_decoder);
+        file_pcm_decoder = NULL;
+    }
+
+    if( file_pcm_encoder )
+    {
+        fclose(file_pcm_encoder);
+        file_pcm_encoder = NULL;
+    }
+
+#endif
+
+    /**
+    * Check input parameter */
+
+    if( M4OSA_NULL == pContext )
+    {
+        M4OSA_TRACE1_0(
+            "M4MCS_cleanUp: pContext is M4OSA_NULL, returning M4ERR_PARAMETER");
+        return M4ERR_PARAMETER;
+    }
+
+    /**
+    * Check state automaton */
+    if( M4MCS_kState_CLOSED != pC->State )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_cleanUp(): Wrong State (%d), returning M4ERR_STATE",
+            pC->State);
+        return M4ERR_STATE;
+    }
+
+    /**
+    * Free everything but the shells interfaces */
+    M4MCS_intFreeContextResources(pC);
+    M4MCS_intDestroyKeptVideoEncoder(pC);
+
+    if( M4OSA_NULL != pC->H264MCSTempBuffer )
+    {
+        free(pC->H264MCSTempBuffer);
+        pC->H264MCSTempBuffer = M4OSA_NULL;
+    }
 
     /**
     * Free the shells interfaces */
@@ -3527,6 +3505,113 @@ M4OSA_ERR M4MCS_abort( M4MCS_Context pContext )
     return err;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_reset(M4MCS_Context pContext);
+ * @brief    Finishes the current transcoding whatever the state is, and makes the
+ *           context ready for a new M4MCS_open.
+ * @note     Same as M4MCS_abort followed by M4MCS_init, but the media and codecs
+ *           shells interfaces registered by M4MCS_init are kept. After M4MCS_close,
+ *           the stopped video encoder and the H264 temporary buffer are kept too: the
+ *           next transcoding starts the encoder again instead of creating one, when it
+ *           uses the same encoder settings.
+ * @param    pContext            (IN) MCS context
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_reset( M4MCS_Context pContext )
+{
+    M4OSA_ERR err = M4NO_ERROR;
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
+    M4OSA_Bool bKeepEncoder;
+
+    M4OSA_TRACE2_1("M4MCS_reset called with pContext=0x%x", pContext);
+
+    /**
+    * Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4MCS_reset: pContext is M4OSA_NULL");
+
+    /**
+    * Only the encoder of a transcoding closed normally is kept */
+    bKeepEncoder = (M4MCS_kState_CLOSED == pC->State) ? M4OSA_TRUE : M4OSA_FALSE;
+
+    if( ( pC->State != M4MCS_kState_CREATED)
+        && (pC->State != M4MCS_kState_CLOSED) )
+    {
+        pC->State = M4MCS_kState_FINISHED;
+
+        err = M4MCS_close(pContext);
+
+        if( err != M4NO_ERROR )
+        {
+            M4OSA_TRACE1_1("M4MCS_reset : M4MCS_close fails err = 0x%x", err);
+        }
+    }
+
+    /**
+    * Keep the video encoder left stopped by M4MCS_close: the next transcoding
+    * starts it again if its settings are the same */
+    if( ( M4OSA_TRUE == bKeepEncoder)
+        && (M4MCS_kEncoderStopped == pC->encoderState)
+        && (M4OSA_NULL != pC->pViEncCtxt) )
+    {
+        M4MCS_intDestroyKeptVideoEncoder(pC);
+
+        pC->pKeptViEncCtxt = pC->pViEncCtxt;
+        pC->pKeptVideoEncoderGlobalFcts = pC->pVideoEncoderGlobalFcts;
+        pC->pKeptWriterDataFcts = pC->pWriterDataFcts;
+        pC->KeptVideoEncParams = pC->VideoEncParams;
+        pC->pViEncCtxt = M4OSA_NULL;
+        pC->encoderState = M4MCS_kNoEncoder;
+    }
+
+    M4MCS_intFreeContextResources(pC);
+
+    pC->State = M4MCS_kState_CREATED;
+    M4MCS_intResetContext(pC);
+
+#ifdef M4MCS_SUPPORT_STILL_PICTURE
+
+    err = M4MCS_stillPicInit(pC, pC->pOsaFileReadPtr, pC->pOsaFileWritPtr);
+    M4ERR_CHECK_RETURN(err);
+
+    pC->m_bIsStillPicture = M4OSA_FALSE;
+
+#endif /*M4MCS_SUPPORT_STILL_PICTURE*/
+
+    err = H264MCS_Getinstance(&pC->m_pInstance);
+
+    M4OSA_TRACE3_1("M4MCS_reset(): returning 0x%x", err);
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_getStatistics(M4MCS_Context pContext, M4_StepStats* pStats);
+ * @brief    Get the cumulative time spent in each stage of the transcoding.
+ * @param    pContext            (IN) MCS context
+ * @param    pStats              (OUT) Statistics
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only)
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_getStatistics( M4MCS_Context pContext, M4_StepStats *pStats )
+{
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4MCS_getStatistics: pContext is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pStats), M4ERR_PARAMETER,
+        "M4MCS_getStatistics: pStats is M4OSA_NULL");
+
+    memcpy((void *)pStats, (void *) &pC->Stats, sizeof(M4_StepStats));
+
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_getInputFileProperties(M4MCS_Context pContext,
@@ -5418,6 +5503,18 @@ M4OSA_ERR M4MCS_checkParamsAndStart( M4MCS_Context pContext )
 
 #endif /* M4MCS_WITH_FAST_OPEN */
 
+    if( M4OSA_TRUE == pC->bTwoPassRateControl )
+    {
+        err = M4MCS_intTwoPassAnalysis(pC);
+
+        if( err != M4NO_ERROR )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_checkParamsAndStart : M4MCS_intTwoPassAnalysis returns 0x%x", err);
+            return err;
+        }
+    }
+
     pC->State = M4MCS_kState_READY;
 
     return M4NO_ERROR;
@@ -5425,48 +5522,484 @@ M4OSA_ERR M4MCS_checkParamsAndStart( M4MCS_Context pContext )
 
 /**
  ******************************************************************************
- * M4OSA_ERR M4MCS_intStepSet(M4MCS_InternalContext* pC)
+ * M4OSA_ERR M4MCS_setConcurrentAudio(M4MCS_Context pContext, M4OSA_Bool bConcurrent)
+ * @brief   Runs the audio transcoding on its own thread.
+ * @note    Must be called before the first M4MCS_step.
+ * @param   pContext            (IN) MCS context
+ * @param   bConcurrent         (IN) M4OSA_TRUE to use the audio thread
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return  M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
  ******************************************************************************
  */
-static M4OSA_ERR M4MCS_intStepSet( M4MCS_InternalContext *pC )
+M4OSA_ERR M4MCS_setConcurrentAudio( M4MCS_Context pContext,
+                                   M4OSA_Bool bConcurrent )
 {
-    M4OSA_ERR err;
-    M4ENCODER_Header *encHeader;
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
+
+    M4OSA_TRACE2_2("M4MCS_setConcurrentAudio called with pContext=0x%x, bConcurrent=%d",
+        pContext, bConcurrent);
 
     /**
-    * Prepare the video decoder */
-    err = M4MCS_intPrepareVideoDecoder(pC);
+    * Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4MCS_setConcurrentAudio: pContext is M4OSA_NULL");
 
-    if( M4NO_ERROR != err )
+    /**
+    * Check state automaton */
+    if( ( M4MCS_kState_CREATED != pC->State) && (M4MCS_kState_OPENED != pC->State)
+        && (M4MCS_kState_SET != pC->State) && (M4MCS_kState_READY != pC->State) )
     {
         M4OSA_TRACE1_1(
-            "M4MCS_intStepSet(): M4MCS_intPrepareVideoDecoder() returns 0x%x",
-            err);
-        return err;
+            "M4MCS_setConcurrentAudio(): Wrong State (%d), returning M4ERR_STATE",
+            pC->State);
+        return M4ERR_STATE;
     }
 
-    if( ( pC->InputFileProperties.VideoStreamType == M4VIDEOEDITING_kH264)
-        && (pC->EncodingVideoFormat == M4ENCODER_kNULL) )
-    {
-        pC->bH264Trim = M4OSA_TRUE;
-    }
+    pC->bConcurrentAudio = bConcurrent;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_setTwoPassRateControl(M4MCS_Context pContext, M4OSA_Bool bTwoPass)
+ * @brief   Fits the video bitrate to the maximum output file size with a first pass.
+ * @note    Must be called before M4MCS_checkParamsAndStart.
+ * @param   pContext            (IN) MCS context
+ * @param   bTwoPass            (IN) M4OSA_TRUE to run the first pass
+ * @return  M4NO_ERROR:         No error
+ * @return  M4ERR_PARAMETER:    pContext is M4OSA_NULL (debug only)
+ * @return  M4ERR_STATE:        MCS is not in an appropriate state for this function to be called
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_setTwoPassRateControl( M4MCS_Context pContext,
+                                      M4OSA_Bool bTwoPass )
+{
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)(pContext);
+
+    M4OSA_TRACE2_2("M4MCS_setTwoPassRateControl called with pContext=0x%x, bTwoPass=%d",
+        pContext, bTwoPass);
 
     /**
-    * Prepare the video encoder */
-    err = M4MCS_intPrepareVideoEncoder(pC);
+    * Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4MCS_setTwoPassRateControl: pContext is M4OSA_NULL");
 
-    if( M4NO_ERROR != err )
+    /**
+    * Check state automaton */
+    if( ( M4MCS_kState_CREATED != pC->State) && (M4MCS_kState_OPENED != pC->State)
+        && (M4MCS_kState_SET != pC->State) )
     {
         M4OSA_TRACE1_1(
-            "M4MCS_intStepSet(): M4MCS_intPrepareVideoEncoder() returns 0x%x",
-            err);
-        return err;
+            "M4MCS_setTwoPassRateControl(): Wrong State (%d), returning M4ERR_STATE",
+            pC->State);
+        return M4ERR_STATE;
     }
 
-    if( ( pC->uiBeginCutTime != 0)
-        && (pC->InputFileProperties.VideoStreamType == M4VIDEOEDITING_kH264)
-        && (pC->EncodingVideoFormat == M4ENCODER_kNULL) )
-    {
+    pC->bTwoPassRateControl = bTwoPass;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intTwoPassScanStream(M4MCS_InternalContext* pC,
+ *                                      M4_StreamHandler* pStream, ...)
+ * @brief    Reads the AUs of a stream in the cut range and rewinds the stream
+ * @note     When ppGops is not M4OSA_NULL, the AUs are grouped by GOP and the size and
+ *           duration of each GOP are returned in an array allocated here, to be freed
+ *           by the caller (also on error).
+ * @param    pC          (IN) MCS context
+ * @param    pStream     (IN) Stream to scan
+ * @param    pNbAu       (OUT) Number of AUs in the cut range
+ * @param    pNbBytes    (OUT) Size of these AUs, in bytes
+ * @param    ppGops      (OUT) GOPs of the cut range, M4OSA_NULL to skip the GOP statistics
+ * @param    pNbGops     (OUT) Number of GOPs, can be M4OSA_NULL if ppGops is
+ * @return   M4NO_ERROR: No error
+ * @return   M4ERR_ALLOC: Allocation failed
+ * @return   Any error returned by the reader
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intTwoPassScanStream( M4MCS_InternalContext *pC,
+                                            M4_StreamHandler *pStream,
+                                            M4OSA_UInt32 *pNbAu,
+                                            M4OSA_Double *pNbBytes,
+                                            M4MCS_TwoPassGop **ppGops,
+                                            M4OSA_UInt32 *pNbGops )
+{
+    M4OSA_ERR err;
+    M4_AccessUnit lReaderAU;
+    M4MCS_TwoPassGop *pGops = M4OSA_NULL;
+    M4MCS_TwoPassGop *pNewGops;
+    M4OSA_UInt32 uiMaxGops = 0;
+    M4OSA_UInt32 uiNbGops = 0;
+    M4OSA_Double dGopBytes = 0;
+    M4OSA_Double dGopStart = pC->uiBeginCutTime;
+    M4OSA_Bool bGop = M4OSA_FALSE;
+
+    *pNbAu = 0;
+    *pNbBytes = 0;
+
+    if( M4OSA_NULL != ppGops )
+    {
+        *ppGops = M4OSA_NULL;
+        *pNbGops = 0;
+    }
+
+    err = pC->m_pReader->m_pFctFillAuStruct(pC->pReaderContext, pStream,
+        &lReaderAU);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intTwoPassScanStream: m_pReader->m_pFctFillAuStruct returns 0x%x", err);
+        return err;
+    }
+
+    for ( ;; )
+    {
+        err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext, pStream,
+            &lReaderAU);
+
+        if( M4WAR_NO_MORE_AU == err )
+        {
+            err = M4NO_ERROR;
+            break;
+        }
+        else if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intTwoPassScanStream: m_pReaderDataIt->m_pFctGetNextAu returns 0x%x",
+                err);
+            break;
+        }
+
+        if( lReaderAU.m_CTS > pC->uiEndCutTime )
+        {
+            break;
+        }
+
+        if( lReaderAU.m_CTS < pC->uiBeginCutTime )
+        {
+            continue;
+        }
+
+        if( ( M4OSA_NULL != ppGops) && (M4OSA_TRUE == bGop)
+            && (AU_RAP == (lReaderAU.m_attribute & AU_RAP)) )
+        {
+            /**
+            * The GOP ends at the next sync sample */
+            if( uiNbGops == uiMaxGops )
+            {
+                uiMaxGops = (0 == uiMaxGops) ? M4MCS_TWO_PASS_INITIAL_GOPS
+                    : 2 * uiMaxGops;
+                pNewGops = (M4MCS_TwoPassGop *)M4OSA_32bitAlignedMalloc(
+                    uiMaxGops * sizeof(M4MCS_TwoPassGop), M4MCS,
+                    (M4OSA_Char *)"M4MCS_intTwoPassScanStream: GOPs");
+
+                if( M4OSA_NULL == pNewGops )
+                {
+                    M4OSA_TRACE1_0("M4MCS_intTwoPassScanStream: unable to allocate GOPs");
+                    err = M4ERR_ALLOC;
+                    break;
+                }
+
+                if( M4OSA_NULL != pGops )
+                {
+                    memcpy((void *)pNewGops, (void *)pGops,
+                        uiNbGops * sizeof(M4MCS_TwoPassGop));
+                    free(pGops);
+                }
+                pGops = pNewGops;
+            }
+
+            pGops[uiNbGops].dBytes = dGopBytes;
+            pGops[uiNbGops].dDuration = lReaderAU.m_CTS - dGopStart;
+            uiNbGops++;
+            dGopBytes = 0;
+            dGopStart = lReaderAU.m_CTS;
+        }
+
+        (*pNbAu)++;
+        *pNbBytes += lReaderAU.m_size;
+        dGopBytes += lReaderAU.m_size;
+        bGop = M4OSA_TRUE;
+    }
+
+    if( ( M4NO_ERROR == err) && (M4OSA_NULL != ppGops) && (M4OSA_TRUE == bGop) )
+    {
+        /**
+        * The last GOP ends with the cut range */
+        if( uiNbGops == uiMaxGops )
+        {
+            uiMaxGops++;
+            pNewGops = (M4MCS_TwoPassGop *)M4OSA_32bitAlignedMalloc(
+                uiMaxGops * sizeof(M4MCS_TwoPassGop), M4MCS,
+                (M4OSA_Char *)"M4MCS_intTwoPassScanStream: GOPs");
+
+            if( M4OSA_NULL == pNewGops )
+            {
+                M4OSA_TRACE1_0("M4MCS_intTwoPassScanStream: unable to allocate GOPs");
+                err = M4ERR_ALLOC;
+            }
+            else
+            {
+                if( M4OSA_NULL != pGops )
+                {
+                    memcpy((void *)pNewGops, (void *)pGops,
+                        uiNbGops * sizeof(M4MCS_TwoPassGop));
+                    free(pGops);
+                }
+                pGops = pNewGops;
+            }
+        }
+
+        if( M4NO_ERROR == err )
+        {
+            pGops[uiNbGops].dBytes = dGopBytes;
+            pGops[uiNbGops].dDuration = ( pC->uiEndCutTime > dGopStart)
+                ? pC->uiEndCutTime - dGopStart : 0;
+            uiNbGops++;
+        }
+    }
+
+    if( M4OSA_NULL != ppGops )
+    {
+        *ppGops = pGops;
+        *pNbGops = uiNbGops;
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    /**
+    * Rewind the stream for the transcoding itself */
+    err = pC->m_pReader->m_pFctReset(pC->pReaderContext, pStream);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intTwoPassScanStream: m_pReader->m_pFctReset returns 0x%x", err);
+        return err;
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intTwoPassAnalysis(M4MCS_InternalContext* pC)
+ * @brief    First pass of the two-pass rate control
+ * @note     The input video is not decoded: the size of its GOPs is used as the
+ *           complexity measure. The video budget is the maximum file size minus the
+ *           audio, the moov and a margin growing with the variation of the complexity
+ *           between GOPs, as the encoder regulation is less accurate on uneven content.
+ *           The video bitrate spreads the budget evenly over the duration, and never
+ *           exceeds the requested bitrate nor the input video bitrate.
+ * @param    pC          (IN/OUT) MCS context
+ * @return   M4NO_ERROR: No error
+ * @return   M4ERR_ALLOC: Allocation failed
+ * @return   Any error returned by the reader
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intTwoPassAnalysis( M4MCS_InternalContext *pC )
+{
+    M4OSA_ERR err;
+    M4OSA_UInt32 uiDuration;
+    M4OSA_UInt32 uiNbVideoAu, uiNbAudioAu = 0, uiNbGops = 0;
+    M4MCS_TwoPassGop *pGops = M4OSA_NULL;
+    M4OSA_Double dVideoBytes, dAudioBytes = 0;
+    M4OSA_Double dRate, dSum = 0, dSumSq = 0, dMean, dVariation = 0;
+    M4OSA_Double dMargin, dVideoBudget;
+    M4OSA_Double dBitrate;
+    M4OSA_UInt32 uiMaxBitrate;
+    M4OSA_UInt32 uiBitrate;
+    M4OSA_UInt32 uiNbRates = 0;
+    M4OSA_UInt32 i;
+
+    if( ( 0 == pC->uiMaxFileSize) || (pC->novideo)
+        || (M4ENCODER_kNULL == pC->EncodingVideoFormat)
+        || (M4OSA_NULL == pC->pReaderVideoStream)
+        || (pC->uiEndCutTime <= pC->uiBeginCutTime) )
+    {
+        M4OSA_TRACE2_0("M4MCS_intTwoPassAnalysis: nothing to do");
+        return M4NO_ERROR;
+    }
+
+    uiDuration = pC->uiEndCutTime - pC->uiBeginCutTime;
+
+    err = M4MCS_intTwoPassScanStream(pC,
+        (M4_StreamHandler *)pC->pReaderVideoStream, &uiNbVideoAu, &dVideoBytes,
+        &pGops, &uiNbGops);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    if( 0 == uiNbGops )
+    {
+        M4OSA_TRACE2_0("M4MCS_intTwoPassAnalysis: no video AU in the cut range");
+        goto cleanup;
+    }
+
+    /**
+    * Audio size: exact when the audio is copied, from its bitrate otherwise */
+    if( ( M4OSA_FALSE == pC->noaudio) && (M4OSA_NULL != pC->pReaderAudioStream) )
+    {
+        if( M4ENCODER_kAudioNULL == pC->AudioEncParams.Format )
+        {
+            err = M4MCS_intTwoPassScanStream(pC,
+                (M4_StreamHandler *)pC->pReaderAudioStream, &uiNbAudioAu,
+                &dAudioBytes, M4OSA_NULL, M4OSA_NULL);
+
+            if( M4NO_ERROR != err )
+            {
+                goto cleanup;
+            }
+        }
+        else
+        {
+            dAudioBytes = (M4OSA_Double)pC->uiAudioBitrate * uiDuration / 8000.0;
+            uiNbAudioAu = uiDuration / M4MCS_TWO_PASS_AUDIO_AU_DURATION;
+        }
+    }
+
+    /**
+    * Complexity variation between GOPs (coefficient of variation of their bitrate) */
+    for ( i = 0; i < uiNbGops; i++ )
+    {
+        if( pGops[i].dDuration > 0 )
+        {
+            dRate = pGops[i].dBytes / pGops[i].dDuration;
+            dSum += dRate;
+            dSumSq += dRate * dRate;
+            uiNbRates++;
+        }
+    }
+
+    if( 0 < uiNbRates )
+    {
+        dMean = dSum / uiNbRates;
+
+        if( ( dMean > 0) && (dSumSq / uiNbRates > dMean * dMean) )
+        {
+            dVariation = sqrt(dSumSq / uiNbRates - dMean * dMean) / dMean;
+        }
+    }
+
+    if( dVariation > 1.0 )
+    {
+        dVariation = 1.0;
+    }
+
+    dMargin = ( M4MCS_TWO_PASS_MIN_MARGIN + (M4MCS_TWO_PASS_MAX_MARGIN
+        - M4MCS_TWO_PASS_MIN_MARGIN) * dVariation) / 100.0;
+
+    dVideoBudget = pC->uiMaxFileSize * (1.0 - dMargin) - dAudioBytes
+        - M4MCS_TWO_PASS_MOOV_FIXED_BYTES
+        - M4MCS_TWO_PASS_MOOV_BYTES_PER_AU * (M4OSA_Double)(uiNbVideoAu + uiNbAudioAu);
+
+    if( dVideoBudget <= 0 )
+    {
+        M4OSA_TRACE1_0(
+            "M4MCS_intTwoPassAnalysis: no room for the video, keeping the computed bitrate");
+        goto cleanup;
+    }
+
+    /**
+    * Never above the requested bitrate nor the input one */
+    uiMaxBitrate = pC->uiEncVideoBitrate;
+
+    if( ( 0 < pC->InputFileProperties.uiVideoBitrate)
+        && (pC->InputFileProperties.uiVideoBitrate < uiMaxBitrate) )
+    {
+        uiMaxBitrate = pC->InputFileProperties.uiVideoBitrate;
+    }
+
+    if( uiMaxBitrate > M4VIDEOEDITING_k8_MBPS )
+    {
+        uiMaxBitrate = M4VIDEOEDITING_k8_MBPS;
+    }
+
+    /**
+    * The encoder gets one bitrate for the whole session, and the re-encoded GOPs are
+    * not bounded by their input size: the budget is spread evenly over the duration */
+    dBitrate = dVideoBudget * 8000.0 / uiDuration;
+    uiBitrate = ( dBitrate < uiMaxBitrate) ? (M4OSA_UInt32)dBitrate : uiMaxBitrate;
+
+    if( uiBitrate < M4VIDEOEDITING_k16_KBPS )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intTwoPassAnalysis: bitrate %d too low, keeping the computed bitrate",
+            uiBitrate);
+        goto cleanup;
+    }
+
+    M4OSA_TRACE1_4("M4MCS_intTwoPassAnalysis: %d GOPs, variation %d%%, margin %d%%,\
+                   video bitrate %d", uiNbGops, (M4OSA_Int32)(dVariation * 100),
+                   (M4OSA_Int32)(dMargin * 100), uiBitrate);
+    M4OSA_TRACE1_2("M4MCS_intTwoPassAnalysis: bitrate %d instead of %d",
+        uiBitrate, pC->uiEncVideoBitrate);
+
+    pC->uiEncVideoBitrate = uiBitrate;
+
+cleanup:
+    if( M4OSA_NULL != pGops )
+    {
+        free(pGops);
+    }
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intStepSet(M4MCS_InternalContext* pC)
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intStepSet( M4MCS_InternalContext *pC )
+{
+    M4OSA_ERR err;
+    M4ENCODER_Header *encHeader;
+
+    /**
+    * Prepare the video decoder */
+    err = M4MCS_intPrepareVideoDecoder(pC);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intStepSet(): M4MCS_intPrepareVideoDecoder() returns 0x%x",
+            err);
+        return err;
+    }
+
+    if( ( pC->InputFileProperties.VideoStreamType == M4VIDEOEDITING_kH264)
+        && (pC->EncodingVideoFormat == M4ENCODER_kNULL) )
+    {
+        pC->bH264Trim = M4OSA_TRUE;
+    }
+
+    /**
+    * Prepare the video encoder */
+    err = M4MCS_intPrepareVideoEncoder(pC);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intStepSet(): M4MCS_intPrepareVideoEncoder() returns 0x%x",
+            err);
+        return err;
+    }
+
+    if( ( pC->uiBeginCutTime != 0)
+        && (pC->InputFileProperties.VideoStreamType == M4VIDEOEDITING_kH264)
+        && (pC->EncodingVideoFormat == M4ENCODER_kNULL) )
+    {
 
         err = pC->pVideoEncoderGlobalFcts->pFctSetOption(pC->pViEncCtxt,
             M4ENCODER_kOptionID_H264ProcessNALUContext,
@@ -5674,6 +6207,227 @@ static M4OSA_ERR M4MCS_intPrepareVideoDecoder( M4MCS_InternalContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4MCS_intIsKeptVideoEncoderCompatible(M4MCS_InternalContext* pC,
+ *                                                  M4ENCODER_AdvancedParams* pEncParams);
+ * @brief    Tells if the kept video encoder was opened with the given settings.
+ * @param    pC          (IN) MCS private context
+ * @param    pEncParams  (IN) Settings of the video encoder to create
+ * @return   M4OSA_TRUE if the kept encoder can be started again
+ ******************************************************************************
+ */
+static M4OSA_Bool M4MCS_intIsKeptVideoEncoderCompatible( M4MCS_InternalContext *pC,
+                                                        M4ENCODER_AdvancedParams *pEncParams )
+{
+    M4ENCODER_AdvancedParams *pKept = &pC->KeptVideoEncParams;
+
+    /**
+    * The H.264 trimming encoder is opened with other parameters and closed by the
+    * null encoding itself */
+    if( ( M4OSA_TRUE == pC->bH264Trim)
+        || (pC->pKeptVideoEncoderGlobalFcts != pC->pVideoEncoderGlobalFcts)
+        || (pC->pKeptWriterDataFcts != pC->pWriterDataFcts) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    if( ( pKept->Format != pEncParams->Format)
+        || (pKept->InputFormat != pEncParams->InputFormat)
+        || (pKept->FrameWidth != pEncParams->FrameWidth)
+        || (pKept->FrameHeight != pEncParams->FrameHeight)
+        || (pKept->FrameRate != pEncParams->FrameRate)
+        || (pKept->uiTimeScale != pEncParams->uiTimeScale)
+        || (pKept->videoProfile != pEncParams->videoProfile)
+        || (pKept->videoLevel != pEncParams->videoLevel)
+        || (pKept->Bitrate != pEncParams->Bitrate)
+        || (pKept->bInternalRegulation != pEncParams->bInternalRegulation)
+        || (pKept->uiStartingQuantizerValue != pEncParams->uiStartingQuantizerValue) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    return M4OSA_TRUE;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4MCS_intDestroyKeptVideoEncoder(M4MCS_InternalContext* pC);
+ * @brief    Closes and frees the video encoder kept by M4MCS_reset, if any.
+ * @param    pC          (IN/OUT) MCS private context
+ ******************************************************************************
+ */
+static M4OSA_Void M4MCS_intDestroyKeptVideoEncoder( M4MCS_InternalContext *pC )
+{
+    M4OSA_ERR err;
+
+    if( M4OSA_NULL == pC->pKeptViEncCtxt )
+    {
+        return;
+    }
+
+    err = pC->pKeptVideoEncoderGlobalFcts->pFctClose(pC->pKeptViEncCtxt);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intDestroyKeptVideoEncoder: pFctClose returns 0x%x", err);
+        /**< don't return, the encoder still has to be freed */
+    }
+
+    err = pC->pKeptVideoEncoderGlobalFcts->pFctCleanup(pC->pKeptViEncCtxt);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intDestroyKeptVideoEncoder: pFctCleanup returns 0x%x", err);
+    }
+
+    pC->pKeptViEncCtxt = M4OSA_NULL;
+    pC->pKeptVideoEncoderGlobalFcts = M4OSA_NULL;
+    pC->pKeptWriterDataFcts = M4OSA_NULL;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intCreateVideoEncoder(M4MCS_InternalContext* pC,
+ *                                       M4ENCODER_AdvancedParams* pEncParams);
+ * @brief    Creates, opens and starts the video encoder.
+ * @note     The encoder kept by M4MCS_reset is just started again when it was
+ *           opened with the same settings, otherwise it is destroyed.
+ * @param    pC          (IN/OUT) MCS private context
+ * @param    pEncParams  (IN) Video encoder settings
+ * @return   M4NO_ERROR  No error
+ * @return   Any error returned by the encoder shell
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intCreateVideoEncoder( M4MCS_InternalContext *pC,
+                                             M4ENCODER_AdvancedParams *pEncParams )
+{
+    M4OSA_ERR err;
+    M4ENCODER_Params EncParams1;
+
+    if( M4OSA_NULL != pC->pKeptViEncCtxt )
+    {
+        if( M4OSA_TRUE == M4MCS_intIsKeptVideoEncoderCompatible(pC, pEncParams) )
+        {
+            M4OSA_TRACE1_0(
+                "M4MCS_intCreateVideoEncoder: restarting the kept encoder");
+
+            pC->pViEncCtxt = pC->pKeptViEncCtxt;
+            pC->pKeptViEncCtxt = M4OSA_NULL;
+            pC->pKeptVideoEncoderGlobalFcts = M4OSA_NULL;
+            pC->pKeptWriterDataFcts = M4OSA_NULL;
+            pC->VideoEncParams = *pEncParams;
+            pC->encoderState = M4MCS_kEncoderStopped;
+
+            err = pC->pVideoEncoderGlobalFcts->pFctStart(pC->pViEncCtxt);
+
+            if( M4NO_ERROR != err )
+            {
+                M4OSA_TRACE1_1(
+                    "M4MCS_intCreateVideoEncoder: EncoderInt->pFctStart returns 0x%x",
+                    err);
+                return err;
+            }
+
+            pC->encoderState = M4MCS_kEncoderRunning;
+            return M4NO_ERROR;
+        }
+
+        M4MCS_intDestroyKeptVideoEncoder(pC);
+    }
+
+    /**
+    * Create video encoder */
+    err = pC->pVideoEncoderGlobalFcts->pFctInit(&pC->pViEncCtxt,
+        pC->pWriterDataFcts, \
+        M4MCS_intApplyVPP, pC, pC->pCurrentVideoEncoderExternalAPI, \
+        pC->pCurrentVideoEncoderUserData);
+
+    /**< We put the MCS context in place of the VPP context */
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intCreateVideoEncoder: EncoderInt->pFctInit returns 0x%x",
+            err);
+        return err;
+    }
+
+    pC->encoderState = M4MCS_kEncoderClosed;
+
+    /**
+    * Our VPP writes at the stride of the output planes: the encoder can give its
+    * input buffers directly, instead of converting an intermediate frame.
+    * Not all the encoders support it, so the error is ignored */
+    if( M4ENCODER_kNULL != pC->EncodingVideoFormat )
+    {
+        err = pC->pVideoEncoderGlobalFcts->pFctSetOption(pC->pViEncCtxt,
+            M4ENCODER_kOptionID_StridedPreProcessing, (M4OSA_DataOption)M4OSA_TRUE);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE2_1("M4MCS_intCreateVideoEncoder: strided VPP not supported (0x%x)",
+                err);
+        }
+    }
+
+    if( M4OSA_TRUE == pC->bH264Trim )
+        //if((M4ENCODER_kNULL == pC->EncodingVideoFormat)
+        //    && (M4VIDEOEDITING_kH264 == pC->InputFileProperties.VideoStreamType))
+    {
+        EncParams1.InputFormat = pEncParams->InputFormat;
+        //EncParams1.InputFrameWidth = pEncParams->InputFrameWidth;
+        //EncParams1.InputFrameHeight = pEncParams->InputFrameHeight;
+        EncParams1.FrameWidth = pEncParams->FrameWidth;
+        EncParams1.FrameHeight = pEncParams->FrameHeight;
+        EncParams1.videoProfile= pEncParams->videoProfile;
+        EncParams1.videoLevel= pEncParams->videoLevel;
+        EncParams1.Bitrate = pEncParams->Bitrate;
+        EncParams1.FrameRate = pEncParams->FrameRate;
+        EncParams1.Format = M4ENCODER_kH264; //pEncParams->Format;
+        M4OSA_TRACE1_2("mcs encoder open profile :%d, level %d",
+            EncParams1.videoProfile, EncParams1.videoLevel);
+        err = pC->pVideoEncoderGlobalFcts->pFctOpen(pC->pViEncCtxt,
+            &pC->WriterVideoAU, &EncParams1);
+    }
+    else
+    {
+        M4OSA_TRACE1_2("mcs encoder open Adv profile :%d, level %d",
+            pEncParams->videoProfile, pEncParams->videoLevel);
+        err = pC->pVideoEncoderGlobalFcts->pFctOpen(pC->pViEncCtxt,
+            &pC->WriterVideoAU, pEncParams);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intCreateVideoEncoder: EncoderInt->pFctOpen returns 0x%x",
+            err);
+        return err;
+    }
+
+    pC->encoderState = M4MCS_kEncoderStopped;
+
+    if( M4OSA_NULL != pC->pVideoEncoderGlobalFcts->pFctStart )
+    {
+        err = pC->pVideoEncoderGlobalFcts->pFctStart(pC->pViEncCtxt);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intCreateVideoEncoder: EncoderInt->pFctStart returns 0x%x",
+                err);
+            return err;
+        }
+    }
+
+    pC->encoderState = M4MCS_kEncoderRunning;
+    pC->VideoEncParams = *pEncParams;
+
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_intPrepareVideoEncoder(M4MCS_InternalContext* pC);
@@ -5687,7 +6441,6 @@ static M4OSA_ERR M4MCS_intPrepareVideoEncoder( M4MCS_InternalContext *pC )
 {
     M4OSA_ERR err;
     M4ENCODER_AdvancedParams EncParams; /**< Encoder advanced parameters */
-    M4ENCODER_Params EncParams1;
     M4OSA_Double dFrameRate;            /**< tmp variable */
 
     if( pC->novideo )
@@ -5870,75 +6623,18 @@ static M4OSA_ERR M4MCS_intPrepareVideoEncoder( M4MCS_InternalContext *pC )
     }
 
     /**
-    * Create video encoder */
-    err = pC->pVideoEncoderGlobalFcts->pFctInit(&pC->pViEncCtxt,
-        pC->pWriterDataFcts, \
-        M4MCS_intApplyVPP, pC, pC->pCurrentVideoEncoderExternalAPI, \
-        pC->pCurrentVideoEncoderUserData);
-
-    /**< We put the MCS context in place of the VPP context */
-    if( M4NO_ERROR != err )
-    {
-        M4OSA_TRACE1_1(
-            "M4MCS_intPrepareVideoEncoder: EncoderInt->pFctInit returns 0x%x",
-            err);
-        return err;
-    }
-
-    pC->encoderState = M4MCS_kEncoderClosed;
-
-    if( M4OSA_TRUE == pC->bH264Trim )
-        //if((M4ENCODER_kNULL == pC->EncodingVideoFormat)
-        //    && (M4VIDEOEDITING_kH264 == pC->InputFileProperties.VideoStreamType))
-    {
-        EncParams1.InputFormat = EncParams.InputFormat;
-        //EncParams1.InputFrameWidth = EncParams.InputFrameWidth;
-        //EncParams1.InputFrameHeight = EncParams.InputFrameHeight;
-        EncParams1.FrameWidth = EncParams.FrameWidth;
-        EncParams1.FrameHeight = EncParams.FrameHeight;
-        EncParams1.videoProfile= EncParams.videoProfile;
-        EncParams1.videoLevel= EncParams.videoLevel;
-        EncParams1.Bitrate = EncParams.Bitrate;
-        EncParams1.FrameRate = EncParams.FrameRate;
-        EncParams1.Format = M4ENCODER_kH264; //EncParams.Format;
-        M4OSA_TRACE1_2("mcs encoder open profile :%d, level %d",
-            EncParams1.videoProfile, EncParams1.videoLevel);
-        err = pC->pVideoEncoderGlobalFcts->pFctOpen(pC->pViEncCtxt,
-            &pC->WriterVideoAU, &EncParams1);
-    }
-    else
-    {
-        M4OSA_TRACE1_2("mcs encoder open Adv profile :%d, level %d",
-            EncParams.videoProfile, EncParams.videoLevel);
-        err = pC->pVideoEncoderGlobalFcts->pFctOpen(pC->pViEncCtxt,
-            &pC->WriterVideoAU, &EncParams);
-    }
+    * Create the video encoder, or start again the one kept from the previous
+    * transcoding */
+    err = M4MCS_intCreateVideoEncoder(pC, &EncParams);
 
     if( M4NO_ERROR != err )
     {
         M4OSA_TRACE1_1(
-            "M4MCS_intPrepareVideoEncoder: EncoderInt->pFctOpen returns 0x%x",
+            "M4MCS_intPrepareVideoEncoder: M4MCS_intCreateVideoEncoder returns 0x%x",
             err);
         return err;
     }
 
-    pC->encoderState = M4MCS_kEncoderStopped;
-
-    if( M4OSA_NULL != pC->pVideoEncoderGlobalFcts->pFctStart )
-    {
-        err = pC->pVideoEncoderGlobalFcts->pFctStart(pC->pViEncCtxt);
-
-        if( M4NO_ERROR != err )
-        {
-            M4OSA_TRACE1_1(
-                "M4MCS_intPrepareVideoEncoder: EncoderInt->pFctStart returns 0x%x",
-                err);
-            return err;
-        }
-    }
-
-    pC->encoderState = M4MCS_kEncoderRunning;
-
     /******************************/
     /* Video resize management    */
     /******************************/
@@ -7289,6 +7985,30 @@ static M4OSA_ERR M4MCS_intStepEncoding( M4MCS_InternalContext *pC,
 {
     M4OSA_ERR err;
     M4OSA_UInt32 uiAudioStepCount = 0;
+    M4_MediaTime dAudioCts;
+    M4OSA_UInt32 uiAudioAUDuration;
+    M4_StepTimer timer;
+
+    /**
+    * Start the audio thread on the first step, when audio and video are both
+    * re-encoded; the audio chain then runs while the video is transcoded */
+    if( ( M4OSA_TRUE == pC->bConcurrentAudio) && (M4OSA_NULL == pC->pAudioThread)
+        && (pC->noaudio == M4OSA_FALSE) && (pC->novideo == M4OSA_FALSE)
+        && (M4MCS_kStreamState_STARTED == pC->AudioState)
+        && (M4MCS_kStreamState_STARTED == pC->VideoState)
+        && (pC->AudioEncParams.Format != M4ENCODER_kAudioNULL)
+        && (M4OSA_FALSE == pC->b_isRawWriter) )
+    {
+        err = M4MCS_intStartAudioThread(pC);
+
+        if( M4NO_ERROR != err )
+        {
+            /* Not fatal, the audio is transcoded on this thread */
+            M4OSA_TRACE1_1(
+                "M4MCS_intStepEncoding(): M4MCS_intStartAudioThread returns 0x%x", err);
+            pC->bConcurrentAudio = M4OSA_FALSE;
+        }
+    }
 
     /* ---------- VIDEO TRANSCODING ---------- */
 
@@ -7366,51 +8086,76 @@ static M4OSA_ERR M4MCS_intStepEncoding( M4MCS_InternalContext *pC,
     if( ( pC->noaudio == M4OSA_FALSE) && (M4MCS_kStreamState_STARTED
         == pC->AudioState) ) /**< If there is an audio stream */
     {
+        if( M4OSA_NULL != pC->pAudioThread )
+        {
+            dAudioCts = pC->dAudioStepCts;
+            uiAudioAUDuration = pC->uiAudioStepDuration;
+        }
+        else
+        {
+            dAudioCts = pC->ReaderAudioAU.m_CTS;
+            uiAudioAUDuration = pC->m_audioAUDuration;
+        }
+
         while(
             /**< If the video encoding is running, encode audio until we reach video time */
             ( ( pC->novideo == M4OSA_FALSE)
             && (M4MCS_kStreamState_STARTED == pC->VideoState)
-            && (pC->ReaderAudioAU.m_CTS
-            + pC->m_audioAUDuration < pC->ReaderVideoAU.m_CTS)) ||
+            && (dAudioCts + uiAudioAUDuration < pC->ReaderVideoAU.m_CTS)) ||
             /**< If the video encoding is not running, perform 1 step of audio encoding */
             (( M4MCS_kStreamState_STARTED == pC->AudioState)
             && (uiAudioStepCount < 1)) )
         {
             uiAudioStepCount++;
+            M4_StepStatsStart(&pC->Stats, &timer);
 
-            /**< check if an adio effect has to be applied*/
-            err = M4MCS_intCheckAudioEffects(pC);
-
-            if( M4NO_ERROR != err )
-            {
-                M4OSA_TRACE1_1(
-                    "M4MCS_intStepEncoding(): M4MCS_intCheckAudioEffects returns err: 0x%x",
-                    err);
-                return err;
-            }
-
-            if( pC->AudioEncParams.Format == M4ENCODER_kAudioNULL )
+            if( M4OSA_NULL != pC->pAudioThread )
             {
-                err = M4MCS_intAudioNullEncoding(pC);
+                /**< The step has been done by the audio thread, only write its AU */
+                err = M4MCS_intWriteAudioStep(pC);
+                dAudioCts = pC->dAudioStepCts;
+                uiAudioAUDuration = pC->uiAudioStepDuration;
             }
-            else /**< Audio transcoding */
+            else
             {
-                err = M4MCS_intAudioTranscoding(pC);
+                /**< check if an adio effect has to be applied*/
+                err = M4MCS_intCheckAudioEffects(pC);
+
+                if( M4NO_ERROR != err )
+                {
+                    M4OSA_TRACE1_1(
+                        "M4MCS_intStepEncoding(): M4MCS_intCheckAudioEffects returns err: 0x%x",
+                        err);
+                    return err;
+                }
+
+                if( pC->AudioEncParams.Format == M4ENCODER_kAudioNULL )
+                {
+                    err = M4MCS_intAudioNullEncoding(pC);
+                }
+                else /**< Audio transcoding */
+                {
+                    err = M4MCS_intAudioTranscoding(pC);
+                }
+                dAudioCts = pC->ReaderAudioAU.m_CTS;
+                uiAudioAUDuration = pC->m_audioAUDuration;
             }
 
+            M4_StepStatsStop(&pC->Stats, M4_kStepStage_Audio, &timer);
+
             /**
             * No more space, quit properly */
             if( M4WAR_WRITER_STOP_REQ == err )
             {
                 *pProgress =
-                    (M4OSA_UInt8)(( ( (M4OSA_UInt32)pC->ReaderAudioAU.m_CTS
+                    (M4OSA_UInt8)(( ( (M4OSA_UInt32)dAudioCts
                     - pC->uiBeginCutTime) * 100)
                     / (pC->uiEndCutTime - pC->uiBeginCutTime));
 
                 pC->State = M4MCS_kState_FINISHED;
 
                 /* bad file produced on very short 3gp file */
-                if( pC->ReaderAudioAU.m_CTS - pC->uiBeginCutTime == 0 )
+                if( dAudioCts - pC->uiBeginCutTime == 0 )
                 {
                     /* Nothing has been encoded -> bad produced file -> error returned */
                     M4OSA_TRACE2_0(
@@ -7465,8 +8210,8 @@ static M4OSA_ERR M4MCS_intStepEncoding( M4MCS_InternalContext *pC,
             * Check for end cut */
             /* We absolutely want to have less or same audio duration as video ->
             (2*pC->m_audioAUDuration) */
-            if( (M4OSA_UInt32)pC->ReaderAudioAU.m_CTS
-                + (2 *pC->m_audioAUDuration) > pC->uiEndCutTime )
+            if( (M4OSA_UInt32)dAudioCts
+                + (2 *uiAudioAUDuration) > pC->uiEndCutTime )
             {
                 pC->AudioState = M4MCS_kStreamState_FINISHED;
                 break;
@@ -7519,7 +8264,9 @@ static M4OSA_ERR M4MCS_intStepEncoding( M4MCS_InternalContext *pC,
     * Increment CTS for next step */
     if( pC->novideo == M4OSA_FALSE )
     {
-        if( pC->EncodingVideoFormat == M4ENCODER_kNULL )
+        if( ( pC->EncodingVideoFormat == M4ENCODER_kNULL)
+            && (( M4OSA_FALSE == pC->bH264Trim) || (0 == pC->uiBeginCutTime)
+            || (M4OSA_TRUE == pC->bLastDecodedFrameCTS)) )
         {
            pC->dViDecCurrentCts +=  1;
         }
@@ -7667,13 +8414,25 @@ static M4OSA_ERR M4MCS_intStepBeginVideoJump( M4MCS_InternalContext *pC )
             pC->ReaderVideoAU1.m_structSize = 0;
         }
 
-        err = H264MCS_ProcessSPS_PPS(pC->m_pInstance,
-            (M4OSA_UInt8 *)pC->ReaderVideoAU1.m_dataAddress, pC->ReaderVideoAU1.m_size);
+        err = H264MCS_ProcessSPS_PPS(pC->m_pInstance,
+            (M4OSA_UInt8 *)pC->ReaderVideoAU1.m_dataAddress, pC->ReaderVideoAU1.m_size);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intStepBeginVideoJump: H264MCS_ProcessSPS_PPS returns 0x%x!",
+                err);
+            return err;
+        }
+
+        /**
+        * Only the frames up to the next sync sample will be re-encoded */
+        err = M4MCS_intFindNextVideoRap(pC);
 
         if( M4NO_ERROR != err )
         {
             M4OSA_TRACE1_1(
-                "M4MCS_intStepBeginVideoJump: H264MCS_ProcessSPS_PPS returns 0x%x!",
+                "M4MCS_intStepBeginVideoJump: M4MCS_intFindNextVideoRap returns 0x%x!",
                 err);
             return err;
         }
@@ -7683,7 +8442,16 @@ static M4OSA_ERR M4MCS_intStepBeginVideoJump( M4MCS_InternalContext *pC )
 
         iCts = iCtsOri;
 
-
+        if( ( pC->iH264NextRapCts >= 0)
+            && ((M4OSA_Double)pC->iH264NextRapCts <= pC->dViDecStartingCts) )
+        {
+            /**
+            * The begin cut is on a sync sample: nothing to re-encode, the null
+            * encoding copies the stream from it */
+            pC->dViDecCurrentCts = pC->dViDecStartingCts;
+            pC->State = M4MCS_kState_PROCESSING;
+            return M4NO_ERROR;
+        }
     }
     /* - CRLV6775 -H.264 Trimming */
 
@@ -7746,6 +8514,68 @@ static M4OSA_ERR M4MCS_intStepBeginVideoJump( M4MCS_InternalContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intFindNextVideoRap(M4MCS_InternalContext* pC)
+ * @brief    Finds the first video sync sample at or after the begin cut (H.264 trimming)
+ * @note    Reads the video AUs following the current reader position, the decoder
+ *           jumps by itself afterwards. The search stops at the end cut and at most
+ *           M4MCS_H264_RAP_SEARCH_MAX_TIME after the begin cut: iH264NextRapCts is
+ *           then set to -1 and the whole cut is re-encoded.
+ * @param   pC          (IN/OUT) MCS context
+ * @return   M4NO_ERROR:         No error
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intFindNextVideoRap( M4MCS_InternalContext *pC )
+{
+    M4OSA_ERR err;
+    M4_AccessUnit lReaderVideoAU; /**< Read video access unit */
+
+    pC->iH264NextRapCts = -1;
+
+    err = pC->m_pReader->m_pFctFillAuStruct(pC->pReaderContext,
+        (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4MCS_intFindNextVideoRap: m_pReader->m_pFctFillAuStruct(video) returns 0x%x",
+            err);
+        return err;
+    }
+
+    do
+    {
+        err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext,
+            (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
+
+        if( M4WAR_NO_MORE_AU == err )
+        {
+            return M4NO_ERROR;
+        }
+        else if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intFindNextVideoRap: m_pReaderDataIt->m_pFctGetNextAu(video)\
+                 returns 0x%x", err);
+            return err;
+        }
+
+        if( ( lReaderVideoAU.m_CTS >= pC->dViDecStartingCts)
+            && (AU_RAP == (lReaderVideoAU.m_attribute & AU_RAP)) )
+        {
+            pC->iH264NextRapCts = (M4OSA_Int32)lReaderVideoAU.m_CTS;
+            M4OSA_TRACE1_1("M4MCS_intFindNextVideoRap: next sync sample at %d ms",
+                pC->iH264NextRapCts);
+            return M4NO_ERROR;
+        }
+    } while( ( lReaderVideoAU.m_CTS < pC->uiEndCutTime)
+        && (lReaderVideoAU.m_CTS
+        < pC->dViDecStartingCts + M4MCS_H264_RAP_SEARCH_MAX_TIME) );
+
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_intStepBeginVideoDecode(M4MCS_InternalContext* pC)
@@ -8305,7 +9135,11 @@ static M4OSA_ERR M4MCS_intAudioTranscoding( M4MCS_InternalContext *pC )
            M4AD_kOptionID_GetAudioAUErrCode, (M4OSA_DataOption) &errCode);
 
     if ( M4WAR_NO_MORE_AU == errCode ) {
-        pC->AudioState = M4MCS_kStreamState_FINISHED;
+        /* With the audio thread, the state is changed when this step is written */
+        if( M4OSA_NULL == pC->pAudioThread )
+        {
+            pC->AudioState = M4MCS_kStreamState_FINISHED;
+        }
             M4OSA_TRACE2_0(
                 "M4MCS_intAudioTranscoding():\
                  m_pReaderDataIt->m_pFctGetNextAu(audio) returns M4WAR_NO_MORE_AU");
@@ -8621,15 +9455,24 @@ m4mcs_intaudiotranscoding_encode_and_write:
 
     /**
     * Prepare the writer AU */
-    err = pC->pWriterDataFcts->pStartAU(pC->pWriterContext,
-        M4MCS_WRITER_AUDIO_STREAM_ID, &pC->WriterAudioAU);
-
-    if( M4NO_ERROR != err )
+    if( M4OSA_NULL != pC->pAudioThread )
     {
-        M4OSA_TRACE1_1(
-            "M4MCS_intAudioTranscoding(): pWriterDataFcts->pStartAU(Audio) returns 0x%x",
-            err);
-        return err;
+        /* The audio thread does not use the writer, encode into the step buffer */
+        pC->WriterAudioAU.dataAddress =
+            (M4OSA_MemAddr32)pC->pAudioSteps[pC->uiAudioStepWrite].pData;
+    }
+    else
+    {
+        err = pC->pWriterDataFcts->pStartAU(pC->pWriterContext,
+            M4MCS_WRITER_AUDIO_STREAM_ID, &pC->WriterAudioAU);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intAudioTranscoding(): pWriterDataFcts->pStartAU(Audio) returns 0x%x",
+                err);
+            return err;
+        }
     }
 
     /*FlB 2009.03.04: apply audio effects if an effect is active*/
@@ -8719,6 +9562,15 @@ m4mcs_intaudiotranscoding_encode_and_write:
         /**
         * Write the encoded AU to the output file */
         pC->uiAudioAUCount++;
+
+        if( M4OSA_NULL != pC->pAudioThread )
+        {
+            /* Written by M4MCS_intWriteAudioStep */
+            pC->pAudioSteps[pC->uiAudioStepWrite].bAU = M4OSA_TRUE;
+            pC->pAudioSteps[pC->uiAudioStepWrite].AU = pC->WriterAudioAU;
+            goto m4mcs_intaudiotranscoding_end;
+        }
+
         err = pC->pWriterDataFcts->pProcessAU(pC->pWriterContext,
             M4MCS_WRITER_AUDIO_STREAM_ID, &pC->WriterAudioAU);
 
@@ -8766,6 +9618,250 @@ m4mcs_intaudiotranscoding_end:
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intAudioThread(M4OSA_Void* pParam)
+ * @brief   Audio thread function: does one audio step into the step queue.
+ * @note    Called in loop by the OSAL thread until it returns an error, which
+ *          happens after the last step (end of stream, end cut or error) or
+ *          when bAudioThreadStop is set.
+ * @param   pParam  (IN) MCS internal context
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intAudioThread( M4OSA_Void *pParam )
+{
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext *)pParam;
+    M4MCS_AudioStep *pStep;
+    M4OSA_ERR err;
+
+    M4OSA_semaphoreWait(pC->semAudioStepFree, M4OSA_WAIT_FOREVER);
+
+    if( M4OSA_TRUE == pC->bAudioThreadStop )
+    {
+        return M4WAR_NO_MORE_AU;
+    }
+
+    pStep = &pC->pAudioSteps[pC->uiAudioStepWrite];
+    pStep->bAU = M4OSA_FALSE;
+
+    /**< check if an adio effect has to be applied*/
+    err = M4MCS_intCheckAudioEffects(pC);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4MCS_intAudioTranscoding(pC);
+    }
+
+    pStep->err = err;
+    pStep->dReaderCts = pC->ReaderAudioAU.m_CTS;
+    pStep->uiAUDuration = pC->m_audioAUDuration;
+
+    pC->uiAudioStepWrite = (pC->uiAudioStepWrite + 1) % M4MCS_AUDIO_STEP_QUEUE_SIZE;
+    M4OSA_semaphorePost(pC->semAudioStepReady);
+
+    /**
+    * Same end conditions as in M4MCS_intStepEncoding */
+    if( ( M4NO_ERROR != err) || ((M4OSA_UInt32)pStep->dReaderCts
+        + (2 *pStep->uiAUDuration) > pC->uiEndCutTime) )
+    {
+        return M4WAR_NO_MORE_AU;
+    }
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intStartAudioThread(M4MCS_InternalContext* pC)
+ * @brief   Allocates the audio step queue and starts the audio thread.
+ * @param   pC          (IN/OUT) MCS internal context
+ * @return  M4NO_ERROR: No error
+ * @return  M4ERR_ALLOC: There is no more available memory
+ * @return  Any error returned by the OSAL thread or semaphore functions
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intStartAudioThread( M4MCS_InternalContext *pC )
+{
+    M4OSA_ERR err;
+    M4OSA_UInt32 i;
+
+    pC->pAudioSteps = (M4MCS_AudioStep *)M4OSA_32bitAlignedMalloc(
+        M4MCS_AUDIO_STEP_QUEUE_SIZE * sizeof(M4MCS_AudioStep), M4MCS,
+        (M4OSA_Char *)"M4MCS_intStartAudioThread: pAudioSteps");
+
+    if( M4OSA_NULL == pC->pAudioSteps )
+    {
+        return M4ERR_ALLOC;
+    }
+    memset((void *)pC->pAudioSteps, 0,
+        M4MCS_AUDIO_STEP_QUEUE_SIZE * sizeof(M4MCS_AudioStep));
+
+    for ( i = 0; i < M4MCS_AUDIO_STEP_QUEUE_SIZE; i++ )
+    {
+        pC->pAudioSteps[i].pData = (M4OSA_MemAddr8)M4OSA_32bitAlignedMalloc(
+            pC->uiAudioMaxAuSize, M4MCS,
+            (M4OSA_Char *)"M4MCS_intStartAudioThread: step data");
+
+        if( M4OSA_NULL == pC->pAudioSteps[i].pData )
+        {
+            err = M4ERR_ALLOC;
+            goto cleanup;
+        }
+    }
+
+    err = M4OSA_semaphoreOpen(&pC->semAudioStepFree, M4MCS_AUDIO_STEP_QUEUE_SIZE);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    err = M4OSA_semaphoreOpen(&pC->semAudioStepReady, 0);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    pC->bAudioThreadStop = M4OSA_FALSE;
+    pC->uiAudioStepWrite = 0;
+    pC->uiAudioStepRead = 0;
+    pC->dAudioStepCts = pC->ReaderAudioAU.m_CTS;
+    pC->uiAudioStepDuration = pC->m_audioAUDuration;
+
+    err = M4OSA_threadSyncOpen(&pC->pAudioThread,
+        (M4OSA_ThreadDoIt)M4MCS_intAudioThread);
+
+    if( M4NO_ERROR != err )
+    {
+        pC->pAudioThread = M4OSA_NULL;
+        goto cleanup;
+    }
+
+    err = M4OSA_threadSyncStart(pC->pAudioThread, (M4OSA_Void *)pC);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_threadSyncClose(pC->pAudioThread);
+        pC->pAudioThread = M4OSA_NULL;
+        goto cleanup;
+    }
+
+    M4OSA_TRACE3_0("M4MCS_intStartAudioThread(): audio thread started");
+    return M4NO_ERROR;
+
+cleanup:
+    M4MCS_intStopAudioThread(pC);
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4MCS_intStopAudioThread(M4MCS_InternalContext* pC)
+ * @brief   Stops the audio thread if any and frees the audio step queue.
+ * @note    Steps done by the thread but not written yet are dropped.
+ * @param   pC          (IN/OUT) MCS internal context
+ ******************************************************************************
+ */
+static M4OSA_Void M4MCS_intStopAudioThread( M4MCS_InternalContext *pC )
+{
+    M4OSA_ThreadState state;
+    M4OSA_UInt32 i;
+
+    if( M4OSA_NULL != pC->pAudioThread )
+    {
+        /**
+        * Wake the thread up if it waits for a free step */
+        pC->bAudioThreadStop = M4OSA_TRUE;
+        M4OSA_semaphorePost(pC->semAudioStepFree);
+
+        M4OSA_threadSyncGetState(pC->pAudioThread, &state);
+
+        while( M4OSA_kThreadOpened != state )
+        {
+            M4OSA_threadSleep(1);
+            M4OSA_threadSyncGetState(pC->pAudioThread, &state);
+        }
+        M4OSA_threadSyncClose(pC->pAudioThread);
+        pC->pAudioThread = M4OSA_NULL;
+    }
+
+    if( M4OSA_NULL != pC->semAudioStepFree )
+    {
+        M4OSA_semaphoreClose(pC->semAudioStepFree);
+        pC->semAudioStepFree = M4OSA_NULL;
+    }
+
+    if( M4OSA_NULL != pC->semAudioStepReady )
+    {
+        M4OSA_semaphoreClose(pC->semAudioStepReady);
+        pC->semAudioStepReady = M4OSA_NULL;
+    }
+
+    if( M4OSA_NULL != pC->pAudioSteps )
+    {
+        for ( i = 0; i < M4MCS_AUDIO_STEP_QUEUE_SIZE; i++ )
+        {
+            if( M4OSA_NULL != pC->pAudioSteps[i].pData )
+            {
+                free(pC->pAudioSteps[i].pData);
+            }
+        }
+        free(pC->pAudioSteps);
+        pC->pAudioSteps = M4OSA_NULL;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intWriteAudioStep(M4MCS_InternalContext* pC)
+ * @brief   Waits for the next step done by the audio thread and writes its AU.
+ * @param   pC          (IN/OUT) MCS internal context
+ * @return  The error of the audio step, or of the writer
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intWriteAudioStep( M4MCS_InternalContext *pC )
+{
+    M4MCS_AudioStep *pStep = &pC->pAudioSteps[pC->uiAudioStepRead];
+    M4SYS_AccessUnit writerAU;
+    M4OSA_ERR err;
+
+    M4OSA_semaphoreWait(pC->semAudioStepReady, M4OSA_WAIT_FOREVER);
+
+    err = pStep->err;
+    pC->dAudioStepCts = pStep->dReaderCts;
+    pC->uiAudioStepDuration = pStep->uiAUDuration;
+
+    if( M4OSA_TRUE == pStep->bAU )
+    {
+        writerAU = pStep->AU;
+
+        err = pC->pWriterDataFcts->pStartAU(pC->pWriterContext,
+            M4MCS_WRITER_AUDIO_STREAM_ID, &writerAU);
+
+        if( M4NO_ERROR == err )
+        {
+            memcpy((void *)writerAU.dataAddress, (void *)pStep->pData,
+                pStep->AU.size);
+            writerAU.size = pStep->AU.size;
+            writerAU.CTS = pStep->AU.CTS;
+
+            err = pC->pWriterDataFcts->pProcessAU(pC->pWriterContext,
+                M4MCS_WRITER_AUDIO_STREAM_ID, &writerAU);
+        }
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4MCS_intWriteAudioStep(): writer returns 0x%x", err);
+        }
+    }
+
+    pC->uiAudioStepRead = (pC->uiAudioStepRead + 1) % M4MCS_AUDIO_STEP_QUEUE_SIZE;
+    M4OSA_semaphorePost(pC->semAudioStepFree);
+
+    return err;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4MCS_intReallocTemporaryAU(M4OSA_MemAddr8* addr, M4OSA_UInt32 newSize)
@@ -8810,13 +9906,19 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
     M4OSA_MemAddr8 WritebufferAdd = M4OSA_NULL;
     M4OSA_Int32 lastdecodedCTS = 0;
     M4_AccessUnit lReaderVideoAU; /**< Read video access unit */
+    M4_StepTimer timer;
 
     if( pC->novideo )
         return M4NO_ERROR;
 
-    /* H.264 Trimming */
+    /* H.264 Trimming: the frames from the begin cut up to the next sync sample are
+    re-encoded, then the stream is copied from the sync sample on (the copied slice
+    headers are still rewritten to the encoder SPS/PPS). Without sync sample found,
+    the whole cut is re-encoded */
     if( ( ( pC->bH264Trim == M4OSA_TRUE)
-        && (pC->uiVideoAUCount < pC->m_pInstance->clip_sps.num_ref_frames)
+        && (pC->bLastDecodedFrameCTS == M4OSA_FALSE)
+        && (( pC->iH264NextRapCts < 0)
+        || (( pC->dViDecCurrentCts + pC->dCtsIncrement) < pC->iH264NextRapCts))
         && (pC->uiBeginCutTime > 0))
         || (( pC->uiVideoAUCount == 0) && (pC->uiBeginCutTime > 0)) )
     {
@@ -8895,6 +9997,12 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
             }
         }
 
+        if( ( M4OSA_TRUE == pC->bH264Trim) && (pC->iH264NextRapCts >= 0) )
+        {
+            /* The frames were re-encoded up to the next sync sample, copy from it */
+            lastdecodedCTS = pC->iH264NextRapCts;
+        }
+
         err = pC->m_pReader->m_pFctJump(pC->pReaderContext,
             (M4_StreamHandler *)pC->pReaderVideoStream, &lastdecodedCTS);
 
@@ -8905,42 +10013,43 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
             return err;
         }
 
+        if( ( M4OSA_FALSE == pC->bH264Trim) || (pC->iH264NextRapCts < 0) )
+        {
+            /* Skip the last decoded AU, already encoded */
+            err = pC->m_pReader->m_pFctFillAuStruct(pC->pReaderContext,
+                (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
 
-        /* Initializes an access Unit */
-
-        err = pC->m_pReader->m_pFctFillAuStruct(pC->pReaderContext,
-            (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
+            if (M4NO_ERROR != err) {
+                M4OSA_TRACE1_1(
+                    "M4MCS_intVideoNullEncoding:m_pReader->m_pFctFillAuStruct(video)\
+                    returns 0x%x", err);
+                return err;
+            }
 
-        if (M4NO_ERROR != err) {
-            M4OSA_TRACE1_1(
-                "M4MCS_intVideoNullEncoding:m_pReader->m_pFctFillAuStruct(video)\
-                returns 0x%x", err);
-            return err;
-        }
+            err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext,
+                (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
 
-        err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext,
-            (M4_StreamHandler *)pC->pReaderVideoStream, &lReaderVideoAU);
+            if (M4WAR_NO_MORE_AU == err) {
+                M4OSA_TRACE2_0(
+                    "M4MCS_intVideoNullEncoding():\
+                     m_pReaderDataIt->m_pFctGetNextAu(video) returns M4WAR_NO_MORE_AU");
+                /* The audio transcoding is finished */
+                pC->VideoState = M4MCS_kStreamState_FINISHED;
+                return err;
+            }
+            else if (M4NO_ERROR != err) {
+                M4OSA_TRACE1_1(
+                    "M4MCS_intVideoNullEncoding():\
+                     m_pReaderDataIt->m_pFctGetNextAu(video) returns 0x%x",
+                    err);
+                return err;
+            }
 
-        if (M4WAR_NO_MORE_AU == err) {
-            M4OSA_TRACE2_0(
-                "M4MCS_intVideoNullEncoding():\
-                 m_pReaderDataIt->m_pFctGetNextAu(video) returns M4WAR_NO_MORE_AU");
-            /* The audio transcoding is finished */
-            pC->VideoState = M4MCS_kStreamState_FINISHED;
-            return err;
-        }
-        else if (M4NO_ERROR != err) {
             M4OSA_TRACE1_1(
-                "M4MCS_intVideoNullEncoding():\
-                 m_pReaderDataIt->m_pFctGetNextAu(video) returns 0x%x",
-                err);
-            return err;
+                "### [TS_CHECK] M4MCS_intVideoNullEncoding  video AU CTS: %d ",
+                lReaderVideoAU.m_CTS);
         }
 
-        M4OSA_TRACE1_1(
-            "### [TS_CHECK] M4MCS_intVideoNullEncoding  video AU CTS: %d ",
-            lReaderVideoAU.m_CTS);
-
 
     }
 
@@ -9052,9 +10161,11 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
     {
         memcpy((void *) &pC->ReaderVideoAU,
             (void *) &pC->ReaderVideoAU2, sizeof(M4_AccessUnit));
+        M4_StepStatsStart(&pC->Stats, &timer);
         err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext,
             (M4_StreamHandler *)pC->pReaderVideoStream,
             &pC->ReaderVideoAU1);
+        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
 
         if( pC->ReaderVideoAU1.m_maxsize
             > pC->pReaderVideoStream->m_basicProperties.m_maxAUSize )
@@ -9086,9 +10197,11 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
     {
         memcpy((void *) &pC->ReaderVideoAU,
             (void *) &pC->ReaderVideoAU1, sizeof(M4_AccessUnit));
+        M4_StepStatsStart(&pC->Stats, &timer);
         err = pC->m_pReaderDataIt->m_pFctGetNextAu(pC->pReaderContext,
             (M4_StreamHandler *)pC->pReaderVideoStream,
             &pC->ReaderVideoAU2);
+        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
 
         if( pC->ReaderVideoAU2.m_maxsize
             > pC->pReaderVideoStream->m_basicProperties.m_maxAUSize )
@@ -9186,9 +10299,22 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
 
                 if( pC->m_pInstance->is_done == 1 )
                 {
-                    M4MCS_convetFromByteStreamtoNALStream(
-                        (M4OSA_UInt8 *)pC->ReaderVideoAU.m_dataAddress ,
-                        pC->ReaderVideoAU.m_size);
+                    /* The reader AUs normally already have NAL sizes, only
+                    start codes are converted (in place, the size is unchanged) */
+                    err = M4VD_Tools_ConvertByteStreamToNALStream(
+                        (M4OSA_UInt8 *)pC->ReaderVideoAU.m_dataAddress,
+                        pC->ReaderVideoAU.m_size,
+                        (M4OSA_UInt8 *)pC->ReaderVideoAU.m_dataAddress,
+                        M4OSA_NULL);
+
+                    if( M4NO_ERROR != err )
+                    {
+                        M4OSA_TRACE1_1(
+                            "M4MCS_intVideoNullEncoding():\
+                            M4VD_Tools_ConvertByteStreamToNALStream returns 0x%x",
+                            err);
+                        return err;
+                    }
 
                     memcpy((void *)pC->WriterVideoAU.dataAddress,
                         (void *)(pC->ReaderVideoAU.m_dataAddress + 4),
@@ -9229,8 +10355,10 @@ static M4OSA_ERR M4MCS_intVideoNullEncoding( M4MCS_InternalContext *pC )
         /**
         * Write it to the output file */
         pC->uiVideoAUCount++;
+        M4_StepStatsStart(&pC->Stats, &timer);
         err = pC->pWriterDataFcts->pProcessAU(pC->pWriterContext,
             M4MCS_WRITER_VIDEO_STREAM_ID, &pC->WriterVideoAU);
+        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Write, &timer);
 
         if( M4NO_ERROR != err )
         {
@@ -9282,6 +10410,7 @@ static M4OSA_ERR M4MCS_intVideoTranscoding( M4MCS_InternalContext *pC )
     M4_MediaTime mtTranscodedTime = 0.0;
     M4ENCODER_FrameMode FrameMode;
     M4OSA_Int32 derive = 0;
+    M4_StepTimer timer;
 
     /**
     * Get video CTS to decode */
@@ -9294,8 +10423,10 @@ static M4OSA_ERR M4MCS_intVideoTranscoding( M4MCS_InternalContext *pC )
         "M4MCS_intVideoTranscoding(): Calling m_pVideoDecoder->m_pFctDecode(%.2f)",
         mtTranscodedTime);
     pC->isRenderDup = M4OSA_FALSE;
+    M4_StepStatsStart(&pC->Stats, &timer);
     err = pC->m_pVideoDecoder->m_pFctDecode(pC->pViDecCtxt, &mtTranscodedTime,
         M4OSA_FALSE, 0);
+    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Decode, &timer);
 
     if( M4WAR_NO_MORE_AU == err )
     {
@@ -9348,9 +10479,11 @@ static M4OSA_ERR M4MCS_intVideoTranscoding( M4MCS_InternalContext *pC )
          = %.2f",pC->ReaderVideoAU.m_CTS);
     pC->uiVideoAUCount++;
     /* update the given duration (the begin cut is not a real CTS)*/
+    M4_StepStatsStart(&pC->Stats, &timer);
     err = pC->pVideoEncoderGlobalFcts->pFctEncode(pC->pViEncCtxt, M4OSA_NULL,
         (pC->dViDecCurrentCts - pC->dViDecStartingCts - (derive >> 1)),
         FrameMode);
+    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Encode, &timer);
 
     return err;
 }
@@ -0,0 +1,631 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ *************************************************************************
+ * @file   M4MCS_Batch.c
+ * @brief  MCS batch transcoding queue
+ * @note   Jobs are transcoded by a fixed number of lanes. Each lane is a
+ *         thread owning one MCS context, which is reset (and not cleaned
+ *         up) between two jobs. The video encoder of a completed job stays
+ *         stopped and is started again by the next job of the lane when the
+ *         output format, size, frame rate, bitrate, profile and level match.
+ *************************************************************************
+ **/
+
+/****************/
+/*** Includes ***/
+/****************/
+
+/**
+ * OSAL headers */
+#include "M4OSA_Memory.h"   /**< OSAL memory management */
+#include "M4OSA_Debug.h"    /**< OSAL debug management */
+#include "M4OSA_Mutex.h"
+#include "M4OSA_Semaphore.h"
+#include "M4OSA_Thread.h"
+
+/* Our headers */
+#include "M4MCS_API.h"
+#include "M4MCS_ErrorCodes.h"
+#include "M4MCS_InternalTypes.h"
+
+/**
+ * Number of job entries allocated at open, doubled when needed */
+#define M4MCS_BATCH_INITIAL_JOBS    16
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4MCS_intBatchNotify(M4MCS_BatchInternalContext* pB, M4OSA_UInt32 uiJobId,
+ *                                 M4MCS_BatchJobState state, M4OSA_UInt8 uiProgress,
+ *                                 M4OSA_ERR err)
+ * @brief    Calls the user progress callback, if any
+ ******************************************************************************
+ */
+static M4OSA_Void M4MCS_intBatchNotify( M4MCS_BatchInternalContext *pB,
+                                       M4OSA_UInt32 uiJobId,
+                                       M4MCS_BatchJobState state,
+                                       M4OSA_UInt8 uiProgress, M4OSA_ERR err )
+{
+    if( M4OSA_NULL != pB->pProgressFct )
+    {
+        pB->pProgressFct(pB->pUserData, uiJobId, state, uiProgress, err);
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intBatchRunJob(M4MCS_BatchLane* pLane, M4OSA_UInt32 uiJobId,
+ *                                M4MCS_BatchJob* pJob)
+ * @brief    Transcodes one job with the MCS context of the lane
+ * @note     The MCS context is reset before returning, whatever the result
+ * @return   M4NO_ERROR when the output file is complete, M4MCS_WAR_BATCH_JOB_CANCELLED
+ *           or the MCS error otherwise
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intBatchRunJob( M4MCS_BatchLane *pLane,
+                                      M4OSA_UInt32 uiJobId, M4MCS_BatchJob *pJob )
+{
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pLane->pBatch;
+    M4OSA_ERR err;
+    M4OSA_UInt8 uiProgress = 0;
+    M4OSA_UInt8 uiLastProgress = 0;
+    M4OSA_Bool bCancel;
+
+    err = M4MCS_open(pLane->pMcs, pJob->pInputFile, pJob->InputFileType,
+        pJob->pOutputFile, pJob->pTempFile);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4MCS_setOutputParams(pLane->pMcs, &pJob->OutputParams);
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4MCS_setEncodingParams(pLane->pMcs, &pJob->EncodingParams);
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        /* Always set: M4MCS_reset keeps the mode of the previous job of the lane */
+        err = M4MCS_setTwoPassRateControl(pLane->pMcs, pJob->bTwoPassRateControl);
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4MCS_checkParamsAndStart(pLane->pMcs);
+    }
+
+    while( M4NO_ERROR == err )
+    {
+        M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+        bCancel = pB->pJobs[uiJobId].bCancel;
+        M4OSA_mutexUnlock(pB->mutex);
+
+        if( M4OSA_TRUE == bCancel )
+        {
+            err = M4MCS_WAR_BATCH_JOB_CANCELLED;
+            break;
+        }
+
+        err = M4MCS_step(pLane->pMcs, &uiProgress);
+
+        if( ( M4NO_ERROR == err) && (uiProgress != uiLastProgress) )
+        {
+            M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+            pB->pJobs[uiJobId].uiProgress = uiProgress;
+            M4OSA_mutexUnlock(pB->mutex);
+
+            M4MCS_intBatchNotify(pB, uiJobId, M4MCS_kBatchJobRunning, uiProgress,
+                M4NO_ERROR);
+            uiLastProgress = uiProgress;
+        }
+    }
+
+    if( M4MCS_WAR_TRANSCODING_DONE == err )
+    {
+        err = M4MCS_close(pLane->pMcs);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_2("M4MCS_intBatchRunJob: job %d, M4MCS_close returns 0x%x",
+                uiJobId, err);
+        }
+    }
+    else
+    {
+        M4OSA_TRACE1_2("M4MCS_intBatchRunJob: job %d stopped with 0x%x", uiJobId, err);
+    }
+
+    /**
+    * Get the context back to the created state for the next job, keeping the
+    * video encoder of a completed job */
+    M4MCS_reset(pLane->pMcs);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intBatchLane(M4OSA_Void* pParam)
+ * @brief    Lane thread function: waits for a pending job and transcodes it
+ * @note     Called in loop by the OSAL thread until it returns an error, which
+ *           only happens when the batch is closed
+ ******************************************************************************
+ */
+static M4OSA_ERR M4MCS_intBatchLane( M4OSA_Void *pParam )
+{
+    M4MCS_BatchLane *pLane = (M4MCS_BatchLane *)pParam;
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pLane->pBatch;
+    M4MCS_BatchJob job;
+    M4MCS_BatchJobState state;
+    M4OSA_UInt32 uiJobId;
+    M4OSA_ERR err;
+
+    M4OSA_semaphoreWait(pB->semJobs, M4OSA_WAIT_FOREVER);
+
+    M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+
+    if( M4OSA_TRUE == pB->bClosing )
+    {
+        M4OSA_mutexUnlock(pB->mutex);
+        return M4WAR_NO_MORE_AU;
+    }
+
+    /**
+    * Jobs cancelled while pending are skipped; their semaphore post is
+    * consumed here */
+    while( ( pB->uiNextJob < pB->uiNbJobs)
+        && (M4MCS_kBatchJobPending != pB->pJobs[pB->uiNextJob].state) )
+    {
+        pB->uiNextJob++;
+    }
+
+    if( pB->uiNextJob == pB->uiNbJobs )
+    {
+        M4OSA_mutexUnlock(pB->mutex);
+        return M4NO_ERROR;
+    }
+
+    uiJobId = pB->uiNextJob++;
+    pB->pJobs[uiJobId].state = M4MCS_kBatchJobRunning;
+    job = pB->pJobs[uiJobId].job;
+
+    M4OSA_mutexUnlock(pB->mutex);
+
+    M4MCS_intBatchNotify(pB, uiJobId, M4MCS_kBatchJobRunning, 0, M4NO_ERROR);
+
+    err = M4MCS_intBatchRunJob(pLane, uiJobId, &job);
+
+    if( M4NO_ERROR == err )
+    {
+        state = M4MCS_kBatchJobDone;
+    }
+    else if( M4MCS_WAR_BATCH_JOB_CANCELLED == err )
+    {
+        state = M4MCS_kBatchJobCancelled;
+    }
+    else
+    {
+        state = M4MCS_kBatchJobFailed;
+    }
+
+    M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+    pB->pJobs[uiJobId].state = state;
+    pB->pJobs[uiJobId].err = err;
+
+    if( M4MCS_kBatchJobDone == state )
+    {
+        pB->pJobs[uiJobId].uiProgress = 100;
+    }
+    M4OSA_mutexUnlock(pB->mutex);
+
+    M4MCS_intBatchNotify(pB, uiJobId, state,
+        (M4OSA_UInt8)((M4MCS_kBatchJobDone == state) ? 100 : 0), err);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchOpen(M4MCS_BatchContext* pContext, M4OSA_UInt32 uiNbLanes,
+ *                           M4OSA_FileReadPointer* pFileReadPtrFct,
+ *                           M4OSA_FileWriterPointer* pFileWritePtrFct,
+ *                           M4MCS_BatchProgressFct pProgressFct, M4OSA_Void* pUserData)
+ * @brief    Creates a batch transcoding queue with uiNbLanes parallel lanes.
+ * @param    pContext            (OUT) Batch context
+ * @param    uiNbLanes           (IN) Number of jobs transcoded at the same time
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param    pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
+ * @param    pProgressFct        (IN) Progress callback, can be M4OSA_NULL
+ * @param    pUserData           (IN) Given back to pProgressFct
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL or uiNbLanes is 0
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchOpen( M4MCS_BatchContext *pContext, M4OSA_UInt32 uiNbLanes,
+                          M4OSA_FileReadPointer *pFileReadPtrFct,
+                          M4OSA_FileWriterPointer *pFileWritePtrFct,
+                          M4MCS_BatchProgressFct pProgressFct, M4OSA_Void *pUserData )
+{
+    M4MCS_BatchInternalContext *pB;
+    M4OSA_ERR err;
+    M4OSA_UInt32 i;
+
+    M4OSA_TRACE2_2("M4MCS_batchOpen called with pContext=0x%x, uiNbLanes=%d",
+        pContext, uiNbLanes);
+
+    if( ( M4OSA_NULL == pContext) || (0 == uiNbLanes)
+        || (M4OSA_NULL == pFileReadPtrFct) || (M4OSA_NULL == pFileWritePtrFct) )
+    {
+        return M4ERR_PARAMETER;
+    }
+    *pContext = M4OSA_NULL;
+
+    pB = (M4MCS_BatchInternalContext *)M4OSA_32bitAlignedMalloc(
+        sizeof(M4MCS_BatchInternalContext), M4MCS,
+        (M4OSA_Char *)"M4MCS_BatchInternalContext");
+
+    if( M4OSA_NULL == pB )
+    {
+        return M4ERR_ALLOC;
+    }
+    memset((void *)pB, 0, sizeof(M4MCS_BatchInternalContext));
+    pB->pProgressFct = pProgressFct;
+    pB->pUserData = pUserData;
+
+    /**
+    * From now on, M4MCS_batchClose frees whatever has been created */
+    *pContext = (M4MCS_BatchContext)pB;
+
+    err = M4OSA_mutexOpen(&pB->mutex);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    err = M4OSA_semaphoreOpen(&pB->semJobs, 0);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    pB->pJobs = (M4MCS_BatchJobEntry *)M4OSA_32bitAlignedMalloc(
+        M4MCS_BATCH_INITIAL_JOBS * sizeof(M4MCS_BatchJobEntry), M4MCS,
+        (M4OSA_Char *)"M4MCS_batchOpen: pJobs");
+    pB->pLanes = (M4MCS_BatchLane *)M4OSA_32bitAlignedMalloc(
+        uiNbLanes * sizeof(M4MCS_BatchLane), M4MCS,
+        (M4OSA_Char *)"M4MCS_batchOpen: pLanes");
+
+    if( ( M4OSA_NULL == pB->pJobs) || (M4OSA_NULL == pB->pLanes) )
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+    pB->uiMaxJobs = M4MCS_BATCH_INITIAL_JOBS;
+    memset((void *)pB->pLanes, 0, uiNbLanes * sizeof(M4MCS_BatchLane));
+
+    for ( i = 0; i < uiNbLanes; i++ )
+    {
+        M4MCS_BatchLane *pLane = &pB->pLanes[i];
+
+        pLane->pBatch = (M4OSA_Void *)pB;
+
+        err = M4MCS_init(&pLane->pMcs, pFileReadPtrFct, pFileWritePtrFct);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1("M4MCS_batchOpen: M4MCS_init returns 0x%x", err);
+            /* A partially initialized context is freed by abort */
+            M4MCS_abort(pLane->pMcs);
+            pLane->pMcs = M4OSA_NULL;
+            goto cleanup;
+        }
+        pB->uiNbLanes++;
+
+        err = M4OSA_threadSyncOpen(&pLane->pThread, (M4OSA_ThreadDoIt)M4MCS_intBatchLane);
+
+        if( M4NO_ERROR != err )
+        {
+            pLane->pThread = M4OSA_NULL;
+            goto cleanup;
+        }
+
+        err = M4OSA_threadSyncStart(pLane->pThread, (M4OSA_Void *)pLane);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_threadSyncClose(pLane->pThread);
+            pLane->pThread = M4OSA_NULL;
+            goto cleanup;
+        }
+    }
+
+    return M4NO_ERROR;
+
+cleanup:
+    M4OSA_TRACE1_1("M4MCS_batchOpen: returning 0x%x", err);
+    M4MCS_batchClose((M4MCS_BatchContext)pB);
+    *pContext = M4OSA_NULL;
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchAddJob(M4MCS_BatchContext pContext, M4MCS_BatchJob* pJob,
+ *                             M4OSA_UInt32* pJobId)
+ * @brief    Queues a transcoding. Jobs are started in the order they are added.
+ * @param    pContext            (IN) Batch context
+ * @param    pJob                (IN) Job parameters, copied
+ * @param    pJobId              (OUT) Job identifier
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ * @return   M4ERR_STATE:        The batch is being closed
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchAddJob( M4MCS_BatchContext pContext, M4MCS_BatchJob *pJob,
+                            M4OSA_UInt32 *pJobId )
+{
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pContext;
+    M4MCS_BatchJobEntry *pEntry;
+
+    if( ( M4OSA_NULL == pB) || (M4OSA_NULL == pJob) || (M4OSA_NULL == pJobId) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+
+    if( M4OSA_TRUE == pB->bClosing )
+    {
+        M4OSA_mutexUnlock(pB->mutex);
+        return M4ERR_STATE;
+    }
+
+    if( pB->uiNbJobs == pB->uiMaxJobs )
+    {
+        M4MCS_BatchJobEntry *pJobs = (M4MCS_BatchJobEntry *)M4OSA_32bitAlignedMalloc(
+            2 * pB->uiMaxJobs * sizeof(M4MCS_BatchJobEntry), M4MCS,
+            (M4OSA_Char *)"M4MCS_batchAddJob: pJobs");
+
+        if( M4OSA_NULL == pJobs )
+        {
+            M4OSA_mutexUnlock(pB->mutex);
+            return M4ERR_ALLOC;
+        }
+        memcpy((void *)pJobs, (void *)pB->pJobs,
+            pB->uiNbJobs * sizeof(M4MCS_BatchJobEntry));
+        free(pB->pJobs);
+        pB->pJobs = pJobs;
+        pB->uiMaxJobs *= 2;
+    }
+
+    pEntry = &pB->pJobs[pB->uiNbJobs];
+    pEntry->job = *pJob;
+    pEntry->state = M4MCS_kBatchJobPending;
+    pEntry->uiProgress = 0;
+    pEntry->err = M4NO_ERROR;
+    pEntry->bCancel = M4OSA_FALSE;
+    *pJobId = pB->uiNbJobs;
+    pB->uiNbJobs++;
+
+    M4OSA_mutexUnlock(pB->mutex);
+
+    M4OSA_semaphorePost(pB->semJobs);
+
+    M4OSA_TRACE3_1("M4MCS_batchAddJob: job %d queued", *pJobId);
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchCancelJob(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId)
+ * @brief    Cancels a pending or running job.
+ * @param    pContext            (IN) Batch context
+ * @param    uiJobId             (IN) Job identifier
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    Unknown job identifier
+ * @return   M4ERR_STATE:        The job is already finished
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchCancelJob( M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId )
+{
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pContext;
+    M4OSA_ERR err = M4NO_ERROR;
+    M4OSA_Bool bNotify = M4OSA_FALSE;
+
+    if( M4OSA_NULL == pB )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+
+    if( uiJobId >= pB->uiNbJobs )
+    {
+        err = M4ERR_PARAMETER;
+    }
+    else if( M4MCS_kBatchJobPending == pB->pJobs[uiJobId].state )
+    {
+        pB->pJobs[uiJobId].state = M4MCS_kBatchJobCancelled;
+        pB->pJobs[uiJobId].err = M4MCS_WAR_BATCH_JOB_CANCELLED;
+        bNotify = M4OSA_TRUE;
+    }
+    else if( M4MCS_kBatchJobRunning == pB->pJobs[uiJobId].state )
+    {
+        /* The lane notifies the cancellation when the job is stopped */
+        pB->pJobs[uiJobId].bCancel = M4OSA_TRUE;
+    }
+    else
+    {
+        err = M4ERR_STATE;
+    }
+
+    M4OSA_mutexUnlock(pB->mutex);
+
+    if( M4OSA_TRUE == bNotify )
+    {
+        M4MCS_intBatchNotify(pB, uiJobId, M4MCS_kBatchJobCancelled, 0,
+            M4MCS_WAR_BATCH_JOB_CANCELLED);
+    }
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchGetJobStatus(M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId,
+ *                                   M4MCS_BatchJobState* pState, M4OSA_UInt8* pProgress,
+ *                                   M4OSA_ERR* pJobErr)
+ * @brief    Gets the state, the progress and the result of a job.
+ * @param    pContext            (IN) Batch context
+ * @param    uiJobId             (IN) Job identifier
+ * @param    pState              (OUT) Job state
+ * @param    pProgress           (OUT) Job progress, 0..100
+ * @param    pJobErr             (OUT) Job result, M4NO_ERROR if not finished or done
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    Unknown job identifier or a parameter is M4OSA_NULL
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchGetJobStatus( M4MCS_BatchContext pContext, M4OSA_UInt32 uiJobId,
+                                  M4MCS_BatchJobState *pState, M4OSA_UInt8 *pProgress,
+                                  M4OSA_ERR *pJobErr )
+{
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pContext;
+
+    if( ( M4OSA_NULL == pB) || (M4OSA_NULL == pState) || (M4OSA_NULL == pProgress)
+        || (M4OSA_NULL == pJobErr) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+
+    if( uiJobId >= pB->uiNbJobs )
+    {
+        M4OSA_mutexUnlock(pB->mutex);
+        return M4ERR_PARAMETER;
+    }
+    *pState = pB->pJobs[uiJobId].state;
+    *pProgress = pB->pJobs[uiJobId].uiProgress;
+    *pJobErr = pB->pJobs[uiJobId].err;
+
+    M4OSA_mutexUnlock(pB->mutex);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_batchClose(M4MCS_BatchContext pContext)
+ * @brief    Cancels the pending and running jobs, stops the lanes and frees the batch.
+ * @param    pContext            (IN) Batch context
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    pContext is M4OSA_NULL
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_batchClose( M4MCS_BatchContext pContext )
+{
+    M4MCS_BatchInternalContext *pB = (M4MCS_BatchInternalContext *)pContext;
+    M4OSA_ThreadState state;
+    M4OSA_UInt32 i;
+
+    M4OSA_TRACE2_1("M4MCS_batchClose called with pContext=0x%x", pContext);
+
+    if( M4OSA_NULL == pB )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    if( M4OSA_NULL != pB->mutex )
+    {
+        M4OSA_mutexLock(pB->mutex, M4OSA_WAIT_FOREVER);
+        pB->bClosing = M4OSA_TRUE;
+
+        for ( i = 0; i < pB->uiNbJobs; i++ )
+        {
+            if( M4MCS_kBatchJobPending == pB->pJobs[i].state )
+            {
+                pB->pJobs[i].state = M4MCS_kBatchJobCancelled;
+                pB->pJobs[i].err = M4MCS_WAR_BATCH_JOB_CANCELLED;
+            }
+            else if( M4MCS_kBatchJobRunning == pB->pJobs[i].state )
+            {
+                pB->pJobs[i].bCancel = M4OSA_TRUE;
+            }
+        }
+        M4OSA_mutexUnlock(pB->mutex);
+    }
+
+    /**
+    * Wake up all the lanes: they exit once their current job is stopped */
+    for ( i = 0; i < pB->uiNbLanes; i++ )
+    {
+        if( M4OSA_NULL != pB->semJobs )
+        {
+            M4OSA_semaphorePost(pB->semJobs);
+        }
+    }
+
+    for ( i = 0; i < pB->uiNbLanes; i++ )
+    {
+        M4MCS_BatchLane *pLane = &pB->pLanes[i];
+
+        if( M4OSA_NULL != pLane->pThread )
+        {
+            M4OSA_threadSyncGetState(pLane->pThread, &state);
+
+            while( M4OSA_kThreadOpened != state )
+            {
+                M4OSA_threadSleep(1);
+                M4OSA_threadSyncGetState(pLane->pThread, &state);
+            }
+            M4OSA_threadSyncClose(pLane->pThread);
+            pLane->pThread = M4OSA_NULL;
+        }
+
+        if( M4OSA_NULL != pLane->pMcs )
+        {
+            M4MCS_abort(pLane->pMcs);
+            pLane->pMcs = M4OSA_NULL;
+        }
+    }
+
+    if( M4OSA_NULL != pB->pLanes )
+    {
+        free(pB->pLanes);
+    }
+
+    if( M4OSA_NULL != pB->pJobs )
+    {
+        free(pB->pJobs);
+    }
+
+    if( M4OSA_NULL != pB->semJobs )
+    {
+        M4OSA_semaphoreClose(pB->semJobs);
+    }
+
+    if( M4OSA_NULL != pB->mutex )
+    {
+        M4OSA_mutexClose(pB->mutex);
+    }
+    free(pB);
+
+    return M4NO_ERROR;
+}
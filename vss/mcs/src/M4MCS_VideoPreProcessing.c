@@ -53,10 +53,10 @@
 
 /*
  ******************************************************************************
- * M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
- *                               M4VIFI_ImagePlane* pPlaneOut)
+ * M4OSA_ERR M4MCS_intRenderAndResize(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
+ *                                     M4VIFI_ImagePlane* pPlaneOut)
  * @brief    Do the video rendering and the resize (if needed)
- * @note    It is called by the video encoder
+ * @note    It is called by the video encoder, through M4MCS_intApplyVPP
  * @param    pContext    (IN) VPP context, which actually is the MCS internal context in our case
  * @param    pPlaneIn    (IN) Contains the image
  * @param    pPlaneOut    (IN/OUT) Pointer to an array of 3 planes that will contain the output
@@ -67,8 +67,9 @@
  * @return    Any error returned by an underlaying module
  ******************************************************************************
  */
-M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
-                             M4VIFI_ImagePlane* pPlaneOut)
+static M4OSA_ERR M4MCS_intRenderAndResize(M4VPP_Context pContext,
+                                          M4VIFI_ImagePlane* pPlaneIn,
+                                          M4VIFI_ImagePlane* pPlaneOut)
 {
     M4OSA_ERR        err = M4NO_ERROR;
 
@@ -433,16 +434,16 @@ M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
     }
     else
     {
-        /* Copy last decoded plane to output plane */
+        /* Copy last decoded plane to output plane (both have the encoder stride) */
         memcpy((void *)pPlaneOut[0].pac_data,
                         (void *)pC->lastDecodedPlane[0].pac_data,
-                         (pPlaneOut[0].u_height * pPlaneOut[0].u_width));
+                         (pPlaneOut[0].u_height * pPlaneOut[0].u_stride));
         memcpy((void *)pPlaneOut[1].pac_data,
                         (void *)pC->lastDecodedPlane[1].pac_data,
-                          (pPlaneOut[1].u_height * pPlaneOut[1].u_width));
+                          (pPlaneOut[1].u_height * pPlaneOut[1].u_stride));
         memcpy((void *)pPlaneOut[2].pac_data,
                         (void *)pC->lastDecodedPlane[2].pac_data,
-                          (pPlaneOut[2].u_height * pPlaneOut[2].u_width));
+                          (pPlaneOut[2].u_height * pPlaneOut[2].u_stride));
         pC->lastDecodedPlane = pPlaneOut;
     }
 
@@ -452,4 +453,30 @@ M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
     return M4NO_ERROR;
 }
 
+/*
+ ******************************************************************************
+ * M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
+ *                               M4VIFI_ImagePlane* pPlaneOut)
+ * @brief    Encoder callback: renders and resizes the decoded frame
+ * @note     The time spent is counted in the resize stage of the MCS statistics.
+ * @param    pContext    (IN) VPP context, which actually is the MCS internal context in our case
+ * @param    pPlaneIn    (IN) Contains the image
+ * @param    pPlaneOut    (IN/OUT) Pointer to an array of 3 planes that will contain the output
+ *                                  YUV420 image
+ * @return    M4NO_ERROR:    No error
+ * @return    Any error returned by M4MCS_intRenderAndResize
+ ******************************************************************************
+ */
+M4OSA_ERR M4MCS_intApplyVPP(M4VPP_Context pContext, M4VIFI_ImagePlane* pPlaneIn,
+                             M4VIFI_ImagePlane* pPlaneOut)
+{
+    M4MCS_InternalContext *pC = (M4MCS_InternalContext*)(pContext);
+    M4_StepTimer timer;
+    M4OSA_ERR err;
 
+    M4_StepStatsStart(&pC->Stats, &timer);
+    err = M4MCS_intRenderAndResize(pContext, pPlaneIn, pPlaneOut);
+    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Resize, &timer);
+
+    return err;
+}
@@ -29,9 +29,12 @@ LOCAL_SRC_FILES:=          \
       M4VIFI_xVSS_RGB565toYUV420.c \
       M4xVSS_API.c \
       M4xVSS_internal.c \
+      M4xVSS_Segments.c \
+      M4xVSS_Proxy.c \
       M4VSS3GPP_AudioMixing.c \
       M4VSS3GPP_Clip.c \
       M4VSS3GPP_ClipAnalysis.c \
+      M4VSS3GPP_Thumbnails.c \
       M4VSS3GPP_Codecs.c \
       M4VSS3GPP_Edit.c \
       M4VSS3GPP_EditAudio.c \
@@ -46,6 +49,7 @@ LOCAL_SRC_FILES:=          \
       M4AMRR_CoreReader.c \
       M4READER_Amr.c \
       M4VD_Tools.c \
+      M4_StepStats.c \
       VideoEditorResampler.cpp \
       M4DECODER_Null.c
 
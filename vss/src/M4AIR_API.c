@@ -48,6 +48,7 @@
 #include "M4OSA_Memory.h"
 #include "M4VIFI_FiltersAPI.h"
 #include "M4AIR_API.h"
+#include <stdint.h>
 
 /************************ M4AIR INTERNAL TYPES DEFINITIONS ***********************/
 
@@ -97,6 +98,21 @@ typedef struct
     M4OSA_Bool                m_bRevertXY;  /**< Depend on output orientation, used during
                                                 processing to revert X and Y processing order
                                                  (+-90 rotation) */
+    M4OSA_Bool                m_bPanZoom;   /**< Flag to know if M4AIR_configurePanZoom
+                                                 has been called */
+    M4OSA_UInt8*            pu8_panZoomTables;  /**< Single allocation holding all the
+                                                     pan and zoom tables below */
+    M4OSA_UInt32            u32_pz_width[3];    /**< Output width of each plane */
+    M4OSA_UInt32            u32_pz_height[3];   /**< Output height of each plane */
+    M4OSA_UInt32*           pu32_col_start[3];  /**< 16.16 source position of each output
+                                                     column in the start window */
+    M4OSA_UInt32*           pu32_col_end[3];    /**< Same for the end window */
+    M4OSA_UInt32*           pu32_row_start[3];  /**< 16.16 source position of each output
+                                                     row in the start window */
+    M4OSA_UInt32*           pu32_row_end[3];    /**< Same for the end window */
+    M4OSA_UInt32*           pu32_col_offset[3]; /**< Column source offsets of the current
+                                                     picture */
+    M4OSA_UInt8*            pu8_col_frac[3];    /**< Column weights of the current picture */
 }M4AIR_InternalContext;
 
 /********************************* MACROS *******************************/
@@ -104,6 +120,130 @@ typedef struct
      if ((pointer) == M4OSA_NULL) return ((M4OSA_ERR)(retval));
 
 
+/********************** M4AIR INTERNAL FUNCTIONS ********************/
+/**
+ ******************************************************************************
+ * M4OSA_Void M4AIR_buildPanZoomTable(M4OSA_UInt32* pu32_pos, M4OSA_UInt32 u32_coord,
+ *                                    M4OSA_UInt32 u32_size_in, M4OSA_UInt32 u32_size_out,
+ *                                    M4OSA_Bool bChroma)
+ * @brief   Computes the 16.16 source position of each output sample along one dimension.
+ * @note    Ratio and initial accumulator are the same as the ones of M4AIR_configure,
+ *          the window offset is included in the position.
+ * @param   pu32_pos:       (OUT) Table of u32_size_out (luma) positions
+ * @param   u32_coord:      (IN) Luma coordinate of the first pixel of the window
+ * @param   u32_size_in:    (IN) Luma size of the window
+ * @param   u32_size_out:   (IN) Luma size of the output
+ * @param   bChroma:        (IN) Compute the table of a 2 times sub-sampled plane
+ ******************************************************************************
+ */
+static M4OSA_Void M4AIR_buildPanZoomTable(M4OSA_UInt32* pu32_pos, M4OSA_UInt32 u32_coord,
+                                          M4OSA_UInt32 u32_size_in, M4OSA_UInt32 u32_size_out,
+                                          M4OSA_Bool bChroma)
+{
+    M4OSA_UInt32 k, u32_inc, u32_accum;
+
+    if(M4OSA_TRUE == bChroma)
+    {
+        u32_size_in = (u32_size_in+1)>>1;
+        u32_size_out = (u32_size_out+1)>>1;
+    }
+
+    /* Compute ratio between src and destination size */
+    if((u32_size_out >= u32_size_in) && (u32_size_out > 1))
+    {
+        u32_inc = ((u32_size_in-1) * 0x10000) / (u32_size_out-1);
+    }
+    else
+    {
+        u32_inc = (u32_size_in * 0x10000) / u32_size_out;
+    }
+
+    /* Initial accumulator value, between 0 and 0.5 */
+    if(u32_inc >= 0x10000)
+    {
+        u32_accum = u32_inc & 0xffff;
+        if(!u32_accum)
+        {
+            u32_accum = 0x10000;
+        }
+        u32_accum >>= 1;
+    }
+    else
+    {
+        u32_accum = 0;
+    }
+
+    /**< Take into account that the coordinate can be odd, in this case we have to put
+         a 0.5 offset for U and V plane as they are 2 times sub-sampled vs Y */
+    if(M4OSA_TRUE == bChroma)
+    {
+        if(u32_coord&0x1)
+        {
+            u32_accum += 0x8000;
+        }
+        u32_coord >>= 1;
+    }
+    u32_accum += u32_coord << 16;
+
+    for(k=0;k<u32_size_out;k++)
+    {
+        pu32_pos[k] = u32_accum;
+        u32_accum += u32_inc;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4AIR_interpolatePosition(M4OSA_UInt32 u32_start, M4OSA_UInt32 u32_end,
+ *                                        M4OSA_UInt32 uiStep, M4OSA_UInt32 uiNbSteps)
+ * @brief   Linear interpolation of a 16.16 position between the start and end windows.
+ ******************************************************************************
+ */
+static M4OSA_UInt32 M4AIR_interpolatePosition(M4OSA_UInt32 u32_start, M4OSA_UInt32 u32_end,
+                                              M4OSA_UInt32 uiStep, M4OSA_UInt32 uiNbSteps)
+{
+    int64_t i64_delta = (int64_t)u32_end - (int64_t)u32_start;
+
+    return (M4OSA_UInt32)((int64_t)u32_start
+        + (i64_delta * (int64_t)uiStep) / (int64_t)uiNbSteps);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4AIR_bilinearRow(...)
+ * @brief   Bilinear interpolation of one output row from two input rows.
+ * @note    Column offsets and weights are precomputed, so the loop has no branch and
+ *          no accumulator dependency between two output pixels.
+ * @param   pu8_src_top:    (IN) Upper input row
+ * @param   pu8_src_bottom: (IN) Lower input row
+ * @param   u32_y_frac:     (IN) Vertical weight (0..16)
+ * @param   pu32_x_offset:  (IN) Input offset of each output pixel
+ * @param   pu8_x_frac:     (IN) Horizontal weight of each output pixel (0..16)
+ * @param   pu8_data_out:   (OUT) Output row
+ * @param   u32_width:      (IN) Number of output pixels
+ ******************************************************************************
+ */
+static M4OSA_Void M4AIR_bilinearRow(M4OSA_UInt8* pu8_src_top, M4OSA_UInt8* pu8_src_bottom,
+                                    M4OSA_UInt32 u32_y_frac, M4OSA_UInt32* pu32_x_offset,
+                                    M4OSA_UInt8* pu8_x_frac, M4OSA_UInt8* pu8_data_out,
+                                    M4OSA_UInt32 u32_width)
+{
+    M4OSA_UInt32 k, u32_off, u32_x_frac;
+
+    for(k=0;k<u32_width;k++)
+    {
+        u32_off = pu32_x_offset[k];
+        u32_x_frac = pu8_x_frac[k];
+
+        /* Weighted combination */
+        pu8_data_out[k] = (M4OSA_UInt8)(((pu8_src_top[u32_off]*(16-u32_x_frac) +
+                                          pu8_src_top[u32_off+1]*u32_x_frac)*(16-u32_y_frac) +
+                                         (pu8_src_bottom[u32_off]*(16-u32_x_frac) +
+                                          pu8_src_bottom[u32_off+1]*u32_x_frac)*u32_y_frac )>>8);
+    }
+}
+
+
 /********************** M4AIR PUBLIC API IMPLEMENTATION ********************/
 /**
  ******************************************************************************
@@ -151,6 +291,8 @@ M4OSA_ERR M4AIR_create(M4OSA_Context* pContext,M4AIR_InputFormatType inputFormat
     /**< Save input format and update state */
     pC->m_inputFormat = inputFormat;
     pC->m_state = M4AIR_kCreated;
+    pC->m_bPanZoom = M4OSA_FALSE;
+    pC->pu8_panZoomTables = M4OSA_NULL;
 
     /* Return the context to the caller */
     *pContext = pC ;
@@ -192,6 +334,10 @@ M4OSA_ERR M4AIR_cleanUp(M4OSA_Context pContext)
     {
         return M4ERR_STATE;
     }
+    if(M4OSA_NULL != pC->pu8_panZoomTables)
+    {
+        free(pC->pu8_panZoomTables);
+    }
     free(pC) ;
 
     return M4NO_ERROR ;
@@ -243,6 +389,7 @@ M4OSA_ERR M4AIR_configure(M4OSA_Context pContext, M4AIR_Params* pParams)
 
     /** Save parameters */
     pC->m_params = *pParams;
+    pC->m_bPanZoom = M4OSA_FALSE;
 
     /* Check for the input&output width and height are even */
         if( ((pC->m_params.m_inputSize.m_height)&0x1)    ||
@@ -965,4 +1112,262 @@ M4OSA_ERR M4AIR_get(M4OSA_Context pContext, M4VIFI_ImagePlane* pIn, M4VIFI_Image
 }
 
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4AIR_configurePanZoom(M4OSA_Context pContext, M4AIR_Params* pStartParams,
+ *                                  M4AIR_Params* pEndParams)
+ * @brief   This function will configure the AIR for an animated pan and zoom.
+ * @note    The source position of each output column and row is precomputed (16.16 fixed
+ *          point) for the start and the end windows. Since the mapping is linear in the
+ *          window coordinates, any intermediate window is obtained by interpolating these
+ *          tables, see M4AIR_getPanZoom. Only the YUV420 planar format, top-left output
+ *          orientation and normal (non stripe) mode are supported. Both windows must have
+ *          the same output size.
+ * @param    pContext:        (IN) Context identifying the instance
+ * @param    pStartParams:    (IN) AIR parameters of the first picture
+ * @param    pEndParams:      (IN) AIR parameters of the last picture
+ * @return    M4NO_ERROR: there is no error
+ * @return    M4ERR_ALLOC: No more memory is available
+ * @return    M4ERR_PARAMETER: pContext is M4OSA_NULL (debug only), or unsupported parameters
+ * @return    M4ERR_STATE: Internal state is incompatible with this function call.
+ * @return    M4ERR_AIR_FORMAT_NOT_SUPPORTED: the input format is not supported.
+ * @return    M4ERR_AIR_ILLEGAL_FRAME_SIZE: the input or output size is incorrect
+ ******************************************************************************
+ */
+M4OSA_ERR M4AIR_configurePanZoom(M4OSA_Context pContext, M4AIR_Params* pStartParams,
+                                 M4AIR_Params* pEndParams)
+{
+    M4AIR_InternalContext* pC = (M4AIR_InternalContext*)pContext ;
+    M4OSA_UInt32    i, u32_size;
+    M4OSA_UInt32*   pu32_table;
+    M4OSA_UInt8*    pu8_table;
+
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pContext) ;
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pStartParams) ;
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pEndParams) ;
+
+    /**< Check state */
+    if((M4AIR_kCreated != pC->m_state)&&(M4AIR_kConfigured != pC->m_state))
+    {
+        return M4ERR_STATE;
+    }
+
+    if(M4AIR_kYUV420P != pC->m_inputFormat)
+    {
+        return M4ERR_AIR_FORMAT_NOT_SUPPORTED;
+    }
+
+    if((M4OSA_TRUE == pStartParams->m_bOutputStripe)
+        || (M4OSA_TRUE == pEndParams->m_bOutputStripe)
+        || (M4COMMON_kOrientationTopLeft != pStartParams->m_outputOrientation)
+        || (M4COMMON_kOrientationTopLeft != pEndParams->m_outputOrientation)
+        || (pStartParams->m_outputSize.m_width != pEndParams->m_outputSize.m_width)
+        || (pStartParams->m_outputSize.m_height != pEndParams->m_outputSize.m_height))
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    /* Check for the input&output width and height are even and not null */
+    if( (0 == pStartParams->m_inputSize.m_width) || (0 == pStartParams->m_inputSize.m_height)
+        || (0 == pEndParams->m_inputSize.m_width) || (0 == pEndParams->m_inputSize.m_height)
+        || (0 == pStartParams->m_outputSize.m_width)
+        || (0 == pStartParams->m_outputSize.m_height)
+        || ((pStartParams->m_inputSize.m_width)&0x1)
+        || ((pStartParams->m_inputSize.m_height)&0x1)
+        || ((pEndParams->m_inputSize.m_width)&0x1)
+        || ((pEndParams->m_inputSize.m_height)&0x1)
+        || ((pStartParams->m_outputSize.m_width)&0x1)
+        || ((pStartParams->m_outputSize.m_height)&0x1))
+    {
+        return M4ERR_AIR_ILLEGAL_FRAME_SIZE;
+    }
+
+    /**< Compute the size of the tables, for each plane: start/end positions and current
+         offset of each column, start/end positions of each row, current weight of
+         each column */
+    u32_size = 0;
+    for(i=0;i<3;i++)
+    {
+        pC->u32_pz_width[i] = (0 == i)?pStartParams->m_outputSize.m_width:\
+            (pStartParams->m_outputSize.m_width+1)>>1;
+        pC->u32_pz_height[i] = (0 == i)?pStartParams->m_outputSize.m_height:\
+            (pStartParams->m_outputSize.m_height+1)>>1;
+
+        u32_size += (3*pC->u32_pz_width[i] + 2*pC->u32_pz_height[i]) * sizeof(M4OSA_UInt32)
+            + pC->u32_pz_width[i];
+    }
+
+    /**< Tables of a previous pan and zoom are released */
+    if(M4OSA_NULL != pC->pu8_panZoomTables)
+    {
+        free(pC->pu8_panZoomTables);
+        pC->pu8_panZoomTables = M4OSA_NULL;
+    }
+    pC->m_bPanZoom = M4OSA_FALSE;
+
+    pC->pu8_panZoomTables = (M4OSA_UInt8*)M4OSA_32bitAlignedMalloc(u32_size, M4AIR,
+        (M4OSA_Char *)"AIR pan and zoom tables");
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_ALLOC, pC->pu8_panZoomTables) ;
+
+    /**< Dispatch the allocation, 32 bits tables first to keep them aligned */
+    pu32_table = (M4OSA_UInt32*)pC->pu8_panZoomTables;
+    for(i=0;i<3;i++)
+    {
+        pC->pu32_col_start[i] = pu32_table;
+        pu32_table += pC->u32_pz_width[i];
+        pC->pu32_col_end[i] = pu32_table;
+        pu32_table += pC->u32_pz_width[i];
+        pC->pu32_col_offset[i] = pu32_table;
+        pu32_table += pC->u32_pz_width[i];
+        pC->pu32_row_start[i] = pu32_table;
+        pu32_table += pC->u32_pz_height[i];
+        pC->pu32_row_end[i] = pu32_table;
+        pu32_table += pC->u32_pz_height[i];
+    }
+    pu8_table = (M4OSA_UInt8*)pu32_table;
+    for(i=0;i<3;i++)
+    {
+        pC->pu8_col_frac[i] = pu8_table;
+        pu8_table += pC->u32_pz_width[i];
+    }
+
+    /**< Precompute source positions of the start and end windows */
+    for(i=0;i<3;i++)
+    {
+        M4OSA_Bool bChroma = (0 == i)?M4OSA_FALSE:M4OSA_TRUE;
+
+        M4AIR_buildPanZoomTable(pC->pu32_col_start[i], pStartParams->m_inputCoord.m_x,
+            pStartParams->m_inputSize.m_width, pStartParams->m_outputSize.m_width, bChroma);
+        M4AIR_buildPanZoomTable(pC->pu32_col_end[i], pEndParams->m_inputCoord.m_x,
+            pEndParams->m_inputSize.m_width, pEndParams->m_outputSize.m_width, bChroma);
+        M4AIR_buildPanZoomTable(pC->pu32_row_start[i], pStartParams->m_inputCoord.m_y,
+            pStartParams->m_inputSize.m_height, pStartParams->m_outputSize.m_height, bChroma);
+        M4AIR_buildPanZoomTable(pC->pu32_row_end[i], pEndParams->m_inputCoord.m_y,
+            pEndParams->m_inputSize.m_height, pEndParams->m_outputSize.m_height, bChroma);
+    }
+
+    /** Save parameters */
+    pC->m_params = *pStartParams;
+    pC->m_bOnlyCopy = M4OSA_FALSE;
+    pC->m_bFlipX = M4OSA_FALSE;
+    pC->m_bFlipY = M4OSA_FALSE;
+    pC->m_bRevertXY = M4OSA_FALSE;
+    pC->m_procRows = 0;
+    pC->m_bPanZoom = M4OSA_TRUE;
+
+    /**< Update state */
+    pC->m_state = M4AIR_kConfigured;
+
+    return M4NO_ERROR ;
+}
+
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4AIR_getPanZoom(M4OSA_Context pContext, M4OSA_UInt32 uiStep,
+ *                            M4OSA_UInt32 uiNbSteps, M4VIFI_ImagePlane* pIn,
+ *                            M4VIFI_ImagePlane* pOut)
+ * @brief   This function will provide the picture of the pan and zoom at a given step.
+ * @note    The window used is the linear interpolation between the start (uiStep = 0) and
+ *          end (uiStep = uiNbSteps) windows given in M4AIR_configurePanZoom. Only the
+ *          column and row tables are interpolated, the resize itself is done row by row
+ *          by M4AIR_bilinearRow. Dimension specified in output plane(s) structure must be
+ *          the same than the one specified in M4AIR_configurePanZoom.
+ * @param    pContext:    (IN) Context identifying the instance
+ * @param    uiStep:      (IN) Current step, between 0 and uiNbSteps
+ * @param    uiNbSteps:   (IN) Number of steps between the start and end windows
+ * @param    pIn:         (IN) Plane structure containing input Plane(s).
+ * @param    pOut:        (IN/OUT)  Plane structure containing output Plane(s).
+ * @return    M4NO_ERROR: there is no error
+ * @return    M4ERR_PARAMETER: pContext is M4OSA_NULL (debug only).
+ * @return    M4ERR_STATE: M4AIR_configurePanZoom has not been called.
+ * @return    M4ERR_AIR_ILLEGAL_FRAME_SIZE: an input plane is too small
+ ******************************************************************************
+ */
+M4OSA_ERR M4AIR_getPanZoom(M4OSA_Context pContext, M4OSA_UInt32 uiStep, M4OSA_UInt32 uiNbSteps,
+                           M4VIFI_ImagePlane* pIn, M4VIFI_ImagePlane* pOut)
+{
+    M4AIR_InternalContext* pC = (M4AIR_InternalContext*)pContext ;
+    M4OSA_UInt32    i, j, k, u32_pos, u32_max, u32_row, u32_y_frac;
+    M4OSA_UInt8     *pu8_src_top, *pu8_data_out;
+
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pContext) ;
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pIn) ;
+    M4ERR_CHECK_NULL_RETURN_VALUE(M4ERR_PARAMETER, pOut) ;
+
+    /**< Check state */
+    if((M4AIR_kConfigured != pC->m_state) || (M4OSA_FALSE == pC->m_bPanZoom))
+    {
+        return M4ERR_STATE;
+    }
+
+    /**< A single step means a fixed window, the start one */
+    if(0 == uiNbSteps)
+    {
+        uiNbSteps = 1;
+        uiStep = 0;
+    }
+    if(uiStep > uiNbSteps)
+    {
+        uiStep = uiNbSteps;
+    }
+
+    /**< Loop on each Plane */
+    for(i=0;i<3;i++)
+    {
+        if((pIn[i].u_width < 2) || (pIn[i].u_height < 2))
+        {
+            return M4ERR_AIR_ILLEGAL_FRAME_SIZE;
+        }
+
+        /**< Column offsets and weights of this picture. Positions beyond the last input
+             column are clamped so that the right neighbour is always inside the plane */
+        u32_max = pIn[i].u_width - 1;
+        for(k=0;k<pC->u32_pz_width[i];k++)
+        {
+            u32_pos = M4AIR_interpolatePosition(pC->pu32_col_start[i][k],
+                pC->pu32_col_end[i][k], uiStep, uiNbSteps);
+            if((u32_pos >> 16) >= u32_max)
+            {
+                pC->pu32_col_offset[i][k] = u32_max - 1;
+                pC->pu8_col_frac[i][k] = 16;
+            }
+            else
+            {
+                pC->pu32_col_offset[i][k] = u32_pos >> 16;
+                pC->pu8_col_frac[i][k] = (M4OSA_UInt8)((u32_pos >> 12)&15);
+            }
+        }
+
+        pu8_data_out = pOut[i].pac_data + pOut[i].u_topleft;
+
+        /**< Loop on each row */
+        u32_max = pIn[i].u_height - 1;
+        for(j=0;j<pC->u32_pz_height[i];j++)
+        {
+            u32_pos = M4AIR_interpolatePosition(pC->pu32_row_start[i][j],
+                pC->pu32_row_end[i][j], uiStep, uiNbSteps);
+            if((u32_pos >> 16) >= u32_max)
+            {
+                u32_row = u32_max - 1;
+                u32_y_frac = 16;
+            }
+            else
+            {
+                u32_row = u32_pos >> 16;
+                u32_y_frac = (u32_pos >> 12)&15;
+            }
+
+            pu8_src_top = pIn[i].pac_data + pIn[i].u_topleft + u32_row * pIn[i].u_stride;
+
+            M4AIR_bilinearRow(pu8_src_top, pu8_src_top + pIn[i].u_stride, u32_y_frac,
+                pC->pu32_col_offset[i], pC->pu8_col_frac[i], pu8_data_out,
+                pC->u32_pz_width[i]);
+
+            pu8_data_out += pOut[i].u_stride;
+        }
+    }
+
+    return M4NO_ERROR ;
+}
 
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
 #include "M4OSA_Types.h"
 #include "M4OSA_Debug.h"
 
@@ -24,6 +26,7 @@
  * @file   M4VD_Tools.c
  * @brief
  * @note   This file implements helper functions for Bitstream parser
+ *         and H264 byte stream scanning
  ************************************************************************
  */
 
@@ -95,5 +98,140 @@ M4OSA_ERR M4VD_Tools_WriteBitsToMemory(M4OSA_UInt32 bitsToWrite,
     return M4NO_ERROR;
 }
 
+M4OSA_UInt8* M4VD_Tools_FindStartCode(M4OSA_UInt8* pData, M4OSA_UInt32 size,
+                                      M4OSA_UInt32* pStartCodeSize)
+{
+    M4OSA_UInt8 *pCur, *pEnd;
+
+    if (size < 4)
+    {
+        return M4OSA_NULL;
+    }
+
+    /* The last byte of a start code is searched with memchr (optimized by the C
+    library), the two zero bytes are then checked backward. The last byte of the
+    buffer cannot end a start code since the NAL header must follow */
+    pCur = pData + 2;
+    pEnd = pData + size - 1;
+
+    while (pCur < pEnd)
+    {
+        pCur = (M4OSA_UInt8*)memchr((void *)pCur, 0x01, pEnd - pCur);
+        if (M4OSA_NULL == pCur)
+        {
+            return M4OSA_NULL;
+        }
+
+        if ((0 == pCur[-1]) && (0 == pCur[-2]))
+        {
+            if ((pCur - 3 >= pData) && (0 == pCur[-3]))
+            {
+                *pStartCodeSize = 4;
+                return pCur - 3;
+            }
+            *pStartCodeSize = 3;
+            return pCur - 2;
+        }
+        pCur++;
+    }
+
+    return M4OSA_NULL;
+}
+
+M4OSA_Bool M4VD_Tools_IsNALStream(M4OSA_UInt8* pData, M4OSA_UInt32 size)
+{
+    M4OSA_UInt32 pos = 0, nalSize;
+
+    while (size - pos >= 4)
+    {
+        nalSize = ((M4OSA_UInt32)pData[pos] << 24) | ((M4OSA_UInt32)pData[pos + 1] << 16)
+            | ((M4OSA_UInt32)pData[pos + 2] << 8) | (M4OSA_UInt32)pData[pos + 3];
+        if ((0 == nalSize) || (nalSize > size - pos - 4))
+        {
+            return M4OSA_FALSE;
+        }
+        pos += 4 + nalSize;
+    }
+
+    return ((0 != size) && (pos == size)) ? M4OSA_TRUE : M4OSA_FALSE;
+}
+
+M4OSA_ERR M4VD_Tools_ConvertByteStreamToNALStream(M4OSA_UInt8* pIn, M4OSA_UInt32 inSize,
+                                                  M4OSA_UInt8* pOut, M4OSA_UInt32* pOutSize)
+{
+    M4OSA_UInt8 *pStartCode, *pNal, *pNext, *pEnd;
+    M4OSA_UInt32 startCodeSize, nextStartCodeSize = 0;
+    M4OSA_UInt32 nalSize, outSize = 0;
+
+    /* The NAL sizes are checked first: a NAL size of 256 to 511 bytes begins as a
+    3 bytes start code */
+    if (M4VD_Tools_IsNALStream(pIn, inSize))
+    {
+        if (pOut != pIn)
+        {
+            if ((M4OSA_NULL == pOutSize) || (inSize > *pOutSize))
+            {
+                M4OSA_TRACE1_0("M4VD_Tools_ConvertByteStreamToNALStream: output buffer too small");
+                return M4ERR_PARAMETER;
+            }
+            memcpy((void *)pOut, (void *)pIn, inSize);
+        }
+        if (M4OSA_NULL != pOutSize)
+        {
+            *pOutSize = inSize;
+        }
+        return M4NO_ERROR;
+    }
+
+    pStartCode = M4VD_Tools_FindStartCode(pIn, inSize, &startCodeSize);
+    if (pStartCode != pIn)
+    {
+        M4OSA_TRACE1_0("M4VD_Tools_ConvertByteStreamToNALStream: no start code at the beginning");
+        return M4ERR_PARAMETER;
+    }
+
+    pEnd = pIn + inSize;
+
+    while (M4OSA_NULL != pStartCode)
+    {
+        pNal = pStartCode + startCodeSize;
+        pNext = M4VD_Tools_FindStartCode(pNal, pEnd - pNal, &nextStartCodeSize);
+        nalSize = ((M4OSA_NULL != pNext) ? pNext : pEnd) - pNal;
+
+        if (pOut == pIn)
+        {
+            /* In place: the NAL size simply overwrites the start code */
+            if (4 != startCodeSize)
+            {
+                M4OSA_TRACE1_0("M4VD_Tools_ConvertByteStreamToNALStream:\
+                    3 bytes start code, cannot convert in place");
+                return M4ERR_PARAMETER;
+            }
+        }
+        else if ((M4OSA_NULL == pOutSize) || (outSize + 4 + nalSize > *pOutSize))
+        {
+            M4OSA_TRACE1_0("M4VD_Tools_ConvertByteStreamToNALStream: output buffer too small");
+            return M4ERR_PARAMETER;
+        }
 
+        pOut[outSize + 0] = (M4OSA_UInt8)((nalSize >> 24) & 0xFF);
+        pOut[outSize + 1] = (M4OSA_UInt8)((nalSize >> 16) & 0xFF);
+        pOut[outSize + 2] = (M4OSA_UInt8)((nalSize >> 8) & 0xFF);
+        pOut[outSize + 3] = (M4OSA_UInt8)((nalSize) & 0xFF);
+        if (pOut != pIn)
+        {
+            memcpy((void *)(pOut + outSize + 4), (void *)pNal, nalSize);
+        }
+        outSize += 4 + nalSize;
 
+        pStartCode = pNext;
+        startCodeSize = nextStartCodeSize;
+    }
+
+    if (M4OSA_NULL != pOutSize)
+    {
+        *pOutSize = outSize;
+    }
+
+    return M4NO_ERROR;
+}
@@ -40,6 +40,9 @@
  *    OSAL headers */
 #include "M4OSA_Memory.h" /* OSAL memory management */
 #include "M4OSA_Debug.h"  /* OSAL debug management */
+#include "M4OSA_Thread.h"
+#include "M4OSA_Mutex.h"
+#include "M4OSA_Semaphore.h"
 
 /**
  ******************************************************************************
@@ -189,6 +192,765 @@ M4OSA_ERR M4VSS3GPP_editAnalyseClip( M4OSA_Void *pClip,
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intGetFileIdentity()
+ * @brief    Gets the size and the modification date of a clip file
+ * @param    pClip               (IN) File descriptor of the clip
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param    pFileSize           (OUT) File size
+ * @param    pModifiedTime       (OUT) File modification date
+ * @return   M4NO_ERROR:         No error
+ * @return   Any error returned by the file reader
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intGetFileIdentity( M4OSA_Void *pClip,
+                                              M4OSA_FileReadPointer *pFileReadPtrFct,
+                                              M4OSA_FilePosition *pFileSize,
+                                              M4OSA_Time *pModifiedTime )
+{
+    M4OSA_ERR err;
+    M4OSA_Context pFileContext = M4OSA_NULL;
+    M4OSA_FileAttribute attribute;
+
+    err = pFileReadPtrFct->openRead(&pFileContext, pClip, M4OSA_kFileRead);
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    err = pFileReadPtrFct->getOption(pFileContext, M4OSA_kFileReadGetFileSize,
+        (M4OSA_DataOption *)pFileSize);
+
+    if( M4NO_ERROR == err )
+    {
+        err = pFileReadPtrFct->getOption(pFileContext, M4OSA_kFileReadGetFileAttribute,
+            (M4OSA_DataOption *) &attribute);
+        *pModifiedTime = attribute.modifiedDate.time;
+    }
+
+    pFileReadPtrFct->closeRead(pFileContext);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheOpen()
+ * @brief    Creates a clip properties cache
+ * @param    pCacheContext       (OUT) Pointer on the cache context to create
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    pCacheContext is M4OSA_NULL (debug only)
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheOpen( M4OSA_Context *pCacheContext )
+{
+    M4OSA_ERR err;
+    M4VSS3GPP_AnalysisCache *pCache;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pCacheContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_analysisCacheOpen: pCacheContext is M4OSA_NULL");
+
+    *pCacheContext = M4OSA_NULL;
+
+    pCache = (M4VSS3GPP_AnalysisCache *)M4OSA_32bitAlignedMalloc(
+        sizeof(M4VSS3GPP_AnalysisCache), M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_analysisCacheOpen: cache");
+
+    if( M4OSA_NULL == pCache )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_analysisCacheOpen: unable to allocate the cache");
+        return M4ERR_ALLOC;
+    }
+
+    pCache->pEntries = (M4VSS3GPP_AnalysisCacheEntry *)M4OSA_32bitAlignedMalloc(
+        M4VSS3GPP_ANALYSIS_CACHE_SIZE * sizeof(M4VSS3GPP_AnalysisCacheEntry), M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_analysisCacheOpen: entries");
+
+    if( M4OSA_NULL == pCache->pEntries )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_analysisCacheOpen: unable to allocate the entries");
+        free(pCache);
+        return M4ERR_ALLOC;
+    }
+
+    memset((void *)pCache->pEntries, 0,
+        M4VSS3GPP_ANALYSIS_CACHE_SIZE * sizeof(M4VSS3GPP_AnalysisCacheEntry));
+    pCache->uiNextEntry = 0;
+
+    err = M4OSA_mutexOpen(&pCache->mutex);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4VSS3GPP_analysisCacheOpen: M4OSA_mutexOpen returns 0x%x", err);
+        free(pCache->pEntries);
+        free(pCache);
+        return err;
+    }
+
+    *pCacheContext = (M4OSA_Context)pCache;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheGet()
+ * @brief    Looks a file up in a clip properties cache
+ * @param    pCacheContext       (IN) Cache context
+ * @param    pClip               (IN) File descriptor of the clip
+ * @param    FileType            (IN) Type of the clip file
+ * @param    pClipProperties     (OUT) Cached properties, filled on M4NO_ERROR only
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return   M4NO_ERROR:         The properties were found
+ * @return   M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED: The file is not in the cache or was modified
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheGet( M4OSA_Context pCacheContext, M4OSA_Void *pClip,
+                                     M4VIDEOEDITING_FileType FileType,
+                                     M4VIDEOEDITING_ClipProperties *pClipProperties,
+                                     M4OSA_FileReadPointer *pFileReadPtrFct )
+{
+    M4VSS3GPP_AnalysisCache *pCache = (M4VSS3GPP_AnalysisCache *)pCacheContext;
+    M4VSS3GPP_AnalysisCacheEntry *pEntry;
+    M4OSA_FilePosition fileSize = 0;
+    M4OSA_Time modifiedTime = 0;
+    M4OSA_ERR err = M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+    M4OSA_UInt32 i;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pCacheContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_analysisCacheGet: pCacheContext is M4OSA_NULL");
+
+    /**
+    * A file that cannot be opened is never found, the analysis will report the error */
+    if( M4NO_ERROR != M4VSS3GPP_intGetFileIdentity(pClip, pFileReadPtrFct, &fileSize,
+        &modifiedTime) )
+    {
+        return M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+    }
+
+    M4OSA_mutexLock(pCache->mutex, M4OSA_WAIT_FOREVER);
+
+    for ( i = 0; i < M4VSS3GPP_ANALYSIS_CACHE_SIZE; i++ )
+    {
+        pEntry = &pCache->pEntries[i];
+
+        if( ( M4OSA_NULL != pEntry->pFile) && (pEntry->FileType == FileType)
+            && (pEntry->fileSize == fileSize) && (pEntry->modifiedTime == modifiedTime)
+            && (0 == strcmp((const char *)pEntry->pFile, (const char *)pClip)) )
+        {
+            memcpy((void *)pClipProperties, (void *) &pEntry->ClipProperties,
+                sizeof(M4VIDEOEDITING_ClipProperties));
+            err = M4NO_ERROR;
+            break;
+        }
+    }
+
+    M4OSA_mutexUnlock(pCache->mutex);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheSet()
+ * @brief    Stores the properties of a file in a clip properties cache
+ * @param    pCacheContext       (IN) Cache context
+ * @param    pClip               (IN) File descriptor of the clip
+ * @param    FileType            (IN) Type of the clip file
+ * @param    pClipProperties     (IN) Properties to store
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ * @return   Any error returned by the file reader
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheSet( M4OSA_Context pCacheContext, M4OSA_Void *pClip,
+                                     M4VIDEOEDITING_FileType FileType,
+                                     M4VIDEOEDITING_ClipProperties *pClipProperties,
+                                     M4OSA_FileReadPointer *pFileReadPtrFct )
+{
+    M4VSS3GPP_AnalysisCache *pCache = (M4VSS3GPP_AnalysisCache *)pCacheContext;
+    M4VSS3GPP_AnalysisCacheEntry *pEntry = M4OSA_NULL;
+    M4OSA_FilePosition fileSize = 0;
+    M4OSA_Time modifiedTime = 0;
+    M4OSA_Char *pFile;
+    M4OSA_UInt32 uiLength;
+    M4OSA_UInt32 i;
+    M4OSA_ERR err;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pCacheContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_analysisCacheSet: pCacheContext is M4OSA_NULL");
+
+    err = M4VSS3GPP_intGetFileIdentity(pClip, pFileReadPtrFct, &fileSize, &modifiedTime);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_analysisCacheSet: M4VSS3GPP_intGetFileIdentity returns 0x%x", err);
+        return err;
+    }
+
+    uiLength = strlen((const char *)pClip) + 1;
+    pFile = (M4OSA_Char *)M4OSA_32bitAlignedMalloc(uiLength, M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_analysisCacheSet: file path");
+
+    if( M4OSA_NULL == pFile )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_analysisCacheSet: unable to allocate the file path");
+        return M4ERR_ALLOC;
+    }
+    memcpy((void *)pFile, (void *)pClip, uiLength);
+
+    M4OSA_mutexLock(pCache->mutex, M4OSA_WAIT_FOREVER);
+
+    /**
+    * Replace the entry of the same file if any (it was modified), else the oldest one */
+    for ( i = 0; i < M4VSS3GPP_ANALYSIS_CACHE_SIZE; i++ )
+    {
+        if( ( M4OSA_NULL != pCache->pEntries[i].pFile)
+            && (pCache->pEntries[i].FileType == FileType)
+            && (0 == strcmp((const char *)pCache->pEntries[i].pFile, (const char *)pClip)) )
+        {
+            pEntry = &pCache->pEntries[i];
+            break;
+        }
+    }
+
+    if( M4OSA_NULL == pEntry )
+    {
+        pEntry = &pCache->pEntries[pCache->uiNextEntry];
+        pCache->uiNextEntry = (pCache->uiNextEntry + 1) % M4VSS3GPP_ANALYSIS_CACHE_SIZE;
+    }
+
+    if( M4OSA_NULL != pEntry->pFile )
+    {
+        free(pEntry->pFile);
+    }
+    pEntry->pFile = pFile;
+    pEntry->FileType = FileType;
+    pEntry->fileSize = fileSize;
+    pEntry->modifiedTime = modifiedTime;
+    memcpy((void *) &pEntry->ClipProperties, (void *)pClipProperties,
+        sizeof(M4VIDEOEDITING_ClipProperties));
+
+    M4OSA_mutexUnlock(pCache->mutex);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheLoad()
+ * @brief    Fills a clip properties cache from an index file
+ * @note     The whole file is read at once, then parsed in memory.
+ * @param    pCacheContext       (IN) Cache context
+ * @param    pIndexFile          (IN) File descriptor of the index file
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ * @return   M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED: The index file is not valid
+ * @return   Any error returned by the file reader
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheLoad( M4OSA_Context pCacheContext, M4OSA_Void *pIndexFile,
+                                      M4OSA_FileReadPointer *pFileReadPtrFct )
+{
+    M4VSS3GPP_AnalysisCache *pCache = (M4VSS3GPP_AnalysisCache *)pCacheContext;
+    M4VSS3GPP_AnalysisCacheEntry *pEntry;
+    M4OSA_Context pFileContext = M4OSA_NULL;
+    M4OSA_FilePosition fileSize = 0;
+    M4OSA_UInt8 *pIndex, *pData, *pEnd;
+    M4OSA_UInt32 header[4];
+    M4OSA_UInt32 uiSize, uiPathLength, i;
+    M4OSA_ERR err;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pCacheContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_analysisCacheLoad: pCacheContext is M4OSA_NULL");
+
+    err = pFileReadPtrFct->openRead(&pFileContext, pIndexFile, M4OSA_kFileRead);
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    err = pFileReadPtrFct->getOption(pFileContext, M4OSA_kFileReadGetFileSize,
+        (M4OSA_DataOption *) &fileSize);
+
+    if( ( M4NO_ERROR != err) || (fileSize < (M4OSA_FilePosition)sizeof(header)) )
+    {
+        pFileReadPtrFct->closeRead(pFileContext);
+        return (M4NO_ERROR != err) ? err : M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+    }
+
+    pIndex = (M4OSA_UInt8 *)M4OSA_32bitAlignedMalloc(fileSize, M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_analysisCacheLoad: index");
+
+    if( M4OSA_NULL == pIndex )
+    {
+        pFileReadPtrFct->closeRead(pFileContext);
+        return M4ERR_ALLOC;
+    }
+
+    uiSize = fileSize;
+    err = pFileReadPtrFct->readData(pFileContext, (M4OSA_MemAddr8)pIndex, &uiSize);
+    pFileReadPtrFct->closeRead(pFileContext);
+
+    if( ( M4NO_ERROR != err) || (uiSize != (M4OSA_UInt32)fileSize) )
+    {
+        free(pIndex);
+        return (M4NO_ERROR != err) ? err : M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+    }
+
+    /**
+    * An index written by another build (other structure layout) is ignored */
+    memcpy((void *)header, (void *)pIndex, sizeof(header));
+
+    if( ( M4VSS3GPP_ANALYSIS_INDEX_MAGIC != header[0])
+        || (M4VSS3GPP_ANALYSIS_INDEX_VERSION != header[1])
+        || (sizeof(M4VIDEOEDITING_ClipProperties) != header[2]) )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_analysisCacheLoad: index file not valid, ignored");
+        free(pIndex);
+        return M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+    }
+
+    pData = pIndex + sizeof(header);
+    pEnd = pIndex + fileSize;
+
+    M4OSA_mutexLock(pCache->mutex, M4OSA_WAIT_FOREVER);
+
+    for ( i = 0; i < header[3]; i++ )
+    {
+        if( ( pEnd - pData) < (M4OSA_Int32)M4VSS3GPP_ANALYSIS_INDEX_ENTRY_SIZE )
+        {
+            break;
+        }
+        memcpy((void *) &uiPathLength, (void *)pData, sizeof(M4OSA_UInt32));
+
+        if( ( 0 == uiPathLength) || ((M4OSA_UInt32)(pEnd - pData)
+            < M4VSS3GPP_ANALYSIS_INDEX_ENTRY_SIZE + uiPathLength)
+            || (0 != pData[M4VSS3GPP_ANALYSIS_INDEX_ENTRY_SIZE + uiPathLength - 1]) )
+        {
+            break;
+        }
+
+        pEntry = &pCache->pEntries[pCache->uiNextEntry];
+
+        if( M4OSA_NULL != pEntry->pFile )
+        {
+            free(pEntry->pFile);
+        }
+        pEntry->pFile = (M4OSA_Char *)M4OSA_32bitAlignedMalloc(uiPathLength, M4VSS3GPP,
+            (M4OSA_Char *)"M4VSS3GPP_analysisCacheLoad: file path");
+
+        if( M4OSA_NULL == pEntry->pFile )
+        {
+            err = M4ERR_ALLOC;
+            break;
+        }
+        pData += sizeof(M4OSA_UInt32);
+        memcpy((void *) &pEntry->FileType, (void *)pData, sizeof(M4OSA_Int32));
+        pData += sizeof(M4OSA_Int32);
+        memcpy((void *) &pEntry->fileSize, (void *)pData, sizeof(M4OSA_Int32));
+        pData += sizeof(M4OSA_Int32);
+        memcpy((void *) &pEntry->modifiedTime, (void *)pData, sizeof(M4OSA_Time));
+        pData += sizeof(M4OSA_Time);
+        memcpy((void *) &pEntry->ClipProperties, (void *)pData,
+            sizeof(M4VIDEOEDITING_ClipProperties));
+        pData += sizeof(M4VIDEOEDITING_ClipProperties);
+        memcpy((void *)pEntry->pFile, (void *)pData, uiPathLength);
+        pData += uiPathLength;
+
+        pCache->uiNextEntry = (pCache->uiNextEntry + 1) % M4VSS3GPP_ANALYSIS_CACHE_SIZE;
+    }
+
+    M4OSA_mutexUnlock(pCache->mutex);
+
+    M4OSA_TRACE3_1("M4VSS3GPP_analysisCacheLoad: %d entries loaded", i);
+    free(pIndex);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheSave()
+ * @brief    Writes the content of a clip properties cache to an index file
+ * @note     The index is built in memory, then written at once.
+ * @param    pCacheContext       (IN) Cache context
+ * @param    pIndexFile          (IN) File descriptor of the index file
+ * @param    pFileWritePtrFct    (IN) Pointer to OSAL file writer functions
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_ALLOC:        There is no more available memory
+ * @return   Any error returned by the file writer
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheSave( M4OSA_Context pCacheContext, M4OSA_Void *pIndexFile,
+                                      M4OSA_FileWriterPointer *pFileWritePtrFct )
+{
+    M4VSS3GPP_AnalysisCache *pCache = (M4VSS3GPP_AnalysisCache *)pCacheContext;
+    M4VSS3GPP_AnalysisCacheEntry *pEntry;
+    M4OSA_Context pFileContext = M4OSA_NULL;
+    M4OSA_UInt8 *pIndex, *pData;
+    M4OSA_UInt32 header[4];
+    M4OSA_UInt32 uiSize, uiPathLength, i;
+    M4OSA_ERR err;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pCacheContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_analysisCacheSave: pCacheContext is M4OSA_NULL");
+
+    M4OSA_mutexLock(pCache->mutex, M4OSA_WAIT_FOREVER);
+
+    header[0] = M4VSS3GPP_ANALYSIS_INDEX_MAGIC;
+    header[1] = M4VSS3GPP_ANALYSIS_INDEX_VERSION;
+    header[2] = sizeof(M4VIDEOEDITING_ClipProperties);
+    header[3] = 0;
+    uiSize = sizeof(header);
+
+    for ( i = 0; i < M4VSS3GPP_ANALYSIS_CACHE_SIZE; i++ )
+    {
+        if( M4OSA_NULL != pCache->pEntries[i].pFile )
+        {
+            header[3]++;
+            uiSize += M4VSS3GPP_ANALYSIS_INDEX_ENTRY_SIZE
+                + strlen((const char *)pCache->pEntries[i].pFile) + 1;
+        }
+    }
+
+    pIndex = (M4OSA_UInt8 *)M4OSA_32bitAlignedMalloc(uiSize, M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_analysisCacheSave: index");
+
+    if( M4OSA_NULL == pIndex )
+    {
+        M4OSA_mutexUnlock(pCache->mutex);
+        return M4ERR_ALLOC;
+    }
+
+    memcpy((void *)pIndex, (void *)header, sizeof(header));
+    pData = pIndex + sizeof(header);
+
+    for ( i = 0; i < M4VSS3GPP_ANALYSIS_CACHE_SIZE; i++ )
+    {
+        pEntry = &pCache->pEntries[i];
+
+        if( M4OSA_NULL == pEntry->pFile )
+        {
+            continue;
+        }
+        uiPathLength = strlen((const char *)pEntry->pFile) + 1;
+
+        memcpy((void *)pData, (void *) &uiPathLength, sizeof(M4OSA_UInt32));
+        pData += sizeof(M4OSA_UInt32);
+        memcpy((void *)pData, (void *) &pEntry->FileType, sizeof(M4OSA_Int32));
+        pData += sizeof(M4OSA_Int32);
+        memcpy((void *)pData, (void *) &pEntry->fileSize, sizeof(M4OSA_Int32));
+        pData += sizeof(M4OSA_Int32);
+        memcpy((void *)pData, (void *) &pEntry->modifiedTime, sizeof(M4OSA_Time));
+        pData += sizeof(M4OSA_Time);
+        memcpy((void *)pData, (void *) &pEntry->ClipProperties,
+            sizeof(M4VIDEOEDITING_ClipProperties));
+        pData += sizeof(M4VIDEOEDITING_ClipProperties);
+        memcpy((void *)pData, (void *)pEntry->pFile, uiPathLength);
+        pData += uiPathLength;
+    }
+
+    M4OSA_mutexUnlock(pCache->mutex);
+
+    err = pFileWritePtrFct->openWrite(&pFileContext, pIndexFile, M4OSA_kFileWrite);
+
+    if( M4NO_ERROR == err )
+    {
+        err = pFileWritePtrFct->writeData(pFileContext, (M4OSA_MemAddr8)pIndex, uiSize);
+        pFileWritePtrFct->closeWrite(pFileContext);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4VSS3GPP_analysisCacheSave: unable to write the index, 0x%x", err);
+    }
+    free(pIndex);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_analysisCacheClose()
+ * @brief    Frees a clip properties cache
+ * @param    pCacheContext       (IN) Cache context
+ * @return   M4NO_ERROR:         No error
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_analysisCacheClose( M4OSA_Context pCacheContext )
+{
+    M4VSS3GPP_AnalysisCache *pCache = (M4VSS3GPP_AnalysisCache *)pCacheContext;
+    M4OSA_UInt32 i;
+
+    if( M4OSA_NULL == pCache )
+    {
+        return M4NO_ERROR;
+    }
+
+    for ( i = 0; i < M4VSS3GPP_ANALYSIS_CACHE_SIZE; i++ )
+    {
+        if( M4OSA_NULL != pCache->pEntries[i].pFile )
+        {
+            free(pCache->pEntries[i].pFile);
+        }
+    }
+    free(pCache->pEntries);
+    M4OSA_mutexClose(pCache->mutex);
+    free(pCache);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intAnalyseNextClip()
+ * @brief    Analyses the next clip of an analysis job
+ * @note     The cache is looked up first, and filled with the new analysis.
+ * @param    pJob                (IN/OUT) Analysis job
+ * @return   M4NO_ERROR:         A clip was handled (its error, if any, is kept in the job)
+ * @return   M4WAR_NO_MORE_AU:   There is no more clip to analyse
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intAnalyseNextClip( M4VSS3GPP_AnalysisJob *pJob )
+{
+    M4VSS3GPP_ClipSettings *pClip;
+    M4OSA_UInt32 uiClip;
+    M4OSA_ERR err;
+
+    M4OSA_mutexLock(pJob->mutex, M4OSA_WAIT_FOREVER);
+
+    /**
+    * Skip the clips analysed by the integrator */
+    while( ( pJob->uiNextClip < pJob->uiClipNumber)
+        && (M4OSA_TRUE == pJob->pClipList[pJob->uiNextClip]->ClipProperties.bAnalysed) )
+    {
+        pJob->uiNextClip++;
+    }
+
+    /**
+    * Clips are taken in order, so the clips after a failing one are not needed */
+    if( ( pJob->uiNextClip >= pJob->uiClipNumber) || (M4NO_ERROR != pJob->err) )
+    {
+        M4OSA_mutexUnlock(pJob->mutex);
+        return M4WAR_NO_MORE_AU;
+    }
+    uiClip = pJob->uiNextClip++;
+
+    M4OSA_mutexUnlock(pJob->mutex);
+
+    pClip = pJob->pClipList[uiClip];
+    err = M4VSS3GPP_WAR_ANALYSIS_NOT_CACHED;
+
+    /**
+    * The analysis does not fill the properties of ARGB8888 clips, do not cache them */
+    if( ( M4OSA_NULL != pJob->pCache)
+        && (M4VIDEOEDITING_kFileType_ARGB8888 != pClip->FileType) )
+    {
+        err = M4VSS3GPP_analysisCacheGet(pJob->pCache, pClip->pFile, pClip->FileType,
+            &pClip->ClipProperties, pJob->pFileReadPtr);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        err = M4VSS3GPP_editAnalyseClip(pClip->pFile, pClip->FileType,
+            &pClip->ClipProperties, pJob->pFileReadPtr);
+
+        if( ( M4NO_ERROR == err) && (M4OSA_NULL != pJob->pCache)
+            && (M4VIDEOEDITING_kFileType_ARGB8888 != pClip->FileType) )
+        {
+            /**
+            * Not being able to cache the analysis is not an error */
+            M4VSS3GPP_analysisCacheSet(pJob->pCache, pClip->pFile, pClip->FileType,
+                &pClip->ClipProperties, pJob->pFileReadPtr);
+        }
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_2("M4VSS3GPP_intAnalyseNextClip: clip %d analysis returns 0x%x",
+            uiClip, err);
+
+        M4OSA_mutexLock(pJob->mutex, M4OSA_WAIT_FOREVER);
+
+        if( ( M4NO_ERROR == pJob->err) || (uiClip < pJob->uiErrClip) )
+        {
+            pJob->err = err;
+            pJob->uiErrClip = uiClip;
+        }
+        M4OSA_mutexUnlock(pJob->mutex);
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intAnalysisThread()
+ * @brief    Analysis thread function, called in loop until it returns an error
+ * @param    pParam              (IN/OUT) Analysis job
+ * @return   M4NO_ERROR:         A clip was handled
+ * @return   M4WAR_NO_MORE_AU:   There is no more clip to analyse, the thread ends
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intAnalysisThread( M4OSA_Void *pParam )
+{
+    M4VSS3GPP_AnalysisJob *pJob = (M4VSS3GPP_AnalysisJob *)pParam;
+    M4OSA_ERR err;
+
+    err = M4VSS3GPP_intAnalyseNextClip(pJob);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_semaphorePost(pJob->semDone);
+    }
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editAnalyseClipList()
+ * @brief    Analyses all the clips of a list which are not analysed yet
+ * @note     Up to M4VSS3GPP_ANALYSIS_MAX_THREADS - 1 threads are started, the calling
+ *           thread analyses clips too. If threads cannot be started, the analysis goes on
+ *           with the threads that could.
+ * @param    pClipList           (IN/OUT) Array of pointers on the clip settings
+ * @param    uiClipNumber        (IN) Number of clips in pClipList
+ * @param    pFileReadPtrFct     (IN) Pointer to OSAL file reader functions
+ * @param    pCacheContext       (IN) Analysis cache, can be M4OSA_NULL
+ * @return   M4NO_ERROR:         No error
+ * @return   M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL (debug only)
+ * @return   Any error returned by M4VSS3GPP_editAnalyseClip
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editAnalyseClipList( M4VSS3GPP_ClipSettings **pClipList,
+                                        M4OSA_UInt32 uiClipNumber,
+                                        M4OSA_FileReadPointer *pFileReadPtrFct,
+                                        M4OSA_Context pCacheContext )
+{
+    M4VSS3GPP_AnalysisJob job;
+    M4OSA_Context pThreads[M4VSS3GPP_ANALYSIS_MAX_THREADS - 1];
+    M4OSA_ThreadState state;
+    M4OSA_UInt32 uiNbToAnalyse = 0;
+    M4OSA_UInt32 uiNbThreads = 0;
+    M4OSA_UInt32 i;
+    M4OSA_ERR err;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pClipList), M4ERR_PARAMETER,
+        "M4VSS3GPP_editAnalyseClipList: pClipList is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileReadPtrFct), M4ERR_PARAMETER,
+        "M4VSS3GPP_editAnalyseClipList: pFileReadPtrFct is M4OSA_NULL");
+
+    for ( i = 0; i < uiClipNumber; i++ )
+    {
+        if( M4OSA_FALSE == pClipList[i]->ClipProperties.bAnalysed )
+        {
+            uiNbToAnalyse++;
+        }
+    }
+
+    job.pClipList = pClipList;
+    job.uiClipNumber = uiClipNumber;
+    job.pFileReadPtr = pFileReadPtrFct;
+    job.pCache = pCacheContext;
+    job.uiNextClip = 0;
+    job.err = M4NO_ERROR;
+    job.uiErrClip = 0;
+    job.mutex = M4OSA_NULL;
+    job.semDone = M4OSA_NULL;
+
+    err = M4OSA_mutexOpen(&job.mutex);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4VSS3GPP_editAnalyseClipList: M4OSA_mutexOpen returns 0x%x", err);
+        return err;
+    }
+
+    if( uiNbToAnalyse > 1 )
+    {
+        err = M4OSA_semaphoreOpen(&job.semDone, 0);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_editAnalyseClipList: M4OSA_semaphoreOpen returns 0x%x", err);
+            M4OSA_mutexClose(job.mutex);
+            return err;
+        }
+
+        /**
+        * The calling thread takes one clip, start a thread for the others */
+        while( ( uiNbThreads < (M4VSS3GPP_ANALYSIS_MAX_THREADS - 1))
+            && (uiNbThreads < (uiNbToAnalyse - 1)) )
+        {
+            err = M4OSA_threadSyncOpen(&pThreads[uiNbThreads],
+                (M4OSA_ThreadDoIt)M4VSS3GPP_intAnalysisThread);
+
+            if( M4NO_ERROR != err )
+            {
+                break;
+            }
+
+            err = M4OSA_threadSyncStart(pThreads[uiNbThreads], (M4OSA_Void *) &job);
+
+            if( M4NO_ERROR != err )
+            {
+                M4OSA_threadSyncClose(pThreads[uiNbThreads]);
+                break;
+            }
+            uiNbThreads++;
+        }
+        M4OSA_TRACE3_2("M4VSS3GPP_editAnalyseClipList: %d clips, %d threads started",
+            uiNbToAnalyse, uiNbThreads);
+    }
+
+    while( M4NO_ERROR == M4VSS3GPP_intAnalyseNextClip(&job) );
+
+    /**
+    * Wait for the end of the threads. The thread state is set to opened just after the
+    * semaphore is posted, so the wait on it is short */
+    for ( i = 0; i < uiNbThreads; i++ )
+    {
+        M4OSA_semaphoreWait(job.semDone, M4OSA_WAIT_FOREVER);
+    }
+
+    for ( i = 0; i < uiNbThreads; i++ )
+    {
+        M4OSA_threadSyncGetState(pThreads[i], &state);
+
+        while( M4OSA_kThreadOpened != state )
+        {
+            M4OSA_threadSleep(1);
+            M4OSA_threadSyncGetState(pThreads[i], &state);
+        }
+        M4OSA_threadSyncClose(pThreads[i]);
+    }
+
+    if( M4OSA_NULL != job.semDone )
+    {
+        M4OSA_semaphoreClose(job.semDone);
+    }
+    M4OSA_mutexClose(job.mutex);
+
+    if( M4NO_ERROR != job.err )
+    {
+        M4OSA_TRACE1_2("M4VSS3GPP_editAnalyseClipList: clip %d returns 0x%x",
+            job.uiErrClip, job.err);
+        return job.err;
+    }
+
+    M4OSA_TRACE3_0("M4VSS3GPP_editAnalyseClipList(): returning M4NO_ERROR");
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_editCheckClipCompatibility()
@@ -40,6 +40,8 @@
 #include "M4OSA_Memory.h"   /**< OSAL memory management */
 #include "M4OSA_Debug.h"    /**< OSAL debug management */
 #include "M4OSA_CharStar.h" /**< OSAL string management */
+#include "M4OSA_Thread.h"   /**< OSAL thread management */
+#include "M4OSA_Semaphore.h"
 
 #ifdef WIN32
 #include "string.h"         /**< for strcpy (Don't want to get dependencies
@@ -64,6 +66,12 @@ M4VSS3GPP_intCreateMP3OutputFile( M4VSS3GPP_InternalEditContext *pC,
                                  M4OSA_Void *pOutputFile );
 static M4OSA_ERR M4VSS3GPP_intSwitchToNextClip(
     M4VSS3GPP_InternalEditContext *pC );
+static M4OSA_Void M4VSS3GPP_intStartPrefetch(
+    M4VSS3GPP_InternalEditContext *pC );
+static M4OSA_Void M4VSS3GPP_intStopPrefetch(
+    M4VSS3GPP_InternalEditContext *pC );
+static M4OSA_Bool M4VSS3GPP_intIsStreamCopyClip(
+    M4VSS3GPP_InternalEditContext *pC );
 static M4OSA_ERR
 M4VSS3GPP_intComputeOutputVideoAndAudioDsi( M4VSS3GPP_InternalEditContext *pC,
                                            M4OSA_UInt8 uiMasterClip );
@@ -155,6 +163,7 @@ M4OSA_ERR M4VSS3GPP_editInit( M4VSS3GPP_EditContext *pContext,
     pC->pClipList = M4OSA_NULL;
     pC->pTransitionList = M4OSA_NULL;
     pC->pEffectsList = M4OSA_NULL;
+    pC->pEffectsLut = M4OSA_NULL;
     pC->pActiveEffectsList = M4OSA_NULL;
     pC->pActiveEffectsList1 = M4OSA_NULL;
     pC->bClip1ActiveFramingEffect = M4OSA_FALSE;
@@ -162,6 +171,12 @@ M4OSA_ERR M4VSS3GPP_editInit( M4VSS3GPP_EditContext *pContext,
     pC->uiCurrentClip = 0;
     pC->pC1 = M4OSA_NULL;
     pC->pC2 = M4OSA_NULL;
+    pC->pPrefetchThread = M4OSA_NULL;
+    pC->semPrefetchDone = M4OSA_NULL;
+    pC->pPrefetchClip = M4OSA_NULL;
+    pC->uiPrefetchClip = 0;
+    pC->PrefetchErr = M4NO_ERROR;
+    pC->bClip1StreamCopy = M4OSA_FALSE;
     pC->yuv1[0].pac_data = pC->yuv1[1].pac_data = pC->
         yuv1[2].pac_data = M4OSA_NULL;
     pC->yuv2[0].pac_data = pC->yuv2[1].pac_data = pC->
@@ -234,6 +249,8 @@ M4OSA_ERR M4VSS3GPP_editInit( M4VSS3GPP_EditContext *pContext,
     pC->State = M4VSS3GPP_kEditState_CREATED;
     pC->Vstate = M4VSS3GPP_kEditVideoState_READ_WRITE;
     pC->Astate = M4VSS3GPP_kEditAudioState_READ_WRITE;
+
+    M4_StepStatsReset(&pC->Stats);
     /* The flag is set to false at the beginning of every clip */
     pC->m_bClipExternalHasStarted = M4OSA_FALSE;
 
@@ -489,6 +506,7 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
     M4VIDEOEDITING_FileType outputFileType =
         M4VIDEOEDITING_kFileType_Unsupported; /**< 3GPP or MP3 (we don't do AMR output) */
     M4OSA_UInt32 uiC1duration, uiC2duration;
+    M4VSS3GPP_ClipSettings **pClipSettingsList;
 
     M4OSA_TRACE3_2(
         "M4VSS3GPP_editOpen called with pContext=0x%x, pSettings=0x%x",
@@ -570,6 +588,20 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
                 sizeof(M4VSS3GPP_EffectSettings));
         }
 
+        /**
+        * No effect is a lookup table until M4VSS3GPP_editSetEffectLut says so */
+        pC->pEffectsLut =
+            (M4VFL_ColorLut **)M4OSA_32bitAlignedMalloc(sizeof(M4VFL_ColorLut *) * pC->nbEffects,
+            M4VSS3GPP, (M4OSA_Char *)"pC->pEffectsLut");
+
+        if( M4OSA_NULL == pC->pEffectsLut )
+        {
+            M4OSA_TRACE1_0(
+                "M4VSS3GPP_editOpen: unable to allocate pC->pEffectsLut, returning M4ERR_ALLOC");
+            return M4ERR_ALLOC;
+        }
+        memset((void *)pC->pEffectsLut, 0, sizeof(M4VFL_ColorLut *) * pC->nbEffects);
+
         /**
         * Allocate active effects list RC */
         pC->pActiveEffectsList =
@@ -602,6 +634,7 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
         pC->nbActiveEffects = 0;
         pC->nbActiveEffects1 = 0;
         pC->pEffectsList = M4OSA_NULL;
+        pC->pEffectsLut = M4OSA_NULL;
         pC->pActiveEffectsList = M4OSA_NULL;
         pC->pActiveEffectsList1 = M4OSA_NULL;
         pC->bClip1ActiveFramingEffect = M4OSA_FALSE;
@@ -609,24 +642,34 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
     }
 
     /**
-    * Test the clip analysis data, if it is not provided, analyse the clips by ourselves. */
+    * Test the clip analysis data, if it is not provided, analyse the clips by ourselves
+    * (all the missing analyses at once, so that they run concurrently). */
+    pClipSettingsList = (M4VSS3GPP_ClipSettings **)M4OSA_32bitAlignedMalloc(
+        pC->uiClipNumber * sizeof(M4VSS3GPP_ClipSettings *), M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_editOpen: pClipSettingsList");
+
+    if( M4OSA_NULL == pClipSettingsList )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_editOpen: unable to allocate pClipSettingsList,\
+                       returning M4ERR_ALLOC");
+        return M4ERR_ALLOC;
+    }
+
     for ( i = 0; i < pC->uiClipNumber; i++ )
     {
-        if( M4OSA_FALSE == pC->pClipList[i].ClipProperties.bAnalysed )
-        {
-            /**< Analysis not provided by the integrator */
-            err = M4VSS3GPP_editAnalyseClip(pC->pClipList[i].pFile,
-                pC->pClipList[i].FileType, &pC->pClipList[i].ClipProperties,
-                pC->pOsaFileReadPtr);
+        pClipSettingsList[i] = &pC->pClipList[i];
+    }
 
-            if( M4NO_ERROR != err )
-            {
-                M4OSA_TRACE1_1(
-                    "M4VSS3GPP_editOpen: M4VSS3GPP_editAnalyseClip returns 0x%x!",
-                    err);
-                return err;
-            }
-        }
+    err = M4VSS3GPP_editAnalyseClipList(pClipSettingsList, pC->uiClipNumber,
+        pC->pOsaFileReadPtr, M4OSA_NULL);
+    free(pClipSettingsList);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_editOpen: M4VSS3GPP_editAnalyseClipList returns 0x%x!",
+            err);
+        return err;
     }
 
     /**
@@ -1338,6 +1381,47 @@ M4OSA_ERR M4VSS3GPP_editOpen( M4VSS3GPP_EditContext pContext,
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editSetEffectLut()
+ * @brief    Declare that an external video effect is a per plane lookup table.
+ * @param    pContext           (IN) VSS edit context
+ * @param    uiEffect           (IN) Index of the effect in the edit settings
+ * @param    pLut               (IN) Per plane table equivalent to the external effect
+ * @return    M4NO_ERROR:       No error
+ * @return    M4ERR_PARAMETER:  Bad effect index or table type
+ * @return    M4ERR_STATE:      M4VSS3GPP_editOpen() has not been called
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editSetEffectLut( M4VSS3GPP_EditContext pContext, M4OSA_UInt8 uiEffect,
+                                     M4VFL_ColorLut *pLut )
+{
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pContext;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_editSetEffectLut: pContext is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pLut), M4ERR_PARAMETER,
+        "M4VSS3GPP_editSetEffectLut: pLut is M4OSA_NULL");
+
+    if( M4OSA_NULL == pC->pEffectsLut )
+    {
+        M4OSA_TRACE1_0("M4VSS3GPP_editSetEffectLut: no effect, returning M4ERR_STATE");
+        return M4ERR_STATE;
+    }
+    if( (uiEffect >= pC->nbEffects)
+        || (pC->pEffectsList[uiEffect].VideoEffectType < M4VSS3GPP_kVideoEffectType_External)
+        || (M4VFL_kColorLut_Planes != pLut->type) )
+    {
+        M4OSA_TRACE1_1("M4VSS3GPP_editSetEffectLut: effect %d cannot be a table,\
+            returning M4ERR_PARAMETER", uiEffect);
+        return M4ERR_PARAMETER;
+    }
+
+    pC->pEffectsLut[uiEffect] = pLut;
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_editStep()
@@ -1359,7 +1443,9 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
     M4VSS3GPP_InternalEditContext *pC =
         (M4VSS3GPP_InternalEditContext *)pContext;
     M4OSA_UInt32 uiProgressAudio, uiProgressVideo, uiProgress;
+    M4OSA_UInt32 uiNbAu;
     M4OSA_ERR err;
+    M4_StepTimer stepTimer, audioTimer;
 
     M4OSA_TRACE3_1("M4VSS3GPP_editStep called with pContext=0x%x", pContext);
 
@@ -1372,6 +1458,8 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
 
     /**
     * Check state automaton and select correct processing */
+    M4_StepStatsStart(&pC->Stats, &stepTimer);
+
     switch( pC->State )
     {
         case M4VSS3GPP_kEditState_VIDEO:
@@ -1379,15 +1467,31 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
             break;
 
         case M4VSS3GPP_kEditState_AUDIO:
+            M4_StepStatsStart(&pC->Stats, &audioTimer);
             err = M4VSS3GPP_intEditStepAudio(pC);
+
+            /**
+            * Stream copy: go on copying the audio AUs of the clip */
+            for ( uiNbAu = 1; ( M4OSA_TRUE == pC->bClip1StreamCopy) && (M4NO_ERROR == err)
+                && (M4VSS3GPP_kEditState_AUDIO == pC->State)
+                && (M4VSS3GPP_kEditAudioState_READ_WRITE == pC->Astate)
+                && (uiNbAu < M4VSS3GPP_STREAM_COPY_BURST); uiNbAu++ )
+            {
+                err = M4VSS3GPP_intEditStepAudio(pC);
+            }
+            M4_StepStatsStop(&pC->Stats, M4_kStepStage_Audio, &audioTimer);
             break;
 
         case M4VSS3GPP_kEditState_MP3:
+            M4_StepStatsStart(&pC->Stats, &audioTimer);
             err = M4VSS3GPP_intEditStepMP3(pC);
+            M4_StepStatsStop(&pC->Stats, M4_kStepStage_Audio, &audioTimer);
             break;
 
         case M4VSS3GPP_kEditState_MP3_JUMP:
+            M4_StepStatsStart(&pC->Stats, &audioTimer);
             err = M4VSS3GPP_intEditJumpMP3(pC);
+            M4_StepStatsStop(&pC->Stats, M4_kStepStage_Audio, &audioTimer);
             break;
 
         default:
@@ -1396,6 +1500,8 @@ M4OSA_ERR M4VSS3GPP_editStep( M4VSS3GPP_EditContext pContext,
             return M4ERR_STATE;
     }
 
+    M4_StepStatsStopStep(&pC->Stats, &stepTimer);
+
     /**
     * Compute progress.
     * We do the computing with 32bits precision because in some (very) extreme case, we may get
@@ -1467,6 +1573,12 @@ M4OSA_ERR M4VSS3GPP_editClose( M4VSS3GPP_EditContext pContext )
         return M4ERR_STATE;
     }
 
+    M4_StepStatsTrace(&pC->Stats, (const M4OSA_Char *)"VSS");
+
+    /**
+    * There may be a clip being prefetched */
+    M4VSS3GPP_intStopPrefetch(pC);
+
     /**
     * There may be an encoder to destroy */
     err = M4VSS3GPP_intDestroyVideoEncoder(pC);
@@ -1672,6 +1784,11 @@ M4OSA_ERR M4VSS3GPP_editClose( M4VSS3GPP_EditContext pContext )
         free(pC->pEffectsList);
         pC->pEffectsList = M4OSA_NULL;
     }
+    if( pC->pEffectsLut != M4OSA_NULL )
+    {
+        free(pC->pEffectsLut);
+        pC->pEffectsLut = M4OSA_NULL;
+    }
 
     /**
     * RC Free active effects list */
@@ -1805,6 +1922,32 @@ M4OSA_ERR M4VSS3GPP_editCleanUp( M4VSS3GPP_EditContext pContext )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editGetStatistics()
+ * @brief    Get the time spent in each stage of the edit steps.
+ * @param    pContext           (IN) VSS edit context
+ * @param    pStats             (OUT) Statistics since M4VSS3GPP_editInit()
+ * @return    M4NO_ERROR:       No error
+ * @return    M4ERR_PARAMETER:  At least one parameter is M4OSA_NULL (debug only)
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editGetStatistics( M4VSS3GPP_EditContext pContext,
+                                      M4_StepStats *pStats )
+{
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pContext;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4VSS3GPP_editGetStatistics: pContext is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pStats), M4ERR_PARAMETER,
+        "M4VSS3GPP_editGetStatistics: pStats is M4OSA_NULL");
+
+    memcpy((void *)pStats, (void *) &pC->Stats, sizeof(M4_StepStats));
+
+    return M4NO_ERROR;
+}
+
 #ifdef WIN32
 /**
  ******************************************************************************
@@ -2729,13 +2872,15 @@ M4VSS3GPP_intComputeOutputVideoAndAudioDsi( M4VSS3GPP_InternalEditContext *pC,
                     encHeader->Size);
             }
 
-            err = M4VSS3GPP_intDestroyVideoEncoder(pC);
+            /**
+            * Keep the encoder for the first encoded segment */
+            err = M4VSS3GPP_intStopVideoEncoder(pC);
 
             if( M4NO_ERROR != err )
             {
                 M4OSA_TRACE1_1(
                     "M4VSS3GPP_intComputeOutputVideoAndAudioDsi:\
-                    M4VSS3GPP_intDestroyVideoEncoder returned error 0x%x",
+                    M4VSS3GPP_intStopVideoEncoder returned error 0x%x",
                     err);
             }
         }
@@ -2913,13 +3058,12 @@ static M4OSA_ERR M4VSS3GPP_intSwitchToNextClip(
     * else open it */
     else
     {
-        err = M4VSS3GPP_intOpenClip(pC, &pC->pC1,
-            &pC->pClipList[pC->uiCurrentClip]);
+        err = M4VSS3GPP_intOpenNextClip(pC, &pC->pC1, pC->uiCurrentClip);
 
         if( M4NO_ERROR != err )
         {
             M4OSA_TRACE1_1(
-                "M4VSS3GPP_intSwitchToNextClip: M4VSS3GPP_intOpenClip() returns 0x%x!",
+                "M4VSS3GPP_intSwitchToNextClip: M4VSS3GPP_intOpenNextClip() returns 0x%x!",
                 err);
             return err;
         }
@@ -2969,6 +3113,14 @@ static M4OSA_ERR M4VSS3GPP_intSwitchToNextClip(
         }
     }
 
+    /**
+    * Check if the clip is only copied */
+    pC->bClip1StreamCopy = M4VSS3GPP_intIsStreamCopyClip(pC);
+
+    /**
+    * Open the next clip while this one is processed */
+    M4VSS3GPP_intStartPrefetch(pC);
+
     /**
     * Init starting state for this clip processing */
     if( M4SYS_kMP3 == pC->ewc.AudioStreamType )
@@ -3075,6 +3227,207 @@ M4OSA_ERR M4VSS3GPP_intReachedEndOfAudio( M4VSS3GPP_InternalEditContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4VSS3GPP_intIsStreamCopyClip()
+ * @brief    Tells if clip1 is only copied to the output
+ * @note    The clip has no effect, no begin cut, no transition with its neighbours
+ *          and is already in the output format: all its AUs are written as read,
+ *          so the steps copy them in bursts of M4VSS3GPP_STREAM_COPY_BURST.
+ * @param   pC            (IN) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_Bool M4VSS3GPP_intIsStreamCopyClip(
+    M4VSS3GPP_InternalEditContext *pC )
+{
+    if( ( 0 != pC->nbEffects) || (M4OSA_TRUE == pC->bIsMMS)
+        || (M4VIDEOEDITING_kFileType_ARGB8888 == pC->pC1->pSettings->FileType)
+        || (M4OSA_TRUE == pC->pC1->pSettings->bTranscodingRequired)
+        || (0 != pC->pC1->pSettings->uiBeginCutTime)
+        || (0 != pC->pTransitionList[pC->uiCurrentClip].uiTransitionDuration) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    if( ( pC->uiCurrentClip > 0)
+        && (0 != pC->pTransitionList[pC->uiCurrentClip - 1].uiTransitionDuration) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    return M4OSA_TRUE;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intPrefetchThread()
+ * @brief    Opens the clip to prefetch (thread function, runs once)
+ * @param   pParam        (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intPrefetchThread( M4OSA_Void *pParam )
+{
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pParam;
+
+    pC->PrefetchErr = M4VSS3GPP_intOpenClip(pC, &pC->pPrefetchClip,
+        &pC->pClipList[pC->uiPrefetchClip]);
+
+    M4OSA_TRACE3_2("M4VSS3GPP_intPrefetchThread: clip %d opened (0x%x)",
+        pC->uiPrefetchClip, pC->PrefetchErr);
+    M4OSA_semaphorePost(pC->semPrefetchDone);
+
+    /**
+    * Any value but M4NO_ERROR ends the thread */
+    return M4WAR_NO_MORE_AU;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intStartPrefetch()
+ * @brief    Starts opening the clip after the current one on a thread
+ * @note     Nothing is done if there is no next clip. If the thread can not
+ *           be started, the next clip is just opened when needed.
+ * @param   pC            (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_Void M4VSS3GPP_intStartPrefetch(
+    M4VSS3GPP_InternalEditContext *pC )
+{
+    M4OSA_ERR err;
+
+    if( ( M4OSA_NULL != pC->pPrefetchThread)
+        || (pC->uiCurrentClip + 1 >= pC->uiClipNumber) )
+    {
+        return;
+    }
+
+    if( M4OSA_NULL == pC->semPrefetchDone )
+    {
+        err = M4OSA_semaphoreOpen(&pC->semPrefetchDone, 0);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intStartPrefetch: M4OSA_semaphoreOpen returns 0x%x", err);
+            pC->semPrefetchDone = M4OSA_NULL;
+            return;
+        }
+    }
+
+    pC->uiPrefetchClip = (M4OSA_UInt8)(pC->uiCurrentClip + 1);
+    pC->pPrefetchClip = M4OSA_NULL;
+    pC->PrefetchErr = M4NO_ERROR;
+
+    err = M4OSA_threadSyncOpen(&pC->pPrefetchThread,
+        (M4OSA_ThreadDoIt)M4VSS3GPP_intPrefetchThread);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intStartPrefetch: M4OSA_threadSyncOpen returns 0x%x", err);
+        pC->pPrefetchThread = M4OSA_NULL;
+        return;
+    }
+
+    err = M4OSA_threadSyncStart(pC->pPrefetchThread, (M4OSA_Void *)pC);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1(
+            "M4VSS3GPP_intStartPrefetch: M4OSA_threadSyncStart returns 0x%x", err);
+        M4OSA_threadSyncClose(pC->pPrefetchThread);
+        pC->pPrefetchThread = M4OSA_NULL;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intJoinPrefetch()
+ * @brief    Waits for the end of the prefetch thread, if any
+ * @param   pC            (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_Void M4VSS3GPP_intJoinPrefetch( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4OSA_ThreadState state;
+
+    if( M4OSA_NULL == pC->pPrefetchThread )
+    {
+        return;
+    }
+
+    /**
+    * The thread state is set to opened just after the semaphore is posted,
+    * so the wait on it is short */
+    M4OSA_semaphoreWait(pC->semPrefetchDone, M4OSA_WAIT_FOREVER);
+    M4OSA_threadSyncGetState(pC->pPrefetchThread, &state);
+
+    while( M4OSA_kThreadOpened != state )
+    {
+        M4OSA_threadSleep(1);
+        M4OSA_threadSyncGetState(pC->pPrefetchThread, &state);
+    }
+    M4OSA_threadSyncClose(pC->pPrefetchThread);
+    pC->pPrefetchThread = M4OSA_NULL;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intStopPrefetch()
+ * @brief    Waits for the prefetch thread and closes the clip it opened
+ * @param   pC            (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_Void M4VSS3GPP_intStopPrefetch( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4VSS3GPP_intJoinPrefetch(pC);
+
+    if( M4OSA_NULL != pC->pPrefetchClip )
+    {
+        M4VSS3GPP_intClipCleanUp(pC->pPrefetchClip);
+        pC->pPrefetchClip = M4OSA_NULL;
+    }
+
+    if( M4OSA_NULL != pC->semPrefetchDone )
+    {
+        M4OSA_semaphoreClose(pC->semPrefetchDone);
+        pC->semPrefetchDone = M4OSA_NULL;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intOpenNextClip()
+ * @brief    Gets a clip of the clip list opened
+ * @note     If the clip is being opened by the prefetch thread, waits for it
+ *           and takes it, else opens it.
+ * @param   pC            (IN/OUT) Internal edit context
+ * @param   hClip         (OUT) Opened clip
+ * @param   uiClipIndex   (IN) Index of the clip in the clip list
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intOpenNextClip( M4VSS3GPP_InternalEditContext *pC,
+                                    M4VSS3GPP_ClipContext **hClip,
+                                    M4OSA_UInt8 uiClipIndex )
+{
+    if( ( M4OSA_NULL != pC->pPrefetchThread)
+        && (uiClipIndex == pC->uiPrefetchClip) )
+    {
+        M4VSS3GPP_intJoinPrefetch(pC);
+
+        *hClip = pC->pPrefetchClip;
+        pC->pPrefetchClip = M4OSA_NULL;
+        return pC->PrefetchErr;
+    }
+
+    /**
+    * Not the prefetched clip: drop the prefetch */
+    M4VSS3GPP_intStopPrefetch(pC);
+
+    return M4VSS3GPP_intOpenClip(pC, hClip, &pC->pClipList[uiClipIndex]);
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intOpenClip()
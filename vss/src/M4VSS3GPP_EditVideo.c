@@ -61,16 +61,25 @@
 
 static M4OSA_ERR M4VSS3GPP_intCheckVideoMode(
     M4VSS3GPP_InternalEditContext *pC );
+static M4OSA_ERR M4VSS3GPP_intStreamCopyVideo(
+    M4VSS3GPP_InternalEditContext *pC );
 static M4OSA_Void
 M4VSS3GPP_intCheckVideoEffects( M4VSS3GPP_InternalEditContext *pC,
                                M4OSA_UInt8 uiClipNumber );
 static M4OSA_ERR M4VSS3GPP_intApplyVideoEffect(
           M4VSS3GPP_InternalEditContext *pC, M4VIFI_ImagePlane *pPlaneIn,
           M4VIFI_ImagePlane *pPlaneOut, M4OSA_Bool bSkipFramingEffect);
+static M4VSS3GPP_EffectSettings* M4VSS3GPP_intGetActiveEffect(
+          M4VSS3GPP_InternalEditContext *pC, M4OSA_UInt8 uiIndex);
+static M4OSA_Bool M4VSS3GPP_intIsLutEffect(M4VSS3GPP_InternalEditContext *pC,
+                                           M4VSS3GPP_EffectSettings *pFx);
 
 static M4OSA_ERR
 M4VSS3GPP_intVideoTransition( M4VSS3GPP_InternalEditContext *pC,
                              M4VIFI_ImagePlane *pPlaneOut );
+static M4OSA_ERR M4VSS3GPP_intVPPFrame( M4VPP_Context pContext,
+                                       M4VIFI_ImagePlane *pPlaneIn,
+                                       M4VIFI_ImagePlane *pPlaneOut );
 
 static M4OSA_Void
 M4VSS3GPP_intUpdateTimeInfo( M4VSS3GPP_InternalEditContext *pC,
@@ -130,6 +139,7 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
     M4ENCODER_FrameMode FrameMode;
     M4OSA_Bool bSkipFrame;
     M4OSA_UInt16 offset;
+    M4_StepTimer timer;
 
     /**
      * Check if we reached end cut. Decorrelate input and output encoding
@@ -160,6 +170,15 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
         return err;
     }
 
+    /**
+    * A stream copy clip stays in read/write mode until its end */
+    if( ( M4OSA_TRUE == pC->bClip1StreamCopy)
+        && (M4VSS3GPP_kEditVideoState_READ_WRITE == pC->Vstate)
+        && (M4VSS3GPP_kClipStatus_READ == pC->pC1->Vstatus) )
+    {
+        return M4VSS3GPP_intStreamCopyVideo(pC);
+    }
+
     /* Don't change the states if we are in decodeUpTo() */
     if ( (M4VSS3GPP_kClipStatus_DECODE_UP_TO != pC->pC1->Vstatus)
         && (( pC->pC2 == M4OSA_NULL)
@@ -199,6 +218,16 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 * to get to the good position. */
                 if( M4VSS3GPP_kClipStatus_READ != pC->pC1->Vstatus )
                 {
+                    /**
+                    * The decoder must not read the stream ahead any more (not all
+                    * the decoders support this option, the result is ignored) */
+                    if( M4OSA_NULL != pC->pC1->pViDecCtxt )
+                    {
+                        pC->pC1->ShellAPI.m_pVideoDecoder->m_pFctSetOption(
+                            pC->pC1->pViDecCtxt, M4DECODER_kOptionID_PauseReadAhead,
+                            M4OSA_NULL);
+                    }
+
                     /**
                     * Jump to target video time (tc = to-T) */
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
@@ -216,10 +245,12 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                         return err;
                     }
 
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = pC->pC1->ShellAPI.m_pReaderDataIt->m_pFctGetNextAu(
                         pC->pC1->pReaderContext,
                         (M4_StreamHandler *)pC->pC1->pVideoStream,
                         &pC->pC1->VideoAU);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
 
                     if( ( M4NO_ERROR != err) && (M4WAR_NO_MORE_AU != err) )
                     {
@@ -321,10 +352,12 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
 
                     /**
                     * Write the AU */
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = pC->ShellAPI.pWriterDataFcts->pProcessAU(
                         pC->ewc.p3gpWriterContext,
                         M4VSS3GPP_WRITER_VIDEO_STREAM_ID,
                         &pC->ewc.WriterVideoAU);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Write, &timer);
 
                     if( M4NO_ERROR != err )
                     {
@@ -350,10 +383,12 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
 
                     /**
                     * Read next AU for next step */
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = pC->pC1->ShellAPI.m_pReaderDataIt->m_pFctGetNextAu(
                         pC->pC1->pReaderContext,
                         (M4_StreamHandler *)pC->pC1->pVideoStream,
                         &pC->pC1->VideoAU);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
 
                     if( ( M4NO_ERROR != err) && (M4WAR_NO_MORE_AU != err) )
                     {
@@ -387,10 +422,12 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                     {
                         /* In other cases (reader late), just let the reader catch up
                          pC->ewc.dVTo */
+                        M4_StepStatsStart(&pC->Stats, &timer);
                         err = pC->pC1->ShellAPI.m_pReaderDataIt->m_pFctGetNextAu(
                             pC->pC1->pReaderContext,
                             (M4_StreamHandler *)pC->pC1->pVideoStream,
                             &pC->pC1->VideoAU);
+                        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
 
                         if( ( M4NO_ERROR != err) && (M4WAR_NO_MORE_AU != err) )
                         {
@@ -438,7 +475,9 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 * Decode the video up to the target time
                 (will jump to the previous RAP if needed ) */
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1, (M4OSA_Int32)pC->ewc.dInputVidCts);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Decode, &timer);
                 if( M4NO_ERROR != err )
                 {
                     M4OSA_TRACE1_1(
@@ -469,8 +508,10 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                     FrameMode = M4ENCODER_kNormalFrame;
 
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctEncode(pC->ewc.pEncContext, M4OSA_NULL,
                 pC->ewc.dInputVidCts, FrameMode);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Encode, &timer);
                 /**
                 * Check if we had a VPP error... */
                 if( M4NO_ERROR != pC->ewc.VppError )
@@ -563,8 +604,10 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                         }
                     }
                     // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC1,
                          (M4OSA_Int32)pC->ewc.dInputVidCts);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Decode, &timer);
                     if( M4NO_ERROR != err )
                     {
                         M4OSA_TRACE1_1(
@@ -603,8 +646,10 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                     }
 
                     // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = M4VSS3GPP_intClipDecodeVideoUpToCts(pC->pC2,
                          (M4OSA_Int32)pC->ewc.dInputVidCts);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Decode, &timer);
                     if( M4NO_ERROR != err )
                     {
                         M4OSA_TRACE1_1(
@@ -631,8 +676,10 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
                 * Encode the frame (rendering, filtering and writing will be done
                 in encoder callbacks */
                 // Decorrelate input and output encoding timestamp to handle encoder prefetch
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctEncode(pC->ewc.pEncContext, M4OSA_NULL,
                     pC->ewc.dInputVidCts, M4ENCODER_kNormalFrame);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Encode, &timer);
 
                 /**
                 * If encode returns a process frame error, it is likely to be a VPP error */
@@ -713,6 +760,129 @@ M4OSA_ERR M4VSS3GPP_intEditStepVideo( M4VSS3GPP_InternalEditContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intStreamCopyVideo()
+ * @brief    Copies up to M4VSS3GPP_STREAM_COPY_BURST video AUs of a stream copy clip
+ * @note    Nothing can change the video mode of the clip, so the AUs are written with
+ *          their own CTS (shifted by the clip offset) instead of being picked on the
+ *          output frame grid, and the output time follows the last written AU.
+ * @param   pC    (IN/OUT) Internal edit context
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intStreamCopyVideo(
+    M4VSS3GPP_InternalEditContext *pC )
+{
+    M4OSA_ERR err;
+    M4OSA_UInt16 offset = 0;
+    M4OSA_UInt32 uiNbAu;
+    M4_StepTimer timer;
+
+    /* for h.264 stream do not read the 1st 4 bytes as they are header indicators */
+    if( pC->pC1->pVideoStream->m_basicProperties.m_streamType
+        == M4DA_StreamTypeVideoMpeg4Avc )
+        offset = 4;
+
+    for ( uiNbAu = 0; uiNbAu < M4VSS3GPP_STREAM_COPY_BURST; uiNbAu++ )
+    {
+        if( ( 0 == pC->pC1->VideoAU.m_size)
+            || (pC->pC1->VideoAU.m_CTS >= pC->pC1->iEndTime) )
+        {
+            /**
+            * No more AU to copy: the next step ends the clip video exactly at its
+            * end time */
+            pC->ewc.dInputVidCts = (M4OSA_Double)(pC->pC1->iEndTime
+                + pC->pC1->iVoffset - pC->iInOutTimeOffset);
+            return M4NO_ERROR;
+        }
+
+        /**
+        * Get the output AU to write into */
+        err = pC->ShellAPI.pWriterDataFcts->pStartAU(pC->ewc.p3gpWriterContext,
+            M4VSS3GPP_WRITER_VIDEO_STREAM_ID, &pC->ewc.WriterVideoAU);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intStreamCopyVideo: pWriterDataFcts->pStartAU(Video) returns 0x%x!",
+                err);
+            return err;
+        }
+
+        /**
+        * Copy the input AU to the output AU */
+        pC->ewc.WriterVideoAU.attribute = pC->pC1->VideoAU.m_attribute;
+        pC->ewc.WriterVideoAU.CTS = (M4OSA_Time)pC->pC1->VideoAU.m_CTS +
+            (M4OSA_Time)pC->pC1->iVoffset;
+        pC->ewc.WriterVideoAU.size = pC->pC1->VideoAU.m_size - offset;
+
+        if( pC->ewc.WriterVideoAU.size > pC->ewc.uiVideoMaxAuSize )
+        {
+            M4OSA_TRACE1_2(
+                "M4VSS3GPP_intStreamCopyVideo: AU size greater than MaxAuSize (%d>%d)!\
+                 returning M4VSS3GPP_ERR_INPUT_VIDEO_AU_TOO_LARGE",
+                pC->ewc.WriterVideoAU.size, pC->ewc.uiVideoMaxAuSize);
+            return M4VSS3GPP_ERR_INPUT_VIDEO_AU_TOO_LARGE;
+        }
+
+        memcpy((void *)pC->ewc.WriterVideoAU.dataAddress,
+            (void *)(pC->pC1->VideoAU.m_dataAddress + offset),
+            (pC->ewc.WriterVideoAU.size));
+
+        /**
+        * The output time goes on from the written AU */
+        pC->ewc.dInputVidCts = (M4OSA_Double)pC->ewc.WriterVideoAU.CTS
+            + pC->dOutputFrameDuration;
+
+        /**
+        * Update time info for the Counter Time System to be equal to the bit-stream time */
+        M4VSS3GPP_intUpdateTimeInfo(pC, &pC->ewc.WriterVideoAU);
+        M4OSA_TRACE2_2("B ---- write : cts  = %lu [ 0x%x ]",
+            pC->ewc.WriterVideoAU.CTS, pC->ewc.WriterVideoAU.size);
+
+        /**
+        * Write the AU */
+        M4_StepStatsStart(&pC->Stats, &timer);
+        err = pC->ShellAPI.pWriterDataFcts->pProcessAU(pC->ewc.p3gpWriterContext,
+            M4VSS3GPP_WRITER_VIDEO_STREAM_ID, &pC->ewc.WriterVideoAU);
+        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Write, &timer);
+
+        if( M4WAR_WRITER_STOP_REQ == err )
+        {
+            M4OSA_TRACE1_0("M4VSS3GPP_intStreamCopyVideo: File was cut to avoid oversize");
+            return M4VSS3GPP_WAR_EDITING_DONE;
+        }
+        else if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intStreamCopyVideo: pWriterDataFcts->pProcessAU(Video) returns 0x%x!",
+                err);
+            return err;
+        }
+
+        /**
+        * Read the next AU */
+        M4_StepStatsStart(&pC->Stats, &timer);
+        err = pC->pC1->ShellAPI.m_pReaderDataIt->m_pFctGetNextAu(pC->pC1->pReaderContext,
+            (M4_StreamHandler *)pC->pC1->pVideoStream, &pC->pC1->VideoAU);
+        M4_StepStatsStop(&pC->Stats, M4_kStepStage_Read, &timer);
+
+        if( M4WAR_NO_MORE_AU == err )
+        {
+            pC->pC1->VideoAU.m_size = 0;
+        }
+        else if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intStreamCopyVideo: m_pReaderDataIt->m_pFctGetNextAu returns 0x%x!",
+                err);
+            return err;
+        }
+    }
+
+    return M4NO_ERROR;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intCheckVideoMode()
@@ -752,8 +922,8 @@ static M4OSA_ERR M4VSS3GPP_intCheckVideoMode(
         {
             pC->pC1->bGetYuvDataFromDecoder = M4OSA_TRUE;
 
-            err = M4VSS3GPP_intOpenClip(pC, &pC->pC2,
-                &pC->pClipList[pC->uiCurrentClip + 1]);
+            err = M4VSS3GPP_intOpenNextClip(pC, &pC->pC2,
+                (M4OSA_UInt8)(pC->uiCurrentClip + 1));
 
             if( M4NO_ERROR != err )
             {
@@ -890,8 +1060,8 @@ static M4OSA_ERR M4VSS3GPP_intCheckVideoMode(
         && pC->bIsMMS == M4OSA_FALSE )
     {
         /**
-        * Create the encoder, if not created already*/
-        if (pC->ewc.encoderState == M4VSS3GPP_kNoEncoder) {
+        * Create the encoder, or restart it, if not running already*/
+        if (pC->ewc.encoderState != M4VSS3GPP_kEncoderRunning) {
             err = M4VSS3GPP_intCreateVideoEncoder(pC);
 
             if( M4NO_ERROR != err )
@@ -903,10 +1073,11 @@ static M4OSA_ERR M4VSS3GPP_intCheckVideoMode(
             }
         }
     }
-    else if( pC->bIsMMS == M4OSA_TRUE && pC->ewc.pEncContext == M4OSA_NULL )
+    else if( pC->bIsMMS == M4OSA_TRUE
+        && pC->ewc.encoderState != M4VSS3GPP_kEncoderRunning )
     {
         /**
-        * Create the encoder */
+        * Create the encoder, or restart it */
         err = M4VSS3GPP_intCreateVideoEncoder(pC);
 
         if( M4NO_ERROR != err )
@@ -942,13 +1113,14 @@ static M4OSA_ERR M4VSS3GPP_intCheckVideoMode(
         && pC->bIsMMS == M4OSA_FALSE )
     {
         /**
-        * Destroy the previously created encoder */
-        err = M4VSS3GPP_intDestroyVideoEncoder(pC);
+        * Stop the previously created encoder, it is restarted by the next
+        * encoded segment */
+        err = M4VSS3GPP_intStopVideoEncoder(pC);
 
         if( M4NO_ERROR != err )
         {
             M4OSA_TRACE1_1(
-                "M4VSS3GPP_intCheckVideoMode: M4VSS3GPP_intDestroyVideoEncoder returns 0x%x!",
+                "M4VSS3GPP_intCheckVideoMode: M4VSS3GPP_intStopVideoEncoder returns 0x%x!",
                 err);
             return err;
         }
@@ -1014,6 +1186,7 @@ M4OSA_ERR M4VSS3GPP_intProcessAU( M4WRITER_Context pContext,
                                  M4SYS_StreamID streamID, M4SYS_AccessUnit *pAU )
 {
     M4OSA_ERR err;
+    M4_StepTimer timer;
 
     /**
     * Given context is actually the VSS3GPP context */
@@ -1030,8 +1203,10 @@ M4OSA_ERR M4VSS3GPP_intProcessAU( M4WRITER_Context pContext,
 
     /**
     * Write the AU */
+    M4_StepStatsStart(&pC->Stats, &timer);
     err = pC->ShellAPI.pWriterDataFcts->pProcessAU(pC->ewc.p3gpWriterContext,
         M4VSS3GPP_WRITER_VIDEO_STREAM_ID, pAU);
+    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Write, &timer);
 
     if( M4NO_ERROR != err )
     {
@@ -1049,9 +1224,9 @@ M4OSA_ERR M4VSS3GPP_intProcessAU( M4WRITER_Context pContext,
 
 /**
  ******************************************************************************
- * M4OSA_ERR M4VSS3GPP_intVPP()
+ * M4OSA_ERR M4VSS3GPP_intVPPFrame()
  * @brief    We implement our own VideoPreProcessing function
- * @note    It is called by the video encoder
+ * @note    It is called by the video encoder, through M4VSS3GPP_intVPP
  * @param    pContext    (IN) VPP context, which actually is the VSS 3GPP context in our case
  * @param    pPlaneIn    (IN)
  * @param    pPlaneOut    (IN/OUT) Pointer to an array of 3 planes that will contain the output
@@ -1059,11 +1234,13 @@ M4OSA_ERR M4VSS3GPP_intProcessAU( M4WRITER_Context pContext,
  * @return    M4NO_ERROR:    No error
  ******************************************************************************
  */
-M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
-                           M4VIFI_ImagePlane *pPlaneOut )
+static M4OSA_ERR M4VSS3GPP_intVPPFrame( M4VPP_Context pContext,
+                                       M4VIFI_ImagePlane *pPlaneIn,
+                                       M4VIFI_ImagePlane *pPlaneOut )
 {
     M4OSA_ERR err = M4NO_ERROR;
     M4_MediaTime ts;
+    M4_StepTimer timer;
     M4VIFI_ImagePlane *pTmp = M4OSA_NULL;
     M4VIFI_ImagePlane *pLastDecodedFrame = M4OSA_NULL ;
     M4VIFI_ImagePlane *pDecoderRenderFrame = M4OSA_NULL;
@@ -1409,9 +1586,11 @@ M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
                     (pC->pC1->pSettings->FileType !=
                         M4VIDEOEDITING_kFileType_ARGB8888)) {
 
+                    M4_StepStatsStart(&pC->Stats, &timer);
                     err = M4VSS3GPP_intApplyRenderingMode(pC,
                               pC->pC1->pSettings->xVSS.MediaRendering,
                               pDecoderRenderFrame, pTmp);
+                    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Resize, &timer);
                     if (M4NO_ERROR != err) {
                         M4OSA_TRACE1_1("M4VSS3GPP_intVPP: \
                             M4VSS3GPP_intApplyRenderingMode) error 0x%x ", err);
@@ -1559,9 +1738,11 @@ M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
                     pTmp = pPlaneOut;
                 }
                 /* Do rendering mode */
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = M4VSS3GPP_intApplyRenderingMode(pC,
                           pC->pC1->pSettings->xVSS.MediaRendering,
                           pDecoderRenderFrame, pTmp);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Resize, &timer);
                 if (M4NO_ERROR != err) {
                     pC->ewc.VppError = err;
                     return M4NO_ERROR;
@@ -1640,6 +1821,34 @@ M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
     M4OSA_TRACE3_0("M4VSS3GPP_intVPP: returning M4NO_ERROR");
     return M4NO_ERROR;
 }
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intVPP()
+ * @brief    VideoPreProcessing function given to the video encoder
+ * @note    The time spent is counted in the effect stage of the edit statistics,
+ *          except the decoding and the resizing done meanwhile.
+ * @param    pContext    (IN) VPP context, which actually is the VSS 3GPP context in our case
+ * @param    pPlaneIn    (IN)
+ * @param    pPlaneOut    (IN/OUT) Pointer to an array of 3 planes that will contain the output
+ *                                  YUV420 image
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intVPP( M4VPP_Context pContext, M4VIFI_ImagePlane *pPlaneIn,
+                           M4VIFI_ImagePlane *pPlaneOut )
+{
+    M4VSS3GPP_InternalEditContext *pC =
+        (M4VSS3GPP_InternalEditContext *)pContext;
+    M4_StepTimer timer;
+    M4OSA_ERR err;
+
+    M4_StepStatsStart(&pC->Stats, &timer);
+    err = M4VSS3GPP_intVPPFrame(pContext, pPlaneIn, pPlaneOut);
+    M4_StepStatsStop(&pC->Stats, M4_kStepStage_Effect, &timer);
+
+    return err;
+}
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intApplyVideoOverlay()
@@ -1736,10 +1945,59 @@ M4VSS3GPP_intApplyVideoOverlay (M4VSS3GPP_InternalEditContext *pC,
     M4OSA_TRACE3_0("M4VSS3GPP_intApplyVideoOverlay: returning M4NO_ERROR");
     return M4NO_ERROR;
 }
+/**
+ ******************************************************************************
+ * M4VSS3GPP_EffectSettings* M4VSS3GPP_intGetActiveEffect()
+ * @brief    Returns the settings of an active effect of the current clip
+ * @param   pC                (IN) Internal edit context
+ * @param   uiIndex            (IN) Index in the active effects list
+ * @return    The effect settings
+ ******************************************************************************
+ */
+static M4VSS3GPP_EffectSettings* M4VSS3GPP_intGetActiveEffect(
+          M4VSS3GPP_InternalEditContext *pC, M4OSA_UInt8 uiIndex)
+{
+    if (pC->bIssecondClip == M4OSA_TRUE)
+    {
+        return &(pC->pEffectsList[pC->pActiveEffectsList1[uiIndex]]);
+    }
+    return &(pC->pEffectsList[pC->pActiveEffectsList[uiIndex]]);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4VSS3GPP_intIsLutEffect()
+ * @brief    Tells if an effect is a per plane lookup table (fades and color effects)
+ * @note    Consecutive lookup table effects are fused into a single pass on the frame.
+ *          External effects are tables only if declared with M4VSS3GPP_editSetEffectLut.
+ * @param   pC                (IN) Internal edit context
+ * @param   pFx                (IN) Effect settings, in pC->pEffectsList
+ * @return    M4OSA_TRUE if the effect can be fused
+ ******************************************************************************
+ */
+static M4OSA_Bool M4VSS3GPP_intIsLutEffect(M4VSS3GPP_InternalEditContext *pC,
+                                           M4VSS3GPP_EffectSettings *pFx)
+{
+    if ((M4VSS3GPP_kVideoEffectType_FadeFromBlack == pFx->VideoEffectType)
+        || (M4VSS3GPP_kVideoEffectType_FadeToBlack == pFx->VideoEffectType))
+    {
+        return M4OSA_TRUE;
+    }
+    if ((pFx->VideoEffectType >= M4VSS3GPP_kVideoEffectType_External)
+        && (M4OSA_NULL != pC->pEffectsLut[pFx - pC->pEffectsList]))
+    {
+        return M4OSA_TRUE;
+    }
+    return M4OSA_FALSE;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intApplyVideoEffect()
  * @brief    Apply video effect from pPlaneIn to pPlaneOut
+ * @note    Consecutive lookup table effects (fades, color effects) are fused into one
+ *            table, applied in a single pass: each pass (stage) reads and writes a full
+ *            frame, so stacking such effects no longer multiplies the memory traffic.
  * @param   pC                (IN/OUT) Internal edit context
  * @param   uiClip1orClip2    (IN/OUT) 1 for first clip, 2 for second clip
  * @param    pInputPlanes    (IN) Input raw YUV420 image
@@ -1768,6 +2026,12 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
     M4VIFI_ImagePlane  pTempYuvPlane[3];
     M4OSA_UInt8 i;
     M4OSA_UInt8 NumActiveEffects =0;
+    M4OSA_UInt8 NumStages = 0;
+    M4OSA_UInt8 iStage = 0;
+    M4OSA_Bool bIsLutEffect;
+    M4OSA_Bool bPreviousIsLutEffect = M4OSA_FALSE;
+    M4VFL_ColorLut fusedLut;
+    M4VFL_ColorLut effectLut;
 
 
     pClip = pC->pC1;
@@ -1782,9 +2046,21 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
 
     memset((void *)pTempYuvPlane, 0, 3*sizeof(M4VIFI_ImagePlane));
 
+    /**
+    * Count the passes on the frame: a run of lookup table effects is one pass */
+    for (i=0; i<NumActiveEffects; i++)
+    {
+        bIsLutEffect = M4VSS3GPP_intIsLutEffect(pC, M4VSS3GPP_intGetActiveEffect(pC, i));
+        if ((M4OSA_FALSE == bIsLutEffect) || (M4OSA_FALSE == bPreviousIsLutEffect))
+        {
+            NumStages++;
+        }
+        bPreviousIsLutEffect = bIsLutEffect;
+    }
+
     /**
     * Allocate temporary plane if needed RC */
-    if (NumActiveEffects > 1) {
+    if (NumStages > 1) {
         err = M4VSS3GPP_intAllocateYUV420(pTempYuvPlane, pPlaneOut->u_width,
                   pPlaneOut->u_height);
 
@@ -1801,7 +2077,7 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
         }
     }
 
-    if (NumActiveEffects  % 2 == 0)
+    if (NumStages  % 2 == 0)
     {
         pPlaneTempIn = pPlaneIn;
         pPlaneTempOut = pTempYuvPlane;
@@ -1814,11 +2090,9 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
 
     for (i=0; i<NumActiveEffects; i++)
     {
+        pFx = M4VSS3GPP_intGetActiveEffect(pC, i);
         if (pC->bIssecondClip == M4OSA_TRUE)
         {
-
-
-            pFx = &(pC->pEffectsList[pC->pActiveEffectsList1[i]]);
             /* Compute how far from the beginning of the effect we are, in clip-base time. */
             // Decorrelate input and output encoding timestamp to handle encoder prefetch
             VideoEffectTime = ((M4OSA_Int32)pC->ewc.dInputVidCts) +
@@ -1827,7 +2101,6 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
         }
         else
         {
-            pFx = &(pC->pEffectsList[pC->pActiveEffectsList[i]]);
             /* Compute how far from the beginning of the effect we are, in clip-base time. */
             // Decorrelate input and output encoding timestamp to handle encoder prefetch
             VideoEffectTime = ((M4OSA_Int32)pC->ewc.dInputVidCts) - pFx->uiStartTime;
@@ -1846,52 +2119,70 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
         if( PercentageDone > 1.0 )
             PercentageDone = 1.0;
 
-        switch( pFx->VideoEffectType )
+        if (M4VSS3GPP_intIsLutEffect(pC, pFx))
         {
-            case M4VSS3GPP_kVideoEffectType_FadeFromBlack:
+            /**
+            * Fuse the table of this effect with the previous ones of the run */
+            if (M4VSS3GPP_kVideoEffectType_FadeFromBlack == pFx->VideoEffectType)
+            {
                 /**
                 * Compute where we are in the effect (scale is 0->1024). */
                 tmp = (M4OSA_Int32)(PercentageDone * 1024);
-
-                /**
-                * Apply the darkening effect */
-                err =
-                    M4VFL_modifyLumaWithScale((M4ViComImagePlane *)pPlaneTempIn,
-                    (M4ViComImagePlane *)pPlaneTempOut, tmp, M4OSA_NULL);
-
-                if( M4NO_ERROR != err )
-                {
-                    M4OSA_TRACE1_1(
-                        "M4VSS3GPP_intApplyVideoEffect:\
-                        M4VFL_modifyLumaWithScale returns error 0x%x,\
-                        returning M4VSS3GPP_ERR_LUMA_FILTER_ERROR",
-                        err);
-                    return M4VSS3GPP_ERR_LUMA_FILTER_ERROR;
-                }
-                break;
-
-            case M4VSS3GPP_kVideoEffectType_FadeToBlack:
+                M4VFL_colorLutBuildLumaScale(&effectLut, tmp);
+            }
+            else if (M4VSS3GPP_kVideoEffectType_FadeToBlack == pFx->VideoEffectType)
+            {
                 /**
                 * Compute where we are in the effect (scale is 0->1024) */
                 tmp = (M4OSA_Int32)(( 1.0 - PercentageDone) * 1024);
+                M4VFL_colorLutBuildLumaScale(&effectLut, tmp);
+            }
+            else
+            {
+                memcpy((void *)&effectLut,
+                    (void *)pC->pEffectsLut[pFx - pC->pEffectsList],
+                    sizeof(M4VFL_ColorLut));
+            }
 
-                /**
-                * Apply the darkening effect */
-                err =
-                    M4VFL_modifyLumaWithScale((M4ViComImagePlane *)pPlaneTempIn,
-                    (M4ViComImagePlane *)pPlaneTempOut, tmp, M4OSA_NULL);
-
+            if ((0 == i) || (M4OSA_FALSE
+                == M4VSS3GPP_intIsLutEffect(pC, M4VSS3GPP_intGetActiveEffect(pC, i-1))))
+            {
+                memcpy((void *)&fusedLut, (void *)&effectLut, sizeof(M4VFL_ColorLut));
+            }
+            else
+            {
+                err = M4VFL_colorLutCompose(&fusedLut, &effectLut);
                 if( M4NO_ERROR != err )
                 {
                     M4OSA_TRACE1_1(
                         "M4VSS3GPP_intApplyVideoEffect:\
-                        M4VFL_modifyLumaWithScale returns error 0x%x,\
+                        M4VFL_colorLutCompose returns error 0x%x,\
                         returning M4VSS3GPP_ERR_LUMA_FILTER_ERROR",
                         err);
                     return M4VSS3GPP_ERR_LUMA_FILTER_ERROR;
                 }
-                break;
+            }
+
+            if ((i+1 < NumActiveEffects) && (M4OSA_TRUE
+                == M4VSS3GPP_intIsLutEffect(pC, M4VSS3GPP_intGetActiveEffect(pC, i+1))))
+            {
+                /* The run goes on, the frame is processed with the last effect of the run */
+                continue;
+            }
 
+            err = M4VFL_colorLutApply(&fusedLut, pPlaneTempIn, pPlaneTempOut);
+            if( M4NO_ERROR != err )
+            {
+                M4OSA_TRACE1_1(
+                    "M4VSS3GPP_intApplyVideoEffect:\
+                    M4VFL_colorLutApply returns error 0x%x,\
+                    returning M4VSS3GPP_ERR_LUMA_FILTER_ERROR",
+                    err);
+                return M4VSS3GPP_ERR_LUMA_FILTER_ERROR;
+            }
+        }
+        else switch( pFx->VideoEffectType )
+        {
             default:
                 if( pFx->VideoEffectType
                     >= M4VSS3GPP_kVideoEffectType_External )
@@ -1954,9 +2245,9 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
                 }
         }
         /**
-        * RC Updates pTempPlaneIn and pTempPlaneOut depending on current effect */
-        if (((i % 2 == 0) && (NumActiveEffects  % 2 == 0))
-            || ((i % 2 != 0) && (NumActiveEffects % 2 != 0)))
+        * RC Updates pTempPlaneIn and pTempPlaneOut depending on current stage */
+        if (((iStage % 2 == 0) && (NumStages  % 2 == 0))
+            || ((iStage % 2 != 0) && (NumStages % 2 != 0)))
         {
             pPlaneTempIn = pTempYuvPlane;
             pPlaneTempOut = pPlaneOut;
@@ -1966,6 +2257,7 @@ M4VSS3GPP_intApplyVideoEffect (M4VSS3GPP_InternalEditContext *pC,
             pPlaneTempIn = pPlaneOut;
             pPlaneTempOut = pTempYuvPlane;
         }
+        iStage++;
     }
 
     for(i=0; i<3; i++) {
@@ -2429,6 +2721,29 @@ M4OSA_ERR M4VSS3GPP_intCreateVideoEncoder( M4VSS3GPP_InternalEditContext *pC )
     M4OSA_ERR err;
     M4ENCODER_AdvancedParams EncParams;
 
+    /**
+    * The output video settings do not change during the edit: an encoder kept
+    * by M4VSS3GPP_intStopVideoEncoder is just started again */
+    if( M4VSS3GPP_kEncoderStopped == pC->ewc.encoderState )
+    {
+        M4OSA_TRACE1_0(
+            "M4VSS3GPP_intCreateVideoEncoder: restarting the stopped encoder");
+
+        err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctStart(
+            pC->ewc.pEncContext);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intCreateVideoEncoder: pVideoEncoderGlobalFcts->pFctStart returns 0x%x",
+                err);
+            return err;
+        }
+
+        pC->ewc.encoderState = M4VSS3GPP_kEncoderRunning;
+        return M4NO_ERROR;
+    }
+
     /**
     * Simulate a writer interface with our specific function */
     pC->ewc.OurWriterDataInterface.pProcessAU =
@@ -2619,6 +2934,50 @@ M4OSA_ERR M4VSS3GPP_intCreateVideoEncoder( M4VSS3GPP_InternalEditContext *pC )
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intStopVideoEncoder()
+ * @brief    Stops the video encoder, but keeps it for the next encoded segment
+ * @note
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_intStopVideoEncoder( M4VSS3GPP_InternalEditContext *pC )
+{
+    M4OSA_ERR err = M4NO_ERROR;
+
+    /**
+    * Without stop and start functions, the encoder can only be destroyed */
+    if( ( M4OSA_NULL == pC->ShellAPI.pVideoEncoderGlobalFcts->pFctStop)
+        || (M4OSA_NULL == pC->ShellAPI.pVideoEncoderGlobalFcts->pFctStart) )
+    {
+        return M4VSS3GPP_intDestroyVideoEncoder(pC);
+    }
+
+    if( ( M4OSA_NULL != pC->ewc.pEncContext)
+        && (M4VSS3GPP_kEncoderRunning == pC->ewc.encoderState) )
+    {
+        /**
+        * Stopping flushes the frames still in the encoder */
+        err = pC->ShellAPI.pVideoEncoderGlobalFcts->pFctStop(
+            pC->ewc.pEncContext);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intStopVideoEncoder:\
+                pVideoEncoderGlobalFcts->pFctStop returns 0x%x, destroying the encoder",
+                err);
+            M4VSS3GPP_intDestroyVideoEncoder(pC);
+            return err;
+        }
+
+        pC->ewc.encoderState = M4VSS3GPP_kEncoderStopped;
+    }
+
+    M4OSA_TRACE3_1("M4VSS3GPP_intStopVideoEncoder: returning 0x%x", err);
+    return err;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4VSS3GPP_intDestroyVideoEncoder()
@@ -3521,6 +3880,7 @@ M4OSA_ERR M4VSS3GPP_intRenderFrameWithEffect(M4VSS3GPP_InternalEditContext *pC,
     M4VIFI_ImagePlane* pTmp = M4OSA_NULL;
     M4VIFI_ImagePlane pTemp[3];
     M4OSA_UInt8 i = 0;
+    M4_StepTimer timer;
     M4OSA_Bool bSkipFramingEffect = M4OSA_FALSE;
 
     memset((void *)pTemp, 0, 3*sizeof(M4VIFI_ImagePlane));
@@ -3634,9 +3994,11 @@ M4OSA_ERR M4VSS3GPP_intRenderFrameWithEffect(M4VSS3GPP_InternalEditContext *pC,
                 } else {
                     pTmp = pC->yuv1;
                 }
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = M4VSS3GPP_intApplyRenderingMode (pC,
                         pClipCtxt->pSettings->xVSS.MediaRendering,
                         pDecoderRenderFrame,pTmp);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Resize, &timer);
             } else {
                 if (pC->bClip2ActiveFramingEffect == M4OSA_TRUE) {
                     err = M4VSS3GPP_intAllocateYUV420(pTemp,
@@ -3651,9 +4013,11 @@ M4OSA_ERR M4VSS3GPP_intRenderFrameWithEffect(M4VSS3GPP_InternalEditContext *pC,
                 } else {
                     pTmp = pC->yuv2;
                 }
+                M4_StepStatsStart(&pC->Stats, &timer);
                 err = M4VSS3GPP_intApplyRenderingMode (pC,
                         pClipCtxt->pSettings->xVSS.MediaRendering,
                         pDecoderRenderFrame,pTmp);
+                M4_StepStatsStop(&pC->Stats, M4_kStepStage_Resize, &timer);
             }
             if (M4NO_ERROR != err) {
                 M4OSA_TRACE1_1("M4VSS3GPP_intRenderFrameWithEffect: \
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file    M4VSS3GPP_Thumbnails.c
+ * @brief    Extraction of a strip of thumbnails from a clip
+ * @note    The clip is opened once, with one video decoder. The requested times
+ *            are decoded in increasing order, so that the decoder either seeks or
+ *            decodes forward from the previous thumbnail, whichever is cheaper.
+ ******************************************************************************
+ */
+
+/****************/
+/*** Includes ***/
+/****************/
+
+#include "NXPSW_CompilerSwitches.h"
+/**
+ *    Our headers */
+#include "M4VSS3GPP_API.h"
+#include "M4VSS3GPP_ErrorCodes.h"
+#include "M4VSS3GPP_InternalTypes.h"
+#include "M4VSS3GPP_InternalFunctions.h"
+
+/**
+ *    OSAL headers */
+#include "M4OSA_Memory.h" /* OSAL memory management */
+#include "M4OSA_Debug.h"  /* OSAL debug management */
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VSS3GPP_intThumbnailsSort()
+ * @brief    Sorts the indexes of the requested times by increasing time
+ * @note    Insertion sort: a strip is made of a few dozen times, often already sorted
+ * @param   pTimes      (IN) Requested times
+ * @param   pOrder      (OUT) Indexes in pTimes, by increasing time
+ * @param   uiNbTimes   (IN) Number of times
+ ******************************************************************************
+ */
+static M4OSA_Void M4VSS3GPP_intThumbnailsSort( const M4OSA_Int32 *pTimes,
+                                              M4OSA_UInt32 *pOrder,
+                                              M4OSA_UInt32 uiNbTimes )
+{
+    M4OSA_UInt32 i, j, uiIndex;
+
+    for ( i = 0; i < uiNbTimes; i++ )
+    {
+        uiIndex = i;
+
+        for ( j = i; (j > 0) && (pTimes[pOrder[j - 1]] > pTimes[uiIndex]); j-- )
+        {
+            pOrder[j] = pOrder[j - 1];
+        }
+        pOrder[j] = uiIndex;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_intThumbnailsDecode()
+ * @brief    Decodes the frames of the sorted times and resizes them into the thumbnails
+ * @param   pClipCtxt       (IN) Opened clip, with its video decoder
+ * @param   pTimes          (IN) Requested times
+ * @param   pOrder          (IN) Indexes in pTimes, by increasing time
+ * @param   uiNbTimes       (IN) Number of times
+ * @param   bExact          (IN) See M4VSS3GPP_editExtractThumbnails
+ * @param   pFrame          (IN/OUT) Decoded frame planes, at the clip size
+ * @param   pThumbnails     (OUT) Thumbnail planes
+ * @param   pThumbnailTimes (OUT) Thumbnail frame times, can be M4OSA_NULL
+ ******************************************************************************
+ */
+static M4OSA_ERR M4VSS3GPP_intThumbnailsDecode( M4VSS3GPP_ClipContext *pClipCtxt,
+                                               const M4OSA_Int32 *pTimes,
+                                               const M4OSA_UInt32 *pOrder,
+                                               M4OSA_UInt32 uiNbTimes, M4OSA_Bool bExact,
+                                               M4VIFI_ImagePlane *pFrame,
+                                               M4VIFI_ImagePlane *pThumbnails,
+                                               M4OSA_Int32 *pThumbnailTimes )
+{
+    M4READER_GlobalInterface *pReader = pClipCtxt->ShellAPI.m_pReader;
+    M4DECODER_VideoInterface *pDecoder = pClipCtxt->ShellAPI.m_pVideoDecoder;
+    M4OSA_Int32 iDuration =
+        (M4OSA_Int32)pClipCtxt->pVideoStream->m_basicProperties.m_duration;
+    M4OSA_Int32 *pDecodeTimes;
+    M4OSA_Int32 iFrameCts = -1;
+    M4_MediaTime dTime;
+    M4OSA_UInt32 i, uiIndex;
+    M4OSA_ERR err = M4NO_ERROR;
+
+    pDecodeTimes = (M4OSA_Int32 *)M4OSA_32bitAlignedMalloc(uiNbTimes * sizeof(M4OSA_Int32),
+        M4VSS3GPP, (M4OSA_Char *)"M4VSS3GPP_intThumbnailsDecode: pDecodeTimes");
+
+    if( M4OSA_NULL == pDecodeTimes )
+    {
+        return M4ERR_ALLOC;
+    }
+
+    /**
+    * Find the times to decode before decoding anything: looking for the sync
+    * samples moves the reader, the first decoding seeks it again */
+    for ( i = 0; i < uiNbTimes; i++ )
+    {
+        pDecodeTimes[i] = pTimes[pOrder[i]];
+
+        if( pDecodeTimes[i] < 0 )
+        {
+            pDecodeTimes[i] = 0;
+        }
+        else if( pDecodeTimes[i] > iDuration )
+        {
+            pDecodeTimes[i] = iDuration;
+        }
+
+        if( (M4OSA_FALSE == bExact) && (M4OSA_NULL != pReader->m_pFctGetPrevRapTime) )
+        {
+            /* On failure, the exact time is decoded */
+            M4OSA_Int32 iRapTime = pDecodeTimes[i];
+
+            if( M4NO_ERROR == pReader->m_pFctGetPrevRapTime(pClipCtxt->pReaderContext,
+                (M4_StreamHandler *)pClipCtxt->pVideoStream, &iRapTime) )
+            {
+                pDecodeTimes[i] = iRapTime;
+            }
+        }
+    }
+
+    for ( i = 0; (i < uiNbTimes) && (M4NO_ERROR == err); i++ )
+    {
+        uiIndex = pOrder[i];
+
+        /**
+        * Decode and render a new frame, unless the previous thumbnail already has it.
+        * The decoder decodes forward instead of seeking when the time is close. */
+        if( (i == 0) || (pDecodeTimes[i] != pDecodeTimes[i - 1]) )
+        {
+            dTime = (M4_MediaTime)pDecodeTimes[i];
+            err = pDecoder->m_pFctDecode(pClipCtxt->pViDecCtxt, &dTime, M4OSA_TRUE, 0);
+
+            if( (M4NO_ERROR != err) && (M4WAR_NO_MORE_AU != err) )
+            {
+                M4OSA_TRACE1_1(
+                    "M4VSS3GPP_intThumbnailsDecode: m_pFctDecode returns 0x%x", err);
+                break;
+            }
+
+            err = pDecoder->m_pFctRender(pClipCtxt->pViDecCtxt, &dTime, pFrame, M4OSA_TRUE);
+
+            if( M4NO_ERROR == err )
+            {
+                iFrameCts = (M4OSA_Int32)dTime;
+            }
+            else if( (M4WAR_VIDEORENDERER_NO_NEW_FRAME == err) && (iFrameCts >= 0) )
+            {
+                /* The frame decoded for the previous time is still the right one */
+                err = M4NO_ERROR;
+            }
+            else
+            {
+                M4OSA_TRACE1_1(
+                    "M4VSS3GPP_intThumbnailsDecode: m_pFctRender returns 0x%x", err);
+                if( M4WAR_VIDEORENDERER_NO_NEW_FRAME == err )
+                {
+                    err = M4VSS3GPP_ERR_EDITING_NO_SUPPORTED_VIDEO_STREAM_IN_FILE;
+                }
+                break;
+            }
+        }
+
+        err = M4VIFI_ResizeBilinearYUV420toYUV420(M4OSA_NULL, pFrame,
+            &pThumbnails[3 * uiIndex]);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4VSS3GPP_intThumbnailsDecode: M4VIFI_ResizeBilinearYUV420toYUV420 returns 0x%x",
+                err);
+            break;
+        }
+
+        if( M4OSA_NULL != pThumbnailTimes )
+        {
+            pThumbnailTimes[uiIndex] = iFrameCts;
+        }
+    }
+
+    free(pDecodeTimes);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4VSS3GPP_editExtractThumbnails()
+ * @brief    Extracts the thumbnails of a clip at several times
+ * @note    See M4VSS3GPP_API.h
+ ******************************************************************************
+ */
+M4OSA_ERR M4VSS3GPP_editExtractThumbnails( M4OSA_Void *pClip,
+                                          M4VIDEOEDITING_FileType FileType,
+                                          M4OSA_FileReadPointer *pFileReadPtrFct,
+                                          const M4OSA_Int32 *pTimes, M4OSA_UInt32 uiNbTimes,
+                                          M4OSA_Bool bExact, M4VIFI_ImagePlane *pThumbnails,
+                                          M4OSA_Int32 *pThumbnailTimes )
+{
+    M4VSS3GPP_ClipContext *pClipContext = M4OSA_NULL;
+    M4VSS3GPP_ClipSettings ClipSettings;
+    M4VIFI_ImagePlane frame[3];
+    M4OSA_UInt32 *pOrder = M4OSA_NULL;
+    M4OSA_UInt32 uiWidth, uiHeight;
+    M4OSA_ERR err;
+
+    M4OSA_TRACE3_2("M4VSS3GPP_editExtractThumbnails called with pClip=0x%x, uiNbTimes=%d",
+        pClip, uiNbTimes);
+
+    /**
+    *    Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pClip), M4ERR_PARAMETER,
+        "M4VSS3GPP_editExtractThumbnails: pClip is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileReadPtrFct), M4ERR_PARAMETER,
+        "M4VSS3GPP_editExtractThumbnails: pFileReadPtrFct is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pTimes), M4ERR_PARAMETER,
+        "M4VSS3GPP_editExtractThumbnails: pTimes is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pThumbnails), M4ERR_PARAMETER,
+        "M4VSS3GPP_editExtractThumbnails: pThumbnails is M4OSA_NULL");
+
+    if( (0 == uiNbTimes) || (M4VIDEOEDITING_kFileType_ARGB8888 == FileType) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    frame[0].pac_data = M4OSA_NULL;
+
+    /**
+    * Build dummy clip settings, in order to use the editClipOpen function */
+    memset((void *)&ClipSettings, 0, sizeof(M4VSS3GPP_ClipSettings));
+    ClipSettings.pFile = pClip;
+    ClipSettings.FileType = FileType;
+    ClipSettings.uiBeginCutTime = 0;
+    ClipSettings.uiEndCutTime = 0;
+    ClipSettings.ClipProperties.bAnalysed = M4OSA_FALSE;
+
+    /**
+    * Open the clip with its video decoder, without the audio */
+    err = M4VSS3GPP_intClipInit(&pClipContext, pFileReadPtrFct);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4VSS3GPP_intClipOpen(pClipContext, &ClipSettings, M4OSA_TRUE,
+            M4OSA_FALSE, M4OSA_FALSE);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4VSS3GPP_editExtractThumbnails: unable to open the clip (0x%x)",
+            err);
+        goto cleanup;
+    }
+
+    if( (M4OSA_NULL == pClipContext->pVideoStream)
+        || (M4OSA_NULL == pClipContext->pViDecCtxt) )
+    {
+        err = M4VSS3GPP_ERR_EDITING_NO_SUPPORTED_VIDEO_STREAM_IN_FILE;
+        goto cleanup;
+    }
+
+    /**
+    * Decoded frame, at the clip size */
+    uiWidth = pClipContext->pVideoStream->m_videoWidth;
+    uiHeight = pClipContext->pVideoStream->m_videoHeight;
+
+    frame[0].pac_data = (M4VIFI_UInt8 *)M4OSA_32bitAlignedMalloc(
+        (uiWidth * uiHeight * 3) >> 1, M4VSS3GPP,
+        (M4OSA_Char *)"M4VSS3GPP_editExtractThumbnails: frame");
+    pOrder = (M4OSA_UInt32 *)M4OSA_32bitAlignedMalloc(uiNbTimes * sizeof(M4OSA_UInt32),
+        M4VSS3GPP, (M4OSA_Char *)"M4VSS3GPP_editExtractThumbnails: pOrder");
+
+    if( (M4OSA_NULL == frame[0].pac_data) || (M4OSA_NULL == pOrder) )
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+
+    frame[0].u_width = uiWidth;
+    frame[0].u_height = uiHeight;
+    frame[0].u_stride = uiWidth;
+    frame[0].u_topleft = 0;
+    frame[1].u_width = uiWidth >> 1;
+    frame[1].u_height = uiHeight >> 1;
+    frame[1].u_stride = frame[1].u_width;
+    frame[1].u_topleft = 0;
+    frame[1].pac_data = frame[0].pac_data + (uiWidth * uiHeight);
+    frame[2].u_width = frame[1].u_width;
+    frame[2].u_height = frame[1].u_height;
+    frame[2].u_stride = frame[1].u_stride;
+    frame[2].u_topleft = 0;
+    frame[2].pac_data = frame[1].pac_data + (frame[1].u_width * frame[1].u_height);
+
+    M4VSS3GPP_intThumbnailsSort(pTimes, pOrder, uiNbTimes);
+
+    err = M4VSS3GPP_intThumbnailsDecode(pClipContext, pTimes, pOrder, uiNbTimes, bExact,
+        frame, pThumbnails, pThumbnailTimes);
+
+cleanup:
+    if( M4OSA_NULL != pOrder )
+    {
+        free(pOrder);
+    }
+
+    if( M4OSA_NULL != frame[0].pac_data )
+    {
+        free(frame[0].pac_data);
+    }
+
+    if( M4OSA_NULL != pClipContext )
+    {
+        if( M4NO_ERROR == err )
+        {
+            err = M4VSS3GPP_intClipClose(pClipContext);
+        }
+        M4VSS3GPP_intClipCleanUp(pClipContext);
+    }
+
+    M4OSA_TRACE3_1("M4VSS3GPP_editExtractThumbnails(): returning 0x%x", err);
+    return err;
+}
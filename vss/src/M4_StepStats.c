@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ************************************************************************
+ * @file   M4_StepStats.c
+ * @brief  Cumulative timers and counters of the MCS and VSS step loops
+ ************************************************************************
+ */
+
+#include <string.h>
+
+#include "M4OSA_Types.h"
+#include "M4OSA_Debug.h"
+#include "M4OSA_Clock.h"
+#include "M4OSA_CharStar.h"
+
+#include "M4_StepStats.h"
+
+/**
+ * Clock timescale: the OSAL clock does not go beyond 10 kHz */
+#define M4_STEPSTATS_TIMESCALE      10000
+
+/**
+ * JSON names of the stages, in M4_StepStage order */
+static const M4OSA_Char *M4_StepStatsNames[M4_kStepStage_NB] =
+{
+    (const M4OSA_Char *)"read",
+    (const M4OSA_Char *)"decode",
+    (const M4OSA_Char *)"effect",
+    (const M4OSA_Char *)"resize",
+    (const M4OSA_Char *)"encode",
+    (const M4OSA_Char *)"write",
+    (const M4OSA_Char *)"audio"
+};
+
+static M4OSA_Time M4_StepStatsNow(M4OSA_Void)
+{
+    M4OSA_Time now = 0;
+
+    M4OSA_clockGetTime(&now, M4_STEPSTATS_TIMESCALE);
+
+    return now * (1000000 / M4_STEPSTATS_TIMESCALE);
+}
+
+M4OSA_Void M4_StepStatsReset(M4_StepStats *pStats)
+{
+    memset((void *)pStats, 0, sizeof(M4_StepStats));
+}
+
+M4OSA_Void M4_StepStatsStart(M4_StepStats *pStats, M4_StepTimer *pTimer)
+{
+    pTimer->startTime = M4_StepStatsNow();
+    pTimer->measuredTime = pStats->measuredTime;
+}
+
+M4OSA_Void M4_StepStatsStop(M4_StepStats *pStats, M4_StepStage stage,
+                            M4_StepTimer *pTimer)
+{
+    M4OSA_Time elapsed = M4_StepStatsNow() - pTimer->startTime;
+
+    /* Remove the time of the nested stages */
+    elapsed -= pStats->measuredTime - pTimer->measuredTime;
+
+    /* The OSAL clock may roll over */
+    if( elapsed < 0 )
+    {
+        elapsed = 0;
+    }
+
+    pStats->uiCount[stage]++;
+    pStats->time[stage] += elapsed;
+    pStats->measuredTime += elapsed;
+}
+
+M4OSA_Void M4_StepStatsStopStep(M4_StepStats *pStats, M4_StepTimer *pTimer)
+{
+    M4OSA_Time elapsed = M4_StepStatsNow() - pTimer->startTime;
+
+    if( elapsed < 0 )
+    {
+        elapsed = 0;
+    }
+
+    pStats->uiNbSteps++;
+    pStats->stepTime += elapsed;
+}
+
+M4OSA_Void M4_StepStatsMerge(M4_StepStats *pStats, const M4_StepStats *pOther)
+{
+    M4OSA_UInt32 i;
+
+    for ( i = 0; i < M4_kStepStage_NB; i++ )
+    {
+        pStats->uiCount[i] += pOther->uiCount[i];
+        pStats->time[i] += pOther->time[i];
+    }
+    pStats->uiNbSteps += pOther->uiNbSteps;
+    pStats->stepTime += pOther->stepTime;
+    pStats->measuredTime += pOther->measuredTime;
+}
+
+M4OSA_ERR M4_StepStatsToJson(const M4_StepStats *pStats, M4OSA_Char *pBuffer,
+                             M4OSA_UInt32 uiSize)
+{
+    M4OSA_ERR err;
+    M4OSA_UInt32 uiLength;
+    M4OSA_UInt32 i;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pStats) || (M4OSA_NULL == pBuffer) || (0 == uiSize),
+        M4ERR_PARAMETER, "M4_StepStatsToJson: invalid parameter");
+
+    err = M4OSA_chrSPrintf(pBuffer, uiSize - 1,
+        (M4OSA_Char *)"{\"steps\":{\"count\":%lu,\"ms\":%lu}",
+        (unsigned long)pStats->uiNbSteps, (unsigned long)(pStats->stepTime / 1000));
+
+    for ( i = 0; (M4NO_ERROR == err) && (i < M4_kStepStage_NB); i++ )
+    {
+        uiLength = strlen((const char *)pBuffer);
+        err = M4OSA_chrSPrintf(pBuffer + uiLength, uiSize - 1 - uiLength,
+            (M4OSA_Char *)",\"%s\":{\"count\":%lu,\"ms\":%lu}", M4_StepStatsNames[i],
+            (unsigned long)pStats->uiCount[i], (unsigned long)(pStats->time[i] / 1000));
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        uiLength = strlen((const char *)pBuffer);
+        err = M4OSA_chrSPrintf(pBuffer + uiLength, uiSize - 1 - uiLength,
+            (M4OSA_Char *)"}");
+    }
+
+    return err;
+}
+
+M4OSA_Void M4_StepStatsTrace(const M4_StepStats *pStats, const M4OSA_Char *pName)
+{
+    M4OSA_Char json[M4_STEPSTATS_JSON_SIZE];
+
+    if( 0 == pStats->uiNbSteps )
+    {
+        return;
+    }
+
+    if( M4NO_ERROR == M4_StepStatsToJson(pStats, json, M4_STEPSTATS_JSON_SIZE) )
+    {
+        M4OSA_TRACE1_2("%s statistics: %s", pName, json);
+    }
+}
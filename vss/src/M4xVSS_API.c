@@ -224,6 +224,33 @@ M4OSA_ERR M4xVSS_Init( M4OSA_Context *pContext, M4xVSS_InitParams *pParams )
     /* initialize MCS context*/
     xVSS_context->pMCS_Ctxt = M4OSA_NULL;
 
+    M4_StepStatsReset(&xVSS_context->Stats);
+
+    /* Saving is done by one thread unless M4xVSS_setSaveThreads is called */
+    xVSS_context->uiSaveThreads = 1;
+    xVSS_context->pSegments = M4OSA_NULL;
+
+    /* The preview proxy batch is opened by the first M4xVSS_proxyStart */
+    xVSS_context->pProxyBatch = M4OSA_NULL;
+    xVSS_context->pProxyJobs = M4OSA_NULL;
+    xVSS_context->pProxyMutex = M4OSA_NULL;
+
+    /* The caches only avoid analysing unchanged files again, they are optional */
+    if( M4NO_ERROR != M4VSS3GPP_analysisCacheOpen(&xVSS_context->pAnalysisCache) )
+    {
+        M4OSA_TRACE1_0("M4xVSS_Init: unable to create the analysis cache");
+        xVSS_context->pAnalysisCache = M4OSA_NULL;
+    }
+
+    if( M4NO_ERROR != M4VSS3GPP_analysisCacheOpen(&xVSS_context->pPropertiesCache) )
+    {
+        M4OSA_TRACE1_0("M4xVSS_Init: unable to create the properties cache");
+        xVSS_context->pPropertiesCache = M4OSA_NULL;
+    }
+
+    /* Reuse the analyses of the previous sessions, if any */
+    M4xVSS_internalAnalysisCacheIndex(xVSS_context, M4OSA_FALSE);
+
     *pContext = xVSS_context;
 
     return M4NO_ERROR;
@@ -3906,6 +3933,8 @@ replace3GP_3GP:
                 Effects[j].xVSS.uiFiftiesOutFrameRate;
             fiftiesCtx->shiftRandomValue = 0;
             fiftiesCtx->stripeRandomValue = 0;
+            fiftiesCtx->randomSeed = xVSS_context->pSettings->Effects[j].uiStartTime;
+            fiftiesCtx->randomCounter = 0;
 
             /* Save the structure associated with corresponding effect */
             xVSS_context->pSettings->Effects[j].pExtVideoEffectFctCtxt =
@@ -3926,7 +3955,9 @@ replace3GP_3GP:
             || xVSS_context->pSettings->Effects[j].VideoEffectType
             == M4xVSS_kVideoEffectType_Negative
             || xVSS_context->pSettings->Effects[j].VideoEffectType
-            == M4xVSS_kVideoEffectType_Gradient )
+            == M4xVSS_kVideoEffectType_Gradient
+            || xVSS_context->pSettings->Effects[j].VideoEffectType
+            == M4xVSS_kVideoEffectType_ColorLut )
         {
             M4xVSS_ColorStruct *ColorCtx;
 
@@ -3957,10 +3988,27 @@ replace3GP_3GP:
             {
                 ColorCtx->rgb16ColorData = 0;
             }
+            ColorCtx->lut.pLut3D = M4OSA_NULL;
 
             /* Save the structure associated with corresponding effect */
             xVSS_context->pSettings->Effects[j].pExtVideoEffectFctCtxt =
                 ColorCtx;
+
+            /* Compile the color effect once, it is then applied by table lookups */
+            err = M4xVSS_internalBuildColorLut(xVSS_context, ColorCtx,
+                &(xVSS_context->pSettings->Effects[j]));
+            /* The LUT file path belongs to the caller */
+            xVSS_context->pSettings->Effects[j].xVSS.pColorLutFilePath = M4OSA_NULL;
+
+            if( err != M4NO_ERROR )
+            {
+                M4OSA_TRACE1_1(
+                    "M4xVSS_SendCommand: M4xVSS_internalBuildColorLut returned 0x%x",
+                    err);
+                /* Free Send command */
+                M4xVSS_freeCommand(xVSS_context);
+                return err;
+            }
         }
     }
 
@@ -5439,6 +5487,7 @@ M4OSA_ERR M4xVSS_Step( M4OSA_Context pContext, M4OSA_UInt8 *pProgress )
         xVSS_context->pAudioMixContext;
     M4OSA_ERR err = M4NO_ERROR;
     M4OSA_UInt8 uiProgress = 0;
+    M4_StepTimer stepTimer, audioTimer;
 
     switch( xVSS_context->m_state )
     {
@@ -5446,6 +5495,23 @@ M4OSA_ERR M4xVSS_Step( M4OSA_Context pContext, M4OSA_UInt8 *pProgress )
         //case M4xVSS_kStateGeneratingPreview:
             {
                 if( xVSS_context->editingStep
+                    == M4xVSS_kMicroStateEditingSegments ) /* VSS sessions on the segments */
+                {
+                    err = M4xVSS_internalStepSegments(xVSS_context, &uiProgress);
+
+                    if( err != M4NO_ERROR )
+                    {
+                        if( err == ((M4OSA_UInt32)M4ERR_FILE_INVALID_POSITION) )
+                        {
+                            err = M4xVSSERR_NO_MORE_SPACE;
+                        }
+                        M4OSA_TRACE1_1(
+                            "M4xVSS_Step: M4xVSS_internalStepSegments returned 0x%x\n", err);
+                        return err;
+                    }
+                    goto end_step;
+                }
+                else if( xVSS_context->editingStep
                     == M4xVSS_kMicroStateEditing ) /* VSS -> creating effects, transitions ... */
                 {
                     /* RC: to delete unecessary temp files on the fly */
@@ -5619,7 +5685,11 @@ M4OSA_ERR M4xVSS_Step( M4OSA_Context pContext, M4OSA_UInt8 *pProgress )
                     == M4xVSS_kMicroStateAudioMixing ) /* Audio mixing: mix/replace audio track
                     with given BGM */
                 {
+                    M4_StepStatsStart(&xVSS_context->Stats, &stepTimer);
+                    M4_StepStatsStart(&xVSS_context->Stats, &audioTimer);
                     err = M4VSS3GPP_audioMixingStep(pAudioMixingCtxt, &uiProgress);
+                    M4_StepStatsStop(&xVSS_context->Stats, M4_kStepStage_Audio, &audioTimer);
+                    M4_StepStatsStopStep(&xVSS_context->Stats, &stepTimer);
 
                     if( ( err != M4NO_ERROR)
                         && (err != M4VSS3GPP_WAR_END_OF_AUDIO_MIXING) )
@@ -6099,6 +6169,15 @@ M4OSA_ERR M4xVSS_CleanUp( M4OSA_Context pContext )
         return M4ERR_STATE;
     }
 
+    M4_StepStatsTrace(&xVSS_context->Stats, (const M4OSA_Char *)"xVSS");
+
+    /* Cancel the proxy transcodings, before the temporary path is freed */
+    M4xVSS_internalStopProxies(xVSS_context);
+
+    /* Keep the analyses for the next session (the index files are in the temporary
+       path, whose name may need the UTF conversion buffer) */
+    M4xVSS_internalAnalysisCacheIndex(xVSS_context, M4OSA_TRUE);
+
     /**
     * UTF conversion: free temporary buffer*/
     if( xVSS_context->UTFConversionContext.pTempOutConversionBuffer
@@ -6116,6 +6195,11 @@ M4OSA_ERR M4xVSS_CleanUp( M4OSA_Context pContext )
     free(xVSS_context->pSettings);
     xVSS_context->pSettings = M4OSA_NULL;
 
+    M4VSS3GPP_analysisCacheClose(xVSS_context->pAnalysisCache);
+    xVSS_context->pAnalysisCache = M4OSA_NULL;
+    M4VSS3GPP_analysisCacheClose(xVSS_context->pPropertiesCache);
+    xVSS_context->pPropertiesCache = M4OSA_NULL;
+
     free(xVSS_context);
     xVSS_context = M4OSA_NULL;
     M4OSA_TRACE3_0("M4xVSS_CleanUp:leaving ");
@@ -6357,6 +6441,65 @@ M4OSA_ERR M4xVSS_getVSS3GPPContext( M4OSA_Context pContext,
     return err;
 }
 
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_getStatistics(M4OSA_Context pContext,
+ *                                              M4_StepStats* pStats)
+ * @brief        This function returns the time spent in each stage of the steps
+ * @param    pContext            (IN) Pointer on the xVSS edit context
+ * @param    pStats            (OUT) Statistics since M4xVSS_Init
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    At least one parameter is M4OSA_NULL
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_getStatistics( M4OSA_Context pContext, M4_StepStats *pStats )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+
+    /**
+    *    Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4xVSS_getStatistics: pContext is NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pStats), M4ERR_PARAMETER,
+        "M4xVSS_getStatistics: pStats is NULL");
+
+    memcpy((void *)pStats, (void *) &xVSS_context->Stats, sizeof(M4_StepStats));
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_setSaveThreads(M4OSA_Context pContext,
+ *                                              M4OSA_UInt32 uiNbThreads)
+ * @brief        This function sets the number of threads used to save
+ * @param    pContext            (IN) Pointer on the xVSS edit context
+ * @param    uiNbThreads        (IN) Number of threads, 1 to M4xVSS_SAVE_MAX_THREADS
+ * @return    M4NO_ERROR:        No error
+ * @return    M4ERR_PARAMETER:    pContext is M4OSA_NULL or uiNbThreads is out of range
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_setSaveThreads( M4OSA_Context pContext, M4OSA_UInt32 uiNbThreads )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+
+    /**
+    *    Check input parameters */
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pContext), M4ERR_PARAMETER,
+        "M4xVSS_setSaveThreads: pContext is NULL");
+
+    if( ( 0 == uiNbThreads) || (uiNbThreads > M4xVSS_SAVE_MAX_THREADS) )
+    {
+        M4OSA_TRACE1_1("M4xVSS_setSaveThreads: invalid number of threads %d",
+            uiNbThreads);
+        return M4ERR_PARAMETER;
+    }
+
+    xVSS_context->uiSaveThreads = uiNbThreads;
+
+    return M4NO_ERROR;
+}
+
 M4OSA_ERR M4xVSS_getVideoDecoderCapabilities(M4DECODER_VideoDecoders **decoders) {
     M4OSA_ERR err = M4NO_ERROR;
 
@@ -0,0 +1,563 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file    M4xVSS_Proxy.c
+ * @brief    Preview proxies of the xVSS
+ * @note    The clips higher than M4xVSS_PROXY_MIN_HEIGHT are transcoded by an MCS
+ *            batch, in the background, to a small MPEG-4 copy written in the temporary
+ *            path. The copy is written in a temporary file which is renamed once it is
+ *            complete, so that the preview only finds complete proxies.
+ ******************************************************************************
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "M4OSA_Debug.h"
+#include "M4OSA_CharStar.h"
+#include "M4OSA_Mutex.h"
+
+#include "NXPSW_CompilerSwitches.h"
+
+#include "M4MCS_API.h"
+
+#include "M4xVSS_API.h"
+#include "M4xVSS_Internal.h"
+
+#include "OMX_Video.h"
+
+/**
+ * Proxy video bitrates: the proxy is only decoded, never edited */
+#define M4xVSS_PROXY_BITRATE_360        M4VIDEOEDITING_k512_KBPS
+#define M4xVSS_PROXY_BITRATE_480        M4VIDEOEDITING_k800_KBPS
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intProxyDecodePath(M4xVSS_Context* xVSS_context,
+ *                                     M4OSA_Void* pPath, M4OSA_Void** ppDecodedPath)
+ * @brief    Allocates a copy of a path, converted into the customer format
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intProxyDecodePath( M4xVSS_Context *xVSS_context,
+                                           M4OSA_Void *pPath, M4OSA_Void **ppDecodedPath )
+{
+    M4OSA_Void *pDecodedPath = pPath;
+    M4OSA_UInt32 length = strlen((const char *)pPath);
+    M4OSA_ERR err;
+
+    if( xVSS_context->UTFConversionContext.pConvFromUTF8Fct != M4OSA_NULL
+        && xVSS_context->UTFConversionContext.pTempOutConversionBuffer != M4OSA_NULL )
+    {
+        err = M4xVSS_internalConvertFromUTF8(xVSS_context, pPath,
+            (M4OSA_Void *)xVSS_context->UTFConversionContext.pTempOutConversionBuffer,
+            &length);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4xVSS_intProxyDecodePath: M4xVSS_internalConvertFromUTF8 returns 0x%x", err);
+            return err;
+        }
+        pDecodedPath = xVSS_context->UTFConversionContext.pTempOutConversionBuffer;
+    }
+
+    *ppDecodedPath = (M4OSA_Void *)M4OSA_32bitAlignedMalloc(length + 1, M4VS,
+        (M4OSA_Char *)"M4xVSS_intProxyDecodePath: path");
+
+    if( M4OSA_NULL == *ppDecodedPath )
+    {
+        return M4ERR_ALLOC;
+    }
+    memcpy(*ppDecodedPath, pDecodedPath, length + 1);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intProxyModifiedTime(M4xVSS_Context* xVSS_context,
+ *                                       M4OSA_Void* pFile, M4OSA_Time* pTime)
+ * @brief    Gets the modification date of a file
+ * @return   M4NO_ERROR, or the file reader error (the file does not exist)
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intProxyModifiedTime( M4xVSS_Context *xVSS_context,
+                                             M4OSA_Void *pFile, M4OSA_Time *pTime )
+{
+    M4OSA_Context pFileContext = M4OSA_NULL;
+    M4OSA_FileAttribute attribute;
+    M4OSA_ERR err;
+
+    err = xVSS_context->pFileReadPtr->openRead(&pFileContext, pFile, M4OSA_kFileRead);
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    err = xVSS_context->pFileReadPtr->getOption(pFileContext,
+        M4OSA_kFileReadGetFileAttribute, (M4OSA_DataOption *) &attribute);
+
+    if( M4NO_ERROR == err )
+    {
+        *pTime = attribute.modifiedDate.time;
+    }
+
+    xVSS_context->pFileReadPtr->closeRead(pFileContext);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4xVSS_intProxyFreeJob(M4xVSS_ProxyJob* pJob)
+ * @brief    Frees a proxy job entry
+ ******************************************************************************
+ */
+static M4OSA_Void M4xVSS_intProxyFreeJob( M4xVSS_ProxyJob *pJob )
+{
+    if( M4OSA_NULL != pJob->pClipFile )
+    {
+        free(pJob->pClipFile);
+    }
+
+    if( M4OSA_NULL != pJob->pTempFile )
+    {
+        free(pJob->pTempFile);
+    }
+
+    if( M4OSA_NULL != pJob->pProxyFile )
+    {
+        free(pJob->pProxyFile);
+    }
+    free(pJob);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4xVSS_intProxyProgress(M4OSA_Void* pUserData, M4OSA_UInt32 uiJobId,
+ *                                    M4MCS_BatchJobState state, M4OSA_UInt8 uiProgress,
+ *                                    M4OSA_ERR err)
+ * @brief    Batch progress callback: publishes the complete proxies
+ ******************************************************************************
+ */
+static M4OSA_Void M4xVSS_intProxyProgress( M4OSA_Void *pUserData, M4OSA_UInt32 uiJobId,
+                                          M4MCS_BatchJobState state,
+                                          M4OSA_UInt8 uiProgress, M4OSA_ERR err )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pUserData;
+    M4xVSS_ProxyJob *pJob;
+
+    if( (M4MCS_kBatchJobPending == state) || (M4MCS_kBatchJobRunning == state) )
+    {
+        return;
+    }
+
+    M4OSA_mutexLock(xVSS_context->pProxyMutex, M4OSA_WAIT_FOREVER);
+
+    for ( pJob = xVSS_context->pProxyJobs; M4OSA_NULL != pJob;
+        pJob = (M4xVSS_ProxyJob *)pJob->pNext )
+    {
+        if( (pJob->uiJobId == uiJobId) && (M4OSA_FALSE == pJob->bFinished) )
+        {
+            break;
+        }
+    }
+
+    if( M4OSA_NULL != pJob )
+    {
+        if( (M4MCS_kBatchJobDone == state)
+            && (0 == rename((const char *)pJob->pTempFile, (const char *)pJob->pProxyFile)) )
+        {
+            M4OSA_TRACE2_1("M4xVSS_intProxyProgress: proxy %s is ready", pJob->pProxyFile);
+        }
+        else
+        {
+            M4OSA_TRACE1_2("M4xVSS_intProxyProgress: proxy %s not made (0x%x)",
+                pJob->pProxyFile, err);
+            remove((const char *)pJob->pTempFile);
+        }
+        pJob->bFinished = M4OSA_TRUE;
+    }
+
+    M4OSA_mutexUnlock(xVSS_context->pProxyMutex);
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4xVSS_intProxyGetOutput(M4VSS3GPP_ClipSettings* pClip,
+ *                                     M4VIDEOEDITING_VideoFrameSize* pFrameSize,
+ *                                     M4VIDEOEDITING_Bitrate* pBitrate)
+ * @brief    Tells whether a clip needs a proxy, and its size
+ * @note    The MCS resizes without cropping nor black borders, so the proxy keeps the
+ *            aspect ratio of the clip only for the 16:9 and 4:3 clips.
+ ******************************************************************************
+ */
+static M4OSA_Bool M4xVSS_intProxyGetOutput( M4VSS3GPP_ClipSettings *pClip,
+                                           M4VIDEOEDITING_VideoFrameSize *pFrameSize,
+                                           M4VIDEOEDITING_Bitrate *pBitrate )
+{
+    M4VIDEOEDITING_ClipProperties *pProperties = &pClip->ClipProperties;
+    M4OSA_UInt32 uiWidth = pProperties->uiVideoWidth;
+    M4OSA_UInt32 uiHeight = pProperties->uiVideoHeight;
+
+    if( (M4VIDEOEDITING_kFileType_3GPP != pClip->FileType)
+        && (M4VIDEOEDITING_kFileType_MP4 != pClip->FileType)
+        && (M4VIDEOEDITING_kFileType_M4V != pClip->FileType) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    if( (M4VIDEOEDITING_kNoneVideo == pProperties->VideoStreamType)
+        || (uiHeight <= M4xVSS_PROXY_MIN_HEIGHT)
+        || (0 != pProperties->videoRotationDegrees) )
+    {
+        return M4OSA_FALSE;
+    }
+
+    if( uiWidth * 9 == uiHeight * 16 )
+    {
+        *pFrameSize = M4VIDEOEDITING_k640_360;
+        *pBitrate = M4xVSS_PROXY_BITRATE_360;
+        return M4OSA_TRUE;
+    }
+
+    if( uiWidth * 3 == uiHeight * 4 )
+    {
+        *pFrameSize = M4VIDEOEDITING_kVGA;
+        *pBitrate = M4xVSS_PROXY_BITRATE_480;
+        return M4OSA_TRUE;
+    }
+
+    return M4OSA_FALSE;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intProxyOpen(M4xVSS_Context* xVSS_context)
+ * @brief    Opens the proxy batch and its mutex
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intProxyOpen( M4xVSS_Context *xVSS_context )
+{
+    M4OSA_ERR err;
+
+    err = M4OSA_mutexOpen(&xVSS_context->pProxyMutex);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_intProxyOpen: M4OSA_mutexOpen returns 0x%x", err);
+        xVSS_context->pProxyMutex = M4OSA_NULL;
+        return err;
+    }
+
+    /* One lane: the proxies must not slow the editing down */
+    err = M4MCS_batchOpen(&xVSS_context->pProxyBatch, 1, xVSS_context->pFileReadPtr,
+        xVSS_context->pFileWritePtr, M4xVSS_intProxyProgress, (M4OSA_Void *)xVSS_context);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_intProxyOpen: M4MCS_batchOpen returns 0x%x", err);
+        M4OSA_mutexClose(xVSS_context->pProxyMutex);
+        xVSS_context->pProxyMutex = M4OSA_NULL;
+        xVSS_context->pProxyBatch = M4OSA_NULL;
+        return err;
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intProxyAddJob(M4xVSS_Context* xVSS_context, M4xVSS_ProxyJob* pJob,
+ *                                 M4VSS3GPP_ClipSettings* pClip,
+ *                                 M4VIDEOEDITING_VideoFrameSize frameSize,
+ *                                 M4VIDEOEDITING_Bitrate bitrate)
+ * @brief    Queues the transcoding of a proxy
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intProxyAddJob( M4xVSS_Context *xVSS_context, M4xVSS_ProxyJob *pJob,
+                                       M4VSS3GPP_ClipSettings *pClip,
+                                       M4VIDEOEDITING_VideoFrameSize frameSize,
+                                       M4VIDEOEDITING_Bitrate bitrate )
+{
+    M4MCS_BatchJob job;
+
+    memset((void *)&job, 0, sizeof(M4MCS_BatchJob));
+    job.pInputFile = pJob->pClipFile;
+    job.InputFileType = pClip->FileType;
+    job.pOutputFile = pJob->pTempFile;
+    job.pTempFile = M4OSA_NULL;
+
+    job.OutputParams.OutputFileType = M4VIDEOEDITING_kFileType_3GPP;
+    job.OutputParams.OutputVideoFormat = M4VIDEOEDITING_kMPEG4;
+    job.OutputParams.outputVideoProfile = OMX_VIDEO_MPEG4ProfileSimple;
+    job.OutputParams.outputVideoLevel = OMX_VIDEO_MPEG4Level5;
+    job.OutputParams.OutputVideoFrameSize = frameSize;
+    job.OutputParams.OutputVideoFrameRate = M4VIDEOEDITING_k30_FPS;
+    /* The audio is copied */
+    job.OutputParams.OutputAudioFormat = M4VIDEOEDITING_kNullAudio;
+    job.OutputParams.OutputAudioSamplingFrequency = M4VIDEOEDITING_kDefault_ASF;
+    job.OutputParams.bAudioMono = M4OSA_FALSE;
+    job.OutputParams.pOutputPCMfile = M4OSA_NULL;
+    job.OutputParams.MediaRendering = M4MCS_kResizing;
+    job.OutputParams.nbEffects = 0;
+    job.OutputParams.pEffects = M4OSA_NULL;
+    job.OutputParams.bDiscardExif = M4OSA_FALSE;
+    job.OutputParams.bAdjustOrientation = M4OSA_FALSE;
+
+    job.EncodingParams.OutputVideoBitrate = bitrate;
+    job.EncodingParams.OutputAudioBitrate = M4VIDEOEDITING_kUndefinedBitrate;
+    /* The whole clip, the preview applies the cuts */
+    job.EncodingParams.BeginCutTime = 0;
+    job.EncodingParams.EndCutTime = 0;
+    job.EncodingParams.OutputFileSize = 0;
+    job.EncodingParams.OutputVideoTimescale = 0;
+
+    return M4MCS_batchAddJob(xVSS_context->pProxyBatch, &job, &pJob->uiJobId);
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_proxyGetPath(M4OSA_Char* pTempPath, M4OSA_Void* pClipFile,
+ *                                            M4OSA_Char* pProxyFile, M4OSA_UInt32 uiSize)
+ * @brief        This function gives the file name of the preview proxy of a clip
+ * @note        The name is made of a FNV-1a hash and of the length of the clip path
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_proxyGetPath( M4OSA_Char *pTempPath, M4OSA_Void *pClipFile,
+                              M4OSA_Char *pProxyFile, M4OSA_UInt32 uiSize )
+{
+    const M4OSA_UInt8 *pByte = (const M4OSA_UInt8 *)pClipFile;
+    M4OSA_UInt32 uiHash = 2166136261U;
+    M4OSA_UInt32 uiLength = 0;
+
+    if( (M4OSA_NULL == pTempPath) || (M4OSA_NULL == pClipFile)
+        || (M4OSA_NULL == pProxyFile) || (0 == uiSize) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    for ( ; 0 != *pByte; pByte++ )
+    {
+        uiHash = (uiHash ^ *pByte) * 16777619U;
+        uiLength++;
+    }
+
+    return M4OSA_chrSPrintf(pProxyFile, uiSize - 1, (M4OSA_Char *)"%sproxy_%08lx_%lu.3gp",
+        pTempPath, (unsigned long)uiHash, (unsigned long)uiLength);
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_proxyStart(M4OSA_Context pContext,
+ *                                          M4VSS3GPP_ClipSettings* pClip)
+ * @brief        This function starts the background transcoding of the preview proxy of a clip
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_proxyStart( M4OSA_Context pContext, M4VSS3GPP_ClipSettings *pClip )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+    M4OSA_Char proxyFile[M4XVSS_MAX_PATH_LEN];
+    M4OSA_Char tempFile[M4XVSS_MAX_PATH_LEN];
+    M4VIDEOEDITING_VideoFrameSize frameSize;
+    M4VIDEOEDITING_Bitrate bitrate;
+    M4xVSS_ProxyJob *pJob;
+    M4xVSS_ProxyJob *pPrevious;
+    M4xVSS_ProxyJob *pOther;
+    M4OSA_Bool bRunning = M4OSA_FALSE;
+    M4OSA_Time clipTime = 0;
+    M4OSA_Time proxyTime = 0;
+    M4OSA_ERR err;
+
+    if( (M4OSA_NULL == xVSS_context) || (M4OSA_NULL == pClip)
+        || (M4OSA_NULL == pClip->pFile) )
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    if( M4OSA_FALSE == M4xVSS_intProxyGetOutput(pClip, &frameSize, &bitrate) )
+    {
+        return M4NO_ERROR;
+    }
+
+    err = M4xVSS_proxyGetPath(xVSS_context->pTempPath, pClip->pFile, proxyFile,
+        M4XVSS_MAX_PATH_LEN);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4OSA_chrSPrintf(tempFile, M4XVSS_MAX_PATH_LEN - 1, (M4OSA_Char *)"%s.tmp",
+            proxyFile);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_proxyStart: M4OSA_chrSPrintf returns 0x%x", err);
+        return err;
+    }
+
+    pJob = (M4xVSS_ProxyJob *)M4OSA_32bitAlignedMalloc(sizeof(M4xVSS_ProxyJob), M4VS,
+        (M4OSA_Char *)"M4xVSS_proxyStart: pJob");
+
+    if( M4OSA_NULL == pJob )
+    {
+        return M4ERR_ALLOC;
+    }
+    memset((void *)pJob, 0, sizeof(M4xVSS_ProxyJob));
+
+    err = M4xVSS_intProxyDecodePath(xVSS_context, pClip->pFile, &pJob->pClipFile);
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4xVSS_intProxyDecodePath(xVSS_context, tempFile, &pJob->pTempFile);
+    }
+
+    if( M4NO_ERROR == err )
+    {
+        err = M4xVSS_intProxyDecodePath(xVSS_context, proxyFile, &pJob->pProxyFile);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4xVSS_intProxyFreeJob(pJob);
+        return err;
+    }
+
+    /**
+    * Nothing to do if the proxy is not older than the clip */
+    if( (M4NO_ERROR == M4xVSS_intProxyModifiedTime(xVSS_context, pJob->pProxyFile,
+        &proxyTime))
+        && (M4NO_ERROR == M4xVSS_intProxyModifiedTime(xVSS_context, pJob->pClipFile,
+        &clipTime))
+        && (proxyTime >= clipTime) )
+    {
+        M4xVSS_intProxyFreeJob(pJob);
+        return M4NO_ERROR;
+    }
+
+    if( M4OSA_NULL == xVSS_context->pProxyBatch )
+    {
+        err = M4xVSS_intProxyOpen(xVSS_context);
+
+        if( M4NO_ERROR != err )
+        {
+            M4xVSS_intProxyFreeJob(pJob);
+            return err;
+        }
+    }
+
+    M4OSA_mutexLock(xVSS_context->pProxyMutex, M4OSA_WAIT_FOREVER);
+
+    /**
+    * Forget the finished jobs, and do not transcode the same proxy twice */
+    pPrevious = M4OSA_NULL;
+    pOther = xVSS_context->pProxyJobs;
+
+    while( M4OSA_NULL != pOther )
+    {
+        M4xVSS_ProxyJob *pNext = (M4xVSS_ProxyJob *)pOther->pNext;
+
+        if( M4OSA_TRUE == pOther->bFinished )
+        {
+            if( M4OSA_NULL == pPrevious )
+            {
+                xVSS_context->pProxyJobs = pNext;
+            }
+            else
+            {
+                pPrevious->pNext = pNext;
+            }
+            M4xVSS_intProxyFreeJob(pOther);
+        }
+        else
+        {
+            if( 0 == strcmp((const char *)pOther->pProxyFile,
+                (const char *)pJob->pProxyFile) )
+            {
+                bRunning = M4OSA_TRUE;
+            }
+            pPrevious = pOther;
+        }
+        pOther = pNext;
+    }
+
+    /**
+    * The job is chained under the lock, its callback may come before batchAddJob returns */
+    if( M4OSA_FALSE == bRunning )
+    {
+        err = M4xVSS_intProxyAddJob(xVSS_context, pJob, pClip, frameSize, bitrate);
+
+        if( M4NO_ERROR == err )
+        {
+            pJob->pNext = xVSS_context->pProxyJobs;
+            xVSS_context->pProxyJobs = pJob;
+        }
+    }
+
+    M4OSA_mutexUnlock(xVSS_context->pProxyMutex);
+
+    if( M4OSA_TRUE == bRunning )
+    {
+        M4xVSS_intProxyFreeJob(pJob);
+        return M4NO_ERROR;
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_proxyStart: M4xVSS_intProxyAddJob returns 0x%x", err);
+        M4xVSS_intProxyFreeJob(pJob);
+        return err;
+    }
+
+    M4OSA_TRACE2_1("M4xVSS_proxyStart: transcoding proxy %s", pJob->pProxyFile);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_internalStopProxies(M4OSA_Context pContext)
+ * @brief    Cancels the proxy transcodings and frees the proxy jobs
+ * @note    The incomplete proxies are removed by the progress callback
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalStopProxies( M4OSA_Context pContext )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+    M4xVSS_ProxyJob *pJob;
+    M4OSA_ERR err = M4NO_ERROR;
+
+    if( M4OSA_NULL != xVSS_context->pProxyBatch )
+    {
+        err = M4MCS_batchClose(xVSS_context->pProxyBatch);
+        xVSS_context->pProxyBatch = M4OSA_NULL;
+    }
+
+    while( M4OSA_NULL != xVSS_context->pProxyJobs )
+    {
+        pJob = xVSS_context->pProxyJobs;
+        xVSS_context->pProxyJobs = (M4xVSS_ProxyJob *)pJob->pNext;
+        M4xVSS_intProxyFreeJob(pJob);
+    }
+
+    if( M4OSA_NULL != xVSS_context->pProxyMutex )
+    {
+        M4OSA_mutexClose(xVSS_context->pProxyMutex);
+        xVSS_context->pProxyMutex = M4OSA_NULL;
+    }
+
+    return err;
+}
@@ -0,0 +1,891 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file    M4xVSS_Segments.c
+ * @brief    Parallel saving of the xVSS
+ * @note    The storyboard is split at the clip boundaries without transition and
+ *            without effect across them. Each segment is edited by its own VSS session,
+ *            on a pool of OSAL threads, into a temporary file in the output format.
+ *            The segment files are then joined by a last VSS session which copies
+ *            their AUs, as it does for the clips already transcoded by the MCS.
+ ******************************************************************************
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "M4OSA_Debug.h"
+#include "M4OSA_CharStar.h"
+#include "M4OSA_Mutex.h"
+#include "M4OSA_Semaphore.h"
+#include "M4OSA_Thread.h"
+
+#include "NXPSW_CompilerSwitches.h"
+
+#include "M4VSS3GPP_API.h"
+#include "M4VSS3GPP_ErrorCodes.h"
+
+#include "M4xVSS_API.h"
+#include "M4xVSS_Internal.h"
+
+/**
+ * A segment is not ended before it lasts this duration (ms): shorter segments
+ * would cost more to open and join than they save */
+#define M4xVSS_SEGMENT_MIN_DURATION     2000
+
+/**
+ * Maximum wait for a segment edition to end in a step (ms), so that the
+ * progress is still reported */
+#define M4xVSS_SEGMENTS_STEP_WAIT       100
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4xVSS_intSegmentsClipDuration(M4VSS3GPP_EditSettings* pSettings,
+ *                                             M4OSA_UInt32 i)
+ * @brief    Returns the duration of a clip in the output, as M4VSS3GPP_editOpen
+ *            computes it (pictures last as long as their transitions, if any)
+ ******************************************************************************
+ */
+static M4OSA_UInt32 M4xVSS_intSegmentsClipDuration( M4VSS3GPP_EditSettings *pSettings,
+                                                   M4OSA_UInt32 i )
+{
+    M4VSS3GPP_ClipSettings *pClip = pSettings->pClipList[i];
+    M4OSA_UInt32 uiEnd;
+
+    if( M4VIDEOEDITING_kFileType_ARGB8888 == pClip->FileType )
+    {
+        if( ( i + 1 < pSettings->uiClipNumber)
+            && (0 != pSettings->pTransitionList[i]->uiTransitionDuration) )
+        {
+            return pSettings->pTransitionList[i]->uiTransitionDuration;
+        }
+
+        if( ( i > 0) && (0 != pSettings->pTransitionList[i - 1]->uiTransitionDuration) )
+        {
+            return pSettings->pTransitionList[i - 1]->uiTransitionDuration;
+        }
+    }
+
+    uiEnd = pClip->uiEndCutTime;
+
+    if( 0 == uiEnd )
+    {
+        uiEnd = pClip->ClipProperties.uiClipVideoDuration;
+    }
+
+    return (uiEnd > pClip->uiBeginCutTime) ? (uiEnd - pClip->uiBeginCutTime) : 0;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4xVSS_intSegmentsEffectAt(M4VSS3GPP_EditSettings* pSettings,
+ *                                       M4OSA_UInt32 uiTime)
+ * @brief    Tells if an effect is active on both sides of an output time
+ ******************************************************************************
+ */
+static M4OSA_Bool M4xVSS_intSegmentsEffectAt( M4VSS3GPP_EditSettings *pSettings,
+                                             M4OSA_UInt32 uiTime )
+{
+    M4OSA_UInt32 i;
+
+    for ( i = 0; i < pSettings->nbEffects; i++ )
+    {
+        if( ( pSettings->Effects[i].uiStartTime < uiTime)
+            && (pSettings->Effects[i].uiStartTime + pSettings->Effects[i].uiDuration
+            > uiTime) )
+        {
+            return M4OSA_TRUE;
+        }
+    }
+
+    return M4OSA_FALSE;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4xVSS_intSegmentsIsMaster(M4VSS3GPP_EditSettings* pSettings,
+ *                                       M4OSA_UInt32 i)
+ * @brief    Tells if a clip can be the master clip of a segment: the output audio
+ *            format of the segment is then the one of the storyboard
+ ******************************************************************************
+ */
+static M4OSA_Bool M4xVSS_intSegmentsIsMaster( M4VSS3GPP_EditSettings *pSettings,
+                                             M4OSA_UInt32 i )
+{
+    M4VIDEOEDITING_ClipProperties *pMaster =
+        &pSettings->pClipList[pSettings->uiMasterClip]->ClipProperties;
+    M4VIDEOEDITING_ClipProperties *pClip = &pSettings->pClipList[i]->ClipProperties;
+
+    if( i == pSettings->uiMasterClip )
+    {
+        return M4OSA_TRUE;
+    }
+
+    /**
+    * The analysis does not fill the properties of the pictures */
+    if( M4VIDEOEDITING_kFileType_ARGB8888 == pSettings->pClipList[i]->FileType )
+    {
+        return M4OSA_FALSE;
+    }
+
+    return (M4OSA_Bool)(( pMaster->AudioStreamType == pClip->AudioStreamType)
+        && (pMaster->uiSamplingFrequency == pClip->uiSamplingFrequency)
+        && (pMaster->uiNbChannels == pClip->uiNbChannels));
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intSegmentsCreateFile(M4xVSS_Context* xVSS_context,
+ *                                        M4OSA_UInt32 uiIndex,
+ *                                        M4VSS3GPP_ClipSettings* pClip)
+ * @brief    Creates the clip settings of a segment file, in the temporary path
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intSegmentsCreateFile( M4xVSS_Context *xVSS_context,
+                                              M4OSA_UInt32 uiIndex,
+                                              M4VSS3GPP_ClipSettings *pClip )
+{
+    M4OSA_Char out_seg[M4XVSS_MAX_PATH_LEN];
+    M4OSA_Void *pDecodedPath;
+    M4OSA_UInt32 length;
+    M4OSA_ERR err;
+
+    err = M4OSA_chrSPrintf(out_seg, M4XVSS_MAX_PATH_LEN - 1, (M4OSA_Char *)"%sseg%d.3gp",
+        xVSS_context->pTempPath, uiIndex);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_intSegmentsCreateFile: M4OSA_chrSPrintf returns 0x%x", err);
+        return err;
+    }
+
+    /**
+    * UTF conversion: convert into the customer format, before being used */
+    pDecodedPath = out_seg;
+    length = strlen((const char *)out_seg);
+
+    if( xVSS_context->UTFConversionContext.pConvFromUTF8Fct != M4OSA_NULL
+        && xVSS_context->UTFConversionContext.pTempOutConversionBuffer != M4OSA_NULL )
+    {
+        err = M4xVSS_internalConvertFromUTF8(xVSS_context, (M4OSA_Void *)out_seg,
+            (M4OSA_Void *)xVSS_context->UTFConversionContext.pTempOutConversionBuffer,
+            &length);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4xVSS_intSegmentsCreateFile: M4xVSS_internalConvertFromUTF8 returns 0x%x",
+                err);
+            return err;
+        }
+        pDecodedPath = xVSS_context->UTFConversionContext.pTempOutConversionBuffer;
+    }
+
+    err = M4xVSS_CreateClipSettings(pClip, pDecodedPath, length, 0);
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    /**
+    * The segment is in the output format: the join only copies it */
+    pClip->FileType = M4VIDEOEDITING_kFileType_3GPP;
+    pClip->bTranscodingRequired = M4OSA_TRUE;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intSegmentsEdit(M4xVSS_SegmentsContext* pS, M4xVSS_Segment* pSeg)
+ * @brief    Edits one segment into its file
+ * @return   M4NO_ERROR when the segment file is complete, M4ERR_STATE if the
+ *           edition was aborted, or the VSS error
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intSegmentsEdit( M4xVSS_SegmentsContext *pS,
+                                        M4xVSS_Segment *pSeg )
+{
+    M4VSS3GPP_EditContext pVssCtxt;
+    M4_StepStats vssStats;
+    M4OSA_UInt8 uiProgress = 0;
+    M4OSA_Bool bAbort = M4OSA_FALSE;
+    M4OSA_ERR err;
+
+    err = M4xVSS_internalOpenEdition(pS->pXvssContext, &pSeg->Settings, &pVssCtxt);
+
+    if( M4NO_ERROR != err )
+    {
+        return err;
+    }
+
+    while( M4NO_ERROR == err )
+    {
+        M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+        pSeg->uiProgress = uiProgress;
+        bAbort = pS->bAbort;
+        M4OSA_mutexUnlock(pS->mutex);
+
+        if( M4OSA_TRUE == bAbort )
+        {
+            err = M4ERR_STATE;
+            break;
+        }
+
+        err = M4VSS3GPP_editStep(pVssCtxt, &uiProgress);
+
+        if( M4VSS3GPP_WAR_SWITCH_CLIP == err )
+        {
+            err = M4NO_ERROR;
+        }
+    }
+
+    if( M4VSS3GPP_WAR_EDITING_DONE == err )
+    {
+        if( M4NO_ERROR == M4VSS3GPP_editGetStatistics(pVssCtxt, &vssStats) )
+        {
+            M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+            M4_StepStatsMerge(&pS->Stats, &vssStats);
+            M4OSA_mutexUnlock(pS->mutex);
+        }
+
+        err = M4VSS3GPP_editClose(pVssCtxt);
+    }
+
+    M4VSS3GPP_editCleanUp(pVssCtxt);
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_ERR M4xVSS_intSegmentsThread(M4OSA_Void* pParam)
+ * @brief    Edition thread function: edits the next segment to edit
+ * @note     Called in loop by the OSAL thread until it returns an error, which
+ *           happens when there is no segment left or when the saving is aborted
+ ******************************************************************************
+ */
+static M4OSA_ERR M4xVSS_intSegmentsThread( M4OSA_Void *pParam )
+{
+    M4xVSS_SegmentsContext *pS = (M4xVSS_SegmentsContext *)pParam;
+    M4xVSS_Segment *pSeg;
+    M4OSA_ERR err;
+
+    M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+
+    if( ( M4OSA_TRUE == pS->bAbort) || (pS->uiNextSegment == pS->uiNbSegments) )
+    {
+        M4OSA_mutexUnlock(pS->mutex);
+        return M4WAR_NO_MORE_AU;
+    }
+    pSeg = &pS->pSegments[pS->uiNextSegment++];
+
+    M4OSA_mutexUnlock(pS->mutex);
+
+    err = M4xVSS_intSegmentsEdit(pS, pSeg);
+
+    M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+    pSeg->err = err;
+    pSeg->bDone = M4OSA_TRUE;
+    pS->uiNbDone++;
+
+    if( M4NO_ERROR == err )
+    {
+        pSeg->uiProgress = 100;
+    }
+    else if( M4OSA_FALSE == pS->bAbort )
+    {
+        /**
+        * The saving fails, do not edit the other segments */
+        M4OSA_TRACE1_2("M4xVSS_intSegmentsThread: segment %d returns 0x%x",
+            (int)(pSeg - pS->pSegments), err);
+        pS->errFailed = err;
+        pS->bAbort = M4OSA_TRUE;
+    }
+    M4OSA_mutexUnlock(pS->mutex);
+
+    M4OSA_semaphorePost(pS->semDone);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4xVSS_intSegmentsWaitThreads(M4xVSS_SegmentsContext* pS)
+ * @brief    Waits for the end of the edition threads and closes them
+ ******************************************************************************
+ */
+static M4OSA_Void M4xVSS_intSegmentsWaitThreads( M4xVSS_SegmentsContext *pS )
+{
+    M4OSA_ThreadState state;
+    M4OSA_UInt32 i;
+
+    for ( i = 0; i < pS->uiNbThreads; i++ )
+    {
+        M4OSA_threadSyncGetState(pS->pThreads[i], &state);
+
+        while( M4OSA_kThreadOpened != state )
+        {
+            M4OSA_threadSleep(1);
+            M4OSA_threadSyncGetState(pS->pThreads[i], &state);
+        }
+        M4OSA_threadSyncClose(pS->pThreads[i]);
+        pS->pThreads[i] = M4OSA_NULL;
+    }
+    pS->uiNbThreads = 0;
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalStartSegments(M4OSA_Context pContext,
+ *                                                     M4OSA_Bool* pbStarted)
+ * @brief    This function splits the storyboard and starts editing the segments
+ * @note    The clips of the current edit settings must be analysed and the external
+ *            effect functions set. Nothing is started if the storyboard can not be split
+ *            in at least two segments, or if the saving can not be split (MMS, output
+ *            file size limit, MP3 output).
+ * @param    pContext    (IN) The integrator own context
+ * @param    pbStarted    (OUT) M4OSA_TRUE if the segments are being edited
+ * @return    M4NO_ERROR:    No error
+ * @return    M4ERR_ALLOC: Allocation error (no more memory)
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalStartSegments( M4OSA_Context pContext, M4OSA_Bool *pbStarted )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+    M4VSS3GPP_EditSettings *pSettings = xVSS_context->pCurrentEditSettings;
+    M4xVSS_SegmentsContext *pS = M4OSA_NULL;
+    M4OSA_UInt8 *pFirstClip = M4OSA_NULL;
+    M4OSA_UInt32 *pStartTime = M4OSA_NULL;
+    M4OSA_UInt32 uiNbSegments = 0;
+    M4OSA_UInt32 uiClipStart = 0, uiClipEnd, uiSegmentStart = 0;
+    M4OSA_UInt32 uiDuration, uiNextDuration, uiTransition;
+    M4OSA_UInt32 uiCodecs = 2, uiMaxThreads, uiStoryboardDuration;
+    M4OSA_Bool bMaster = M4OSA_FALSE;
+    M4OSA_UInt32 i, j, k, uiLast, uiEnd;
+    M4OSA_ERR err = M4NO_ERROR;
+
+    *pbStarted = M4OSA_FALSE;
+
+    if( ( pSettings->uiClipNumber < 2) || (0 != xVSS_context->targetedBitrate)
+        || (0 != pSettings->xVSS.outputFileSize)
+        || (M4VIDEOEDITING_kFileType_ARGB8888
+        == pSettings->pClipList[pSettings->uiMasterClip]->FileType)
+        || (M4VIDEOEDITING_kMP3
+        == pSettings->pClipList[pSettings->uiMasterClip]->ClipProperties.AudioStreamType) )
+    {
+        return M4NO_ERROR;
+    }
+
+    pFirstClip = (M4OSA_UInt8 *)M4OSA_32bitAlignedMalloc(pSettings->uiClipNumber,
+        M4VS, (M4OSA_Char *)"M4xVSS_internalStartSegments: pFirstClip");
+    pStartTime = (M4OSA_UInt32 *)M4OSA_32bitAlignedMalloc(
+        pSettings->uiClipNumber * sizeof(M4OSA_UInt32), M4VS,
+        (M4OSA_Char *)"M4xVSS_internalStartSegments: pStartTime");
+
+    if( ( M4OSA_NULL == pFirstClip) || (M4OSA_NULL == pStartTime) )
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+
+    /**
+    * Cut after a clip when there is no transition nor effect across its end and the
+    * segment has a clip giving the output audio format */
+    pFirstClip[0] = 0;
+    pStartTime[0] = 0;
+    uiNbSegments = 1;
+
+    for ( i = 0; i < pSettings->uiClipNumber; i++ )
+    {
+        uiDuration = M4xVSS_intSegmentsClipDuration(pSettings, i);
+        uiClipEnd = uiClipStart + uiDuration;
+        uiTransition = 0;
+
+        if( i + 1 < pSettings->uiClipNumber )
+        {
+            /**
+            * A transition is shortened to the shortest of its clips */
+            uiTransition = pSettings->pTransitionList[i]->uiTransitionDuration;
+            uiNextDuration = M4xVSS_intSegmentsClipDuration(pSettings, i + 1);
+
+            if( ( uiTransition > uiDuration) && (uiDuration > 0) )
+            {
+                uiTransition = uiDuration - 1;
+            }
+
+            if( ( uiTransition > uiNextDuration) && (uiNextDuration > 0) )
+            {
+                uiTransition = uiNextDuration - 1;
+            }
+
+            /**
+            * A transition decodes both its clips */
+            if( 0 != uiTransition )
+            {
+                uiCodecs = 3;
+            }
+        }
+
+        if( M4OSA_TRUE == M4xVSS_intSegmentsIsMaster(pSettings, i) )
+        {
+            bMaster = M4OSA_TRUE;
+        }
+
+        if( ( i + 1 < pSettings->uiClipNumber) && (0 == uiTransition)
+            && (M4OSA_TRUE == bMaster)
+            && (uiClipEnd - uiSegmentStart >= M4xVSS_SEGMENT_MIN_DURATION)
+            && (M4OSA_FALSE == M4xVSS_intSegmentsEffectAt(pSettings, uiClipEnd)) )
+        {
+            pFirstClip[uiNbSegments] = (M4OSA_UInt8)(i + 1);
+            pStartTime[uiNbSegments] = uiClipEnd;
+            uiNbSegments++;
+            uiSegmentStart = uiClipEnd;
+            bMaster = M4OSA_FALSE;
+        }
+
+        uiClipStart = uiClipEnd - uiTransition;
+    }
+    uiStoryboardDuration = uiClipStart;
+
+    /**
+    * The last segment is joined to the previous one if it has no master clip */
+    if( M4OSA_FALSE == bMaster )
+    {
+        uiNbSegments--;
+    }
+
+    if( uiNbSegments < 2 )
+    {
+        M4OSA_TRACE2_0("M4xVSS_internalStartSegments: the storyboard is not split");
+        goto cleanup;
+    }
+
+    /**
+    * Each session holds a video encoder and one or two video decoders: more sessions
+    * than the codec instances would fail to create theirs */
+    uiMaxThreads = M4xVSS_SAVE_MAX_VIDEO_CODECS / uiCodecs;
+
+    if( uiMaxThreads > xVSS_context->uiSaveThreads )
+    {
+        uiMaxThreads = xVSS_context->uiSaveThreads;
+    }
+
+    if( uiMaxThreads < 2 )
+    {
+        M4OSA_TRACE2_0("M4xVSS_internalStartSegments: not enough video codecs to split");
+        goto cleanup;
+    }
+
+    pS = (M4xVSS_SegmentsContext *)M4OSA_32bitAlignedMalloc(sizeof(M4xVSS_SegmentsContext),
+        M4VS, (M4OSA_Char *)"M4xVSS_SegmentsContext");
+
+    if( M4OSA_NULL == pS )
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+    memset((void *)pS, 0, sizeof(M4xVSS_SegmentsContext));
+    pS->pXvssContext = xVSS_context;
+    M4_StepStatsReset(&pS->Stats);
+
+    /**
+    * From now on, M4xVSS_internalStopSegments frees whatever has been created */
+    xVSS_context->pSegments = (M4OSA_Context)pS;
+
+    pS->pSegments = (M4xVSS_Segment *)M4OSA_32bitAlignedMalloc(
+        uiNbSegments * sizeof(M4xVSS_Segment), M4VS,
+        (M4OSA_Char *)"M4xVSS_internalStartSegments: pSegments");
+    pS->JoinSettings.pClipList = (M4VSS3GPP_ClipSettings **)M4OSA_32bitAlignedMalloc(
+        uiNbSegments * sizeof(M4VSS3GPP_ClipSettings *), M4VS,
+        (M4OSA_Char *)"M4xVSS_internalStartSegments: pClipList");
+    pS->JoinSettings.pTransitionList =
+        (M4VSS3GPP_TransitionSettings **)M4OSA_32bitAlignedMalloc(
+        (uiNbSegments - 1) * sizeof(M4VSS3GPP_TransitionSettings *), M4VS,
+        (M4OSA_Char *)"M4xVSS_internalStartSegments: pTransitionList");
+    pS->pJoinTransitions = (M4VSS3GPP_TransitionSettings *)M4OSA_32bitAlignedMalloc(
+        (uiNbSegments - 1) * sizeof(M4VSS3GPP_TransitionSettings), M4VS,
+        (M4OSA_Char *)"M4xVSS_internalStartSegments: pJoinTransitions");
+
+    if( ( M4OSA_NULL == pS->pSegments) || (M4OSA_NULL == pS->JoinSettings.pClipList)
+        || (M4OSA_NULL == pS->JoinSettings.pTransitionList)
+        || (M4OSA_NULL == pS->pJoinTransitions) )
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+    memset((void *)pS->pSegments, 0, uiNbSegments * sizeof(M4xVSS_Segment));
+    memset((void *)pS->pJoinTransitions, 0,
+        (uiNbSegments - 1) * sizeof(M4VSS3GPP_TransitionSettings));
+    pS->uiNbSegments = uiNbSegments;
+
+    for ( k = 0; k < uiNbSegments; k++ )
+    {
+        M4xVSS_Segment *pSeg = &pS->pSegments[k];
+
+        uiLast = (k + 1 < uiNbSegments) ? pFirstClip[k + 1] : pSettings->uiClipNumber;
+        uiEnd = (k + 1 < uiNbSegments) ? pStartTime[k + 1] : 0xFFFFFFFF;
+
+        err = M4xVSS_intSegmentsCreateFile(xVSS_context, k, &pSeg->Clip);
+
+        if( M4NO_ERROR != err )
+        {
+            goto cleanup;
+        }
+
+        /**
+        * Same settings as the storyboard, on its clips from pFirstClip[k] */
+        memcpy((void *) &pSeg->Settings, (void *)pSettings, sizeof(M4VSS3GPP_EditSettings));
+        pSeg->Settings.uiClipNumber = (M4OSA_UInt8)(uiLast - pFirstClip[k]);
+        pSeg->Settings.pClipList = &pSettings->pClipList[pFirstClip[k]];
+        pSeg->Settings.pTransitionList = &pSettings->pTransitionList[pFirstClip[k]];
+        pSeg->Settings.pOutputFile = pSeg->Clip.pFile;
+        pSeg->Settings.uiOutputPathSize = pSeg->Clip.filePathSize;
+        pSeg->Settings.pTemporaryFile = M4OSA_NULL;
+        pSeg->Settings.xVSS.pBGMtrack = M4OSA_NULL;
+        pSeg->Settings.Effects = M4OSA_NULL;
+        pSeg->Settings.nbEffects = 0;
+        pSeg->uiDuration = ( k + 1 < uiNbSegments) ? (uiEnd - pStartTime[k])
+            : (uiStoryboardDuration - pStartTime[k]);
+
+        if( ( pSettings->uiMasterClip >= pFirstClip[k])
+            && (pSettings->uiMasterClip < uiLast) )
+        {
+            pSeg->Settings.uiMasterClip = (M4OSA_UInt8)(pSettings->uiMasterClip
+                - pFirstClip[k]);
+        }
+        else
+        {
+            for ( i = pFirstClip[k];
+                M4OSA_FALSE == M4xVSS_intSegmentsIsMaster(pSettings, i); i++ )
+            {
+            }
+            pSeg->Settings.uiMasterClip = (M4OSA_UInt8)(i - pFirstClip[k]);
+        }
+
+        /**
+        * Effects starting in the segment, moved to its time base */
+        for ( i = 0, j = 0; i < pSettings->nbEffects; i++ )
+        {
+            if( ( pSettings->Effects[i].uiStartTime >= pStartTime[k])
+                && (pSettings->Effects[i].uiStartTime < uiEnd) )
+            {
+                j++;
+            }
+        }
+
+        if( j > 0 )
+        {
+            pSeg->Settings.Effects = (M4VSS3GPP_EffectSettings *)M4OSA_32bitAlignedMalloc(
+                j * sizeof(M4VSS3GPP_EffectSettings), M4VS,
+                (M4OSA_Char *)"M4xVSS_internalStartSegments: Effects");
+
+            if( M4OSA_NULL == pSeg->Settings.Effects )
+            {
+                err = M4ERR_ALLOC;
+                goto cleanup;
+            }
+
+            for ( i = 0; i < pSettings->nbEffects; i++ )
+            {
+                if( ( pSettings->Effects[i].uiStartTime >= pStartTime[k])
+                    && (pSettings->Effects[i].uiStartTime < uiEnd) )
+                {
+                    memcpy((void *) &pSeg->Settings.Effects[pSeg->Settings.nbEffects],
+                        (void *) &pSettings->Effects[i], sizeof(M4VSS3GPP_EffectSettings));
+                    pSeg->Settings.Effects[pSeg->Settings.nbEffects].uiStartTime -=
+                        pStartTime[k];
+                    pSeg->Settings.nbEffects++;
+                }
+            }
+        }
+
+        pS->JoinSettings.pClipList[k] = &pSeg->Clip;
+
+        if( k + 1 < uiNbSegments )
+        {
+            pS->pJoinTransitions[k].uiTransitionDuration = 0;
+            pS->pJoinTransitions[k].VideoTransitionType = M4VSS3GPP_kVideoTransitionType_None;
+            pS->pJoinTransitions[k].AudioTransitionType = M4VSS3GPP_kAudioTransitionType_None;
+            pS->JoinSettings.pTransitionList[k] = &pS->pJoinTransitions[k];
+        }
+    }
+
+    /**
+    * The join writes the output file of the storyboard, without effects */
+    {
+        M4VSS3GPP_ClipSettings **pJoinClipList = pS->JoinSettings.pClipList;
+        M4VSS3GPP_TransitionSettings **pJoinTransitionList = pS->JoinSettings.pTransitionList;
+
+        memcpy((void *) &pS->JoinSettings, (void *)pSettings, sizeof(M4VSS3GPP_EditSettings));
+        pS->JoinSettings.uiClipNumber = (M4OSA_UInt8)uiNbSegments;
+        pS->JoinSettings.uiMasterClip = 0;
+        pS->JoinSettings.pClipList = pJoinClipList;
+        pS->JoinSettings.pTransitionList = pJoinTransitionList;
+        pS->JoinSettings.Effects = M4OSA_NULL;
+        pS->JoinSettings.nbEffects = 0;
+    }
+
+    err = M4OSA_mutexOpen(&pS->mutex);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    err = M4OSA_semaphoreOpen(&pS->semDone, 0);
+
+    if( M4NO_ERROR != err )
+    {
+        goto cleanup;
+    }
+
+    /**
+    * Start the edition threads */
+    while( ( pS->uiNbThreads < uiMaxThreads) && (pS->uiNbThreads < uiNbSegments) )
+    {
+        err = M4OSA_threadSyncOpen(&pS->pThreads[pS->uiNbThreads],
+            (M4OSA_ThreadDoIt)M4xVSS_intSegmentsThread);
+
+        if( M4NO_ERROR != err )
+        {
+            goto cleanup;
+        }
+
+        err = M4OSA_threadSyncStart(pS->pThreads[pS->uiNbThreads], (M4OSA_Void *)pS);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_threadSyncClose(pS->pThreads[pS->uiNbThreads]);
+            goto cleanup;
+        }
+        pS->uiNbThreads++;
+    }
+
+    M4OSA_TRACE1_2("M4xVSS_internalStartSegments: %d segments, %d threads",
+        uiNbSegments, pS->uiNbThreads);
+
+    /**
+    * One more step for the progress: the join */
+    xVSS_context->nbStepTotal++;
+    xVSS_context->editingStep = M4xVSS_kMicroStateEditingSegments;
+    *pbStarted = M4OSA_TRUE;
+
+cleanup:
+    if( M4OSA_NULL != pFirstClip )
+    {
+        free(pFirstClip);
+    }
+
+    if( M4OSA_NULL != pStartTime )
+    {
+        free(pStartTime);
+    }
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_internalStartSegments: returns 0x%x", err);
+        M4xVSS_internalStopSegments(xVSS_context);
+    }
+
+    return err;
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalStepSegments(M4OSA_Context pContext,
+ *                                                    M4OSA_UInt8* pProgress)
+ * @brief    This function follows the edition of the segments
+ * @note    It waits M4xVSS_SEGMENTS_STEP_WAIT ms at most. Once all the segments are
+ *            edited, it opens the VSS edition joining them into the output file and
+ *            the saving goes on with M4xVSS_kMicroStateEditing. If a segment fails,
+ *            the segments are deleted and the saving goes on the same way with a VSS
+ *            edition of the whole storyboard.
+ * @param    pContext    (IN) The integrator own context
+ * @param    pProgress    (OUT) Progress of the segment editions (0-100)
+ * @return    M4NO_ERROR:    No error
+ * @return    M4ERR_FILE_INVALID_POSITION if a segment runs out of space
+ * @return    The error of the join or storyboard edition opening
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalStepSegments( M4OSA_Context pContext, M4OSA_UInt8 *pProgress )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+    M4xVSS_SegmentsContext *pS = (M4xVSS_SegmentsContext *)xVSS_context->pSegments;
+    M4VSS3GPP_EditContext pVssCtxt;
+    M4OSA_UInt32 uiTotal = 0, uiDone = 0, uiDuration, uiNbDone;
+    M4OSA_ERR err = M4NO_ERROR;
+    M4OSA_UInt32 i;
+
+    M4OSA_semaphoreWait(pS->semDone, M4xVSS_SEGMENTS_STEP_WAIT);
+
+    M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+
+    for ( i = 0; i < pS->uiNbSegments; i++ )
+    {
+        uiDuration = pS->pSegments[i].uiDuration;
+        uiTotal += uiDuration;
+        uiDone += uiDuration / 100 * pS->pSegments[i].uiProgress;
+    }
+    uiNbDone = pS->uiNbDone;
+    err = pS->errFailed;
+
+    M4OSA_mutexUnlock(pS->mutex);
+
+    if( M4NO_ERROR != err )
+    {
+        if( ((M4OSA_UInt32)M4ERR_FILE_INVALID_POSITION) == err )
+        {
+            /**
+            * No more space: a single session would fail as well */
+            return err;
+        }
+
+        /**
+        * The shells report the lack of codec instances with their own errors (a
+        * decoder or encoder creation failure): the storyboard is saved again by
+        * a single session, which returns the error if it was not that */
+        M4OSA_TRACE1_1(
+            "M4xVSS_internalStepSegments: segment error 0x%x, saving with one session",
+            err);
+
+        M4xVSS_internalStopSegments(xVSS_context);
+        xVSS_context->nbStepTotal--;
+
+        err = M4xVSS_internalOpenEdition(xVSS_context, xVSS_context->pCurrentEditSettings,
+            &pVssCtxt);
+
+        if( M4NO_ERROR != err )
+        {
+            M4OSA_TRACE1_1(
+                "M4xVSS_internalStepSegments: M4xVSS_internalOpenEdition returns 0x%x", err);
+            return err;
+        }
+
+        xVSS_context->pCurrentEditContext = pVssCtxt;
+        *pProgress = 0;
+        return M4NO_ERROR;
+    }
+
+    if( uiNbDone < pS->uiNbSegments )
+    {
+        *pProgress = (M4OSA_UInt8)((uiTotal / 100 > 0) ? (uiDone / (uiTotal / 100)) : 0);
+        return M4NO_ERROR;
+    }
+
+    M4xVSS_intSegmentsWaitThreads(pS);
+
+    err = M4xVSS_internalOpenEdition(xVSS_context, &pS->JoinSettings, &pVssCtxt);
+
+    if( M4NO_ERROR != err )
+    {
+        M4OSA_TRACE1_1("M4xVSS_internalStepSegments: M4xVSS_internalOpenEdition returns 0x%x",
+            err);
+        return err;
+    }
+
+    xVSS_context->pCurrentEditContext = pVssCtxt;
+    xVSS_context->editingStep = M4xVSS_kMicroStateEditing;
+    xVSS_context->currentStep++;
+    *pProgress = 0;
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalStopSegments(M4OSA_Context pContext)
+ * @brief    This function stops the segment editions, if any, and deletes the segments
+ * @note    It does nothing if there is no parallel saving.
+ * @param    pContext    (IN) The integrator own context
+ * @return    M4NO_ERROR:    No error
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalStopSegments( M4OSA_Context pContext )
+{
+    M4xVSS_Context *xVSS_context = (M4xVSS_Context *)pContext;
+    M4xVSS_SegmentsContext *pS = (M4xVSS_SegmentsContext *)xVSS_context->pSegments;
+    M4OSA_UInt32 i;
+
+    if( M4OSA_NULL == pS )
+    {
+        return M4NO_ERROR;
+    }
+
+    if( M4OSA_NULL != pS->mutex )
+    {
+        M4OSA_mutexLock(pS->mutex, M4OSA_WAIT_FOREVER);
+        pS->bAbort = M4OSA_TRUE;
+        M4OSA_mutexUnlock(pS->mutex);
+    }
+    M4xVSS_intSegmentsWaitThreads(pS);
+
+    M4_StepStatsMerge(&xVSS_context->Stats, &pS->Stats);
+
+    if( M4OSA_NULL != pS->pSegments )
+    {
+        for ( i = 0; i < pS->uiNbSegments; i++ )
+        {
+            if( M4OSA_NULL != pS->pSegments[i].Settings.Effects )
+            {
+                free(pS->pSegments[i].Settings.Effects);
+            }
+
+            if( M4OSA_NULL != pS->pSegments[i].Clip.pFile )
+            {
+                remove((const char *)pS->pSegments[i].Clip.pFile);
+                M4xVSS_FreeClipSettings(&pS->pSegments[i].Clip);
+            }
+        }
+        free(pS->pSegments);
+    }
+
+    if( M4OSA_NULL != pS->JoinSettings.pClipList )
+    {
+        free(pS->JoinSettings.pClipList);
+    }
+
+    if( M4OSA_NULL != pS->JoinSettings.pTransitionList )
+    {
+        free(pS->JoinSettings.pTransitionList);
+    }
+
+    if( M4OSA_NULL != pS->pJoinTransitions )
+    {
+        free(pS->pJoinTransitions);
+    }
+
+    if( M4OSA_NULL != pS->semDone )
+    {
+        M4OSA_semaphoreClose(pS->semDone);
+    }
+
+    if( M4OSA_NULL != pS->mutex )
+    {
+        M4OSA_mutexClose(pS->mutex);
+    }
+
+    free(pS);
+    xVSS_context->pSegments = M4OSA_NULL;
+
+    if( M4xVSS_kMicroStateEditingSegments == xVSS_context->editingStep )
+    {
+        xVSS_context->editingStep = M4xVSS_kMicroStateEditing;
+    }
+
+    return M4NO_ERROR;
+}
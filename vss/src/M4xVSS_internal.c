@@ -188,6 +188,16 @@ M4OSA_ERR M4xVSS_internalStartTranscoding(M4OSA_Context pContext,
         return err;
     }
 
+    /**
+     * Transcode the audio while the video is being transcoded */
+    err = M4MCS_setConcurrentAudio(mcs_context, M4OSA_TRUE);
+    if (err != M4NO_ERROR)
+    {
+        M4OSA_TRACE1_1("Error in M4MCS_setConcurrentAudio: 0x%x", err);
+        M4MCS_abort(mcs_context);
+        return err;
+    }
+
     err = M4MCS_checkParamsAndStart(mcs_context);
     if (err != M4NO_ERROR)
     {
@@ -218,8 +228,14 @@ M4OSA_ERR M4xVSS_internalStartTranscoding(M4OSA_Context pContext,
 M4OSA_ERR M4xVSS_internalStopTranscoding(M4OSA_Context pContext)
 {
     M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
+    M4_StepStats mcsStats;
     M4OSA_ERR err;
 
+    if (M4MCS_getStatistics(xVSS_context->pMCS_Ctxt, &mcsStats) == M4NO_ERROR)
+    {
+        M4_StepStatsMerge(&xVSS_context->Stats, &mcsStats);
+    }
+
     err = M4MCS_close(xVSS_context->pMCS_Ctxt);
     if (err != M4NO_ERROR)
     {
@@ -477,6 +493,100 @@ M4OSA_ERR M4xVSS_internalConvertARGB8888toYUV420(M4OSA_Void* pFileIn,
 
 }
 
+/**
+ ******************************************************************************
+ * M4OSA_Void M4xVSS_internalGetPanZoomWindow(M4xVSS_PictureCallbackCtxt* pC,
+ *                                            M4OSA_UInt32 uiImage,
+ *                                            M4VIFI_ImagePlane* pImagePlanes,
+ *                                            M4AIR_Params* pParams)
+ * @brief    Computes the AIR parameters of the pan&zoom window of a given picture
+ * @note    Only used for resizing and cropping media rendering, i.e. when the output
+ *            window is the whole output picture. The window is linear in uiImage, so the
+ *            AIR can interpolate between the first and the last one. The window of a
+ *            picture is the one the per picture AIR configuration used to compute.
+ * @param    pC            (IN) Picture callback context
+ * @param    uiImage        (IN) Index of the picture, from 0 to m_NbImage-1
+ * @param    pImagePlanes(IN) Output planes
+ * @param    pParams        (OUT) AIR parameters
+ ******************************************************************************
+ */
+static M4OSA_Void M4xVSS_internalGetPanZoomWindow(M4xVSS_PictureCallbackCtxt* pC,
+                                                  M4OSA_UInt32 uiImage,
+                                                  M4VIFI_ImagePlane* pImagePlanes,
+                                                  M4AIR_Params* pParams)
+{
+    M4xVSS_Pto3GPP_params* pPto3GPPparams = pC->m_pPto3GPPparams;
+
+    /**
+     * Same window as the black borders path: the ratio is uiImage/m_NbImage and the
+     * per mille position is offset by -1, as in the original per picture computation */
+    pParams->m_inputCoord.m_x = (M4OSA_UInt32)((((M4OSA_Double)pC->m_pDecodedPlane->u_width *
+        (pPto3GPPparams->PanZoomTopleftXa +
+        (M4OSA_Double)((M4OSA_Double)(pPto3GPPparams->PanZoomTopleftXb
+            - pPto3GPPparams->PanZoomTopleftXa) *
+        uiImage) / (M4OSA_Double)pC->m_NbImage-1)) / 1000));
+    pParams->m_inputCoord.m_y = (M4OSA_UInt32)((((M4OSA_Double)pC->m_pDecodedPlane->u_height *
+        (pPto3GPPparams->PanZoomTopleftYa +
+        (M4OSA_Double)((M4OSA_Double)(pPto3GPPparams->PanZoomTopleftYb
+            - pPto3GPPparams->PanZoomTopleftYa) *
+        uiImage) / (M4OSA_Double)pC->m_NbImage-1)) / 1000));
+    pParams->m_inputSize.m_width =
+        (M4OSA_UInt32)((((M4OSA_Double)pC->m_pDecodedPlane->u_width *
+        (pPto3GPPparams->PanZoomXa +
+        (M4OSA_Double)((M4OSA_Double)(pPto3GPPparams->PanZoomXb - pPto3GPPparams->PanZoomXa) *
+        uiImage) / (M4OSA_Double)pC->m_NbImage-1)) / 1000));
+    pParams->m_inputSize.m_height =
+        (M4OSA_UInt32)((((M4OSA_Double)pC->m_pDecodedPlane->u_height *
+        (pPto3GPPparams->PanZoomXa +
+        (M4OSA_Double)((M4OSA_Double)(pPto3GPPparams->PanZoomXb - pPto3GPPparams->PanZoomXa) *
+        uiImage) / (M4OSA_Double)pC->m_NbImage-1)) / 1000));
+
+    if((pParams->m_inputSize.m_width + pParams->m_inputCoord.m_x)
+         > pC->m_pDecodedPlane->u_width)
+    {
+        pParams->m_inputSize.m_width = pC->m_pDecodedPlane->u_width - pParams->m_inputCoord.m_x;
+    }
+    if((pParams->m_inputSize.m_height + pParams->m_inputCoord.m_y)
+         > pC->m_pDecodedPlane->u_height)
+    {
+        pParams->m_inputSize.m_height =
+            pC->m_pDecodedPlane->u_height - pParams->m_inputCoord.m_y;
+    }
+
+    pParams->m_outputSize.m_width = (pImagePlanes->u_width>>1)<<1;
+    pParams->m_outputSize.m_height = (pImagePlanes->u_height>>1)<<1;
+    pParams->m_bOutputStripe = M4OSA_FALSE;
+    pParams->m_outputOrientation = M4COMMON_kOrientationTopLeft;
+
+    /**
+    Picture rendering: Cropping, the window is reduced around its center to keep
+    the output aspect ratio*/
+    if(pC->m_mediaRendering == M4xVSS_kCropping)
+    {
+        if((pParams->m_outputSize.m_height * pParams->m_inputSize.m_width)
+             /pParams->m_outputSize.m_width < pParams->m_inputSize.m_height)
+        {
+            M4OSA_UInt32 tempHeight = pParams->m_inputSize.m_height;
+            /*height will be cropped*/
+            pParams->m_inputSize.m_height = (M4OSA_UInt32)((pParams->m_outputSize.m_height
+                * pParams->m_inputSize.m_width) /pParams->m_outputSize.m_width);
+            pParams->m_inputCoord.m_y += (tempHeight - pParams->m_inputSize.m_height)>>1;
+        }
+        else
+        {
+            M4OSA_UInt32 tempWidth = pParams->m_inputSize.m_width;
+            /*width will be cropped*/
+            pParams->m_inputSize.m_width = (M4OSA_UInt32)((pParams->m_outputSize.m_width
+                * pParams->m_inputSize.m_height) /pParams->m_outputSize.m_height);
+            pParams->m_inputCoord.m_x += (tempWidth - pParams->m_inputSize.m_width)>>1;
+        }
+    }
+
+    /*Width and height have to be even*/
+    pParams->m_inputSize.m_width = (pParams->m_inputSize.m_width>>1)<<1;
+    pParams->m_inputSize.m_height = (pParams->m_inputSize.m_height>>1)<<1;
+}
+
 /**
  ******************************************************************************
  * M4OSA_ERR M4xVSS_PictureCallbackFct (M4OSA_Void* pPictureCtxt,
@@ -1408,19 +1518,54 @@ M4OSA_ERR M4xVSS_PictureCallbackFct(M4OSA_Void* pPictureCtxt, M4VIFI_ImagePlane*
             }
         }
 
-        err = M4AIR_configure(pC->m_air_context, &Params);
-        if(err != M4NO_ERROR)
+        /**
+         * Pan&zoom without black borders: the AIR is configured once with the first and
+         * last windows, each picture is then interpolated from the precomputed tables */
+        if((M4OSA_TRUE == pC->m_pPto3GPPparams->isPanZoom)
+            && (pC->m_mediaRendering != M4xVSS_kBlackBorders))
         {
-            M4OSA_TRACE1_1("M4xVSS_PictureCallbackFct:\
-                 Error when configuring AIR: 0x%x", err);
-            M4AIR_cleanUp(pC->m_air_context);
-            free(pC->m_pDecodedPlane[0].pac_data);
-            free(pC->m_pDecodedPlane);
-            pC->m_pDecodedPlane = M4OSA_NULL;
-            return err;
+            if(M4OSA_FALSE == pC->m_bPanZoomConfigured)
+            {
+                M4AIR_Params StartParams, EndParams;
+
+                M4xVSS_internalGetPanZoomWindow(pC, 0, pImagePlanes, &StartParams);
+                M4xVSS_internalGetPanZoomWindow(pC, pC->m_NbImage - 1, pImagePlanes,
+                    &EndParams);
+
+                err = M4AIR_configurePanZoom(pC->m_air_context, &StartParams, &EndParams);
+                if(err != M4NO_ERROR)
+                {
+                    M4OSA_TRACE1_1("M4xVSS_PictureCallbackFct:\
+                         Error when configuring AIR pan&zoom: 0x%x", err);
+                    M4AIR_cleanUp(pC->m_air_context);
+                    pC->m_air_context = M4OSA_NULL;
+                    free(pC->m_pDecodedPlane[0].pac_data);
+                    free(pC->m_pDecodedPlane);
+                    pC->m_pDecodedPlane = M4OSA_NULL;
+                    return err;
+                }
+                pC->m_bPanZoomConfigured = M4OSA_TRUE;
+            }
+
+            err = M4AIR_getPanZoom(pC->m_air_context, pC->m_ImageCounter, pC->m_NbImage - 1,
+                pC->m_pDecodedPlane, pImagePlanes);
         }
+        else
+        {
+            err = M4AIR_configure(pC->m_air_context, &Params);
+            if(err != M4NO_ERROR)
+            {
+                M4OSA_TRACE1_1("M4xVSS_PictureCallbackFct:\
+                     Error when configuring AIR: 0x%x", err);
+                M4AIR_cleanUp(pC->m_air_context);
+                free(pC->m_pDecodedPlane[0].pac_data);
+                free(pC->m_pDecodedPlane);
+                pC->m_pDecodedPlane = M4OSA_NULL;
+                return err;
+            }
 
-        err = M4AIR_get(pC->m_air_context, pC->m_pDecodedPlane, pImagePlanes);
+            err = M4AIR_get(pC->m_air_context, pC->m_pDecodedPlane, pImagePlanes);
+        }
         if(err != M4NO_ERROR)
         {
             M4OSA_TRACE1_1("M4xVSS_PictureCallbackFct: Error when getting AIR plane: 0x%x", err);
@@ -1458,6 +1603,8 @@ M4OSA_ERR M4xVSS_PictureCallbackFct(M4OSA_Void* pPictureCtxt, M4VIFI_ImagePlane*
                 M4OSA_TRACE1_1("M4xVSS_PictureCallbackFct: Error when cleaning AIR: 0x%x", err);
                 return err;
             }
+            pC->m_air_context = M4OSA_NULL;
+            pC->m_bPanZoomConfigured = M4OSA_FALSE;
         }
         if(M4OSA_NULL != pC->m_pDecodedPlane)
         {
@@ -1642,6 +1789,7 @@ M4OSA_ERR M4xVSS_internalStartConvertPictureTo3gp(M4OSA_Context pContext)
     pCallBackCtxt->m_pPto3GPPparams    = xVSS_context->pPTo3GPPcurrentParams;
     pCallBackCtxt->m_air_context    = M4OSA_NULL;
     pCallBackCtxt->m_mediaRendering = xVSS_context->pPTo3GPPcurrentParams->MediaRendering;
+    pCallBackCtxt->m_bPanZoomConfigured = M4OSA_FALSE;
 
     /**
      * Set the input and output files */
@@ -2338,68 +2486,130 @@ M4OSA_ERR M4xVSS_internalConvertARGB888toYUV420_FrammingEffect(M4OSA_Context pCo
 
 /**
  ******************************************************************************
- * prototype    M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext)
+ * prototype    M4OSA_ERR M4xVSS_internalOpenEdition(M4OSA_Context pContext,
+ *                                                  M4VSS3GPP_EditSettings* pSettings,
+ *                                                  M4VSS3GPP_EditContext* pVssCtxt)
  *
- * @brief    This function prepares VSS for editing
- * @note    It also set special xVSS effect as external effects for the VSS
+ * @brief    This function creates a VSS edition with the xVSS output settings
+ * @note    The clips of pSettings must be analysed and the external effect functions set.
+ *            It may be called by several threads at once.
  * @param    pContext    (IN) The integrator own context
+ * @param    pSettings    (IN) Edit settings
+ * @param    pVssCtxt    (OUT) Opened VSS edit context, M4OSA_NULL on error
  *
  * @return    M4NO_ERROR:    No error
- * @return    M4ERR_PARAMETER: At least one of the function parameters is null
- * @return    M4ERR_ALLOC: Allocation error (no more memory)
+ * @return    Any error returned by M4VSS3GPP_editInit or M4VSS3GPP_editOpen
  ******************************************************************************
  */
-M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext)
+M4OSA_ERR M4xVSS_internalOpenEdition(M4OSA_Context pContext, M4VSS3GPP_EditSettings* pSettings,
+                                     M4VSS3GPP_EditContext* pVssCtxt)
 {
     M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
-    M4VSS3GPP_EditContext pVssCtxt;
-    M4OSA_UInt32 i,j;
+    M4VSS3GPP_InternalEditContext* pVSSContext;
+    M4OSA_UInt8 i;
     M4OSA_ERR err;
 
+    *pVssCtxt = M4OSA_NULL;
+
     /**
      * Create a VSS 3GPP edition instance */
-    err = M4VSS3GPP_editInit( &pVssCtxt, xVSS_context->pFileReadPtr, xVSS_context->pFileWritePtr);
+    err = M4VSS3GPP_editInit(pVssCtxt, xVSS_context->pFileReadPtr, xVSS_context->pFileWritePtr);
     if (err != M4NO_ERROR)
     {
-        M4OSA_TRACE1_1("M4xVSS_internalGenerateEditedFile: M4VSS3GPP_editInit returned 0x%x\n",
+        M4OSA_TRACE1_1("M4xVSS_internalOpenEdition: M4VSS3GPP_editInit returned 0x%x\n",
             err);
-        M4VSS3GPP_editCleanUp(pVssCtxt);
-        /**
-         * Set the VSS context to NULL */
-        xVSS_context->pCurrentEditContext = M4OSA_NULL;
+        M4VSS3GPP_editCleanUp(*pVssCtxt);
+        *pVssCtxt = M4OSA_NULL;
         return err;
     }
 
-        M4VSS3GPP_InternalEditContext* pVSSContext =
-            (M4VSS3GPP_InternalEditContext*)pVssCtxt;
-        pVSSContext->xVSS.outputVideoFormat =
-            xVSS_context->pSettings->xVSS.outputVideoFormat;
-        pVSSContext->xVSS.outputVideoSize =
-            xVSS_context->pSettings->xVSS.outputVideoSize ;
-        pVSSContext->xVSS.outputAudioFormat =
-            xVSS_context->pSettings->xVSS.outputAudioFormat;
-        pVSSContext->xVSS.outputAudioSamplFreq =
-            xVSS_context->pSettings->xVSS.outputAudioSamplFreq;
-        pVSSContext->xVSS.outputVideoBitrate =
-            xVSS_context->pSettings->xVSS.outputVideoBitrate ;
-        pVSSContext->xVSS.outputAudioBitrate =
-            xVSS_context->pSettings->xVSS.outputAudioBitrate ;
-        pVSSContext->xVSS.bAudioMono =
-            xVSS_context->pSettings->xVSS.bAudioMono;
-        pVSSContext->xVSS.outputVideoProfile =
-            xVSS_context->pSettings->xVSS.outputVideoProfile;
-        pVSSContext->xVSS.outputVideoLevel =
-            xVSS_context->pSettings->xVSS.outputVideoLevel;
+    pVSSContext = (M4VSS3GPP_InternalEditContext*)*pVssCtxt;
+    pVSSContext->xVSS.outputVideoFormat =
+        xVSS_context->pSettings->xVSS.outputVideoFormat;
+    pVSSContext->xVSS.outputVideoSize =
+        xVSS_context->pSettings->xVSS.outputVideoSize ;
+    pVSSContext->xVSS.outputAudioFormat =
+        xVSS_context->pSettings->xVSS.outputAudioFormat;
+    pVSSContext->xVSS.outputAudioSamplFreq =
+        xVSS_context->pSettings->xVSS.outputAudioSamplFreq;
+    pVSSContext->xVSS.outputVideoBitrate =
+        xVSS_context->pSettings->xVSS.outputVideoBitrate ;
+    pVSSContext->xVSS.outputAudioBitrate =
+        xVSS_context->pSettings->xVSS.outputAudioBitrate ;
+    pVSSContext->xVSS.bAudioMono =
+        xVSS_context->pSettings->xVSS.bAudioMono;
+    pVSSContext->xVSS.outputVideoProfile =
+        xVSS_context->pSettings->xVSS.outputVideoProfile;
+    pVSSContext->xVSS.outputVideoLevel =
+        xVSS_context->pSettings->xVSS.outputVideoLevel;
     /* In case of MMS use case, we fill directly into the VSS context the targeted bitrate */
     if(xVSS_context->targetedBitrate != 0)
     {
-        M4VSS3GPP_InternalEditContext* pVSSContext = (M4VSS3GPP_InternalEditContext*)pVssCtxt;
-
         pVSSContext->bIsMMS = M4OSA_TRUE;
         pVSSContext->uiMMSVideoBitrate = xVSS_context->targetedBitrate;
         pVSSContext->MMSvideoFramerate = xVSS_context->pSettings->videoFrameRate;
     }
 
+    /**
+     * Open the VSS 3GPP */
+    err = M4VSS3GPP_editOpen(*pVssCtxt, pSettings);
+    if (err != M4NO_ERROR)
+    {
+        M4OSA_TRACE1_1("M4xVSS_internalOpenEdition: M4VSS3GPP_editOpen returned 0x%x\n",
+            err);
+        M4VSS3GPP_editCleanUp(*pVssCtxt);
+        *pVssCtxt = M4OSA_NULL;
+        return err;
+    }
+
+    /**
+     * The per plane color effects can be fused with the other table effects by the VSS */
+    for (i=0; i<pSettings->nbEffects; i++)
+    {
+        M4xVSS_ColorStruct* pColorCtx =
+            (M4xVSS_ColorStruct*)pSettings->Effects[i].pExtVideoEffectFctCtxt;
+
+        if ((M4VSS3GPP_externalVideoEffectColor == pSettings->Effects[i].ExtVideoEffectFct)
+            && (M4OSA_NULL != pColorCtx) && (M4VFL_kColorLut_Planes == pColorCtx->lut.type))
+        {
+            err = M4VSS3GPP_editSetEffectLut(*pVssCtxt, i, &(pColorCtx->lut));
+            if (err != M4NO_ERROR)
+            {
+                M4OSA_TRACE1_1("M4xVSS_internalOpenEdition:\
+                     M4VSS3GPP_editSetEffectLut returned 0x%x\n", err);
+                M4VSS3GPP_editCleanUp(*pVssCtxt);
+                *pVssCtxt = M4OSA_NULL;
+                return err;
+            }
+        }
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext)
+ *
+ * @brief    This function prepares VSS for editing
+ * @note    It also set special xVSS effect as external effects for the VSS.
+ *            If several save threads are set and the storyboard can be split, it starts
+ *            the parallel edition of the segments instead (see M4xVSS_internalStartSegments).
+ * @param    pContext    (IN) The integrator own context
+ *
+ * @return    M4NO_ERROR:    No error
+ * @return    M4ERR_PARAMETER: At least one of the function parameters is null
+ * @return    M4ERR_ALLOC: Allocation error (no more memory)
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext)
+{
+    M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
+    M4VSS3GPP_EditContext pVssCtxt;
+    M4OSA_UInt32 i,j;
+    M4OSA_ERR err;
+    M4OSA_Bool bSegments = M4OSA_FALSE;
+
     /*Warning: since the adding of the UTF conversion, pSettings has been changed in the next
     part in  pCurrentEditSettings (there is a specific current editing structure for the saving,
      as for the preview)*/
@@ -2535,18 +2745,65 @@ M4OSA_ERR M4xVSS_internalGenerateEditedFile(M4OSA_Context pContext)
                  * We do not need to set the color context, it is already set during
                  sendCommand function */
             }
+            if (M4xVSS_kVideoEffectType_ColorLut ==
+             xVSS_context->pCurrentEditSettings->Effects[j].VideoEffectType)
+            {
+                xVSS_context->pCurrentEditSettings->Effects[j].ExtVideoEffectFct =
+                 M4VSS3GPP_externalVideoEffectColor;
+                /**
+                 * We do not need to set the color context, the LUT is loaded during
+                 sendCommand function */
+            }
 
         }
     }
 
     /**
-     * Open the VSS 3GPP */
-    err = M4VSS3GPP_editOpen(pVssCtxt, xVSS_context->pCurrentEditSettings);
+     * Analyse the clips before opening the VSS, so that unchanged clips are not analysed
+     * again for each edition */
+    err = M4VSS3GPP_editAnalyseClipList(xVSS_context->pCurrentEditSettings->pClipList,
+        xVSS_context->pCurrentEditSettings->uiClipNumber, xVSS_context->pFileReadPtr,
+        xVSS_context->pAnalysisCache);
+    if (err != M4NO_ERROR)
+    {
+        M4OSA_TRACE1_1("M4xVSS_internalGenerateEditedFile:\
+             M4VSS3GPP_editAnalyseClipList returned 0x%x\n",err);
+        /**
+         * Set the VSS context to NULL */
+        xVSS_context->pCurrentEditContext = M4OSA_NULL;
+        return err;
+    }
+
+    /**
+     * Edit the segments of the storyboard concurrently, if possible */
+    if (xVSS_context->uiSaveThreads > 1)
+    {
+        err = M4xVSS_internalStartSegments(xVSS_context, &bSegments);
+        if (err != M4NO_ERROR)
+        {
+            M4OSA_TRACE1_1("M4xVSS_internalGenerateEditedFile:\
+                 M4xVSS_internalStartSegments returned 0x%x\n",err);
+            xVSS_context->pCurrentEditContext = M4OSA_NULL;
+            return err;
+        }
+
+        if (bSegments == M4OSA_TRUE)
+        {
+            /**
+             * The VSS edition joining the segments is opened once they are edited */
+            xVSS_context->pCurrentEditContext = M4OSA_NULL;
+            return M4NO_ERROR;
+        }
+    }
+
+    /**
+     * Create and open the VSS 3GPP */
+    err = M4xVSS_internalOpenEdition(xVSS_context, xVSS_context->pCurrentEditSettings,
+        &pVssCtxt);
     if (err != M4NO_ERROR)
     {
         M4OSA_TRACE1_1("M4xVSS_internalGenerateEditedFile:\
-             M4VSS3GPP_editOpen returned 0x%x\n",err);
-        M4VSS3GPP_editCleanUp(pVssCtxt);
+             M4xVSS_internalOpenEdition returned 0x%x\n",err);
         /**
          * Set the VSS context to NULL */
         xVSS_context->pCurrentEditContext = M4OSA_NULL;
@@ -2576,10 +2833,16 @@ M4OSA_ERR M4xVSS_internalCloseEditedFile(M4OSA_Context pContext)
 {
     M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
     M4VSS3GPP_EditContext pVssCtxt = xVSS_context->pCurrentEditContext;
+    M4_StepStats vssStats;
     M4OSA_ERR err;
 
     if(xVSS_context->pCurrentEditContext != M4OSA_NULL)
     {
+        if (M4VSS3GPP_editGetStatistics(pVssCtxt, &vssStats) == M4NO_ERROR)
+        {
+            M4_StepStatsMerge(&xVSS_context->Stats, &vssStats);
+        }
+
         /**
          * Close the VSS 3GPP */
         err = M4VSS3GPP_editClose(pVssCtxt);
@@ -2608,6 +2871,10 @@ M4OSA_ERR M4xVSS_internalCloseEditedFile(M4OSA_Context pContext)
         }
     }
 
+    /**
+     * The segment files of a parallel saving are joined, they can be deleted */
+    M4xVSS_internalStopSegments(xVSS_context);
+
     return M4NO_ERROR;
 }
 
@@ -2904,6 +3171,10 @@ M4OSA_ERR M4xVSS_internalFreeSaving(M4OSA_Context pContext)
     M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
     M4OSA_UInt8 i;
 
+    /**
+     * The segment editions use the current edit settings */
+    M4xVSS_internalStopSegments(xVSS_context);
+
     if(xVSS_context->pCurrentEditSettings != M4OSA_NULL)
     {
         /**
@@ -3300,13 +3571,15 @@ M4OSA_ERR M4xVSS_freeSettings(M4VSS3GPP_EditSettings* pSettings)
                 || M4xVSS_kVideoEffectType_Green == pSettings->Effects[i].VideoEffectType
                 || M4xVSS_kVideoEffectType_Sepia == pSettings->Effects[i].VideoEffectType
                 || M4xVSS_kVideoEffectType_Negative== pSettings->Effects[i].VideoEffectType
-                || M4xVSS_kVideoEffectType_Gradient== pSettings->Effects[i].VideoEffectType)
+                || M4xVSS_kVideoEffectType_Gradient== pSettings->Effects[i].VideoEffectType
+                || M4xVSS_kVideoEffectType_ColorLut== pSettings->Effects[i].VideoEffectType)
             {
                 /* Free Color context */
                 M4xVSS_ColorStruct* ColorCtx = pSettings->Effects[i].pExtVideoEffectFctCtxt;
 
                 if(ColorCtx != M4OSA_NULL)
                 {
+                    M4VFL_colorLutRelease(&ColorCtx->lut);
                     free(ColorCtx);
                     ColorCtx = M4OSA_NULL;
                 }
@@ -3476,6 +3749,15 @@ M4OSA_ERR M4xVSS_internalGetProperties(M4OSA_Context pContext, M4OSA_Char* pFile
     M4OSA_ERR err;
     M4MCS_Context mcs_context;
 
+    /* An unchanged file does not need to be opened again */
+    if( (xVSS_context->pPropertiesCache != M4OSA_NULL)
+        && (M4VSS3GPP_analysisCacheGet(xVSS_context->pPropertiesCache, pFile,
+        M4VIDEOEDITING_kFileType_3GPP, pFileProperties, xVSS_context->pFileReadPtr)
+        == M4NO_ERROR) )
+    {
+        return M4NO_ERROR;
+    }
+
     err = M4MCS_init(&mcs_context, xVSS_context->pFileReadPtr, xVSS_context->pFileWritePtr);
     if(err != M4NO_ERROR)
     {
@@ -3508,9 +3790,95 @@ M4OSA_ERR M4xVSS_internalGetProperties(M4OSA_Context pContext, M4OSA_Char* pFile
         return err;
     }
 
+    if(xVSS_context->pPropertiesCache != M4OSA_NULL)
+    {
+        /* Not being able to cache the properties is not an error */
+        M4VSS3GPP_analysisCacheSet(xVSS_context->pPropertiesCache, pFile,
+            M4VIDEOEDITING_kFileType_3GPP, pFileProperties, xVSS_context->pFileReadPtr);
+    }
+
     return M4NO_ERROR;
 }
 
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalAnalysisCacheIndex(M4OSA_Context pContext,
+ *                                                          M4OSA_Bool bSave)
+ *
+ * @brief    This function loads or saves the clip analysis and properties caches
+ * @note     The index files are kept in the temporary path, so that the analyses of a
+ *           project are reused when it is opened again. Unchanged files are then
+ *           neither analysed nor opened.
+ * @param    pContext    (IN) The integrator own context
+ * @param    bSave        (IN) M4OSA_TRUE to save the caches, M4OSA_FALSE to load them
+ *
+ * @return    M4NO_ERROR:    No error
+ * @return    Any error returned by the cache load or save (the index files may not
+ *            exist yet)
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalAnalysisCacheIndex(M4OSA_Context pContext, M4OSA_Bool bSave)
+{
+    M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
+    const M4OSA_Char* pIndexName[2] = { (M4OSA_Char*)"clipanalysis.idx",
+                                        (M4OSA_Char*)"clipproperties.idx" };
+    M4OSA_Context pCache[2];
+    M4OSA_Char pIndexFile[M4XVSS_MAX_PATH_LEN];
+    M4OSA_Void* pDecodedPath;
+    M4OSA_UInt32 ConvertedSize = 0;
+    M4OSA_ERR err = M4NO_ERROR;
+    M4OSA_UInt32 i;
+
+    pCache[0] = xVSS_context->pAnalysisCache;
+    pCache[1] = xVSS_context->pPropertiesCache;
+
+    for(i=0; i<2; i++)
+    {
+        if(pCache[i] == M4OSA_NULL)
+        {
+            continue;
+        }
+
+        err = M4OSA_chrSPrintf(pIndexFile, M4XVSS_MAX_PATH_LEN - 1, (M4OSA_Char *)"%s%s",
+            xVSS_context->pTempPath, pIndexName[i]);
+        if(err != M4NO_ERROR)
+        {
+            return err;
+        }
+
+        pDecodedPath = pIndexFile;
+        if(xVSS_context->UTFConversionContext.pConvFromUTF8Fct != M4OSA_NULL
+            && xVSS_context->UTFConversionContext.pTempOutConversionBuffer != M4OSA_NULL)
+        {
+            err = M4xVSS_internalConvertFromUTF8(xVSS_context, (M4OSA_Void*)pIndexFile,
+                (M4OSA_Void*)xVSS_context->UTFConversionContext.pTempOutConversionBuffer,
+                &ConvertedSize);
+            if(err != M4NO_ERROR)
+            {
+                M4OSA_TRACE1_1("M4xVSS_internalAnalysisCacheIndex:\
+                     M4xVSS_internalConvertFromUTF8 returns err: 0x%x", err);
+                return err;
+            }
+            pDecodedPath = xVSS_context->UTFConversionContext.pTempOutConversionBuffer;
+        }
+
+        if(bSave)
+        {
+            err = M4VSS3GPP_analysisCacheSave(pCache[i], pDecodedPath,
+                xVSS_context->pFileWritePtr);
+        }
+        else
+        {
+            err = M4VSS3GPP_analysisCacheLoad(pCache[i], pDecodedPath,
+                xVSS_context->pFileReadPtr);
+        }
+        M4OSA_TRACE2_2("M4xVSS_internalAnalysisCacheIndex: %s returns 0x%x",
+            pIndexName[i], err);
+    }
+
+    return err;
+}
+
 
 /**
  ******************************************************************************
@@ -3628,6 +3996,87 @@ M4OSA_ERR M4xVSS_internalGetTargetedTimeScale(M4OSA_Context pContext,
 }
 
 
+/**
+ ******************************************************************************
+ * prototype    M4OSA_ERR M4xVSS_internalBuildColorLut(M4OSA_Context pContext,
+ *                                                     M4xVSS_ColorStruct* pColorCtx,
+ *                                                     M4VSS3GPP_EffectSettings* pEffect)
+ *
+ * @brief    This function compiles a color effect into lookup tables
+ * @note    Built-in color effects are converted into per plane tables, the color LUT
+ *            effect reads its .cube file. The tables are released in M4xVSS_freeSettings.
+ * @param    pContext    (IN) The integrator own context
+ * @param    pColorCtx    (IN/OUT) Color effect context, colorEffectType and rgb16ColorData
+ *                        must be set
+ * @param    pEffect        (IN) Effect settings (.cube file path for the color LUT effect)
+ *
+ * @return    M4NO_ERROR:    No error
+ * @return    M4ERR_PARAMETER: Unknown color effect or missing .cube file path
+ * @return    Any error returned by M4VFL_colorLutLoadCube
+ ******************************************************************************
+ */
+M4OSA_ERR M4xVSS_internalBuildColorLut(M4OSA_Context pContext, M4xVSS_ColorStruct* pColorCtx,
+                                       M4VSS3GPP_EffectSettings* pEffect)
+{
+    M4xVSS_Context* xVSS_context = (M4xVSS_Context*)pContext;
+    M4OSA_ERR err = M4NO_ERROR;
+    M4OSA_Void* pDecodedPath = M4OSA_NULL;
+
+    switch (pColorCtx->colorEffectType)
+    {
+        case M4xVSS_kVideoEffectType_BlackAndWhite:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_BlackAndWhite, 0);
+        case M4xVSS_kVideoEffectType_Pink:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_Pink, 0);
+        case M4xVSS_kVideoEffectType_Green:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_Green, 0);
+        case M4xVSS_kVideoEffectType_Sepia:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_Sepia, 0);
+        case M4xVSS_kVideoEffectType_Negative:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_Negative, 0);
+        case M4xVSS_kVideoEffectType_ColorRGB16:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_ColorRGB16,
+                pColorCtx->rgb16ColorData);
+        case M4xVSS_kVideoEffectType_Gradient:
+            return M4VFL_colorLutBuild(&pColorCtx->lut, M4VFL_kColorEffect_Gradient,
+                pColorCtx->rgb16ColorData);
+        case M4xVSS_kVideoEffectType_ColorLut:
+            break;
+        default:
+            M4OSA_TRACE1_1("M4xVSS_internalBuildColorLut: unknown color effect %d",
+                pColorCtx->colorEffectType);
+            return M4ERR_PARAMETER;
+    }
+
+    if(pEffect->xVSS.pColorLutFilePath == M4OSA_NULL)
+    {
+        M4OSA_TRACE1_0("M4xVSS_internalBuildColorLut: no LUT file for the color LUT effect");
+        return M4ERR_PARAMETER;
+    }
+
+    /**
+     * UTF conversion: convert the file path into the customer format*/
+    pDecodedPath = pEffect->xVSS.pColorLutFilePath;
+
+    if(xVSS_context->UTFConversionContext.pConvFromUTF8Fct != M4OSA_NULL
+            && xVSS_context->UTFConversionContext.pTempOutConversionBuffer != M4OSA_NULL)
+    {
+        M4OSA_UInt32 length = 0;
+        err = M4xVSS_internalConvertFromUTF8(xVSS_context,
+             (M4OSA_Void*) pEffect->xVSS.pColorLutFilePath,
+             (M4OSA_Void*) xVSS_context->UTFConversionContext.pTempOutConversionBuffer, &length);
+        if(err != M4NO_ERROR)
+        {
+            M4OSA_TRACE1_1("M4xVSS_internalBuildColorLut:\
+                 M4xVSS_internalConvertFromUTF8 returns err: 0x%x",err);
+            return err;
+        }
+        pDecodedPath = xVSS_context->UTFConversionContext.pTempOutConversionBuffer;
+    }
+
+    return M4VFL_colorLutLoadCube(&pColorCtx->lut, pDecodedPath, xVSS_context->pFileReadPtr);
+}
+
 /**
  ******************************************************************************
  * prototype    M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
@@ -3637,7 +4086,7 @@ M4OSA_ERR M4xVSS_internalGetTargetedTimeScale(M4OSA_Context pContext,
  *                                                    M4OSA_UInt32 uiEffectKind)
  *
  * @brief    This function apply a color effect on an input YUV420 planar frame
- * @note
+ * @note    The effect has been compiled into lookup tables by M4xVSS_internalBuildColorLut
  * @param    pFunctionContext(IN) Contains which color to apply (not very clean ...)
  * @param    PlaneIn            (IN) Input YUV420 planar
  * @param    PlaneOut        (IN/OUT) Output YUV420 planar
@@ -3653,141 +4102,9 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectColor(M4OSA_Void *pFunctionContext,
                                              M4VSS3GPP_ExternalProgress *pProgress,
                                              M4OSA_UInt32 uiEffectKind)
 {
-    M4VIFI_Int32 plane_number;
-    M4VIFI_UInt32 i,j;
-    M4VIFI_UInt8 *p_buf_src, *p_buf_dest;
     M4xVSS_ColorStruct* ColorContext = (M4xVSS_ColorStruct*)pFunctionContext;
 
-    for (plane_number = 0; plane_number < 3; plane_number++)
-    {
-        p_buf_src = &(PlaneIn[plane_number].pac_data[PlaneIn[plane_number].u_topleft]);
-        p_buf_dest = &(PlaneOut[plane_number].pac_data[PlaneOut[plane_number].u_topleft]);
-        for (i = 0; i < PlaneOut[plane_number].u_height; i++)
-        {
-            /**
-             * Chrominance */
-            if(plane_number==1 || plane_number==2)
-            {
-                //switch ((M4OSA_UInt32)pFunctionContext)
-                // commented because a structure for the effects context exist
-                switch (ColorContext->colorEffectType)
-                {
-                    case M4xVSS_kVideoEffectType_BlackAndWhite:
-                        memset((void *)p_buf_dest,128,
-                         PlaneIn[plane_number].u_width);
-                        break;
-                    case M4xVSS_kVideoEffectType_Pink:
-                        memset((void *)p_buf_dest,255,
-                         PlaneIn[plane_number].u_width);
-                        break;
-                    case M4xVSS_kVideoEffectType_Green:
-                        memset((void *)p_buf_dest,0,
-                         PlaneIn[plane_number].u_width);
-                        break;
-                    case M4xVSS_kVideoEffectType_Sepia:
-                        if(plane_number==1)
-                        {
-                            memset((void *)p_buf_dest,117,
-                             PlaneIn[plane_number].u_width);
-                        }
-                        else
-                        {
-                            memset((void *)p_buf_dest,139,
-                             PlaneIn[plane_number].u_width);
-                        }
-                        break;
-                    case M4xVSS_kVideoEffectType_Negative:
-                        memcpy((void *)p_buf_dest,
-                         (void *)p_buf_src ,PlaneOut[plane_number].u_width);
-                        break;
-
-                    case M4xVSS_kVideoEffectType_ColorRGB16:
-                        {
-                            M4OSA_UInt16 r = 0,g = 0,b = 0,y = 0,u = 0,v = 0;
-
-                            /*first get the r, g, b*/
-                            b = (ColorContext->rgb16ColorData &  0x001f);
-                            g = (ColorContext->rgb16ColorData &  0x07e0)>>5;
-                            r = (ColorContext->rgb16ColorData &  0xf800)>>11;
-
-                            /*keep y, but replace u and v*/
-                            if(plane_number==1)
-                            {
-                                /*then convert to u*/
-                                u = U16(r, g, b);
-                                memset((void *)p_buf_dest,(M4OSA_UInt8)u,
-                                 PlaneIn[plane_number].u_width);
-                            }
-                            if(plane_number==2)
-                            {
-                                /*then convert to v*/
-                                v = V16(r, g, b);
-                                memset((void *)p_buf_dest, (M4OSA_UInt8)v,
-                                 PlaneIn[plane_number].u_width);
-                            }
-                        }
-                        break;
-                    case M4xVSS_kVideoEffectType_Gradient:
-                        {
-                            M4OSA_UInt16 r = 0,g = 0,b = 0,y = 0,u = 0,v = 0;
-
-                            /*first get the r, g, b*/
-                            b = (ColorContext->rgb16ColorData &  0x001f);
-                            g = (ColorContext->rgb16ColorData &  0x07e0)>>5;
-                            r = (ColorContext->rgb16ColorData &  0xf800)>>11;
-
-                            /*for color gradation*/
-                            b = (M4OSA_UInt16)( b - ((b*i)/PlaneIn[plane_number].u_height));
-                            g = (M4OSA_UInt16)(g - ((g*i)/PlaneIn[plane_number].u_height));
-                            r = (M4OSA_UInt16)(r - ((r*i)/PlaneIn[plane_number].u_height));
-
-                            /*keep y, but replace u and v*/
-                            if(plane_number==1)
-                            {
-                                /*then convert to u*/
-                                u = U16(r, g, b);
-                                memset((void *)p_buf_dest,(M4OSA_UInt8)u,
-                                 PlaneIn[plane_number].u_width);
-                            }
-                            if(plane_number==2)
-                            {
-                                /*then convert to v*/
-                                v = V16(r, g, b);
-                                memset((void *)p_buf_dest,(M4OSA_UInt8)v,
-                                 PlaneIn[plane_number].u_width);
-                            }
-                        }
-                        break;
-                        default:
-                        break;
-                }
-            }
-            /**
-             * Luminance */
-            else
-            {
-                //switch ((M4OSA_UInt32)pFunctionContext)
-                // commented because a structure for the effects context exist
-                switch (ColorContext->colorEffectType)
-                {
-                case M4xVSS_kVideoEffectType_Negative:
-                    for(j=0;j<PlaneOut[plane_number].u_width;j++)
-                    {
-                            p_buf_dest[j] = 255 - p_buf_src[j];
-                    }
-                    break;
-                default:
-                    memcpy((void *)p_buf_dest,
-                     (void *)p_buf_src ,PlaneOut[plane_number].u_width);
-                    break;
-                }
-            }
-            p_buf_src += PlaneIn[plane_number].u_stride;
-            p_buf_dest += PlaneOut[plane_number].u_stride;
-        }
-    }
-
-    return M4VIFI_OK;
+    return M4VFL_colorLutApply(&ColorContext->lut, PlaneIn, PlaneOut);
 }
 
 /**
@@ -4015,11 +4332,12 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties( M4OSA_Void *pUserData,
                                                 M4VSS3GPP_ExternalProgress *pProgress,
                                                 M4OSA_UInt32 uiEffectKind )
 {
-    M4VIFI_UInt32 x, y, xShift;
+    M4VIFI_UInt32 x, xShift;
     M4VIFI_UInt8 *pInY = pPlaneIn[0].pac_data;
     M4VIFI_UInt8 *pOutY, *pInYbegin;
     M4VIFI_UInt8 *pInCr,* pOutCr;
     M4VIFI_Int32 plane_number;
+    M4OSA_Bool bNewRandom = M4OSA_FALSE;
 
     /* Internal context*/
     M4xVSS_FiftiesStruct* p_FiftiesData = (M4xVSS_FiftiesStruct *)pUserData;
@@ -4037,21 +4355,28 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties( M4OSA_Void *pUserData,
     pOutY = pPlaneOut[0].pac_data;
     pInYbegin  = pInY;
 
-    /* Initialize the random */
+    /* Draw new random values at the beginning of the effect, then each time we have
+    reached the duration of a partial effect. The values only depend on the seed and
+    on their rank, so that the effect gives the same output on each run */
     if(p_FiftiesData->previousClipTime < 0)
     {
-        M4OSA_randInit();
-        M4OSA_rand((M4OSA_Int32 *)&(p_FiftiesData->shiftRandomValue), (pPlaneIn[0].u_height) >> 4);
-        M4OSA_rand((M4OSA_Int32 *)&(p_FiftiesData->stripeRandomValue), (pPlaneIn[0].u_width)<< 2);
-        p_FiftiesData->previousClipTime = pProgress->uiOutputTime;
+        p_FiftiesData->randomCounter = 0;
+        bNewRandom = M4OSA_TRUE;
     }
-
-    /* Choose random values if we have reached the duration of a partial effect */
     else if( (pProgress->uiOutputTime - p_FiftiesData->previousClipTime)\
          > p_FiftiesData->fiftiesEffectDuration)
     {
-        M4OSA_rand((M4OSA_Int32 *)&(p_FiftiesData->shiftRandomValue), (pPlaneIn[0].u_height) >> 4);
-        M4OSA_rand((M4OSA_Int32 *)&(p_FiftiesData->stripeRandomValue), (pPlaneIn[0].u_width)<< 2);
+        bNewRandom = M4OSA_TRUE;
+    }
+
+    if (M4OSA_TRUE == bNewRandom)
+    {
+        M4OSA_randCounter((M4OSA_Int32 *)&(p_FiftiesData->shiftRandomValue),
+            (pPlaneIn[0].u_height) >> 4, p_FiftiesData->randomSeed,
+            p_FiftiesData->randomCounter++);
+        M4OSA_randCounter((M4OSA_Int32 *)&(p_FiftiesData->stripeRandomValue),
+            (pPlaneIn[0].u_width)<< 2, p_FiftiesData->randomSeed,
+            p_FiftiesData->randomCounter++);
         p_FiftiesData->previousClipTime = pProgress->uiOutputTime;
     }
 
@@ -4076,7 +4401,7 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties( M4OSA_Void *pUserData,
     /* Compute the new pixels values */
     for( x = 0 ; x < pPlaneIn[0].u_height ; x++)
     {
-        M4VIFI_UInt8 *p_outYtmp, *p_inYtmp;
+        M4VIFI_UInt8 *p_inYtmp;
 
         /* Compute the xShift (random value) */
         if (0 == (p_FiftiesData->shiftRandomValue % 5 ))
@@ -4085,29 +4410,22 @@ M4OSA_ERR M4VSS3GPP_externalVideoEffectFifties( M4OSA_Void *pUserData,
             xShift = (x + (pPlaneIn[0].u_height - p_FiftiesData->shiftRandomValue) ) \
                 % (pPlaneIn[0].u_height - 1);
 
-        /* Initialize the pointers */
-        p_outYtmp = pOutY + 1;                                    /* yShift of 1 pixel */
         p_inYtmp  = pInYbegin + (xShift * pPlaneIn[0].u_stride);  /* Apply the xShift */
 
-        for( y = 0 ; y < pPlaneIn[0].u_width ; y++)
+        if (xShift > (pPlaneIn[0].u_height - 4))
         {
-            /* Set Y value */
-            if (xShift > (pPlaneIn[0].u_height - 4))
-                *p_outYtmp = 40;        /* Add some horizontal black lines between the
-                                        two parts of the image */
-            else if ( y == p_FiftiesData->stripeRandomValue)
-                *p_outYtmp = 90;        /* Add a random vertical line for the bulk */
-            else
-                *p_outYtmp = *p_inYtmp;
-
-
-            /* Go to the next pixel */
-            p_outYtmp++;
-            p_inYtmp++;
+            /* Add some horizontal black lines between the two parts of the image */
+            memset((void *)pOutY, 40, pPlaneIn[0].u_width);
+        }
+        else
+        {
+            /* yShift of 1 pixel, the last pixel of the line goes to the beginning */
+            memcpy((void *)(pOutY + 1), (void *)p_inYtmp, pPlaneIn[0].u_width - 1);
+            pOutY[0] = p_inYtmp[pPlaneIn[0].u_width - 1];
 
-            /* Restart at the beginning of the line for the last pixel*/
-            if (y == (pPlaneIn[0].u_width - 2))
-                p_outYtmp = pOutY;
+            /* Add a random vertical line for the bulk */
+            if (p_FiftiesData->stripeRandomValue < pPlaneIn[0].u_width)
+                pOutY[(p_FiftiesData->stripeRandomValue + 1) % pPlaneIn[0].u_width] = 90;
         }
 
         /* Go to the next line */
@@ -4442,21 +4760,19 @@ M4OSA_ERR M4xVSS_AlphaMagicBlending( M4OSA_Void *userData, M4VIFI_ImagePlane Pla
 #define M4XXX_SampleAddress(plane, x, y)  ( (plane).pac_data + (plane).u_topleft + (y)\
      * (plane).u_stride + (x) )
 
-static void M4XXX_CopyPlane(M4VIFI_ImagePlane* dest, M4VIFI_ImagePlane* source)
+/* Copies "height" rows of "width" bytes. When neither plane has padding at the end of its
+rows, the rows are contiguous and a single memcpy is done for the whole block. */
+static void M4XXX_CopyRows(M4OSA_MemAddr8 destWalk, M4OSA_UInt32 destStride,
+                           M4OSA_MemAddr8 sourceWalk, M4OSA_UInt32 sourceStride,
+                           M4OSA_UInt32 width, M4OSA_UInt32 height)
 {
-    M4OSA_UInt32    height, width, sourceStride, destStride, y;
-    M4OSA_MemAddr8    sourceWalk, destWalk;
-
-    /* cache the vars used in the loop so as to avoid them being repeatedly fetched and
-     recomputed from memory. */
-    height = dest->u_height;
-    width = dest->u_width;
+    M4OSA_UInt32 y;
 
-    sourceWalk = (M4OSA_MemAddr8)M4XXX_SampleAddress(*source, 0, 0);
-    sourceStride = source->u_stride;
-
-    destWalk = (M4OSA_MemAddr8)M4XXX_SampleAddress(*dest, 0, 0);
-    destStride = dest->u_stride;
+    if ((destStride == width) && (sourceStride == width))
+    {
+        memcpy((void *)destWalk, (void *)sourceWalk, width * height);
+        return;
+    }
 
     for (y=0; y<height; y++)
     {
@@ -4466,6 +4782,13 @@ static void M4XXX_CopyPlane(M4VIFI_ImagePlane* dest, M4VIFI_ImagePlane* source)
     }
 }
 
+static void M4XXX_CopyPlane(M4VIFI_ImagePlane* dest, M4VIFI_ImagePlane* source)
+{
+    M4XXX_CopyRows((M4OSA_MemAddr8)M4XXX_SampleAddress(*dest, 0, 0), dest->u_stride,
+        (M4OSA_MemAddr8)M4XXX_SampleAddress(*source, 0, 0), source->u_stride,
+        dest->u_width, dest->u_height);
+}
+
 static M4OSA_ERR M4xVSS_VerticalSlideTransition(M4VIFI_ImagePlane* topPlane,
                                                 M4VIFI_ImagePlane* bottomPlane,
                                                 M4VIFI_ImagePlane *PlaneOut,
@@ -4477,11 +4800,8 @@ static M4OSA_ERR M4xVSS_VerticalSlideTransition(M4VIFI_ImagePlane* topPlane,
     "hot" at the same time (better for cache). */
     for (i=0; i<3; i++)
     {
-        M4OSA_UInt32    topPartHeight, bottomPartHeight, width, sourceStride, destStride, y;
-        M4OSA_MemAddr8    sourceWalk, destWalk;
+        M4OSA_UInt32    topPartHeight, bottomPartHeight, width;
 
-        /* cache the vars used in the loop so as to avoid them being repeatedly fetched and
-         recomputed from memory. */
         if (0 == i) /* Y plane */
         {
             bottomPartHeight = 2*shiftUV;
@@ -4493,32 +4813,17 @@ static M4OSA_ERR M4xVSS_VerticalSlideTransition(M4VIFI_ImagePlane* topPlane,
         topPartHeight = PlaneOut[i].u_height - bottomPartHeight;
         width = PlaneOut[i].u_width;
 
-        sourceWalk = (M4OSA_MemAddr8)M4XXX_SampleAddress(topPlane[i], 0, bottomPartHeight);
-        sourceStride = topPlane[i].u_stride;
-
-        destWalk = (M4OSA_MemAddr8)M4XXX_SampleAddress(PlaneOut[i], 0, 0);
-        destStride = PlaneOut[i].u_stride;
-
         /* First the part from the top source clip frame. */
-        for (y=0; y<topPartHeight; y++)
-        {
-            memcpy((void *)destWalk, (void *)sourceWalk, width);
-            destWalk += destStride;
-            sourceWalk += sourceStride;
-        }
-
-        /* and now change the vars to copy the part from the bottom source clip frame. */
-        sourceWalk = (M4OSA_MemAddr8)M4XXX_SampleAddress(bottomPlane[i], 0, 0);
-        sourceStride = bottomPlane[i].u_stride;
-
-        /* destWalk is already at M4XXX_SampleAddress(PlaneOut[i], 0, topPartHeight) */
-
-        for (y=0; y<bottomPartHeight; y++)
-        {
-            memcpy((void *)destWalk, (void *)sourceWalk, width);
-            destWalk += destStride;
-            sourceWalk += sourceStride;
-        }
+        M4XXX_CopyRows((M4OSA_MemAddr8)M4XXX_SampleAddress(PlaneOut[i], 0, 0),
+            PlaneOut[i].u_stride,
+            (M4OSA_MemAddr8)M4XXX_SampleAddress(topPlane[i], 0, bottomPartHeight),
+            topPlane[i].u_stride, width, topPartHeight);
+
+        /* and now the part from the bottom source clip frame. */
+        M4XXX_CopyRows((M4OSA_MemAddr8)M4XXX_SampleAddress(PlaneOut[i], 0, topPartHeight),
+            PlaneOut[i].u_stride,
+            (M4OSA_MemAddr8)M4XXX_SampleAddress(bottomPlane[i], 0, 0),
+            bottomPlane[i].u_stride, width, bottomPartHeight);
     }
     return M4NO_ERROR;
 }
@@ -4690,7 +4995,7 @@ M4OSA_ERR M4xVSS_FadeBlackTransition(M4OSA_Void *userData, M4VIFI_ImagePlane Pla
     {
         /**
          * Compute where we are in the effect (scale is 0->1024) */
-        tmp = (M4OSA_Int32)((1.0 - ((M4OSA_Float)(pProgress->uiProgress*2)/1000)) * 1024 );
+        tmp = (M4OSA_Int32)(((1000 - pProgress->uiProgress*2) << 10) / 1000);
 
         /**
          * Apply the darkening effect */
@@ -4707,7 +5012,7 @@ M4OSA_ERR M4xVSS_FadeBlackTransition(M4OSA_Void *userData, M4VIFI_ImagePlane Pla
     {
         /**
          * Compute where we are in the effect (scale is 0->1024). */
-        tmp = (M4OSA_Int32)( (((M4OSA_Float)(((pProgress->uiProgress-500)*2))/1000)) * 1024 );
+        tmp = (M4OSA_Int32)((((pProgress->uiProgress-500)*2) << 10) / 1000);
 
         /**
          * Apply the darkening effect */
@@ -68,6 +68,8 @@ typedef struct {
     VIDEOEDITOR_BUFFER_Buffer* pNXPBuffer;
     M4OSA_UInt32 NB;
     M4OSA_Char* poolName;
+    M4OSA_UInt32 head;              /**< Index of the oldest filled buffer (ring use) */
+    M4OSA_UInt32 count;             /**< Number of filled buffers (ring use) */
 } VIDEOEDITOR_BUFFER_Pool;
 
 #ifdef __cplusplus
@@ -125,6 +127,58 @@ M4OSA_ERR VIDEOEDITOR_BUFFER_getOldestBuffer(VIDEOEDITOR_BUFFER_Pool *pool,
         VIDEOEDITOR_BUFFER_State desiredState,
         VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer);
 
+/**
+ ************************************************************************
+ M4OSA_ERR VIDEOEDITOR_BUFFER_pushBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+ *         M4_MediaTime cts, VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer)
+ * @brief   Returns the buffer to fill with the frame of time stamp cts
+ * @note    The pool is used as a ring of filled buffers ordered by time
+ *          stamp. When the ring is full, the oldest buffer is reused. The
+ *          buffers whose time stamp is not lower than cts (backward jump)
+ *          are dropped first, so that the ring stays ordered.
+ *
+ * @param   pool       : IN The buffer pool
+ * @param   cts        : IN The time stamp of the new frame
+ * @param   pNXPBuffer : OUT The buffer to fill, already in filled state
+ * @return  Error code
+ ************************************************************************
+*/
+M4OSA_ERR VIDEOEDITOR_BUFFER_pushBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime cts, VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer);
+
+/**
+ ************************************************************************
+ M4OSA_Void VIDEOEDITOR_BUFFER_releaseOlderBuffers(VIDEOEDITOR_BUFFER_Pool* pool,
+ *         M4_MediaTime cts)
+ * @brief   Empties the buffers of the ring whose time stamp is lower than cts
+ *
+ * @param   pool       : IN The buffer pool
+ * @param   cts        : IN The oldest time stamp to keep
+ ************************************************************************
+*/
+M4OSA_Void VIDEOEDITOR_BUFFER_releaseOlderBuffers(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime cts);
+
+/**
+ ************************************************************************
+ M4OSA_ERR VIDEOEDITOR_BUFFER_getNewestBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+ *         M4_MediaTime minCts, M4_MediaTime maxCts,
+ *         VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer)
+ * @brief   Returns the filled buffer of the ring with the highest time stamp
+ *          in [minCts, maxCts]
+ * @note    The ring is searched from its newest buffer.
+ *
+ * @param   pool       : IN The buffer pool
+ * @param   minCts     : IN The lowest accepted time stamp
+ * @param   maxCts     : IN The highest accepted time stamp
+ * @param   pNXPBuffer : OUT The selected buffer
+ * @return  Error code, M4ERR_NO_BUFFER_MATCH if no buffer is in the range
+ ************************************************************************
+*/
+M4OSA_ERR VIDEOEDITOR_BUFFER_getNewestBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime minCts, M4_MediaTime maxCts,
+        VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer);
+
 #ifdef __cplusplus
 }
 #endif //__cplusplus
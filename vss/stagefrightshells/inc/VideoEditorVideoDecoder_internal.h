@@ -53,6 +53,15 @@
 #define VIDEOEDITOR_VIDEC_SHELL_VER_REVISION  1
 
 /* ERRORS */
+/**
+ * A jump less than this far (in ms) ahead of the last decoded frame keeps
+ * decoding forward instead of seeking back to the previous sync sample */
+#define VIDEOEDITOR_VIDEC_FORWARD_JUMP_MAX_MS 500
+
+/**
+ * Number of frames the software decoder decodes ahead on its own thread */
+#define VIDEOEDITOR_VIDEC_DECODE_AHEAD_FRAMES 4
+
 #define M4ERR_SF_DECODER_RSRC_FAIL M4OSA_ERR_CREATE(M4_ERR, 0xFF, 0x0001)
 
 namespace android {
@@ -73,6 +82,8 @@ typedef enum {
 
 typedef M4VS_Bitstream_ctxt VIDEOEDITOR_VIDEO_Bitstream_ctxt;
 
+class VideoEditorVideoDecoderPuller;
+
 typedef struct {
 
     /** Stagefrigth params */
@@ -110,10 +121,21 @@ typedef struct {
     M4OSA_UInt32            mNbOutputFrames;
     M4OSA_Double            mFirstOutputCts;
     M4OSA_Double            mLastOutputCts;
+    M4_MediaTime            mSkipNonRefUpToCts; /**< Non reference AUs before this
+                                                     CTS are not decoded, -1 if none */
+    M4OSA_UInt32            mNbSkippedFrames;
+    M4OSA_UInt32            mNbForwardJumps;
+    M4OSA_Int32             mLastRapDistance; /**< Target of the last jump minus the
+                                                   time decoding restarted from, in ms,
+                                                   see M4DECODER_kOptionID_PrevRapDistance */
+    M4OSA_Bool              mReaderMoved; /**< The caller used the reader since the
+                                               last decode, a jump has to seek */
     M4OSA_Int32             mGivenWidth, mGivenHeight; //Used in case of
                                                        //INFO_FORMAT_CHANGED
     ARect                   mCropRect;  // These are obtained from kKeyCropRect.
     I420ColorConverter*     mI420ColorConverter;
+    VideoEditorVideoDecoderPuller* mPuller; /**< Decode ahead thread, software
+                                                 decoder only, else NULL */
 
 } VideoEditorVideoDecoder_Context;
 
@@ -97,6 +97,8 @@ M4OSA_ERR VIDEOEDITOR_BUFFER_allocatePool(VIDEOEDITOR_BUFFER_Pool** ppool,
         VIDEOEDITOR_BUFFEPOOL_MAX_NAME_SIZE-1);
 
     pool->NB = nbBuffers;
+    pool->head = 0;
+    pool->count = 0;
 
 VIDEOEDITOR_BUFFER_allocatePool_Cleanup:
     if(M4NO_ERROR != lerr)
@@ -231,6 +233,8 @@ M4OSA_ERR VIDEOEDITOR_BUFFER_initPoolBuffers(VIDEOEDITOR_BUFFER_Pool* pool,
         pool->pNXPBuffer[index].idx = index;
         pool->pNXPBuffer[index].buffCTS = -1;
     }
+    pool->head = 0;
+    pool->count = 0;
     return err;
 }
 
@@ -263,3 +267,72 @@ M4OSA_ERR VIDEOEDITOR_BUFFER_getOldestBuffer(VIDEOEDITOR_BUFFER_Pool *pool,
     }
     return err;
 }
+
+M4OSA_ERR VIDEOEDITOR_BUFFER_pushBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime cts, VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer)
+{
+    VIDEOEDITOR_BUFFER_Buffer* pBuffer;
+
+    /* Keep the ring ordered: drop the newer buffers after a backward jump */
+    while (pool->count > 0)
+    {
+        pBuffer = &(pool->pNXPBuffer[(pool->head + pool->count - 1) % pool->NB]);
+        if (pBuffer->buffCTS < cts)
+        {
+            break;
+        }
+        pBuffer->state = VIDEOEDITOR_BUFFER_kEmpty;
+        pool->count--;
+    }
+
+    /* Reuse the oldest buffer if the ring is full */
+    if (pool->count == pool->NB)
+    {
+        pool->pNXPBuffer[pool->head].state = VIDEOEDITOR_BUFFER_kEmpty;
+        pool->head = (pool->head + 1) % pool->NB;
+        pool->count--;
+    }
+
+    pBuffer = &(pool->pNXPBuffer[(pool->head + pool->count) % pool->NB]);
+    pBuffer->buffCTS = cts;
+    pBuffer->state = VIDEOEDITOR_BUFFER_kFilled;
+    pool->count++;
+
+    *pNXPBuffer = pBuffer;
+    return M4NO_ERROR;
+}
+
+M4OSA_Void VIDEOEDITOR_BUFFER_releaseOlderBuffers(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime cts)
+{
+    while ((pool->count > 0) && (pool->pNXPBuffer[pool->head].buffCTS < cts))
+    {
+        pool->pNXPBuffer[pool->head].state = VIDEOEDITOR_BUFFER_kEmpty;
+        pool->head = (pool->head + 1) % pool->NB;
+        pool->count--;
+    }
+}
+
+M4OSA_ERR VIDEOEDITOR_BUFFER_getNewestBuffer(VIDEOEDITOR_BUFFER_Pool* pool,
+        M4_MediaTime minCts, M4_MediaTime maxCts,
+        VIDEOEDITOR_BUFFER_Buffer** pNXPBuffer)
+{
+    VIDEOEDITOR_BUFFER_Buffer* pBuffer;
+    M4OSA_UInt32 i;
+
+    *pNXPBuffer = M4OSA_NULL;
+    for (i = pool->count; i > 0; i--)
+    {
+        pBuffer = &(pool->pNXPBuffer[(pool->head + i - 1) % pool->NB]);
+        if (pBuffer->buffCTS < minCts)
+        {
+            break;
+        }
+        if (pBuffer->buffCTS <= maxCts)
+        {
+            *pNXPBuffer = pBuffer;
+            return M4NO_ERROR;
+        }
+    }
+    return M4ERR_NO_BUFFER_MATCH;
+}
@@ -25,6 +25,7 @@
 #include "utils/Log.h"
 
 #include "VideoEditorUtils.h"
+#include "M4VD_Tools.h"
 
 #include <media/stagefright/MediaErrors.h>
 #include <media/stagefright/MediaDebug.h>
@@ -221,15 +222,12 @@ const uint8_t *parseParamSet(AVCCodecSpecificContext* pC,
     CHECK(type == kNalUnitTypeSeqParamSet ||
           type == kNalUnitTypePicParamSet);
 
-    size_t bytesLeft = length;
-    while (bytesLeft > 4  &&
-            memcmp("\x00\x00\x00\x01", &data[length - bytesLeft], 4)) {
-        --bytesLeft;
+    M4OSA_UInt32 startCodeSize;
+    const uint8_t *nextStartCode = M4VD_Tools_FindStartCode(
+        (M4OSA_UInt8 *)data, length, &startCodeSize);
+    if (nextStartCode == NULL) {
+        nextStartCode = &data[length]; // Last parameter set
     }
-    if (bytesLeft <= 4) {
-        bytesLeft = 0; // Last parameter set
-    }
-    const uint8_t *nextStartCode = &data[length - bytesLeft];
     *paramSetLen = nextStartCode - data;
     if (*paramSetLen == 0) {
         LOGE("Param set is malformed, since its length is 0");
@@ -308,9 +306,11 @@ status_t buildAVCCodecSpecificData(uint8_t **pOutputData, size_t *pOutputSize,
     const uint8_t *nextStartCode = data;
     size_t bytesLeft = size;
     size_t paramSetLen = 0;
+    M4OSA_UInt32 startCodeSize = 4;
     outputSize = 0;
-    while (bytesLeft > 4 && !memcmp("\x00\x00\x00\x01", tmp, 4)) {
-        type = (*(tmp + 4)) & 0x1F;
+    while (bytesLeft > 4 && tmp == M4VD_Tools_FindStartCode(
+            (M4OSA_UInt8 *)tmp, bytesLeft, &startCodeSize)) {
+        type = (*(tmp + startCodeSize)) & 0x1F;
         if (type == kNalUnitTypeSeqParamSet) {
             if (gotPps) {
                 LOGE("SPS must come before PPS");
@@ -319,8 +319,8 @@ status_t buildAVCCodecSpecificData(uint8_t **pOutputData, size_t *pOutputSize,
             if (!gotSps) {
                 gotSps = true;
             }
-            nextStartCode = parseParamSet(&ctx, tmp + 4, bytesLeft - 4, type,
-                &paramSetLen);
+            nextStartCode = parseParamSet(&ctx, tmp + startCodeSize,
+                bytesLeft - startCodeSize, type, &paramSetLen);
         } else if (type == kNalUnitTypePicParamSet) {
             if (!gotSps) {
                 LOGE("SPS must come before PPS");
@@ -329,8 +329,8 @@ status_t buildAVCCodecSpecificData(uint8_t **pOutputData, size_t *pOutputSize,
             if (!gotPps) {
                 gotPps = true;
             }
-            nextStartCode = parseParamSet(&ctx, tmp + 4, bytesLeft - 4, type,
-                &paramSetLen);
+            nextStartCode = parseParamSet(&ctx, tmp + startCodeSize,
+                bytesLeft - startCodeSize, type, &paramSetLen);
         } else {
             LOGE("Only SPS and PPS Nal units are expected");
             return ERROR_MALFORMED;
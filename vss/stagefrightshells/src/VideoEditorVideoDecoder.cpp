@@ -28,10 +28,12 @@
 #include "VideoEditorVideoDecoder_internal.h"
 #include "VideoEditorUtils.h"
 #include "M4VD_Tools.h"
+#include "M4SYS_AccessUnit.h"
 
 #include <media/stagefright/MetaData.h>
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MediaDebug.h>
+#include "utils/Vector.h"
 /********************
  *   DEFINITIONS    *
  ********************/
@@ -43,7 +45,7 @@
 using namespace android;
 static M4OSA_ERR copyBufferToQueue(
     VideoEditorVideoDecoder_Context* pDecShellContext,
-    MediaBuffer* pDecodedBuffer);
+    MediaBuffer* pDecodedBuffer, M4_MediaTime cts);
 
 class VideoEditorVideoDecoderSource : public MediaSource {
     public:
@@ -144,6 +146,40 @@ sp<MetaData> VideoEditorVideoDecoderSource::getFormat() {
     return mFormat;
 }
 
+/**
+ * Tells if an AU is not used as a reference by any other frame, so that it
+ * can be dropped when it is before the CTS a jump has to render.
+ * Only the first NAL of an H264 AU is looked at (the reader gives one length
+ * prefix per AU); an AU which does not start with a slice is kept.
+ */
+static bool VideoEditorVideoDecoder_isNonReferenceAu(
+        VIDEOEDITOR_CodecType codecType, M4_AccessUnit* pAccessUnit) {
+    const uint8_t *data = (const uint8_t *)pAccessUnit->m_dataAddress;
+    M4OSA_UInt32 size = pAccessUnit->m_size;
+
+    if (AU_RAP == (pAccessUnit->m_attribute & AU_RAP)) {
+        return false;
+    }
+    if (VIDEOEDITOR_kH264VideoDec == codecType) {
+        if (size < 5) {
+            return false;
+        }
+        uint8_t nalType = data[4] & 0x1F;
+        // Non IDR slice with nal_ref_idc equal to 0
+        return ((1 == nalType) && (0 == ((data[4] >> 5) & 0x3)));
+    }
+    if (VIDEOEDITOR_kMpeg4VideoDec == codecType) {
+        for (M4OSA_UInt32 i = 0; i + 4 < size; i++) {
+            if (data[i] == 0 && data[i+1] == 0 && data[i+2] == 1 &&
+                data[i+3] == 0xB6) {
+                // vop_coding_type 2 is a B-VOP
+                return ((data[i+4] >> 6) == 2);
+            }
+        }
+    }
+    return false;
+}
+
 status_t VideoEditorVideoDecoderSource::read(MediaBuffer** buffer_out,
         const ReadOptions *options) {
 
@@ -174,6 +210,9 @@ status_t VideoEditorVideoDecoderSource::read(MediaBuffer** buffer_out,
             LOGE("get rap time error = 0x%x\n", (uint32_t)err);
             return UNKNOWN_ERROR;
         }
+        mpDecShellContext->mLastRapDistance = (M4OSA_Int32)(time_us / 1000) - rapTime;
+        LOGV("VideoDecoderSource::read seek to %lld ms, previous RAP %d ms before",
+            time_us / 1000, mpDecShellContext->mLastRapDistance);
 
         err = mpDecShellContext->m_pReaderGlobal->m_pFctJump(
                    mpDecShellContext->m_pReader->m_readerContext,
@@ -197,13 +236,25 @@ status_t VideoEditorVideoDecoderSource::read(MediaBuffer** buffer_out,
     if (mStarted) {
         //getNext AU from reader.
         M4_AccessUnit* pAccessUnit = mpDecShellContext->m_pNextAccessUnitToDecode;
-        lerr = mpDecShellContext->m_pReader->m_pFctGetNextAu(
-                   mpDecShellContext->m_pReader->m_readerContext,
-                   (M4_StreamHandler*)mpDecShellContext->m_pVideoStreamhandler,
-                   pAccessUnit);
-        if (lerr == M4WAR_NO_DATA_YET || lerr == M4WAR_NO_MORE_AU) {
-            *buffer_out = NULL;
-            return ERROR_END_OF_STREAM;
+        for (;;) {
+            lerr = mpDecShellContext->m_pReader->m_pFctGetNextAu(
+                       mpDecShellContext->m_pReader->m_readerContext,
+                       (M4_StreamHandler*)mpDecShellContext->m_pVideoStreamhandler,
+                       pAccessUnit);
+            if (lerr == M4WAR_NO_DATA_YET || lerr == M4WAR_NO_MORE_AU) {
+                *buffer_out = NULL;
+                return ERROR_END_OF_STREAM;
+            }
+            // While decoding up to a jump target, frames that are neither
+            // rendered nor referenced need not be decoded at all
+            if (pAccessUnit->m_CTS >= mpDecShellContext->mSkipNonRefUpToCts ||
+                !VideoEditorVideoDecoder_isNonReferenceAu(mCodecType,
+                    pAccessUnit)) {
+                break;
+            }
+            LOGV("VideoDecoderSource::read skip non reference AU CTS = %lf",
+                pAccessUnit->m_CTS);
+            mpDecShellContext->mNbSkippedFrames++;
         }
 
         //copy the reader AU buffer to mBuffer
@@ -225,12 +276,247 @@ status_t VideoEditorVideoDecoderSource::read(MediaBuffer** buffer_out,
             data[3]=1;
         }
         mBuffer->meta_data()->setInt32(kKeyIsSyncFrame,
-            (pAccessUnit->m_attribute == 0x04)? 1 : 0);
+            (AU_RAP == (pAccessUnit->m_attribute & AU_RAP))? 1 : 0);
         *buffer_out = mBuffer;
     }
     return OK;
 }
 
+/********************
+ *      PULLER      *
+ ********************/
+
+// Decodes ahead of the user on a dedicated thread: up to maxBuffers decoded
+// buffers are read from the decoder while the user is busy elsewhere.
+// The source reads the caller reader, so the thread only runs between start()
+// and pause(): the user pauses it before using the reader itself. A read with
+// a seek option pauses the thread and drops the buffers decoded ahead, then
+// seeks from the calling thread. While paused, or if the thread could not be
+// created, reads are done on the calling thread.
+class VideoEditorVideoDecoderPuller {
+public:
+    VideoEditorVideoDecoderPuller(sp<MediaSource> source, size_t maxBuffers);
+    ~VideoEditorVideoDecoderPuller();
+    status_t initCheck() const;
+    void start();
+    void pause();
+    void stop();
+    status_t read(MediaBuffer** buffer,
+        const MediaSource::ReadOptions* options = NULL);
+private:
+    static int threadStart(void* arg);
+    void threadFunc();
+    void releaseBuffers();
+
+    sp<MediaSource> mSource;
+    size_t mMaxBuffers;
+    Vector<MediaBuffer*> mBuffers;
+
+    Mutex mLock;
+    Condition mUserCond;    // for the user of this class
+    Condition mThreadCond;  // for the decoding thread
+
+    bool mRunning;         // The thread may read ahead (between start and pause)
+    bool mAskToStop;       // Asks the thread to stop
+    bool mReading;         // The thread is reading from the source
+    bool mStopped;         // The thread has stopped, or was never created
+    status_t mInitCheck;   // NO_INIT if the thread could not be created
+    status_t mSourceError; // Error returned by MediaSource read, after mBuffers
+};
+
+VideoEditorVideoDecoderPuller::VideoEditorVideoDecoderPuller(
+    sp<MediaSource> source, size_t maxBuffers) {
+    mSource = source;
+    mMaxBuffers = maxBuffers;
+    mRunning = false;
+    mAskToStop = false;
+    mReading = false;
+    mStopped = false;
+    mInitCheck = OK;
+    mSourceError = OK;
+    if (0 == androidCreateThread(threadStart, this)) {
+        LOGE("VideoEditorVideoDecoderPuller: unable to create the thread");
+        mStopped = true;
+        mInitCheck = NO_INIT;
+    }
+}
+
+VideoEditorVideoDecoderPuller::~VideoEditorVideoDecoderPuller() {
+    stop();
+}
+
+status_t VideoEditorVideoDecoderPuller::initCheck() const {
+    return mInitCheck;
+}
+
+void VideoEditorVideoDecoderPuller::start() {
+    Mutex::Autolock autolock(mLock);
+    if (!mStopped) {
+        mRunning = true;
+        mThreadCond.signal();
+    }
+}
+
+// Returns once the thread has left the source, the buffers decoded ahead are
+// dropped. A pending format change is kept for the next read.
+void VideoEditorVideoDecoderPuller::pause() {
+    mLock.lock();
+    mRunning = false;
+    mLock.unlock();
+    releaseBuffers();
+    mLock.lock();
+    while (mReading) {
+        mUserCond.wait(mLock);
+    }
+    mLock.unlock();
+    releaseBuffers();
+}
+
+void VideoEditorVideoDecoderPuller::stop() {
+    mLock.lock();
+    mRunning = false;
+    mAskToStop = true;
+    mThreadCond.signal();
+    mLock.unlock();
+
+    // A read blocked on the decoder output returns once buffers are released
+    releaseBuffers();
+
+    mLock.lock();
+    while (!mStopped) {
+        mUserCond.wait(mLock);
+    }
+    mLock.unlock();
+    releaseBuffers();
+}
+
+// Releases the buffers decoded ahead, outside of the lock since the decoder
+// is called back.
+void VideoEditorVideoDecoderPuller::releaseBuffers() {
+    Vector<MediaBuffer*> buffers;
+
+    mLock.lock();
+    buffers = mBuffers;
+    mBuffers.clear();
+    mThreadCond.signal();
+    mLock.unlock();
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+        buffers.itemAt(i)->release();
+    }
+}
+
+status_t VideoEditorVideoDecoderPuller::read(MediaBuffer** buffer,
+        const MediaSource::ReadOptions* options) {
+    status_t result;
+
+    *buffer = NULL;
+    if (options == NULL) {
+        mLock.lock();
+        while (mRunning && mBuffers.empty() && (mSourceError == OK) &&
+            !mStopped) {
+            mUserCond.wait(mLock);
+        }
+        if (!mBuffers.empty()) {
+            *buffer = mBuffers.itemAt(0);
+            mBuffers.removeAt(0);
+            mThreadCond.signal();
+            mLock.unlock();
+            return OK;
+        }
+        if (mSourceError != OK) {
+            result = mSourceError;
+            if (result == INFO_FORMAT_CHANGED) {
+                // Keep decoding with the new format
+                mSourceError = OK;
+                mThreadCond.signal();
+            }
+            mLock.unlock();
+            return result;
+        }
+        mLock.unlock();
+
+        // Not reading ahead: the thread is out of the source
+        return mSource->read(buffer, NULL);
+    }
+
+    // Seek: the buffers decoded ahead are out of date. The thread stays
+    // paused until the user starts it again.
+    pause();
+    mLock.lock();
+    bool formatChanged = (mSourceError == INFO_FORMAT_CHANGED);
+    mSourceError = OK;
+    mLock.unlock();
+
+    result = mSource->read(buffer, options);
+
+    if (formatChanged && (result == OK)) {
+        // Report the format change first, the buffer is given next
+        mLock.lock();
+        mBuffers.push(*buffer);
+        mLock.unlock();
+        *buffer = NULL;
+        result = INFO_FORMAT_CHANGED;
+    }
+    return result;
+}
+
+int VideoEditorVideoDecoderPuller::threadStart(void* arg) {
+    VideoEditorVideoDecoderPuller* self = (VideoEditorVideoDecoderPuller*)arg;
+    self->threadFunc();
+    return 0;
+}
+
+void VideoEditorVideoDecoderPuller::threadFunc() {
+    mLock.lock();
+
+    // Loop until we are asked to stop, staying ahead of the user while running
+    while (!mAskToStop) {
+        if (!mRunning || (mSourceError != OK) ||
+            (mBuffers.size() >= mMaxBuffers)) {
+            mThreadCond.wait(mLock);
+            continue;
+        }
+        MediaBuffer* pBuffer = NULL;
+        mReading = true;
+        mLock.unlock();
+        status_t result = mSource->read(&pBuffer, NULL);
+        mLock.lock();
+        mReading = false;
+        if (!mRunning || mAskToStop) {
+            // Decoded while the user was pausing or stopping, drop it
+            if (result == OK) {
+                mLock.unlock();
+                pBuffer->release();
+                mLock.lock();
+            } else if (result == INFO_FORMAT_CHANGED) {
+                mSourceError = result;
+            }
+            mUserCond.signal();
+            continue;
+        }
+        if (result == OK) {
+            mBuffers.push(pBuffer);
+        } else {
+            mSourceError = result;
+        }
+        mUserCond.signal();
+    }
+
+    mStopped = true;
+    mUserCond.signal();
+    mLock.unlock();
+}
+
+static status_t VideoEditorVideoDecoder_read(
+        VideoEditorVideoDecoder_Context* pDecShellContext,
+        MediaBuffer** buffer, const MediaSource::ReadOptions* options = NULL) {
+    if (NULL != pDecShellContext->mPuller) {
+        return pDecShellContext->mPuller->read(buffer, options);
+    }
+    return pDecShellContext->mVideoDecoder->read(buffer, options);
+}
+
 static M4OSA_UInt32 VideoEditorVideoDecoder_GetBitsFromMemory(
         VIDEOEDITOR_VIDEO_Bitstream_ctxt* parsingCtxt, M4OSA_UInt32 nb_bits) {
     return (M4VD_Tools_GetBitsFromMemory((M4VS_Bitstream_ctxt*) parsingCtxt,
@@ -886,6 +1172,15 @@ M4OSA_ERR VideoEditorVideoDecoder_destroy(M4OSA_Context pContext) {
     // Input parameters check
     LOGV("VideoEditorVideoDecoder_destroy begin");
     VIDEOEDITOR_CHECK(M4OSA_NULL != pContext, M4ERR_PARAMETER);
+    LOGV("VideoEditorVideoDecoder_destroy: %d forward jumps, %d skipped AUs",
+        pDecShellContext->mNbForwardJumps, pDecShellContext->mNbSkippedFrames);
+
+    // Stop decoding ahead before the decoder
+    if( NULL != pDecShellContext->mPuller ) {
+        pDecShellContext->mPuller->stop();
+        delete pDecShellContext->mPuller;
+        pDecShellContext->mPuller = NULL;
+    }
 
     // Release the color converter
     delete pDecShellContext->mI420ColorConverter;
@@ -980,6 +1275,11 @@ M4OSA_ERR VideoEditorVideoDecoder_create(M4OSA_Context *pContext,
     pDecShellContext->mNbOutputFrames    = 0;
     pDecShellContext->mFirstOutputCts    = -1;
     pDecShellContext->mLastOutputCts     = -1;
+    pDecShellContext->mSkipNonRefUpToCts = -1;
+    pDecShellContext->mNbSkippedFrames   = 0;
+    pDecShellContext->mNbForwardJumps    = 0;
+    pDecShellContext->mLastRapDistance   = 0;
+    pDecShellContext->mReaderMoved       = M4OSA_FALSE;
     pDecShellContext->m_pDecBufferPool   = M4OSA_NULL;
 
     /**
@@ -1142,6 +1442,11 @@ M4OSA_ERR VideoEditorVideoSoftwareDecoder_create(M4OSA_Context *pContext,
     pDecShellContext->mNbOutputFrames    = 0;
     pDecShellContext->mFirstOutputCts    = -1;
     pDecShellContext->mLastOutputCts     = -1;
+    pDecShellContext->mSkipNonRefUpToCts = -1;
+    pDecShellContext->mNbSkippedFrames   = 0;
+    pDecShellContext->mNbForwardJumps    = 0;
+    pDecShellContext->mLastRapDistance   = 0;
+    pDecShellContext->mReaderMoved       = M4OSA_FALSE;
     pDecShellContext->m_pDecBufferPool   = M4OSA_NULL;
 
     /**
@@ -1215,6 +1520,18 @@ M4OSA_ERR VideoEditorVideoSoftwareDecoder_create(M4OSA_Context *pContext,
     status = pDecShellContext->mVideoDecoder->start();
     VIDEOEDITOR_CHECK(OK == status, M4ERR_SF_DECODER_RSRC_FAIL);
 
+    // Decode ahead on a dedicated thread: the software decoder would
+    // otherwise run on the editing thread. It is started by the first decode,
+    // the caller may still read the stream itself until then.
+    pDecShellContext->mPuller = new VideoEditorVideoDecoderPuller(
+        pDecShellContext->mVideoDecoder, VIDEOEDITOR_VIDEC_DECODE_AHEAD_FRAMES);
+    VIDEOEDITOR_CHECK(NULL != pDecShellContext->mPuller, M4ERR_ALLOC);
+    if (OK != pDecShellContext->mPuller->initCheck()) {
+        // Decode on the editing thread
+        delete pDecShellContext->mPuller;
+        pDecShellContext->mPuller = NULL;
+    }
+
     *pContext = (M4OSA_Context)pDecShellContext;
 
 cleanUp:
@@ -1270,6 +1587,10 @@ M4OSA_ERR VideoEditorVideoDecoder_getOption(M4OSA_Context context,
                 pVideoSize->m_uiWidth, pVideoSize->m_uiHeight);
             break;
 
+        case M4DECODER_kOptionID_PrevRapDistance:
+            *(M4OSA_Int32 *)pValue = pDecShellContext->mLastRapDistance;
+            break;
+
         case M4DECODER_kOptionID_NextRenderedFrameCTS:
             /** How to get this information. SF decoder does not provide this. *
             ** Let us provide last decoded frame CTS as of now. *
@@ -1314,6 +1635,12 @@ M4OSA_ERR VideoEditorVideoDecoder_setOption(M4OSA_Context context,
             break;
         case M4DECODER_kOptionID_DeblockingFilter:
             break;
+        case M4DECODER_kOptionID_PauseReadAhead:
+            if (NULL != pDecShellContext->mPuller) {
+                pDecShellContext->mPuller->pause();
+            }
+            pDecShellContext->mReaderMoved = M4OSA_TRUE;
+            break;
         default:
             lerr = M4ERR_BAD_CONTEXT;
             break;
@@ -1329,6 +1656,7 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
     VideoEditorVideoDecoder_Context* pDecShellContext =
         (VideoEditorVideoDecoder_Context*) context;
     int64_t lFrameTime;
+    M4_MediaTime nextCts;
     MediaBuffer* pDecoderBuffer = NULL;
     MediaBuffer* pNextBuffer = NULL;
     status_t errStatus;
@@ -1349,8 +1677,23 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
     }
     if(M4OSA_TRUE == bJump) {
         LOGV("VideoEditorVideoDecoder_decode: Jump called");
-        pDecShellContext->m_lastDecodedCTS = -1;
-        pDecShellContext->m_lastRenderCts = -1;
+        if ((M4OSA_FALSE == pDecShellContext->mReaderMoved) &&
+            (pDecShellContext->m_lastDecodedCTS >= 0) &&
+            (*pTime - pDecShellContext->m_lastDecodedCTS <=
+                VIDEOEDITOR_VIDEC_FORWARD_JUMP_MAX_MS)) {
+            // The target is just ahead: decoding forward is cheaper than
+            // flushing the decoder and decoding again from a sync sample
+            LOGV("VideoEditorVideoDecoder_decode: forward jump from %lf",
+                pDecShellContext->m_lastDecodedCTS);
+            pDecShellContext->mNbForwardJumps++;
+            pDecShellContext->mLastRapDistance = (M4OSA_Int32)(*pTime -
+                pDecShellContext->m_lastDecodedCTS);
+            needSeek = false;
+        } else {
+            pDecShellContext->m_lastDecodedCTS = -1;
+            pDecShellContext->m_lastRenderCts = -1;
+        }
+        pDecShellContext->mSkipNonRefUpToCts = *pTime - tolerance;
     }
 
     pDecShellContext->mNbInputFrames++;
@@ -1368,10 +1711,12 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
             MediaSource::ReadOptions options;
             int64_t time_us = *pTime * 1000;
             options.setSeekTo(time_us, MediaSource::ReadOptions::SEEK_PREVIOUS_SYNC);
-            errStatus = pDecShellContext->mVideoDecoder->read(&pNextBuffer, &options);
+            errStatus = VideoEditorVideoDecoder_read(pDecShellContext,
+                &pNextBuffer, &options);
             needSeek = false;
         } else {
-            errStatus = pDecShellContext->mVideoDecoder->read(&pNextBuffer);
+            errStatus = VideoEditorVideoDecoder_read(pDecShellContext,
+                &pNextBuffer);
         }
 
         // Handle EOS and format change
@@ -1381,8 +1726,9 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
             lerr = M4WAR_NO_MORE_AU;
             // If we decoded a buffer before EOS, we still need to put it
             // into the queue.
-            if (pDecoderBuffer && bJump) {
-                copyBufferToQueue(pDecShellContext, pDecoderBuffer);
+            if (pDecoderBuffer) {
+                copyBufferToQueue(pDecShellContext, pDecoderBuffer,
+                    pDecShellContext->m_lastDecodedCTS);
             }
             goto VIDEOEDITOR_VideoDecode_cleanUP;
         } else if (INFO_FORMAT_CHANGED == errStatus) {
@@ -1410,31 +1756,37 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
             continue;
         }
 
-        // Now we have a good next buffer, release the previous one.
+        pNextBuffer->meta_data()->findInt64(kKeyTime, &lFrameTime);
+        nextCts = (M4_MediaTime)(lFrameTime/1000);
+
+        // Now we have a good next buffer, release the previous one. It is
+        // only saved if it can still be rendered, i.e. if the next buffer is
+        // beyond the requested time (when bJump is true, only the last
+        // buffer is needed).
         if (pDecoderBuffer != NULL) {
+            if (!bJump && (nextCts > *pTime)) {
+                lerr = copyBufferToQueue(pDecShellContext, pDecoderBuffer,
+                    pDecShellContext->m_lastDecodedCTS);
+            }
             pDecoderBuffer->release();
             pDecoderBuffer = NULL;
+            if (lerr != M4NO_ERROR) {
+                pNextBuffer->release();
+                goto VIDEOEDITOR_VideoDecode_cleanUP;
+            }
         }
         pDecoderBuffer = pNextBuffer;
 
         // Record the timestamp of last decoded buffer
-        pDecoderBuffer->meta_data()->findInt64(kKeyTime, &lFrameTime);
-        pDecShellContext->m_lastDecodedCTS = (M4_MediaTime)(lFrameTime/1000);
+        pDecShellContext->m_lastDecodedCTS = nextCts;
         LOGV("VideoEditorVideoDecoder_decode,decoded frametime = %lf,size = %d",
             (M4_MediaTime)lFrameTime, pDecoderBuffer->size() );
-
-        // If bJump is false, we need to save every decoded buffer
-        if (!bJump) {
-            lerr = copyBufferToQueue(pDecShellContext, pDecoderBuffer);
-            if (lerr != M4NO_ERROR) {
-                goto VIDEOEDITOR_VideoDecode_cleanUP;
-            }
-        }
     }
 
-    // If bJump is true, we only need to copy the last buffer
-    if (bJump) {
-        lerr = copyBufferToQueue(pDecShellContext, pDecoderBuffer);
+    // Save the last decoded buffer
+    if ((M4NO_ERROR == lerr) && (pDecoderBuffer != NULL)) {
+        lerr = copyBufferToQueue(pDecShellContext, pDecoderBuffer,
+            pDecShellContext->m_lastDecodedCTS);
         if (lerr != M4NO_ERROR) {
             goto VIDEOEDITOR_VideoDecode_cleanUP;
         }
@@ -1447,6 +1799,12 @@ M4OSA_ERR VideoEditorVideoDecoder_decode(M4OSA_Context context,
     pDecShellContext->mLastOutputCts = *pTime;
 
 VIDEOEDITOR_VideoDecode_cleanUP:
+    pDecShellContext->mSkipNonRefUpToCts = -1;
+    pDecShellContext->mReaderMoved = M4OSA_FALSE;
+    if ((M4NO_ERROR == lerr) && (NULL != pDecShellContext->mPuller)) {
+        // The caller gives the stream back until it pauses the read ahead
+        pDecShellContext->mPuller->start();
+    }
     *pTime = pDecShellContext->m_lastDecodedCTS;
     if (pDecoderBuffer != NULL) {
         pDecoderBuffer->release();
@@ -1459,22 +1817,14 @@ VIDEOEDITOR_VideoDecode_cleanUP:
 
 static M4OSA_ERR copyBufferToQueue(
     VideoEditorVideoDecoder_Context* pDecShellContext,
-    MediaBuffer* pDecoderBuffer) {
+    MediaBuffer* pDecoderBuffer, M4_MediaTime cts) {
 
     M4OSA_ERR lerr = M4NO_ERROR;
     VIDEOEDITOR_BUFFER_Buffer* tmpDecBuffer;
 
-    // Get a buffer from the queue
-    lerr = VIDEOEDITOR_BUFFER_getBuffer(pDecShellContext->m_pDecBufferPool,
-        VIDEOEDITOR_BUFFER_kEmpty, &tmpDecBuffer);
-    if (lerr == (M4OSA_UInt32)M4ERR_NO_BUFFER_AVAILABLE) {
-        lerr = VIDEOEDITOR_BUFFER_getOldestBuffer(
-            pDecShellContext->m_pDecBufferPool,
-            VIDEOEDITOR_BUFFER_kFilled, &tmpDecBuffer);
-        tmpDecBuffer->state = VIDEOEDITOR_BUFFER_kEmpty;
-        lerr = M4NO_ERROR;
-    }
-
+    // Get the next buffer of the ring, the oldest one is reused if it is full
+    lerr = VIDEOEDITOR_BUFFER_pushBuffer(pDecShellContext->m_pDecBufferPool,
+        cts, &tmpDecBuffer);
     if (lerr != M4NO_ERROR) return lerr;
 
     // Color convert or copy from the given MediaBuffer to our buffer
@@ -1545,8 +1895,6 @@ static M4OSA_ERR copyBufferToQueue(
         lerr = M4ERR_PARAMETER;
     }
 
-    tmpDecBuffer->buffCTS = pDecShellContext->m_lastDecodedCTS;
-    tmpDecBuffer->state = VIDEOEDITOR_BUFFER_kFilled;
     tmpDecBuffer->size = pDecoderBuffer->size();
 
     return lerr;
@@ -1558,13 +1906,11 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
     M4OSA_ERR err = M4NO_ERROR;
     VideoEditorVideoDecoder_Context* pDecShellContext =
         (VideoEditorVideoDecoder_Context*) context;
-    M4OSA_UInt32 lindex, i;
+    M4OSA_UInt32 lindex;
     M4OSA_UInt8* p_buf_src, *p_buf_dest;
     M4VIFI_ImagePlane tmpPlaneIn, tmpPlaneOut;
-    VIDEOEDITOR_BUFFER_Buffer* pTmpVIDEOEDITORBuffer, *pRenderVIDEOEDITORBuffer
-                                                                  = M4OSA_NULL;
+    VIDEOEDITOR_BUFFER_Buffer* pRenderVIDEOEDITORBuffer = M4OSA_NULL;
     M4_MediaTime candidateTimeStamp = -1;
-    M4OSA_Bool bFound = M4OSA_FALSE;
 
     LOGV("VideoEditorVideoDecoder_render begin");
     // Input parameters check
@@ -1583,34 +1929,23 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
         "%lf", pDecShellContext->m_lastRenderCts, *pTime);
 
     /**
-     * Find the buffer appropriate for rendering.  */
-    for (i=0; i < pDecShellContext->m_pDecBufferPool->NB; i++) {
-        pTmpVIDEOEDITORBuffer = &pDecShellContext->m_pDecBufferPool\
-            ->pNXPBuffer[i];
-        if (pTmpVIDEOEDITORBuffer->state == VIDEOEDITOR_BUFFER_kFilled) {
-            /** Free all those buffers older than last rendered frame. */
-            if (pTmpVIDEOEDITORBuffer->buffCTS < pDecShellContext->\
-                    m_lastRenderCts) {
-                pTmpVIDEOEDITORBuffer->state = VIDEOEDITOR_BUFFER_kEmpty;
-            }
+     * Free all those buffers older than last rendered frame. */
+    VIDEOEDITOR_BUFFER_releaseOlderBuffers(pDecShellContext->m_pDecBufferPool,
+        pDecShellContext->m_lastRenderCts);
 
-            /** Get the buffer with appropriate timestamp  */
-            if ( (pTmpVIDEOEDITORBuffer->buffCTS >= pDecShellContext->\
-                    m_lastRenderCts) &&
-                (pTmpVIDEOEDITORBuffer->buffCTS <= *pTime) &&
-                (pTmpVIDEOEDITORBuffer->buffCTS > candidateTimeStamp)) {
-                bFound = M4OSA_TRUE;
-                pRenderVIDEOEDITORBuffer = pTmpVIDEOEDITORBuffer;
-                candidateTimeStamp = pTmpVIDEOEDITORBuffer->buffCTS;
-                LOGV("VideoDecoder_render: found a buffer with timestamp = %lf",
-                    candidateTimeStamp);
-            }
-        }
-    }
-    if (M4OSA_FALSE == bFound) {
+    /**
+     * Find the buffer appropriate for rendering: the ring is ordered by
+     * timestamp, so this is the newest one not after the requested time. */
+    if (M4NO_ERROR != VIDEOEDITOR_BUFFER_getNewestBuffer(
+            pDecShellContext->m_pDecBufferPool,
+            pDecShellContext->m_lastRenderCts, *pTime,
+            &pRenderVIDEOEDITORBuffer)) {
         err = M4WAR_VIDEORENDERER_NO_NEW_FRAME;
         goto cleanUp;
     }
+    candidateTimeStamp = pRenderVIDEOEDITORBuffer->buffCTS;
+    LOGV("VideoDecoder_render: found a buffer with timestamp = %lf",
+        candidateTimeStamp);
 
     LOGV("VideoEditorVideoDecoder_render 3 ouput %d %d %d %d",
         pOutputPlane[0].u_width, pOutputPlane[0].u_height,
@@ -1654,14 +1989,31 @@ M4OSA_ERR VideoEditorVideoDecoder_render(M4OSA_Context context,
         M4OSA_UInt32 tempHeight =
             pDecShellContext->m_pVideoStreamhandler->m_videoHeight;
 
-        memcpy((void *) pOutputPlane[0].pac_data, (void *)tempBuffPtr,
-            tempWidth * tempHeight);
-        tempBuffPtr += (tempWidth * tempHeight);
-        memcpy((void *) pOutputPlane[1].pac_data, (void *)tempBuffPtr,
-            (tempWidth/2) * (tempHeight/2));
-        tempBuffPtr += ((tempWidth/2) * (tempHeight/2));
-        memcpy((void *) pOutputPlane[2].pac_data, (void *)tempBuffPtr,
-            (tempWidth/2) * (tempHeight/2));
+        if ((pOutputPlane[0].u_stride == tempWidth) &&
+            (0 == pOutputPlane[0].u_topleft)) {
+            memcpy((void *) pOutputPlane[0].pac_data, (void *)tempBuffPtr,
+                tempWidth * tempHeight);
+            tempBuffPtr += (tempWidth * tempHeight);
+            memcpy((void *) pOutputPlane[1].pac_data, (void *)tempBuffPtr,
+                (tempWidth/2) * (tempHeight/2));
+            tempBuffPtr += ((tempWidth/2) * (tempHeight/2));
+            memcpy((void *) pOutputPlane[2].pac_data, (void *)tempBuffPtr,
+                (tempWidth/2) * (tempHeight/2));
+        } else {
+            // The output planes are padded (encoder input layout), copy per row
+            for (int plane = 0; plane < 3; plane++) {
+                M4OSA_UInt32 width = (0 == plane) ? tempWidth : tempWidth/2;
+                M4OSA_UInt32 height = (0 == plane) ? tempHeight : tempHeight/2;
+                M4OSA_UInt8* pDst = pOutputPlane[plane].pac_data +
+                    pOutputPlane[plane].u_topleft;
+
+                for (M4OSA_UInt32 row = 0; row < height; row++) {
+                    memcpy((void *)pDst, (void *)tempBuffPtr, width);
+                    tempBuffPtr += width;
+                    pDst += pOutputPlane[plane].u_stride;
+                }
+            }
+        }
     }
 
     pDecShellContext->mNbRenderedFrames++;
@@ -53,6 +53,13 @@
     #error "Cannot force DSI retrieval if codec type is not fixed"
 #endif
 
+// Initial number of entries of the encoder source queue (it grows if needed)
+#define VIDEOEDITOR_ENCODER_QUEUE_SIZE 8
+
+// Number of input buffers kept by the pool on top of the prefetched frames:
+// one being filled and one being copied by the encoder
+#define VIDEOEDITOR_ENCODER_POOL_EXTRA 2
+
 /********************
  *   SOURCE CLASS   *
  ********************/
@@ -75,10 +82,6 @@ struct VideoEditorVideoEncoderSource : public MediaSource {
         virtual ~VideoEditorVideoEncoderSource();
 
     private:
-        struct MediaBufferChain {
-            MediaBuffer* buffer;
-            MediaBufferChain* nextLink;
-        };
         enum State {
             CREATED,
             STARTED,
@@ -91,8 +94,10 @@ struct VideoEditorVideoEncoderSource : public MediaSource {
         VideoEditorVideoEncoderSource &operator=(
                 const VideoEditorVideoEncoderSource &);
 
-        MediaBufferChain* mFirstBufferLink;
-        MediaBufferChain* mLastBufferLink;
+        // Circular queue of the stored buffers
+        MediaBuffer**     mQueue;
+        int32_t           mQueueSize;
+        int32_t           mFirstBuffer;
         int32_t           mNbBuffer;
         bool              mIsEOS;
         State             mState;
@@ -111,8 +116,9 @@ sp<VideoEditorVideoEncoderSource> VideoEditorVideoEncoderSource::Create(
 
 VideoEditorVideoEncoderSource::VideoEditorVideoEncoderSource(
     const sp<MetaData> &format):
-        mFirstBufferLink(NULL),
-        mLastBufferLink(NULL),
+        mQueue(NULL),
+        mQueueSize(0),
+        mFirstBuffer(0),
         mNbBuffer(0),
         mIsEOS(false),
         mState(CREATED),
@@ -126,6 +132,7 @@ VideoEditorVideoEncoderSource::~VideoEditorVideoEncoderSource() {
     if( STARTED == mState ) {
         stop();
     }
+    delete[] mQueue;
 }
 
 status_t VideoEditorVideoEncoderSource::start(MetaData *meta) {
@@ -137,6 +144,8 @@ status_t VideoEditorVideoEncoderSource::start(MetaData *meta) {
         LOGV("VideoEditorVideoEncoderSource::start: invalid state %d", mState);
         return UNKNOWN_ERROR;
     }
+    // The source may be restarted after an EOS
+    mIsEOS = false;
     mState = STARTED;
 
     LOGV("VideoEditorVideoEncoderSource::start() END (0x%x)", err);
@@ -153,18 +162,15 @@ status_t VideoEditorVideoEncoderSource::stop() {
         return UNKNOWN_ERROR;
     }
 
-    // Release the buffer chain
-    int32_t i = 0;
-    MediaBufferChain* tmpLink = NULL;
-    while( mFirstBufferLink ) {
-        i++;
-        tmpLink = mFirstBufferLink;
-        mFirstBufferLink = mFirstBufferLink->nextLink;
-        delete tmpLink;
+    // Release the queued buffers, so that pooled buffers go back to their pool
+    Mutex::Autolock autolock(mLock);
+    LOGV("VideoEditorVideoEncoderSource::stop : %d buffer remained", mNbBuffer);
+    while( mNbBuffer > 0 ) {
+        mQueue[mFirstBuffer]->release();
+        mFirstBuffer = (mFirstBuffer + 1) % mQueueSize;
+        mNbBuffer--;
     }
-    LOGV("VideoEditorVideoEncoderSource::stop : %d buffer remained", i);
-    mFirstBufferLink = NULL;
-    mLastBufferLink = NULL;
+    mFirstBuffer = 0;
 
     mState = CREATED;
 
@@ -183,7 +189,6 @@ status_t VideoEditorVideoEncoderSource::read(MediaBuffer **buffer,
     Mutex::Autolock autolock(mLock);
     MediaSource::ReadOptions readOptions;
     status_t err = OK;
-    MediaBufferChain* tmpLink = NULL;
 
     LOGV("VideoEditorVideoEncoderSource::read() begin");
 
@@ -192,26 +197,20 @@ status_t VideoEditorVideoEncoderSource::read(MediaBuffer **buffer,
         return UNKNOWN_ERROR;
     }
 
-    while (mFirstBufferLink == NULL && !mIsEOS) {
+    while (mNbBuffer == 0 && !mIsEOS) {
         mBufferCond.wait(mLock);
     }
 
     // End of stream?
-    if (mFirstBufferLink == NULL) {
+    if (mNbBuffer == 0) {
         *buffer = NULL;
         LOGV("VideoEditorVideoEncoderSource::read : EOS");
         return ERROR_END_OF_STREAM;
     }
 
-    // Get a buffer from the chain
-    *buffer = mFirstBufferLink->buffer;
-    tmpLink = mFirstBufferLink;
-    mFirstBufferLink = mFirstBufferLink->nextLink;
-
-    if ( NULL == mFirstBufferLink ) {
-        mLastBufferLink = NULL;
-    }
-    delete tmpLink;
+    // Get a buffer from the queue
+    *buffer = mQueue[mFirstBuffer];
+    mFirstBuffer = (mFirstBuffer + 1) % mQueueSize;
     mNbBuffer--;
 
     LOGV("VideoEditorVideoEncoderSource::read() END (0x%x)", err);
@@ -228,15 +227,20 @@ int32_t VideoEditorVideoEncoderSource::storeBuffer(MediaBuffer *buffer) {
         LOGV("VideoEditorVideoEncoderSource::storeBuffer : reached EOS");
         mIsEOS = true;
     } else {
-        MediaBufferChain* newLink = new MediaBufferChain;
-        newLink->buffer = buffer;
-        newLink->nextLink = NULL;
-        if( NULL != mLastBufferLink ) {
-            mLastBufferLink->nextLink = newLink;
-        } else {
-            mFirstBufferLink = newLink;
+        if( mNbBuffer == mQueueSize ) {
+            // The queue is full (or not allocated yet), double its size
+            int32_t newSize = (0 == mQueueSize) ?
+                VIDEOEDITOR_ENCODER_QUEUE_SIZE : 2*mQueueSize;
+            MediaBuffer** newQueue = new MediaBuffer*[newSize];
+            for( int32_t i = 0; i < mNbBuffer; i++ ) {
+                newQueue[i] = mQueue[(mFirstBuffer + i) % mQueueSize];
+            }
+            delete[] mQueue;
+            mQueue = newQueue;
+            mQueueSize = newSize;
+            mFirstBuffer = 0;
         }
-        mLastBufferLink = newLink;
+        mQueue[(mFirstBuffer + mNbBuffer) % mQueueSize] = buffer;
         mNbBuffer++;
     }
     mBufferCond.signal();
@@ -248,6 +252,91 @@ int32_t VideoEditorVideoEncoderSource::getNumberOfBuffersInQueue() {
     Mutex::Autolock autolock(mLock);
     return mNbBuffer;
 }
+/********************
+ *   BUFFER POOL    *
+ ********************/
+
+// Recycles the encoder input buffers: a buffer given to the encoder source
+// comes back to the pool when the encoder releases it.
+// The pool allocates its buffers on demand, up to its capacity. If all of
+// them are in use, a buffer out of the pool is returned, so that the caller
+// never blocks on the encoder.
+class VideoEditorVideoEncoderBufferPool : public MediaBufferObserver {
+public:
+    VideoEditorVideoEncoderBufferPool(size_t bufferSize, int32_t capacity);
+    virtual ~VideoEditorVideoEncoderBufferPool();
+    MediaBuffer* acquireBuffer();
+    virtual void signalBufferReturned(MediaBuffer* buffer);
+private:
+    // Don't call me
+    VideoEditorVideoEncoderBufferPool(const VideoEditorVideoEncoderBufferPool &);
+    VideoEditorVideoEncoderBufferPool &operator=(
+            const VideoEditorVideoEncoderBufferPool &);
+
+    size_t        mBufferSize;
+    int32_t       mCapacity;
+    MediaBuffer** mBuffers;      // All the buffers allocated by the pool
+    int32_t       mNbBuffers;
+    MediaBuffer** mFreeBuffers;  // Stack of the buffers not in use
+    int32_t       mNbFreeBuffers;
+    Mutex         mLock;
+};
+
+VideoEditorVideoEncoderBufferPool::VideoEditorVideoEncoderBufferPool(
+    size_t bufferSize, int32_t capacity):
+        mBufferSize(bufferSize),
+        mCapacity(capacity),
+        mNbBuffers(0),
+        mNbFreeBuffers(0) {
+    mBuffers = new MediaBuffer*[mCapacity];
+    mFreeBuffers = new MediaBuffer*[mCapacity];
+    LOGV("VideoEditorVideoEncoderBufferPool: %d buffers of %d bytes",
+        mCapacity, mBufferSize);
+}
+
+VideoEditorVideoEncoderBufferPool::~VideoEditorVideoEncoderBufferPool() {
+    Mutex::Autolock autolock(mLock);
+
+    for (int32_t i = 0; i < mNbBuffers; i++) {
+        MediaBuffer* buffer = mBuffers[i];
+        if (0 == buffer->refcount()) {
+            buffer->setObserver(NULL);
+            buffer->release();
+        } else {
+            LOGW("VideoEditorVideoEncoderBufferPool: buffer %d still in use",
+                i);
+        }
+    }
+    delete[] mBuffers;
+    delete[] mFreeBuffers;
+}
+
+MediaBuffer* VideoEditorVideoEncoderBufferPool::acquireBuffer() {
+    Mutex::Autolock autolock(mLock);
+    MediaBuffer* buffer = NULL;
+
+    if (mNbFreeBuffers > 0) {
+        buffer = mFreeBuffers[--mNbFreeBuffers];
+    } else if (mNbBuffers < mCapacity) {
+        buffer = new MediaBuffer(mBufferSize);
+        buffer->setObserver(this);
+        mBuffers[mNbBuffers++] = buffer;
+    } else {
+        LOGV("VideoEditorVideoEncoderBufferPool: pool is empty");
+        return new MediaBuffer(mBufferSize);
+    }
+
+    buffer->add_ref();
+    buffer->reset();
+    return buffer;
+}
+
+void VideoEditorVideoEncoderBufferPool::signalBufferReturned(
+        MediaBuffer* buffer) {
+    Mutex::Autolock autolock(mLock);
+    mFreeBuffers[mNbFreeBuffers++] = buffer;
+}
+
 /********************
  *      PULLER      *
  ********************/
@@ -470,6 +559,14 @@ typedef struct {
     OMX_COLOR_FORMATTYPE              mEncoderColorFormat;
     VideoEditorVideoEncoderPuller*    mPuller;
     I420ColorConverter*               mI420ColorConverter;
+    VideoEditorVideoEncoderBufferPool* mInputPool;
+    M4OSA_UInt8*                      mI420Buffer;  // VPP output if converted
+    bool                              mConvertInput;
+    bool                              mPlanarInput;  // Encoder layout is padded I420
+    bool                              mStridedPreProcessing;
+    int                               mEncoderWidth;
+    int                               mEncoderHeight;
+    ARect                             mEncoderRect;
 
     uint32_t                          mNbInputFrames;
     double                            mFirstInputCts;
@@ -642,6 +739,11 @@ M4OSA_ERR VideoEditorVideoEncoder_init(M4ENCODER_Format format,
     pEncoderContext->mPreProcFunction = pVPPfct;
     pEncoderContext->mPreProcContext = pVPPctxt;
     pEncoderContext->mPuller = NULL;
+    pEncoderContext->mInputPool = NULL;
+    pEncoderContext->mI420Buffer = M4OSA_NULL;
+    pEncoderContext->mConvertInput = false;
+    pEncoderContext->mPlanarInput = false;
+    pEncoderContext->mStridedPreProcessing = false;
 
     // Get color converter and determine encoder input format
     pEncoderContext->mI420ColorConverter = new I420ColorConverter;
@@ -720,6 +822,10 @@ M4OSA_ERR VideoEditorVideoEncoder_close(M4ENCODER_Context pContext) {
     delete pEncoderContext->mPuller;
     pEncoderContext->mPuller = NULL;
 
+    delete pEncoderContext->mInputPool;
+    pEncoderContext->mInputPool = NULL;
+    SAFE_FREE(pEncoderContext->mI420Buffer);
+
     delete pEncoderContext->mI420ColorConverter;
     pEncoderContext->mI420ColorConverter = NULL;
 
@@ -750,6 +856,8 @@ M4OSA_ERR VideoEditorVideoEncoder_open(M4ENCODER_Context pContext,
 
     int32_t iFrameRate = 0;
     uint32_t codecFlags = 0;
+    size_t inputBufferSize = 0;
+    int32_t nbInputBuffers = 0;
 
     LOGV(">>> VideoEditorVideoEncoder_open begin");
     // Input parameters check
@@ -905,6 +1013,48 @@ M4OSA_ERR VideoEditorVideoEncoder_open(M4ENCODER_Context pContext,
     pEncoderContext->mPuller = new VideoEditorVideoEncoderPuller(
         pEncoderContext->mEncoder);
 
+    // Size the input buffers: the pre-processing writes YUV420 planar, either
+    // straight in the input buffer or in a staging buffer when the encoder
+    // needs another layout
+    inputBufferSize = (size_t)(pEncoderContext->mCodecParams->FrameWidth *
+        pEncoderContext->mCodecParams->FrameHeight * 3) / 2;
+    if (pEncoderContext->mI420ColorConverter) {
+        int encoderBufferSize;
+
+        if (pEncoderContext->mI420ColorConverter->getEncoderInputBufferInfo(
+            pEncoderContext->mCodecParams->FrameWidth,
+            pEncoderContext->mCodecParams->FrameHeight,
+            &pEncoderContext->mEncoderWidth, &pEncoderContext->mEncoderHeight,
+            &pEncoderContext->mEncoderRect, &encoderBufferSize) == 0) {
+            pEncoderContext->mConvertInput = true;
+            inputBufferSize = (size_t)encoderBufferSize;
+
+            // A planar layout only padded on the right and at the bottom can be
+            // described with image planes: the pre-processing may write into it
+            pEncoderContext->mPlanarInput =
+                ((OMX_COLOR_FormatYUV420Planar ==
+                    pEncoderContext->mEncoderColorFormat) ||
+                 (OMX_COLOR_FormatYUV420PackedPlanar ==
+                    pEncoderContext->mEncoderColorFormat)) &&
+                (0 == pEncoderContext->mEncoderRect.left) &&
+                (0 == pEncoderContext->mEncoderRect.top) &&
+                (0 == (pEncoderContext->mEncoderWidth & 1)) &&
+                (0 == (pEncoderContext->mEncoderHeight & 1)) &&
+                (encoderBufferSize >= (pEncoderContext->mEncoderWidth *
+                    pEncoderContext->mEncoderHeight * 3) / 2);
+        } else {
+            LOGW("VideoEditorVideoEncoder_open: no encoder buffer info");
+        }
+    }
+
+    // The encoder source holds at most mMaxPrefetchFrames buffers
+    nbInputBuffers = VIDEOEDITOR_ENCODER_POOL_EXTRA;
+    if (pEncoderContext->mMaxPrefetchFrames > 0) {
+        nbInputBuffers += pEncoderContext->mMaxPrefetchFrames;
+    }
+    pEncoderContext->mInputPool = new VideoEditorVideoEncoderBufferPool(
+        inputBufferSize, nbInputBuffers);
+
     // Set the new state
     pEncoderContext->mState = OPENED;
 
@@ -941,16 +1091,34 @@ M4OSA_ERR VideoEditorVideoEncoder_processInputBuffer(
         M4OSA_UInt32 sizeY = pEncoderContext->mCodecParams->FrameWidth *
             pEncoderContext->mCodecParams->FrameHeight;
         M4OSA_UInt32 sizeU = sizeY >> 2;
-        M4OSA_UInt32 size  = sizeY + 2*sizeU;
         M4OSA_UInt8* pData = M4OSA_NULL;
-        buffer = new MediaBuffer((size_t)size);
+        bool bConvert = pEncoderContext->mConvertInput;
+        M4OSA_UInt32 stride = pEncoderContext->mCodecParams->FrameWidth;
+
+        buffer = pEncoderContext->mInputPool->acquireBuffer();
         pData = (M4OSA_UInt8*)buffer->data() + buffer->range_offset();
 
+        if (bConvert && pEncoderContext->mPlanarInput &&
+            pEncoderContext->mStridedPreProcessing) {
+            // Pre-process straight into the encoder layout
+            stride = pEncoderContext->mEncoderWidth;
+            sizeY = stride * pEncoderContext->mEncoderHeight;
+            sizeU = sizeY >> 2;
+            bConvert = false;
+        } else if (bConvert) {
+            // Pre-process into the staging frame, then convert it
+            if (M4OSA_NULL == pEncoderContext->mI420Buffer) {
+                SAFE_MALLOC(pEncoderContext->mI420Buffer, M4OSA_UInt8,
+                    sizeY + 2*sizeU, "Encoder I420 buffer");
+            }
+            pData = pEncoderContext->mI420Buffer;
+        }
+
         // Prepare the output image for pre-processing
         pOutPlane[0].u_width   = pEncoderContext->mCodecParams->FrameWidth;
         pOutPlane[0].u_height  = pEncoderContext->mCodecParams->FrameHeight;
         pOutPlane[0].u_topleft = 0;
-        pOutPlane[0].u_stride  = pOutPlane[0].u_width;
+        pOutPlane[0].u_stride  = stride;
         pOutPlane[1].u_width   = pOutPlane[0].u_width/2;
         pOutPlane[1].u_height  = pOutPlane[0].u_height/2;
         pOutPlane[1].u_topleft = 0;
@@ -969,35 +1137,16 @@ M4OSA_ERR VideoEditorVideoEncoder_processInputBuffer(
             pEncoderContext->mPreProcContext, M4OSA_NULL, pOutPlane);
         VIDEOEDITOR_CHECK(M4NO_ERROR == err, err);
 
-        // Convert MediaBuffer to the encoder input format if necessary
-        if (pEncoderContext->mI420ColorConverter) {
-            I420ColorConverter* converter = pEncoderContext->mI420ColorConverter;
-            int actualWidth = pEncoderContext->mCodecParams->FrameWidth;
-            int actualHeight = pEncoderContext->mCodecParams->FrameHeight;
-
-            int encoderWidth, encoderHeight;
-            ARect encoderRect;
-            int encoderBufferSize;
-
-            if (converter->getEncoderInputBufferInfo(
-                actualWidth, actualHeight,
-                &encoderWidth, &encoderHeight,
-                &encoderRect, &encoderBufferSize) == 0) {
-
-                MediaBuffer* newBuffer = new MediaBuffer(encoderBufferSize);
-
-                if (converter->convertI420ToEncoderInput(
-                    pData,  // srcBits
-                    actualWidth, actualHeight,
-                    encoderWidth, encoderHeight,
-                    encoderRect,
-                    (uint8_t*)newBuffer->data() + newBuffer->range_offset()) < 0) {
-                    LOGE("convertI420ToEncoderInput failed");
-                }
-
-                // switch to new buffer
-                buffer->release();
-                buffer = newBuffer;
+        // Convert the frame to the encoder input format if necessary
+        if (bConvert) {
+            if (pEncoderContext->mI420ColorConverter->convertI420ToEncoderInput(
+                pData,  // srcBits
+                pEncoderContext->mCodecParams->FrameWidth,
+                pEncoderContext->mCodecParams->FrameHeight,
+                pEncoderContext->mEncoderWidth, pEncoderContext->mEncoderHeight,
+                pEncoderContext->mEncoderRect,
+                (uint8_t*)buffer->data() + buffer->range_offset()) < 0) {
+                LOGE("convertI420ToEncoderInput failed");
             }
         }
 
@@ -1250,6 +1399,8 @@ M4OSA_ERR VideoEditorVideoEncoder_start(M4ENCODER_Context pContext) {
     pEncoderContext->mNbOutputFrames = 0;
     pEncoderContext->mFirstOutputCts = -1;
     pEncoderContext->mLastOutputCts  = -1;
+    // A restarted encoder may get its timestamps from 0 again (new MCS job)
+    pEncoderContext->mLastCTS        = 0;
 
     result = pEncoderContext->mEncoder->start();
     VIDEOEDITOR_CHECK(OK == result, M4ERR_STATE);
@@ -1308,6 +1459,12 @@ M4OSA_ERR VideoEditorVideoEncoder_stop(M4ENCODER_Context pContext) {
         pEncoderContext->mPuller->stop();
         pEncoderContext->mEncoder->stop();
         pEncoderContext->mState = OPENED;
+
+        // The puller threads are over, get a new puller in case the encoder
+        // is started again
+        delete pEncoderContext->mPuller;
+        pEncoderContext->mPuller = new VideoEditorVideoEncoderPuller(
+            pEncoderContext->mEncoder);
     }
 
     if (pEncoderContext->mNbInputFrames != pEncoderContext->mNbOutputFrames) {
@@ -1350,6 +1507,10 @@ M4OSA_ERR VideoEditorVideoEncoder_setOption(M4ENCODER_Context pContext,
             pEncoderContext->mH264NALUPostProcessCtx =
                 (M4OSA_Context)optionValue;
             break;
+        case M4ENCODER_kOptionID_StridedPreProcessing:
+            pEncoderContext->mStridedPreProcessing =
+                (M4OSA_FALSE != (M4OSA_Bool)(size_t)optionValue);
+            break;
         default:
             LOGV("VideoEditorVideoEncoder_setOption: unsupported optionId 0x%X",
                 optionID);
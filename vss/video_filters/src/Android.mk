@@ -32,7 +32,8 @@ LOCAL_SRC_FILES:=          \
       M4VIFI_ResizeYUVtoBGR565.c \
       M4VIFI_RGB888toYUV420.c \
       M4VIFI_RGB565toYUV420.c \
-      M4VFL_transition.c
+      M4VFL_transition.c \
+      M4VFL_ColorLut.c
 
 LOCAL_MODULE_TAGS := optional
 
@@ -0,0 +1,713 @@
+/*
+ * Copyright (C) 2011 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/**
+ ******************************************************************************
+ * @file        M4VFL_ColorLut.c
+ * @brief       Lookup table based color effects on YUV420 planar frames
+ * @note        The per frame loops only contain memset/memcpy or table
+ *              lookups, without any branch on the effect type, so that the
+ *              compiler can unroll and vectorize them.
+ ******************************************************************************
+*/
+
+/**
+ * OSAL (memset, memcpy and allocation) ***/
+#include "M4OSA_Memory.h"
+#include "M4OSA_Debug.h"
+
+#include "M4VFL_ColorLut.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Local clipping, the M4VIFI clip table is not used so that this file only
+ * depends on the OSAL */
+#define M4VFL_LUT_CLIP(x)   (((x) < 0) ? 0 : (((x) > 255) ? 255 : (x)))
+
+/**
+ * RGB565 components to chroma, same coefficients as U16/V16 in M4VIFI_Defines.h */
+#define M4VFL_LUT_U16(r, g, b) \
+    M4VFL_LUT_CLIP(128 + ((-(45483 * (r)) - (43936 * (g)) + (134771 * (b))) >> 15))
+#define M4VFL_LUT_V16(r, g, b) \
+    M4VFL_LUT_CLIP(128 + (((134771 * (r)) - (55532 * (g)) - (21917 * (b))) >> 15))
+
+/**
+ * Maximum length of a .cube line, longer lines are truncated */
+#define M4VFL_LUT_CUBE_LINE_SIZE    256
+#define M4VFL_LUT_CUBE_READ_SIZE    4096
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutSetPlane(M4VFL_ColorLut *pLut, M4OSA_UInt32 plane,
+ *                                   M4OSA_Int32 value)
+ * @brief   Sets a plane table to the constant value, or to the identity if value is -1
+ ******************************************************************************
+*/
+static M4OSA_Void M4VFL_colorLutSetPlane(M4VFL_ColorLut *pLut, M4OSA_UInt32 plane,
+                                         M4OSA_Int32 value)
+{
+    M4OSA_UInt32 i;
+
+    pLut->bCopy[plane] = (value < 0) ? M4OSA_TRUE : M4OSA_FALSE;
+    pLut->bFill[plane] = (value < 0) ? M4OSA_FALSE : M4OSA_TRUE;
+
+    for (i = 0; i < 256; i++)
+    {
+        pLut->lut[plane][i] = (M4OSA_UInt8)((value < 0) ? i : value);
+    }
+}
+
+M4OSA_ERR M4VFL_colorLutBuild(M4VFL_ColorLut *pLut, M4VFL_ColorEffect effect,
+                              M4OSA_UInt16 rgb16Color)
+{
+    M4OSA_Int32 r, g, b;
+    M4OSA_UInt32 i;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pLut), M4ERR_PARAMETER,
+        "M4VFL_colorLutBuild: pLut is M4OSA_NULL");
+
+    pLut->type = M4VFL_kColorLut_Planes;
+    pLut->pLut3D = M4OSA_NULL;
+
+    b = (rgb16Color & 0x001f);
+    g = (rgb16Color & 0x07e0) >> 5;
+    r = (rgb16Color & 0xf800) >> 11;
+    pLut->gradientR = (M4OSA_UInt16)r;
+    pLut->gradientG = (M4OSA_UInt16)g;
+    pLut->gradientB = (M4OSA_UInt16)b;
+
+    /**
+     * Luma is kept, except for the negative effect */
+    M4VFL_colorLutSetPlane(pLut, 0, -1);
+
+    switch (effect)
+    {
+        case M4VFL_kColorEffect_BlackAndWhite:
+            M4VFL_colorLutSetPlane(pLut, 1, 128);
+            M4VFL_colorLutSetPlane(pLut, 2, 128);
+            break;
+
+        case M4VFL_kColorEffect_Pink:
+            M4VFL_colorLutSetPlane(pLut, 1, 255);
+            M4VFL_colorLutSetPlane(pLut, 2, 255);
+            break;
+
+        case M4VFL_kColorEffect_Green:
+            M4VFL_colorLutSetPlane(pLut, 1, 0);
+            M4VFL_colorLutSetPlane(pLut, 2, 0);
+            break;
+
+        case M4VFL_kColorEffect_Sepia:
+            M4VFL_colorLutSetPlane(pLut, 1, 117);
+            M4VFL_colorLutSetPlane(pLut, 2, 139);
+            break;
+
+        case M4VFL_kColorEffect_Negative:
+            pLut->bCopy[0] = M4OSA_FALSE;
+            for (i = 0; i < 256; i++)
+            {
+                pLut->lut[0][i] = (M4OSA_UInt8)(255 - i);
+            }
+            M4VFL_colorLutSetPlane(pLut, 1, -1);
+            M4VFL_colorLutSetPlane(pLut, 2, -1);
+            break;
+
+        case M4VFL_kColorEffect_ColorRGB16:
+            M4VFL_colorLutSetPlane(pLut, 1, M4VFL_LUT_U16(r, g, b));
+            M4VFL_colorLutSetPlane(pLut, 2, M4VFL_LUT_V16(r, g, b));
+            break;
+
+        case M4VFL_kColorEffect_Gradient:
+            /**
+             * The chroma depends on the row, it is computed once per row in
+             M4VFL_colorLutApply */
+            pLut->type = M4VFL_kColorLut_Gradient;
+            M4VFL_colorLutSetPlane(pLut, 1, -1);
+            M4VFL_colorLutSetPlane(pLut, 2, -1);
+            break;
+
+        default:
+            M4OSA_TRACE1_1("M4VFL_colorLutBuild: unknown effect %d", effect);
+            return M4ERR_PARAMETER;
+    }
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutUpdateFlags(M4VFL_ColorLut *pLut)
+ * @brief   Detects the identity and constant plane tables
+ ******************************************************************************
+*/
+static M4OSA_Void M4VFL_colorLutUpdateFlags(M4VFL_ColorLut *pLut)
+{
+    M4OSA_UInt32 plane, i;
+
+    for (plane = 0; plane < 3; plane++)
+    {
+        pLut->bCopy[plane] = M4OSA_TRUE;
+        pLut->bFill[plane] = M4OSA_TRUE;
+        for (i = 0; i < 256; i++)
+        {
+            if (pLut->lut[plane][i] != i)
+            {
+                pLut->bCopy[plane] = M4OSA_FALSE;
+            }
+            if (pLut->lut[plane][i] != pLut->lut[plane][0])
+            {
+                pLut->bFill[plane] = M4OSA_FALSE;
+            }
+        }
+    }
+}
+
+M4OSA_Void M4VFL_colorLutInit(M4VFL_ColorLut *pLut)
+{
+    pLut->type = M4VFL_kColorLut_Planes;
+    pLut->pLut3D = M4OSA_NULL;
+    pLut->gradientR = pLut->gradientG = pLut->gradientB = 0;
+    M4VFL_colorLutSetPlane(pLut, 0, -1);
+    M4VFL_colorLutSetPlane(pLut, 1, -1);
+    M4VFL_colorLutSetPlane(pLut, 2, -1);
+}
+
+M4OSA_Void M4VFL_colorLutBuildLumaScale(M4VFL_ColorLut *pLut, M4OSA_UInt32 lumFactor)
+{
+    M4OSA_UInt32 i;
+
+    M4VFL_colorLutInit(pLut);
+
+    /* Same formulas as M4VFL_modifyLumaWithScale */
+    for (i = 0; i < 256; i++)
+    {
+        pLut->lut[0][i] = (M4OSA_UInt8)((i * lumFactor) >> 10);
+        if (lumFactor <= 256)
+        {
+            pLut->lut[1][i] = (M4OSA_UInt8)((((1024 - lumFactor) << 7) + i * lumFactor) >> 10);
+            pLut->lut[2][i] = pLut->lut[1][i];
+        }
+    }
+    M4VFL_colorLutUpdateFlags(pLut);
+}
+
+M4OSA_ERR M4VFL_colorLutCompose(M4VFL_ColorLut *pLut, const M4VFL_ColorLut *pNext)
+{
+    M4OSA_UInt32 plane, i;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pLut), M4ERR_PARAMETER,
+        "M4VFL_colorLutCompose: pLut is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pNext), M4ERR_PARAMETER,
+        "M4VFL_colorLutCompose: pNext is M4OSA_NULL");
+
+    if ((M4VFL_kColorLut_Planes != pLut->type) || (M4VFL_kColorLut_Planes != pNext->type))
+    {
+        return M4ERR_PARAMETER;
+    }
+
+    for (plane = 0; plane < 3; plane++)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            pLut->lut[plane][i] = pNext->lut[plane][pLut->lut[plane][i]];
+        }
+    }
+    M4VFL_colorLutUpdateFlags(pLut);
+
+    return M4NO_ERROR;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Bool M4VFL_colorLutCubeKeyword(M4OSA_Char *pLine, const M4OSA_Char *pKeyword,
+ *                                      M4OSA_Char **ppValue)
+ * @brief   Checks if a .cube line starts with the keyword, returns the value position
+ ******************************************************************************
+*/
+static M4OSA_Bool M4VFL_colorLutCubeKeyword(M4OSA_Char *pLine, const M4OSA_Char *pKeyword,
+                                            M4OSA_Char **ppValue)
+{
+    size_t len = strlen((const char *)pKeyword);
+
+    if ((0 != strncmp((const char *)pLine, (const char *)pKeyword, len))
+        || ((' ' != pLine[len]) && ('\t' != pLine[len])))
+    {
+        return M4OSA_FALSE;
+    }
+    *ppValue = pLine + len;
+    return M4OSA_TRUE;
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt32 M4VFL_colorLutCubeFloats(M4OSA_Char *pLine, M4OSA_Double *pValues)
+ * @brief   Parses up to three floats from a .cube line, returns the number parsed
+ ******************************************************************************
+*/
+static M4OSA_UInt32 M4VFL_colorLutCubeFloats(M4OSA_Char *pLine, M4OSA_Double *pValues)
+{
+    M4OSA_UInt32 n = 0;
+    char *pEnd;
+
+    while (n < 3)
+    {
+        pValues[n] = strtod((const char *)pLine, &pEnd);
+        if (pEnd == (char *)pLine)
+        {
+            break;
+        }
+        pLine = (M4OSA_Char *)pEnd;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Parsing state of a .cube file */
+typedef struct
+{
+    M4OSA_UInt32    size;           /**< LUT_3D_SIZE */
+    M4OSA_UInt32    nbEntries;      /**< Number of RGB entries read */
+    M4OSA_Double    domainMin[3];
+    M4OSA_Double    domainMax[3];
+    M4OSA_Float     *pCube;         /**< size^3 RGB triplets, red fastest */
+    M4OSA_ERR       err;
+} M4VFL_CubeParser;
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutCubeLine(M4VFL_CubeParser *pParser, M4OSA_Char *pLine)
+ * @brief   Parses one line of a .cube file
+ ******************************************************************************
+*/
+static M4OSA_Void M4VFL_colorLutCubeLine(M4VFL_CubeParser *pParser, M4OSA_Char *pLine)
+{
+    M4OSA_Char *pValue;
+    M4OSA_Double values[3];
+    M4OSA_UInt32 nbValues;
+
+    while ((' ' == *pLine) || ('\t' == *pLine))
+    {
+        pLine++;
+    }
+
+    if ((M4NO_ERROR != pParser->err) || ('\0' == *pLine) || ('#' == *pLine))
+    {
+        return;
+    }
+
+    if (M4VFL_colorLutCubeKeyword(pLine, (const M4OSA_Char *)"LUT_3D_SIZE", &pValue))
+    {
+        pParser->size = (M4OSA_UInt32)strtol((const char *)pValue, M4OSA_NULL, 10);
+        if ((M4OSA_NULL != pParser->pCube) || (pParser->size < 2)
+            || (pParser->size > M4VFL_LUT_CUBE_MAX_SIZE))
+        {
+            M4OSA_TRACE1_1("M4VFL_colorLutLoadCube: bad LUT_3D_SIZE %d", pParser->size);
+            pParser->err = M4ERR_VFL_LUT_FILE_INVALID;
+            return;
+        }
+        pParser->pCube = (M4OSA_Float *)M4OSA_32bitAlignedMalloc(
+            pParser->size * pParser->size * pParser->size * 3 * sizeof(M4OSA_Float),
+            M4VEE, (M4OSA_Char *)"M4VFL_colorLutLoadCube: cube");
+        if (M4OSA_NULL == pParser->pCube)
+        {
+            pParser->err = M4ERR_ALLOC;
+        }
+    }
+    else if (M4VFL_colorLutCubeKeyword(pLine, (const M4OSA_Char *)"DOMAIN_MIN", &pValue))
+    {
+        if (3 != M4VFL_colorLutCubeFloats(pValue, pParser->domainMin))
+        {
+            pParser->err = M4ERR_VFL_LUT_FILE_INVALID;
+        }
+    }
+    else if (M4VFL_colorLutCubeKeyword(pLine, (const M4OSA_Char *)"DOMAIN_MAX", &pValue))
+    {
+        if (3 != M4VFL_colorLutCubeFloats(pValue, pParser->domainMax))
+        {
+            pParser->err = M4ERR_VFL_LUT_FILE_INVALID;
+        }
+    }
+    else if ((('0' <= *pLine) && ('9' >= *pLine)) || ('-' == *pLine) || ('+' == *pLine)
+        || ('.' == *pLine))
+    {
+        nbValues = M4VFL_colorLutCubeFloats(pLine, values);
+        if ((3 != nbValues) || (M4OSA_NULL == pParser->pCube)
+            || (pParser->nbEntries >= pParser->size * pParser->size * pParser->size))
+        {
+            M4OSA_TRACE1_1("M4VFL_colorLutLoadCube: unexpected entry %d", pParser->nbEntries);
+            pParser->err = M4ERR_VFL_LUT_FILE_INVALID;
+            return;
+        }
+        pParser->pCube[3*pParser->nbEntries]     = (M4OSA_Float)values[0];
+        pParser->pCube[3*pParser->nbEntries + 1] = (M4OSA_Float)values[1];
+        pParser->pCube[3*pParser->nbEntries + 2] = (M4OSA_Float)values[2];
+        pParser->nbEntries++;
+    }
+    /* Other keywords (TITLE, LUT_1D_SIZE ...) are ignored */
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_Void M4VFL_colorLutCubeSample(M4VFL_CubeParser *pParser, M4OSA_Double *pRgb)
+ * @brief   Trilinear sampling of the parsed cube, pRgb is 0..1 in and out
+ ******************************************************************************
+*/
+static M4OSA_Void M4VFL_colorLutCubeSample(M4VFL_CubeParser *pParser, M4OSA_Double *pRgb)
+{
+    M4OSA_UInt32 n = pParser->size;
+    M4OSA_UInt32 idx[3], c, corner;
+    M4OSA_Double frac[3], pos, out[3] = { 0.0, 0.0, 0.0 }, w;
+
+    for (c = 0; c < 3; c++)
+    {
+        pos = (pRgb[c] - pParser->domainMin[c])
+            / (pParser->domainMax[c] - pParser->domainMin[c]);
+        pos = (pos < 0.0) ? 0.0 : ((pos > 1.0) ? 1.0 : pos);
+        pos *= (M4OSA_Double)(n - 1);
+        idx[c] = (M4OSA_UInt32)pos;
+        if (idx[c] >= n - 1)
+        {
+            idx[c] = n - 2;
+        }
+        frac[c] = pos - (M4OSA_Double)idx[c];
+    }
+
+    for (corner = 0; corner < 8; corner++)
+    {
+        M4OSA_UInt32 ir = idx[0] + (corner & 1);
+        M4OSA_UInt32 ig = idx[1] + ((corner >> 1) & 1);
+        M4OSA_UInt32 ib = idx[2] + ((corner >> 2) & 1);
+        M4OSA_Float *pEntry = &pParser->pCube[3 * (ir + n * (ig + n * ib))];
+
+        w = ((corner & 1) ? frac[0] : 1.0 - frac[0])
+          * (((corner >> 1) & 1) ? frac[1] : 1.0 - frac[1])
+          * (((corner >> 2) & 1) ? frac[2] : 1.0 - frac[2]);
+        out[0] += w * pEntry[0];
+        out[1] += w * pEntry[1];
+        out[2] += w * pEntry[2];
+    }
+
+    pRgb[0] = out[0];
+    pRgb[1] = out[1];
+    pRgb[2] = out[2];
+}
+
+M4OSA_ERR M4VFL_colorLutLoadCube(M4VFL_ColorLut *pLut, M4OSA_Void *pFile,
+                                 M4OSA_FileReadPointer *pFileReadPtr)
+{
+    M4OSA_ERR err = M4NO_ERROR;
+    M4OSA_Context pFileCtxt = M4OSA_NULL;
+    M4OSA_Char *pChunk = M4OSA_NULL;
+    M4OSA_Char line[M4VFL_LUT_CUBE_LINE_SIZE];
+    M4OSA_UInt32 lineLen = 0, chunkSize, i, y, u, v;
+    M4OSA_Bool bEof = M4OSA_FALSE;
+    M4VFL_CubeParser parser;
+    M4OSA_Double rgb[3], yy, uu, vv;
+    M4OSA_UInt8 *pNode;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pLut), M4ERR_PARAMETER,
+        "M4VFL_colorLutLoadCube: pLut is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFile), M4ERR_PARAMETER,
+        "M4VFL_colorLutLoadCube: pFile is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pFileReadPtr), M4ERR_PARAMETER,
+        "M4VFL_colorLutLoadCube: pFileReadPtr is M4OSA_NULL");
+
+    pLut->type = M4VFL_kColorLut_3D;
+    pLut->pLut3D = M4OSA_NULL;
+
+    memset((void *)&parser, 0, sizeof(parser));
+    parser.domainMax[0] = parser.domainMax[1] = parser.domainMax[2] = 1.0;
+
+    pChunk = (M4OSA_Char *)M4OSA_32bitAlignedMalloc(M4VFL_LUT_CUBE_READ_SIZE, M4VEE,
+        (M4OSA_Char *)"M4VFL_colorLutLoadCube: read buffer");
+    if (M4OSA_NULL == pChunk)
+    {
+        return M4ERR_ALLOC;
+    }
+
+    err = pFileReadPtr->openRead(&pFileCtxt, pFile, M4OSA_kFileRead);
+    if (M4NO_ERROR != err)
+    {
+        M4OSA_TRACE1_1("M4VFL_colorLutLoadCube: openRead returned 0x%x", err);
+        pFileCtxt = M4OSA_NULL;
+        goto cleanup;
+    }
+
+    /**
+     * Parse the file line by line */
+    while ((M4OSA_FALSE == bEof) && (M4NO_ERROR == parser.err))
+    {
+        chunkSize = M4VFL_LUT_CUBE_READ_SIZE;
+        err = pFileReadPtr->readData(pFileCtxt, (M4OSA_MemAddr8)pChunk, &chunkSize);
+        if (M4WAR_NO_DATA_YET == err)
+        {
+            bEof = M4OSA_TRUE;
+        }
+        else if (M4NO_ERROR != err)
+        {
+            M4OSA_TRACE1_1("M4VFL_colorLutLoadCube: readData returned 0x%x", err);
+            goto cleanup;
+        }
+        if (0 == chunkSize)
+        {
+            bEof = M4OSA_TRUE;
+        }
+
+        for (i = 0; i < chunkSize; i++)
+        {
+            if (('\n' == pChunk[i]) || ('\r' == pChunk[i]))
+            {
+                line[lineLen] = '\0';
+                M4VFL_colorLutCubeLine(&parser, line);
+                lineLen = 0;
+            }
+            else if (lineLen < M4VFL_LUT_CUBE_LINE_SIZE - 1)
+            {
+                line[lineLen++] = pChunk[i];
+            }
+        }
+    }
+    line[lineLen] = '\0';
+    M4VFL_colorLutCubeLine(&parser, line);
+
+    err = parser.err;
+    if (M4NO_ERROR != err)
+    {
+        goto cleanup;
+    }
+    if ((M4OSA_NULL == parser.pCube)
+        || (parser.nbEntries != parser.size * parser.size * parser.size)
+        || (parser.domainMax[0] <= parser.domainMin[0])
+        || (parser.domainMax[1] <= parser.domainMin[1])
+        || (parser.domainMax[2] <= parser.domainMin[2]))
+    {
+        M4OSA_TRACE1_2("M4VFL_colorLutLoadCube: %d entries read, %d expected",
+            parser.nbEntries, parser.size * parser.size * parser.size);
+        err = M4ERR_VFL_LUT_FILE_INVALID;
+        goto cleanup;
+    }
+
+    /**
+     * Resample the RGB cube into the YUV table: YUV node -> RGB -> cube -> YUV */
+    pLut->pLut3D = (M4OSA_UInt8 *)M4OSA_32bitAlignedMalloc(
+        M4VFL_LUT3D_SIZE * M4VFL_LUT3D_SIZE * M4VFL_LUT3D_SIZE * 3, M4VEE,
+        (M4OSA_Char *)"M4VFL_colorLutLoadCube: 3D table");
+    if (M4OSA_NULL == pLut->pLut3D)
+    {
+        err = M4ERR_ALLOC;
+        goto cleanup;
+    }
+
+    pNode = pLut->pLut3D;
+    for (v = 0; v < M4VFL_LUT3D_SIZE; v++)
+    {
+        for (u = 0; u < M4VFL_LUT3D_SIZE; u++)
+        {
+            for (y = 0; y < M4VFL_LUT3D_SIZE; y++)
+            {
+                yy = (M4OSA_Double)M4VFL_LUT_CLIP((M4OSA_Int32)(y << 4));
+                uu = (M4OSA_Double)M4VFL_LUT_CLIP((M4OSA_Int32)(u << 4)) - 128.0;
+                vv = (M4OSA_Double)M4VFL_LUT_CLIP((M4OSA_Int32)(v << 4)) - 128.0;
+
+                rgb[0] = (yy + 1.402 * vv) / 255.0;
+                rgb[1] = (yy - 0.344136 * uu - 0.714136 * vv) / 255.0;
+                rgb[2] = (yy + 1.772 * uu) / 255.0;
+                for (i = 0; i < 3; i++)
+                {
+                    rgb[i] = (rgb[i] < 0.0) ? 0.0 : ((rgb[i] > 1.0) ? 1.0 : rgb[i]);
+                    rgb[i] = parser.domainMin[i]
+                        + rgb[i] * (parser.domainMax[i] - parser.domainMin[i]);
+                }
+
+                M4VFL_colorLutCubeSample(&parser, rgb);
+                rgb[0] *= 255.0;
+                rgb[1] *= 255.0;
+                rgb[2] *= 255.0;
+
+                yy = 0.299 * rgb[0] + 0.587 * rgb[1] + 0.114 * rgb[2];
+                uu = 128.0 - 0.168736 * rgb[0] - 0.331264 * rgb[1] + 0.5 * rgb[2];
+                vv = 128.0 + 0.5 * rgb[0] - 0.418688 * rgb[1] - 0.081312 * rgb[2];
+                pNode[0] = (M4OSA_UInt8)M4VFL_LUT_CLIP((M4OSA_Int32)(yy + 0.5));
+                pNode[1] = (M4OSA_UInt8)M4VFL_LUT_CLIP((M4OSA_Int32)(uu + 0.5));
+                pNode[2] = (M4OSA_UInt8)M4VFL_LUT_CLIP((M4OSA_Int32)(vv + 0.5));
+                pNode += 3;
+            }
+        }
+    }
+
+cleanup:
+    if (M4OSA_NULL != pFileCtxt)
+    {
+        pFileReadPtr->closeRead(pFileCtxt);
+    }
+    if (M4OSA_NULL != parser.pCube)
+    {
+        free(parser.pCube);
+    }
+    free(pChunk);
+    if ((M4NO_ERROR != err) && (M4OSA_NULL != pLut->pLut3D))
+    {
+        free(pLut->pLut3D);
+        pLut->pLut3D = M4OSA_NULL;
+    }
+    return err;
+}
+
+M4OSA_Void M4VFL_colorLutRelease(M4VFL_ColorLut *pLut)
+{
+    if ((M4OSA_NULL != pLut) && (M4OSA_NULL != pLut->pLut3D))
+    {
+        free(pLut->pLut3D);
+        pLut->pLut3D = M4OSA_NULL;
+    }
+}
+
+/**
+ ******************************************************************************
+ * M4OSA_UInt8 M4VFL_colorLut3DSample(const M4OSA_UInt8 *pLut3D, M4OSA_UInt32 y,
+ *                                    M4OSA_UInt32 u, M4OSA_UInt32 v, M4OSA_UInt32 c)
+ * @brief   Trilinear interpolation of the component c of the 3D table
+ ******************************************************************************
+*/
+static M4OSA_UInt8 M4VFL_colorLut3DSample(const M4OSA_UInt8 *pLut3D, M4OSA_UInt32 y,
+                                          M4OSA_UInt32 u, M4OSA_UInt32 v, M4OSA_UInt32 c)
+{
+    const M4OSA_UInt32 sy = 3;
+    const M4OSA_UInt32 su = 3 * M4VFL_LUT3D_SIZE;
+    const M4OSA_UInt32 sv = 3 * M4VFL_LUT3D_SIZE * M4VFL_LUT3D_SIZE;
+    const M4OSA_UInt8 *p = pLut3D + (y >> 4) * sy + (u >> 4) * su + (v >> 4) * sv + c;
+    M4OSA_UInt32 fy = y & 15, fu = u & 15, fv = v & 15;
+    M4OSA_UInt32 c00, c01, c10, c11, c0, c1;
+
+    /* 4 bits weights on each axis, 12 bits total */
+    c00 = p[0] * (16 - fy) + p[sy] * fy;
+    c01 = p[su] * (16 - fy) + p[su + sy] * fy;
+    c10 = p[sv] * (16 - fy) + p[sv + sy] * fy;
+    c11 = p[sv + su] * (16 - fy) + p[sv + su + sy] * fy;
+    c0 = c00 * (16 - fu) + c01 * fu;
+    c1 = c10 * (16 - fu) + c11 * fu;
+
+    return (M4OSA_UInt8)((c0 * (16 - fv) + c1 * fv + 2048) >> 12);
+}
+
+M4OSA_ERR M4VFL_colorLutApply(M4VFL_ColorLut *pLut, M4VIFI_ImagePlane *pPlaneIn,
+                              M4VIFI_ImagePlane *pPlaneOut)
+{
+    M4OSA_UInt32 plane, i, j, width, height;
+    M4VIFI_UInt8 *p_src, *p_dest;
+
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pLut), M4ERR_PARAMETER,
+        "M4VFL_colorLutApply: pLut is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pPlaneIn), M4ERR_PARAMETER,
+        "M4VFL_colorLutApply: pPlaneIn is M4OSA_NULL");
+    M4OSA_DEBUG_IF2((M4OSA_NULL == pPlaneOut), M4ERR_PARAMETER,
+        "M4VFL_colorLutApply: pPlaneOut is M4OSA_NULL");
+
+    if (M4VFL_kColorLut_3D == pLut->type)
+    {
+        const M4OSA_UInt8 *pLut3D = pLut->pLut3D;
+        M4VIFI_UInt8 *p_y, *p_u, *p_v, *p_yo, *p_uo, *p_vo;
+        M4OSA_UInt32 x, yl, ylum, next_col, next_row;
+
+        if (M4OSA_NULL == pLut3D)
+        {
+            return M4ERR_PARAMETER;
+        }
+
+        /**
+         * Each chroma sample is mapped with the mean of its luma samples,
+         * each luma sample with its co-sited chroma */
+        for (i = 0; i < pPlaneOut[1].u_height; i++)
+        {
+            p_u = pPlaneIn[1].pac_data + pPlaneIn[1].u_topleft + i * pPlaneIn[1].u_stride;
+            p_v = pPlaneIn[2].pac_data + pPlaneIn[2].u_topleft + i * pPlaneIn[2].u_stride;
+            p_uo = pPlaneOut[1].pac_data + pPlaneOut[1].u_topleft + i * pPlaneOut[1].u_stride;
+            p_vo = pPlaneOut[2].pac_data + pPlaneOut[2].u_topleft + i * pPlaneOut[2].u_stride;
+
+            for (yl = 2 * i; (yl < 2 * i + 2) && (yl < pPlaneOut[0].u_height); yl++)
+            {
+                p_y = pPlaneIn[0].pac_data + pPlaneIn[0].u_topleft + yl * pPlaneIn[0].u_stride;
+                p_yo = pPlaneOut[0].pac_data + pPlaneOut[0].u_topleft
+                    + yl * pPlaneOut[0].u_stride;
+                for (x = 0; x < pPlaneOut[0].u_width; x++)
+                {
+                    p_yo[x] = M4VFL_colorLut3DSample(pLut3D, p_y[x], p_u[x >> 1], p_v[x >> 1],
+                        0);
+                }
+            }
+
+            p_y = pPlaneIn[0].pac_data + pPlaneIn[0].u_topleft + 2 * i * pPlaneIn[0].u_stride;
+            next_row = (2 * i + 1 < pPlaneIn[0].u_height) ? pPlaneIn[0].u_stride : 0;
+            for (j = 0; j < pPlaneOut[1].u_width; j++)
+            {
+                next_col = (2 * j + 1 < pPlaneIn[0].u_width) ? 1 : 0;
+                ylum = (p_y[2*j] + p_y[2*j + next_col] + p_y[2*j + next_row]
+                    + p_y[2*j + next_row + next_col] + 2) >> 2;
+                p_uo[j] = M4VFL_colorLut3DSample(pLut3D, ylum, p_u[j], p_v[j], 1);
+                p_vo[j] = M4VFL_colorLut3DSample(pLut3D, ylum, p_u[j], p_v[j], 2);
+            }
+        }
+        return M4NO_ERROR;
+    }
+
+    for (plane = 0; plane < 3; plane++)
+    {
+        const M4OSA_UInt8 *pTable = pLut->lut[plane];
+        M4OSA_UInt8 gradientFill = 0;
+
+        width = pPlaneOut[plane].u_width;
+        height = pPlaneOut[plane].u_height;
+        p_src = pPlaneIn[plane].pac_data + pPlaneIn[plane].u_topleft;
+        p_dest = pPlaneOut[plane].pac_data + pPlaneOut[plane].u_topleft;
+
+        for (i = 0; i < height; i++)
+        {
+            if ((M4VFL_kColorLut_Gradient == pLut->type) && (0 != plane))
+            {
+                /**
+                 * Color gradation: the color fades to black from top to bottom */
+                M4OSA_Int32 r = pLut->gradientR - ((pLut->gradientR * i) / height);
+                M4OSA_Int32 g = pLut->gradientG - ((pLut->gradientG * i) / height);
+                M4OSA_Int32 b = pLut->gradientB - ((pLut->gradientB * i) / height);
+
+                gradientFill = (M4OSA_UInt8)((1 == plane) ?
+                    M4VFL_LUT_U16(r, g, b) : M4VFL_LUT_V16(r, g, b));
+                memset((void *)p_dest, gradientFill, width);
+            }
+            else if (pLut->bFill[plane])
+            {
+                memset((void *)p_dest, pTable[0], width);
+            }
+            else if (pLut->bCopy[plane])
+            {
+                memcpy((void *)p_dest, (void *)p_src, width);
+            }
+            else
+            {
+                for (j = 0; j < width; j++)
+                {
+                    p_dest[j] = pTable[p_src[j]];
+                }
+            }
+            p_src += pPlaneIn[plane].u_stride;
+            p_dest += pPlaneOut[plane].u_stride;
+        }
+    }
+
+    return M4NO_ERROR;
+}
@@ -37,15 +37,57 @@
 #define LUM_FACTOR_MAX 10
 
 
+/**
+ * Copies a plane, with a single memcpy when both planes are contiguous */
+static void M4VFL_copyPlane(const unsigned char *p_src, unsigned long u_stride,
+                            unsigned char *p_dest, unsigned long u_stride_out,
+                            unsigned long u_width, unsigned long u_height)
+{
+    unsigned long j;
+
+    if ((u_stride == u_width) && (u_stride_out == u_width))
+    {
+        memcpy((void *)p_dest, (void *)p_src, u_width * u_height);
+        return;
+    }
+    for (j = u_height; j != 0; j--)
+    {
+        memcpy((void *)p_dest, (void *)p_src, u_width);
+        p_dest += u_stride_out;
+        p_src += u_stride;
+    }
+}
+
+/**
+ * out = (bias + in * factor) >> LUM_FACTOR_MAX on a whole plane.
+ * The inner loop has no dependency between pixels nor branch, so that it can be
+ * vectorized by the compiler (fixed point multiply on 32 bits lanes). */
+static void M4VFL_scalePlane(const unsigned char *p_src, unsigned long u_stride,
+                             unsigned char *p_dest, unsigned long u_stride_out,
+                             unsigned long u_width, unsigned long u_height,
+                             unsigned int factor, unsigned int bias)
+{
+    unsigned long i, j;
+
+    for (j = u_height; j != 0; j--)
+    {
+        for (i = 0; i < u_width; i++)
+        {
+            p_dest[i] = (unsigned char)((bias + p_src[i] * factor) >> LUM_FACTOR_MAX);
+        }
+        p_dest += u_stride_out;
+        p_src += u_stride;
+    }
+}
+
 unsigned char M4VFL_modifyLumaByStep(M4ViComImagePlane *plane_in, M4ViComImagePlane *plane_out,
                                      M4VFL_ModifLumParam *lum_param, void *user_data)
 {
-    unsigned short *p_src, *p_dest, *p_src_line, *p_dest_line;
-    unsigned long pix_src;
-    unsigned long u_outpx, u_outpx2;
+    unsigned char *p_src, *p_dest;
+    unsigned char lut[256];
     unsigned long u_width, u_stride, u_stride_out,u_height, pix;
     unsigned long lf1, lf2, lf3;
-    long i, j;
+    unsigned long i, j;
 
     if (lum_param->copy_chroma != 0)
     {
@@ -56,12 +98,10 @@ unsigned char M4VFL_modifyLumaByStep(M4ViComImagePlane *plane_in, M4ViComImagePl
     /* apply luma factor */
     u_width = plane_in[0].u_width;
     u_height = plane_in[0].u_height;
-    u_stride = (plane_in[0].u_stride >> 1);
-    u_stride_out = (plane_out[0].u_stride >> 1);
-    p_dest = (unsigned short *) &plane_out[0].pac_data[plane_out[0].u_topleft];
-    p_src = (unsigned short *) &plane_in[0].pac_data[plane_in[0].u_topleft];
-    p_dest_line = p_dest;
-    p_src_line = p_src;
+    u_stride = plane_in[0].u_stride;
+    u_stride_out = plane_out[0].u_stride;
+    p_dest = &plane_out[0].pac_data[plane_out[0].u_topleft];
+    p_src = &plane_in[0].pac_data[plane_in[0].u_topleft];
 
     switch(lum_param->lum_factor)
     {
@@ -103,21 +143,20 @@ unsigned char M4VFL_modifyLumaByStep(M4ViComImagePlane *plane_in, M4ViComImagePl
         break;
     }
 
+    /* The factor is the same for the whole frame: compute it once per luma value */
+    for (pix = 0; pix < 256; pix++)
+    {
+        lut[pix] = (unsigned char)(((pix << lf1) + (pix << lf2) + (pix << lf3)) >> LUM_FACTOR_MAX);
+    }
+
     for (j = u_height; j != 0; j--)
     {
-        p_dest = p_dest_line;
-        p_src = p_src_line;
-        for (i = (u_width >> 1); i != 0; i--)
+        for (i = 0; i < u_width; i++)
         {
-            pix_src = (unsigned long) *p_src++;
-            pix = pix_src & 0xFF;
-            u_outpx = (((pix << lf1) + (pix << lf2) + (pix << lf3) ) >> LUM_FACTOR_MAX);
-            pix = ((pix_src & 0xFF00) >> 8);
-            u_outpx2 = ((((pix << lf1) + (pix << lf2) + (pix << lf3) ) >> LUM_FACTOR_MAX)<< 8) ;
-            *p_dest++ = (unsigned short) (u_outpx2 | u_outpx);
+            p_dest[i] = lut[p_src[i]];
         }
-        p_dest_line += u_stride_out;
-        p_src_line += u_stride;
+        p_dest += u_stride_out;
+        p_src += u_stride;
     }
     return 0;
 }
@@ -128,94 +167,33 @@ unsigned char M4VFL_modifyLumaWithScale(M4ViComImagePlane *plane_in,
                                          unsigned long lum_factor,
                                          void *user_data)
 {
-    unsigned short *p_src, *p_dest, *p_src_line, *p_dest_line;
-    unsigned char *p_csrc, *p_cdest, *p_csrc_line, *p_cdest_line;
-    unsigned long pix_src;
-    unsigned long u_outpx, u_outpx2;
-    unsigned long u_width, u_stride, u_stride_out,u_height, pix;
-    long i, j;
+    unsigned long plane;
 
     /* copy or filter chroma */
-    u_width = plane_in[1].u_width;
-    u_height = plane_in[1].u_height;
-    u_stride = plane_in[1].u_stride;
-    u_stride_out = plane_out[1].u_stride;
-    p_cdest_line = (unsigned char *) &plane_out[1].pac_data[plane_out[1].u_topleft];
-    p_csrc_line = (unsigned char *) &plane_in[1].pac_data[plane_in[1].u_topleft];
-
-    if (lum_factor > 256)
-    {
-        p_cdest = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        /* copy chroma */
-        for (j = u_height; j != 0; j--)
-        {
-            for (i = u_width; i != 0; i--)
-            {
-                memcpy((void *)p_cdest_line, (void *)p_csrc_line, u_width);
-                memcpy((void *)p_cdest,(void *) p_csrc, u_width);
-            }
-            p_cdest_line += u_stride_out;
-            p_cdest += u_stride_out;
-            p_csrc_line += u_stride;
-            p_csrc += u_stride;
-        }
-    }
-    else
+    for (plane = 1; plane < 3; plane++)
     {
-        /* filter chroma */
-        pix = (1024 - lum_factor) << 7;
-        for (j = u_height; j != 0; j--)
+        if (lum_factor > 256)
         {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc++ & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
+            M4VFL_copyPlane(&plane_in[plane].pac_data[plane_in[plane].u_topleft],
+                plane_in[plane].u_stride,
+                &plane_out[plane].pac_data[plane_out[plane].u_topleft],
+                plane_out[plane].u_stride, plane_in[plane].u_width, plane_in[plane].u_height);
         }
-        p_cdest_line = (unsigned char *) &plane_out[2].pac_data[plane_out[2].u_topleft];
-        p_csrc_line = (unsigned char *) &plane_in[2].pac_data[plane_in[2].u_topleft];
-        for (j = u_height; j != 0; j--)
+        else
         {
-            p_cdest = p_cdest_line;
-            p_csrc = p_csrc_line;
-            for (i = u_width; i != 0; i--)
-            {
-                *p_cdest++ = ((pix + (*p_csrc & 0xFF) * lum_factor) >> LUM_FACTOR_MAX);
-            }
-            p_cdest_line += u_stride_out;
-            p_csrc_line += u_stride;
+            /* filter chroma towards 128 */
+            M4VFL_scalePlane(&plane_in[plane].pac_data[plane_in[plane].u_topleft],
+                plane_in[plane].u_stride,
+                &plane_out[plane].pac_data[plane_out[plane].u_topleft],
+                plane_out[plane].u_stride, plane_in[plane].u_width, plane_in[plane].u_height,
+                (unsigned int)lum_factor, (unsigned int)((1024 - lum_factor) << 7));
         }
     }
-    /* apply luma factor */
-    u_width = plane_in[0].u_width;
-    u_height = plane_in[0].u_height;
-    u_stride = (plane_in[0].u_stride >> 1);
-    u_stride_out = (plane_out[0].u_stride >> 1);
-    p_dest = (unsigned short *) &plane_out[0].pac_data[plane_out[0].u_topleft];
-    p_src = (unsigned short *) &plane_in[0].pac_data[plane_in[0].u_topleft];
-    p_dest_line = p_dest;
-    p_src_line = p_src;
 
-    for (j = u_height; j != 0; j--)
-    {
-        p_dest = p_dest_line;
-        p_src = p_src_line;
-        for (i = (u_width >> 1); i != 0; i--)
-        {
-            pix_src = (unsigned long) *p_src++;
-            pix = pix_src & 0xFF;
-            u_outpx = ((pix * lum_factor) >> LUM_FACTOR_MAX);
-            pix = ((pix_src & 0xFF00) >> 8);
-            u_outpx2 = (((pix * lum_factor) >> LUM_FACTOR_MAX)<< 8) ;
-            *p_dest++ = (unsigned short) (u_outpx2 | u_outpx);
-        }
-        p_dest_line += u_stride_out;
-        p_src_line += u_stride;
-    }
+    /* apply luma factor */
+    M4VFL_scalePlane(&plane_in[0].pac_data[plane_in[0].u_topleft], plane_in[0].u_stride,
+        &plane_out[0].pac_data[plane_out[0].u_topleft], plane_out[0].u_stride,
+        plane_in[0].u_width, plane_in[0].u_height, (unsigned int)lum_factor, 0);
 
     return 0;
 }